@@ -0,0 +1,149 @@
+/**
+ * @file agenda.c
+ * @brief Implementacao da agenda de eventos (roda de temporizacao).
+ */
+
+#include <string.h>
+#include "forca.h"
+#include "agenda.h"
+
+/**
+ * @brief Converte um instante em ns para o numero do tick correspondente.
+ * @param a A agenda.
+ * @param agoraNs O instante, em ns.
+ * @return O tick.
+ */
+static long long tickDe (const Agenda *a, long long agoraNs){
+    return (agoraNs-a->inicio)/a->resolucao;
+}
+
+/**
+ * @brief Insere um evento no inicio de uma lista.
+ * @param lista O ponteiro para o inicio da lista.
+ * @param e O evento.
+ */
+static void inserirEvento (EventoAgenda **lista, EventoAgenda *e){
+    e->proximo=*lista;
+    if(*lista!=NULL)    (*lista)->anterior=&e->proximo;
+    *lista=e;
+    e->anterior=lista;
+}
+
+/**
+ * @brief Retira um evento da lista em que esta.
+ * @param e O evento.
+ */
+static void retirarEvento (EventoAgenda *e){
+    *e->anterior=e->proximo;
+    if(e->proximo!=NULL)    e->proximo->anterior=e->anterior;
+    e->proximo=NULL;
+    e->anterior=NULL;
+}
+
+/**
+ * @brief Prepara uma agenda vazia.
+ * @param a A agenda.
+ * @param resolucaoMs A duracao de um tick, em milissegundos (minimo 1).
+ */
+void iniciarAgenda (Agenda *a, int resolucaoMs){
+    memset(a,0,sizeof(*a));
+    a->inicio=relogioNs();
+    a->resolucao=(resolucaoMs>0?resolucaoMs:1)*1000000LL;
+}
+
+/**
+ * @brief Agenda uma acao para daqui a atrasoMs milissegundos.
+ * @param a A agenda.
+ * @param e O evento (memoria de quem chama).
+ * @param atrasoMs O atraso em milissegundos.
+ * @param acao A funcao chamada no vencimento.
+ * @param dados O argumento passado para a acao.
+ */
+void agendarEvento (Agenda *a, EventoAgenda *e, int atrasoMs, void (*acao)(void *), void *dados){
+    long long prazo;
+    if(e->anterior!=NULL)   cancelarEvento(a,e);
+    // Arredonda para cima: o evento nunca vence antes do atraso pedido.
+    prazo=tickDe(a,relogioNs()+(atrasoMs>0?atrasoMs:0)*1000000LL+a->resolucao-1);
+    // Um tick ja processado nao seria visitado de novo.
+    if(prazo<a->tickAtual)  prazo=a->tickAtual;
+    e->prazo=prazo;
+    e->acao=acao;
+    e->dados=dados;
+    inserirEvento(&a->slots[prazo&(SLOTS_AGENDA-1)],e);
+    a->quantidade++;
+}
+
+/**
+ * @brief Cancela um evento agendado (nada faz se ele nao estiver agendado).
+ * @param a A agenda.
+ * @param e O evento.
+ */
+void cancelarEvento (Agenda *a, EventoAgenda *e){
+    if(e->anterior==NULL)   return;
+    retirarEvento(e);
+    a->quantidade--;
+}
+
+/**
+ * @brief Executa as acoes de todos os eventos vencidos.
+ *
+ * Os eventos vencidos sao primeiro movidos para uma lista separada e so
+ * depois executados, de modo que as acoes possam mexer na agenda.
+ *
+ * @param a A agenda.
+ * @param agoraNs O instante atual, em ns (relogioNs).
+ * @return O numero de acoes executadas.
+ */
+int processarAgenda (Agenda *a, long long agoraNs){
+    EventoAgenda *prontos=NULL,*e,*proximo;
+    long long agora=tickDe(a,agoraNs),passos,i;
+    int executados=0;
+    if(agora<a->tickAtual)  return 0;
+    // Apos uma volta completa, todas as posicoes ja foram visitadas.
+    passos=agora-a->tickAtual+1;
+    if(passos>SLOTS_AGENDA) passos=SLOTS_AGENDA;
+    for(i=0;i<passos;i++){
+        for(e=a->slots[(a->tickAtual+i)&(SLOTS_AGENDA-1)];e!=NULL;e=proximo){
+            proximo=e->proximo;
+            // Eventos de voltas futuras da roda ficam onde estao.
+            if(e->prazo>agora)  continue;
+            // Continua contado em quantidade ate ser executado (pode ser cancelado antes).
+            retirarEvento(e);
+            inserirEvento(&prontos,e);
+        }
+    }
+    a->tickAtual=agora+1;
+    while(prontos!=NULL){
+        e=prontos;
+        retirarEvento(e);
+        a->quantidade--;
+        e->acao(e->dados);
+        executados++;
+    }
+    return executados;
+}
+
+/**
+ * @brief Calcula quanto falta para o proximo vencimento.
+ * @param a A agenda.
+ * @param agoraNs O instante atual, em ns (relogioNs).
+ * @return Os milissegundos ate o proximo evento, ou -1 se a agenda estiver vazia.
+ */
+int tempoAteProximo (const Agenda *a, long long agoraNs){
+    const EventoAgenda *e;
+    long long tick,restante;
+    int i;
+    if(a->quantidade==0)    return -1;
+    // A primeira posicao com um evento desta volta contem o proximo vencimento.
+    for(i=0;i<SLOTS_AGENDA;i++){
+        tick=a->tickAtual+i;
+        for(e=a->slots[tick&(SLOTS_AGENDA-1)];e!=NULL;e=e->proximo)
+            if(e->prazo<=tick)  break;
+        if(e!=NULL) break;
+    }
+    // Ao fim da volta, acorda e procura de novo.
+    if(i==SLOTS_AGENDA) tick=a->tickAtual+SLOTS_AGENDA;
+    restante=a->inicio+tick*a->resolucao-agoraNs;
+    if(restante<=0) return 0;
+    return (int)((restante+999999)/1000000);
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+/**
+ * @file agenda.h
+ * @brief Arquivo de cabecalho da agenda de eventos (roda de temporizacao).
+ *
+ * Substitui as pausas bloqueantes (delayMS) por eventos adiados: em vez
+ * de dormir, quem precisa esperar agenda uma acao para dali a N ms e
+ * volta ao seu laco. Uma unica thread pode assim cadenciar milhares de
+ * partidas ao mesmo tempo.
+ *
+ * A agenda e uma roda com SLOTS_AGENDA posicoes; cada posicao guarda a
+ * lista dos eventos cujo prazo, em ticks, cai nela modulo o tamanho da
+ * roda. Agendar e cancelar custam O(1); cada tick processado percorre so
+ * a lista de uma posicao. Os eventos sao intrusivos (a memoria e de quem
+ * agenda), de modo que a agenda nunca aloca memoria.
+ *
+ * Uma agenda nao e thread-safe: cada thread deve usar a sua.
+ */
+
+#ifndef AGENDA_H
+#define AGENDA_H
+
+// Numero de posicoes da roda (potencia de 2).
+#define SLOTS_AGENDA 1024
+
+/**
+ * @struct EventoAgenda
+ * @brief Uma acao adiada.
+ *
+ * Deve comecar zerada e continuar valida enquanto estiver agendada.
+ */
+typedef struct EventoAgenda{
+    struct EventoAgenda *proximo;   // Proximo evento da mesma lista.
+    struct EventoAgenda **anterior; // Ponteiro que aponta para este evento (NULL se nao agendado).
+    long long prazo;                // Tick em que o evento vence.
+    void (*acao)(void *dados);      // Funcao chamada no vencimento.
+    void *dados;                    // Argumento da acao.
+} EventoAgenda;
+
+/**
+ * @struct Agenda
+ * @brief A roda de temporizacao.
+ */
+typedef struct{
+    EventoAgenda *slots[SLOTS_AGENDA];
+    long long inicio;       // Instante de referencia, em ns (relogioNs).
+    long long resolucao;    // Duracao de um tick, em ns.
+    long long tickAtual;    // Proximo tick a ser processado.
+    int quantidade;         // Eventos agendados.
+} Agenda;
+
+/**
+ * @brief Prepara uma agenda vazia.
+ * @param a A agenda.
+ * @param resolucaoMs A duracao de um tick, em milissegundos (minimo 1).
+ */
+void iniciarAgenda (Agenda *a, int resolucaoMs);
+
+/**
+ * @brief Agenda uma acao para daqui a atrasoMs milissegundos.
+ *
+ * Se o evento ja estiver agendado, ele e reagendado.
+ *
+ * @param a A agenda.
+ * @param e O evento (memoria de quem chama).
+ * @param atrasoMs O atraso em milissegundos.
+ * @param acao A funcao chamada no vencimento.
+ * @param dados O argumento passado para a acao.
+ */
+void agendarEvento (Agenda *a, EventoAgenda *e, int atrasoMs, void (*acao)(void *), void *dados);
+
+/**
+ * @brief Cancela um evento agendado (nada faz se ele nao estiver agendado).
+ * @param a A agenda.
+ * @param e O evento.
+ */
+void cancelarEvento (Agenda *a, EventoAgenda *e);
+
+/**
+ * @brief Executa as acoes de todos os eventos vencidos.
+ *
+ * As acoes podem agendar ou cancelar eventos, inclusive o proprio.
+ *
+ * @param a A agenda.
+ * @param agoraNs O instante atual, em ns (relogioNs).
+ * @return O numero de acoes executadas.
+ */
+int processarAgenda (Agenda *a, long long agoraNs);
+
+/**
+ * @brief Calcula quanto falta para o proximo vencimento.
+ *
+ * Util como tempo limite de epoll_wait ou poll.
+ *
+ * @param a A agenda.
+ * @param agoraNs O instante atual, em ns (relogioNs).
+ * @return Os milissegundos ate o proximo evento, ou -1 se a agenda estiver vazia.
+ */
+int tempoAteProximo (const Agenda *a, long long agoraNs);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,102 @@
+/**
+ * @file aleatorio.c
+ * @brief Implementacao do gerador xoshiro256** e do sorteio sem vies.
+ */
+
+#include <time.h>
+#include "forca.h"
+#include "aleatorio.h"
+#ifdef _WIN32
+    #include <process.h>
+    #define getpid _getpid
+#else
+    #include <unistd.h>
+#endif
+
+/**
+ * @brief Avanca um estado splitmix64 e retorna o proximo valor.
+ * @param x O estado.
+ * @return O valor gerado.
+ */
+static uint64_t splitmix64 (uint64_t *x){
+    uint64_t z=(*x+=0x9e3779b97f4a7c15ULL);
+    z=(z^(z>>30))*0xbf58476d1ce4e5b9ULL;
+    z=(z^(z>>27))*0x94d049bb133111ebULL;
+    return z^(z>>31);
+}
+
+/**
+ * @brief Rotaciona x para a esquerda em k bits.
+ * @param x O valor.
+ * @param k O numero de bits (1 a 63).
+ * @return O valor rotacionado.
+ */
+static inline uint64_t rotacionar (uint64_t x, int k){
+    return (x<<k)|(x>>(64-k));
+}
+
+/**
+ * @brief Inicia o gerador a partir de uma semente de 64 bits.
+ * @param a O gerador.
+ * @param semente A semente.
+ */
+void semearAleatorio (Aleatorio *a, uint64_t semente){
+    int i;
+    for(i=0;i<4;i++)    a->s[i]=splitmix64(&semente);
+}
+
+/**
+ * @brief Inicia o gerador do fluxo de numero informado de uma semente.
+ * @param a O gerador.
+ * @param semente A semente base.
+ * @param fluxo O numero do fluxo (partida, conexao, thread...).
+ */
+void semearFluxo (Aleatorio *a, uint64_t semente, uint64_t fluxo){
+    // Mistura o fluxo antes de combina-lo, para que (s, f) e (s+1, f-1) nao coincidam.
+    semearAleatorio(a,semente^splitmix64(&fluxo));
+}
+
+/**
+ * @brief Gera o proximo numero de 64 bits.
+ * @param a O gerador.
+ * @return O numero gerado.
+ */
+uint64_t proximoAleatorio (Aleatorio *a){
+    uint64_t *s = a->s;
+    uint64_t resultado=rotacionar(s[1]*5,7)*9,t=s[1]<<17;
+    s[2]^=s[0];
+    s[3]^=s[1];
+    s[1]^=s[2];
+    s[0]^=s[3];
+    s[2]^=t;
+    s[3]=rotacionar(s[3],45);
+    return resultado;
+}
+
+/**
+ * @brief Sorteia um inteiro uniforme em [0, limite), sem o vies do operador %.
+ * @param a O gerador.
+ * @param limite O limite superior (exclusivo).
+ * @return O numero sorteado (0 se limite for 0).
+ */
+uint32_t sortearIntervalo (Aleatorio *a, uint32_t limite){
+    uint64_t m=(proximoAleatorio(a)>>32)*limite;
+    uint32_t piso;
+    // Os 32 bits baixos do produto so podem cair na faixa enviesada se forem menores que o limite.
+    if((uint32_t)m<limite){
+        piso=-limite%limite;
+        while((uint32_t)m<piso) m=(proximoAleatorio(a)>>32)*limite;
+    }
+    return (uint32_t)(m>>32);
+}
+
+/**
+ * @brief Gera uma semente diferente a cada chamada e a cada processo.
+ * @return A semente.
+ */
+uint64_t gerarSemente (void){
+    static uint64_t contador=0;
+    uint64_t x=(uint64_t)relogioNs()^((uint64_t)time(NULL)<<32)^((uint64_t)getpid()<<16)^(uintptr_t)&contador;
+    x+=__atomic_add_fetch(&contador,1,__ATOMIC_RELAXED)*0x9e3779b97f4a7c15ULL;
+    return splitmix64(&x);
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+/**
+ * @file aleatorio.h
+ * @brief Arquivo de cabecalho do gerador de numeros pseudoaleatorios.
+ *
+ * Gerador xoshiro256** com estado explicito: cada partida, conexao ou
+ * thread tem o seu, sem estado global escondido, de modo que o uso em
+ * paralelo e seguro e o resultado depende apenas da semente. A partir
+ * de uma semente e de um numero de fluxo (por exemplo, o indice da
+ * partida) obtem-se sequencias independentes e reproduziveis.
+ */
+
+#ifndef ALEATORIO_H
+#define ALEATORIO_H
+
+#include <stdint.h>
+
+/**
+ * @struct Aleatorio
+ * @brief Estado de um gerador xoshiro256**.
+ */
+typedef struct{
+    uint64_t s[4];
+} Aleatorio;
+
+/**
+ * @brief Inicia o gerador a partir de uma semente de 64 bits.
+ *
+ * O estado e preenchido com splitmix64, de modo que sementes vizinhas
+ * (0, 1, 2, ...) produzem sequencias sem relacao entre si.
+ *
+ * @param a O gerador.
+ * @param semente A semente.
+ */
+void semearAleatorio (Aleatorio *a, uint64_t semente);
+
+/**
+ * @brief Inicia o gerador do fluxo de numero informado de uma semente.
+ * @param a O gerador.
+ * @param semente A semente base.
+ * @param fluxo O numero do fluxo (partida, conexao, thread...).
+ */
+void semearFluxo (Aleatorio *a, uint64_t semente, uint64_t fluxo);
+
+/**
+ * @brief Gera o proximo numero de 64 bits.
+ * @param a O gerador.
+ * @return O numero gerado.
+ */
+uint64_t proximoAleatorio (Aleatorio *a);
+
+/**
+ * @brief Sorteia um inteiro uniforme em [0, limite), sem o vies do operador %.
+ *
+ * Usa o metodo de multiplicacao de Lemire, que quase nunca precisa de
+ * uma divisao.
+ *
+ * @param a O gerador.
+ * @param limite O limite superior (exclusivo).
+ * @return O numero sorteado (0 se limite for 0).
+ */
+uint32_t sortearIntervalo (Aleatorio *a, uint32_t limite);
+
+/**
+ * @brief Gera uma semente diferente a cada chamada e a cada processo.
+ *
+ * Combina o relogio em nanossegundos, a hora, o identificador do
+ * processo e um contador, para que dois processos iniciados no mesmo
+ * segundo nao sorteiem as mesmas palavras.
+ *
+ * @return A semente.
+ */
+uint64_t gerarSemente (void);
+
+#endif
\ No newline at end of file
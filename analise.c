@@ -0,0 +1,424 @@
+/**
+ * @file analise.c
+ * @brief Implementacao da analise paralela do arquivo de resultados.
+ *
+ * Cada linha tem o formato de registrarResultado:
+ * "[dd/mm/YYYY HH:MM]\tnome\tpalavra\tVitoria|Derrota". As chaves das
+ * tabelas hash apontam diretamente para o arquivo mapeado, de modo que
+ * nenhuma linha exige alocacao de memoria.
+ */
+
+#include <stdio.h>
+#include "forca.h"
+#include "analise.h"
+
+#ifndef _WIN32
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * @struct Contagem
+ * @brief Partidas e vitorias de uma chave (jogador ou palavra).
+ */
+typedef struct{
+    const char *chave;      // Aponta para o arquivo mapeado (nao terminada em '\0').
+    uint32_t tamanho;       // Comprimento da chave.
+    uint32_t hash;          // Hash da chave (0 indica posicao livre).
+    uint64_t partidas;
+    uint64_t vitorias;
+} Contagem;
+
+/**
+ * @struct Tabela
+ * @brief Tabela hash de enderecamento aberto com sondagem linear.
+ */
+typedef struct{
+    Contagem *itens;
+    size_t capacidade;      // Sempre potencia de 2.
+    size_t usados;
+} Tabela;
+
+/**
+ * @struct Bloco
+ * @brief Trecho do arquivo processado por uma thread e seus agregados.
+ */
+typedef struct{
+    const char *inicio,*fim;
+    Tabela jogadores,palavras;
+    uint64_t partidasHora[24],vitoriasHora[24];
+    uint64_t linhas,invalidas;
+    int erro;               // 1 se faltou memoria para as tabelas.
+    int emThread;           // 1 se o bloco foi processado por uma thread propria.
+    pthread_t thread;
+} Bloco;
+
+/**
+ * @brief Calcula o hash FNV-1a de uma chave.
+ * @param s A chave.
+ * @param n O comprimento da chave.
+ * @return O hash, nunca zero.
+ */
+static uint32_t calcularHash (const char *s, uint32_t n){
+    uint32_t h=2166136261u,i;
+    for(i=0;i<n;i++){
+        h^=(unsigned char)s[i];
+        h*=16777619u;
+    }
+    return h!=0?h:1;
+}
+
+/**
+ * @brief Inicia uma tabela vazia.
+ * @param t A tabela.
+ * @param capacidade A capacidade inicial (potencia de 2).
+ * @return 0 em caso de sucesso, -1 se faltar memoria.
+ */
+static int iniciarTabela (Tabela *t, size_t capacidade){
+    t->itens=calloc(capacidade,sizeof(Contagem));
+    t->capacidade=capacidade;
+    t->usados=0;
+    return t->itens!=NULL?0:-1;
+}
+
+/**
+ * @brief Localiza a posicao de uma chave, ou a posicao livre onde ela entraria.
+ * @param t A tabela.
+ * @param chave A chave.
+ * @param tamanho O comprimento da chave.
+ * @param hash O hash da chave.
+ * @return A posicao da chave, ou a posicao livre.
+ */
+static Contagem *localizar (Tabela *t, const char *chave, uint32_t tamanho, uint32_t hash){
+    size_t i=hash&(t->capacidade-1);
+    Contagem *c;
+    for(;;){
+        c=&t->itens[i];
+        if(c->hash==0||(c->hash==hash&&c->tamanho==tamanho&&memcmp(c->chave,chave,tamanho)==0))
+            return c;
+        i=(i+1)&(t->capacidade-1);
+    }
+}
+
+/**
+ * @brief Dobra a capacidade de uma tabela, reinserindo seus itens.
+ * @param t A tabela.
+ * @return 0 em caso de sucesso, -1 se faltar memoria (a tabela fica como estava).
+ */
+static int crescerTabela (Tabela *t){
+    Tabela nova;
+    size_t i;
+    if(iniciarTabela(&nova,t->capacidade*2)<0)  return -1;
+    for(i=0;i<t->capacidade;i++)
+        if(t->itens[i].hash!=0)
+            *localizar(&nova,t->itens[i].chave,t->itens[i].tamanho,t->itens[i].hash)=t->itens[i];
+    nova.usados=t->usados;
+    free(t->itens);
+    *t=nova;
+    return 0;
+}
+
+/**
+ * @brief Soma partidas e vitorias a uma chave, criando-a se necessario.
+ * @param t A tabela.
+ * @param chave A chave.
+ * @param tamanho O comprimento da chave.
+ * @param hash O hash da chave.
+ * @param partidas As partidas a somar.
+ * @param vitorias As vitorias a somar.
+ * @return 0 em caso de sucesso, -1 se faltar memoria para crescer a tabela.
+ */
+static int somar (Tabela *t, const char *chave, uint32_t tamanho, uint32_t hash, uint64_t partidas, uint64_t vitorias){
+    Contagem *c;
+    // Mantem a ocupacao abaixo de 50% para sondagens curtas.
+    if(2*(t->usados+1)>t->capacidade&&crescerTabela(t)<0)   return -1;
+    c=localizar(t,chave,tamanho,hash);
+    if(c->hash==0){
+        c->chave=chave;
+        c->tamanho=tamanho;
+        c->hash=hash;
+        t->usados++;
+    }
+    c->partidas+=partidas;
+    c->vitorias+=vitorias;
+    return 0;
+}
+
+/**
+ * @brief Processa as linhas de um bloco.
+ *
+ * Se faltar memoria para as tabelas, o bloco para e marca b->erro.
+ *
+ * @param arg O Bloco.
+ * @return Sempre NULL.
+ */
+static void *processarBloco (void *arg){
+    Bloco *b = arg;
+    const char *p=b->inicio,*fimLinha,*nome,*palavra,*resultado;
+    int hora,vitoria;
+    if(iniciarTabela(&b->jogadores,1024)<0||iniciarTabela(&b->palavras,1024)<0){
+        b->erro=1;
+        return NULL;
+    }
+    while(p<b->fim){
+        fimLinha=memchr(p,'\n',b->fim-p);
+        if(fimLinha==NULL)  fimLinha=b->fim;
+        b->linhas++;
+        // "[dd/mm/YYYY HH:MM]\t" ocupa 19 caracteres; a hora esta nas posicoes 12 e 13.
+        nome=p+19;
+        if(fimLinha-p<20||p[0]!='['||p[17]!=']'||p[18]!='\t'){
+            b->invalidas++;
+            p=fimLinha+1;
+            continue;
+        }
+        palavra=memchr(nome,'\t',fimLinha-nome);
+        resultado=palavra!=NULL?memchr(palavra+1,'\t',fimLinha-(palavra+1)):NULL;
+        if(resultado==NULL||fimLinha-resultado<2){
+            b->invalidas++;
+            p=fimLinha+1;
+            continue;
+        }
+        palavra++;
+        resultado++;
+        hora=(p[12]-'0')*10+(p[13]-'0');
+        vitoria=resultado[0]=='V';
+        if(somar(&b->jogadores,nome,(uint32_t)(palavra-1-nome),calcularHash(nome,(uint32_t)(palavra-1-nome)),1,vitoria)<0
+           ||somar(&b->palavras,palavra,(uint32_t)(resultado-1-palavra),calcularHash(palavra,(uint32_t)(resultado-1-palavra)),1,vitoria)<0){
+            b->erro=1;
+            return NULL;
+        }
+        if(hora>=0&&hora<24){
+            b->partidasHora[hora]++;
+            b->vitoriasHora[hora]+=vitoria;
+        }
+        p=fimLinha+1;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Acrescenta os itens de uma tabela em outra.
+ * @param destino A tabela que recebe os itens.
+ * @param origem A tabela de origem (liberada ao final, mesmo em caso de erro).
+ * @return 0 em caso de sucesso, -1 se faltar memoria.
+ */
+static int combinarTabela (Tabela *destino, Tabela *origem){
+    size_t i;
+    int r=0;
+    for(i=0;i<origem->capacidade&&r==0;i++){
+        Contagem *c = &origem->itens[i];
+        if(c->hash!=0)  r=somar(destino,c->chave,c->tamanho,c->hash,c->partidas,c->vitorias);
+    }
+    free(origem->itens);
+    origem->itens=NULL;
+    return r;
+}
+
+/**
+ * @brief Libera as tabelas que restarem nos blocos.
+ * @param blocos Os blocos.
+ * @param n O numero de blocos.
+ */
+static void liberarBlocos (Bloco *blocos, int n){
+    int j;
+    for(j=0;j<n;j++){
+        free(blocos[j].jogadores.itens);
+        free(blocos[j].palavras.itens);
+    }
+}
+
+/**
+ * @brief Copia os itens ocupados de uma tabela para um vetor compacto.
+ * @param t A tabela.
+ * @return O vetor, com t->usados itens.
+ */
+static Contagem *listarTabela (const Tabela *t){
+    Contagem *v = malloc((t->usados>0?t->usados:1)*sizeof(Contagem));
+    size_t i,n=0;
+    for(i=0;i<t->capacidade;i++)
+        if(t->itens[i].hash!=0) v[n++]=t->itens[i];
+    return v;
+}
+
+/**
+ * @brief Ordena por numero de partidas, da maior para a menor.
+ * @param a A primeira Contagem.
+ * @param b A segunda Contagem.
+ * @return Negativo se a vier antes de b, positivo se vier depois, 0 se empatarem.
+ */
+static int compararPartidas (const void *a, const void *b){
+    const Contagem *x=a,*y=b;
+    return (x->partidas<y->partidas)-(x->partidas>y->partidas);
+}
+
+/**
+ * @brief Ordena pela taxa de vitorias, da menor para a maior (mais dificeis primeiro).
+ * @param a A primeira Contagem.
+ * @param b A segunda Contagem.
+ * @return Negativo se a vier antes de b, positivo se vier depois, 0 se empatarem.
+ */
+static int compararDificuldade (const void *a, const void *b){
+    const Contagem *x=a,*y=b;
+    // Compara vitorias/partidas sem divisao: x.v*y.p contra y.v*x.p.
+    double rx=(double)x->vitorias*y->partidas,ry=(double)y->vitorias*x->partidas;
+    if(rx!=ry)  return rx<ry?-1:1;
+    return compararPartidas(a,b);
+}
+
+/**
+ * @brief Imprime uma linha de ranking.
+ * @param posicao A posicao no ranking (a partir de 1).
+ * @param c A Contagem.
+ */
+static void imprimirContagem (int posicao, const Contagem *c){
+    printf("  %2d. %-30.*s %10llu partidas  %5.1f%% vitorias\n",posicao,(int)(c->tamanho<30?c->tamanho:30),c->chave,
+           (unsigned long long)c->partidas,100.0*c->vitorias/c->partidas);
+}
+
+/**
+ * @brief Analisa o arquivo de resultados e imprime o relatorio.
+ * @param nomeArquivo O arquivo de resultados.
+ * @param threads O numero de threads (0 = uma por nucleo).
+ * @return 0 em caso de sucesso, 1 em caso de erro.
+ */
+int analisarResultados (const char *nomeArquivo, int threads){
+    struct stat st;
+    const char *dados,*corte;
+    Bloco *blocos,unico;
+    Tabela jogadores,palavras;
+    Contagem *lista;
+    uint64_t partidas=0,vitorias=0,linhas=0,invalidas=0,partidasHora[24]={0},vitoriasHora[24]={0},maiorHora=1;
+    long long t0,t1;
+    size_t i,k,n;
+    int fd=open(nomeArquivo,O_RDONLY),j,erro=0;
+    if(fd<0||fstat(fd,&st)<0){
+        printf("Erro ao abrir o arquivo: %s\n",nomeArquivo);
+        if(fd>=0)   close(fd);
+        return 1;
+    }
+    if(st.st_size==0){
+        printf("O arquivo %s esta vazio.\n",nomeArquivo);
+        close(fd);
+        return 0;
+    }
+    t0=relogioNs();
+    dados=mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    if(dados==MAP_FAILED){
+        printf("Erro ao abrir o arquivo: %s\n",nomeArquivo);
+        return 1;
+    }
+    madvise((void *)dados,st.st_size,MADV_SEQUENTIAL);
+    if(threads<=0)  threads=(int)sysconf(_SC_NPROCESSORS_ONLN);
+    if(threads<=0)  threads=1;
+    // Cada bloco termina logo apos uma quebra de linha.
+    blocos=calloc(threads,sizeof(Bloco));
+    // Sem memoria para os blocos, o arquivo inteiro e lido pela thread atual.
+    if(blocos==NULL){
+        memset(&unico,0,sizeof(unico));
+        blocos=&unico;
+        threads=1;
+    }
+    corte=dados;
+    for(j=0;j<threads;j++){
+        const char *fim=j==threads-1?dados+st.st_size:dados+(st.st_size/threads)*(j+1);
+        if(fim<corte)   fim=corte;
+        if(j<threads-1){
+            const char *quebra=memchr(fim,'\n',dados+st.st_size-fim);
+            fim=quebra!=NULL?quebra+1:dados+st.st_size;
+        }
+        blocos[j].inicio=corte;
+        blocos[j].fim=fim;
+        corte=fim;
+        // Um bloco que nao conseguir thread propria e lido pela thread atual, depois de criadas as demais.
+        blocos[j].emThread=pthread_create(&blocos[j].thread,NULL,processarBloco,&blocos[j])==0;
+    }
+    for(j=0;j<threads;j++)  if(!blocos[j].emThread) processarBloco(&blocos[j]);
+    for(j=0;j<threads;j++)  if(blocos[j].emThread)  pthread_join(blocos[j].thread,NULL);
+    // Combina os agregados de cada thread nas tabelas do primeiro bloco.
+    for(j=0;j<threads;j++){
+        erro|=blocos[j].erro;
+        if(j>0&&!erro)
+            erro=combinarTabela(&blocos[0].jogadores,&blocos[j].jogadores)<0||combinarTabela(&blocos[0].palavras,&blocos[j].palavras)<0;
+        linhas+=blocos[j].linhas;
+        invalidas+=blocos[j].invalidas;
+        for(k=0;k<24;k++){
+            partidasHora[k]+=blocos[j].partidasHora[k];
+            vitoriasHora[k]+=blocos[j].vitoriasHora[k];
+        }
+    }
+    if(erro){
+        printf("Memoria insuficiente para a analise.\n");
+        liberarBlocos(blocos,threads);
+        if(blocos!=&unico)  free(blocos);
+        munmap((void *)dados,st.st_size);
+        return 1;
+    }
+    jogadores=blocos[0].jogadores;
+    palavras=blocos[0].palavras;
+    t1=relogioNs();
+    for(k=0;k<24;k++){
+        partidas+=partidasHora[k];
+        vitorias+=vitoriasHora[k];
+        if(partidasHora[k]>maiorHora)   maiorHora=partidasHora[k];
+    }
+
+    printf("\n=== Resultados: %s ===\n\n",nomeArquivo);
+    printf("Partidas: %llu  (%.1f%% vitorias)  |  Jogadores: %zu  |  Palavras: %zu  |  Linhas invalidas: %llu\n",
+           (unsigned long long)partidas,partidas?100.0*vitorias/partidas:0.0,jogadores.usados,palavras.usados,(unsigned long long)invalidas);
+
+    printf("\nJogadores mais ativos:\n");
+    lista=listarTabela(&jogadores);
+    n=jogadores.usados;
+    qsort(lista,n,sizeof(Contagem),compararPartidas);
+    for(i=0;i<n&&i<ANALISE_TOP;i++) imprimirContagem(i+1,&lista[i]);
+    free(lista);
+
+    printf("\nPalavras mais sorteadas:\n");
+    lista=listarTabela(&palavras);
+    n=palavras.usados;
+    qsort(lista,n,sizeof(Contagem),compararPartidas);
+    for(i=0;i<n&&i<ANALISE_TOP;i++) imprimirContagem(i+1,&lista[i]);
+
+    printf("\nPalavras mais dificeis (minimo de %d partidas):\n",ANALISE_MIN_PARTIDAS);
+    // Descarta as palavras com poucas partidas antes de ordenar pela taxa de vitorias.
+    for(i=0,k=0;i<n;i++)
+        if(lista[i].partidas>=ANALISE_MIN_PARTIDAS) lista[k++]=lista[i];
+    qsort(lista,k,sizeof(Contagem),compararDificuldade);
+    for(i=0;i<k&&i<ANALISE_TOP;i++) imprimirContagem(i+1,&lista[i]);
+    free(lista);
+
+    printf("\nAtividade por hora:\n");
+    for(k=0;k<24;k++){
+        printf("  %02zuh %10llu  %5.1f%%  ",k,(unsigned long long)partidasHora[k],partidasHora[k]?100.0*vitoriasHora[k]/partidasHora[k]:0.0);
+        for(j=0;j<(int)(40*partidasHora[k]/maiorHora);j++) putchar('#');
+        putchar('\n');
+    }
+
+    printf("\nLeitura: %.2f MB, %llu linhas em %.3f s com %d thread(s) (%.2f GB/s)\n\n",st.st_size/1e6,
+           (unsigned long long)linhas,(t1-t0)/1e9,threads,st.st_size/((t1-t0)/1e9)/1e9);
+    liberarBlocos(blocos,threads);
+    if(blocos!=&unico)  free(blocos);
+    munmap((void *)dados,st.st_size);
+    return 0;
+}
+
+#else
+
+/**
+ * @brief Analise indisponivel no Windows (requer mmap e pthreads).
+ */
+int analisarResultados (const char *nomeArquivo, int threads){
+    (void)nomeArquivo;
+    (void)threads;
+    printf("A analise de resultados requer um sistema POSIX.\n");
+    return 1;
+}
+
+#endif
\ No newline at end of file
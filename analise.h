@@ -0,0 +1,31 @@
+/**
+ * @file analise.h
+ * @brief Arquivo de cabecalho da analise do arquivo de resultados.
+ *
+ * O arquivo de resultados e mapeado em memoria, dividido em blocos
+ * alinhados em quebras de linha e processado em paralelo. Cada thread
+ * agrega em tabelas hash proprias, que sao combinadas no final.
+ */
+
+#ifndef ANALISE_H
+#define ANALISE_H
+
+// Quantidade de linhas exibidas em cada ranking do relatorio.
+#define ANALISE_TOP 10
+// Minimo de partidas para uma palavra entrar no ranking de dificuldade.
+#define ANALISE_MIN_PARTIDAS 5
+
+/**
+ * @brief Analisa o arquivo de resultados e imprime o relatorio.
+ *
+ * O relatorio traz a taxa de vitorias por jogador e por palavra, as
+ * palavras mais dificeis, a atividade por hora do dia e a vazao da
+ * leitura.
+ *
+ * @param nomeArquivo O arquivo de resultados.
+ * @param threads O numero de threads (0 = uma por nucleo).
+ * @return 0 em caso de sucesso, 1 em caso de erro.
+ */
+int analisarResultados (const char *nomeArquivo, int threads);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,85 @@
+/**
+ * @file arena.c
+ * @brief Implementacao do alocador de objetos de tamanho fixo.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+/**
+ * @brief Inicia uma arena vazia.
+ * @param a A arena.
+ * @param tamObjeto O tamanho de cada objeto (no minimo 4 bytes).
+ */
+void iniciarArena (Arena *a, size_t tamObjeto){
+    memset(a,0,sizeof(*a));
+    // O objeto liberado guarda o numero do proximo da lista.
+    a->tamObjeto=tamObjeto<sizeof(uint32_t)?sizeof(uint32_t):tamObjeto;
+}
+
+/**
+ * @brief Libera todas as placas de uma arena.
+ * @param a A arena.
+ */
+void destruirArena (Arena *a){
+    uint32_t i;
+    for(i=0;i<a->numPlacas;i++) free(a->placas[i]);
+    free(a->placas);
+    memset(a,0,sizeof(*a));
+}
+
+/**
+ * @brief Acrescenta uma placa a arena.
+ *
+ * A placa e alocada de uma vez, mas as paginas so passam a ocupar
+ * memoria quando os objetos sao usados pela primeira vez.
+ *
+ * @param a A arena.
+ * @return 0 em caso de sucesso, -1 se nao houver memoria.
+ */
+static int crescerArena (Arena *a){
+    char **placas,*placa;
+    if(a->numPlacas==a->capPlacas){
+        uint32_t capacidade=a->capPlacas?a->capPlacas*2:16;
+        placas=realloc(a->placas,capacidade*sizeof(char *));
+        if(placas==NULL)    return -1;
+        a->placas=placas;
+        a->capPlacas=capacidade;
+    }
+    placa=malloc((size_t)OBJETOS_POR_PLACA*a->tamObjeto);
+    if(placa==NULL) return -1;
+    a->placas[a->numPlacas++]=placa;
+    return 0;
+}
+
+/**
+ * @brief Reserva um objeto, reaproveitando um liberado se houver.
+ * @param a A arena.
+ * @return O numero do objeto, ou 0 se nao houver memoria.
+ */
+uint32_t alocarArena (Arena *a){
+    uint32_t id=a->livre;
+    if(id!=0){
+        memcpy(&a->livre,enderecoArena(a,id),sizeof(uint32_t));
+        a->emUso++;
+        return id;
+    }
+    // Lista vazia: usa a proxima posicao, abrindo uma placa se preciso.
+    if(a->proximo==UINT32_MAX)  return 0;
+    if(a->proximo==(uint64_t)a->numPlacas*OBJETOS_POR_PLACA&&crescerArena(a)<0)  return 0;
+    a->emUso++;
+    return ++a->proximo;
+}
+
+/**
+ * @brief Devolve um objeto a arena.
+ * @param a A arena.
+ * @param id O numero do objeto (0 e ignorado).
+ */
+void liberarArena (Arena *a, uint32_t id){
+    if(id==0)   return;
+    memcpy(enderecoArena(a,id),&a->livre,sizeof(uint32_t));
+    a->livre=id;
+    a->emUso--;
+}
\ No newline at end of file
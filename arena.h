@@ -0,0 +1,85 @@
+/**
+ * @file arena.h
+ * @brief Arquivo de cabecalho do alocador de objetos de tamanho fixo.
+ *
+ * Os objetos ficam em placas de OBJETOS_POR_PLACA posicoes, alocadas sob
+ * demanda e nunca movidas, e sao identificados por um numero de 32 bits
+ * (0 indica nenhum objeto) em vez de um ponteiro. Os objetos liberados
+ * formam uma lista encadeada pelos seus proprios primeiros bytes e sao
+ * reaproveitados antes de qualquer posicao nova, de modo que milhoes de
+ * objetos pequenos nao pagam o cabecalho nem a fragmentacao do malloc.
+ *
+ * Uma arena nao e protegida contra uso simultaneo: cada thread deve ter
+ * a sua (no servidor, uma por thread de trabalho).
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Numero de objetos de cada placa (potencia de 2).
+#define BITS_PLACA 16
+#define OBJETOS_POR_PLACA (1u<<BITS_PLACA)
+
+/**
+ * @struct Arena
+ * @brief Conjunto de placas de objetos de um mesmo tamanho.
+ */
+typedef struct{
+    char **placas;          // Placas alocadas, cada uma com OBJETOS_POR_PLACA objetos.
+    uint32_t numPlacas;     // Placas em uso.
+    uint32_t capPlacas;     // Capacidade do vetor placas.
+    size_t tamObjeto;       // Tamanho de cada objeto, em bytes.
+    uint32_t livre;         // Primeiro objeto da lista de liberados (0 = vazia).
+    uint32_t proximo;       // Proximo objeto nunca usado.
+    uint32_t emUso;         // Objetos alocados e ainda nao liberados.
+} Arena;
+
+/**
+ * @brief Inicia uma arena vazia.
+ * @param a A arena.
+ * @param tamObjeto O tamanho de cada objeto (no minimo 4 bytes).
+ */
+void iniciarArena (Arena *a, size_t tamObjeto);
+
+/**
+ * @brief Libera todas as placas de uma arena.
+ * @param a A arena.
+ */
+void destruirArena (Arena *a);
+
+/**
+ * @brief Reserva um objeto, reaproveitando um liberado se houver.
+ *
+ * O conteudo do objeto e indefinido.
+ *
+ * @param a A arena.
+ * @return O numero do objeto, ou 0 se nao houver memoria.
+ */
+uint32_t alocarArena (Arena *a);
+
+/**
+ * @brief Devolve um objeto a arena.
+ * @param a A arena.
+ * @param id O numero do objeto (0 e ignorado).
+ */
+void liberarArena (Arena *a, uint32_t id);
+
+/**
+ * @brief Retorna o endereco de um objeto.
+ *
+ * O endereco continua valido enquanto o objeto nao for liberado, mesmo
+ * que a arena cresca.
+ *
+ * @param a A arena.
+ * @param id O numero do objeto (diferente de 0).
+ * @return O endereco do objeto.
+ */
+static inline void *enderecoArena (const Arena *a, uint32_t id){
+    uint32_t i=id-1;
+    return a->placas[i>>BITS_PLACA]+(size_t)(i&(OBJETOS_POR_PLACA-1))*a->tamObjeto;
+}
+
+#endif
\ No newline at end of file
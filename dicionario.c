@@ -0,0 +1,349 @@
+/**
+ * @file dicionario.c
+ * @brief Implementacao do banco de palavras indexado.
+ *
+ * O arquivo e mapeado em memoria (ou lido de uma vez no Windows, ou
+ * copiado, com lerDicionario) e percorrido uma unica vez para montar a
+ * tabela de deslocamentos. O banco embutido e o dicionario binario ja
+ * trazem as tabelas prontas; as do binario sao conferidas em uma passada.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "forca.h"
+#include "dicionario.h"
+// Inclusoes para o mapeamento do arquivo em memoria.
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+// Banco gerado por ferramentas/gerar_palavras.c a partir de palavras.txt.
+#ifdef FORCA_PALAVRAS_EMBUTIDAS
+    #include "palavras_embutidas.h"
+#endif
+
+// Dicionario compartilhado usado por contarPalavras/carregarPalavras.
+static Dicionario dicionarioPadrao;
+static int dicionarioPadraoAberto=0;
+
+/**
+ * @brief Carrega o conteudo bruto do arquivo em memoria.
+ *
+ * Em sistemas POSIX o arquivo e mapeado somente para leitura, a menos
+ * que se peca uma copia; no Windows ele e sempre lido por inteiro com
+ * um unico fread.
+ *
+ * @param d O dicionario que recebera os dados.
+ * @param nomeArquivo O nome do arquivo.
+ * @param mapear 1 para mapear o arquivo, 0 para copia-lo.
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+static int carregarDados (Dicionario *d, const char *nomeArquivo, int mapear){
+#ifdef _WIN32
+    long n;
+    char *buffer;
+    FILE *arq = fopen(nomeArquivo,"rb");
+    if(arq==NULL)   return -1;
+    fseek(arq,0,SEEK_END);
+    n=ftell(arq);
+    fseek(arq,0,SEEK_SET);
+    buffer=malloc(n>0?n:1);
+    if(buffer==NULL||fread(buffer,1,n,arq)!=(size_t)n){
+        free(buffer);
+        fclose(arq);
+        return -1;
+    }
+    fclose(arq);
+    (void)mapear;
+    d->dados=buffer;
+    d->tamanhoDados=n;
+    d->mapeado=0;
+#else
+    struct stat st;
+    void *mapa;
+    char *buffer;
+    ssize_t lidos;
+    int fd = open(nomeArquivo,O_RDONLY);
+    if(fd<0)    return -1;
+    if(fstat(fd,&st)<0){
+        close(fd);
+        return -1;
+    }
+    d->tamanhoDados=st.st_size;
+    // mmap nao aceita tamanho zero: um arquivo vazio e copiado (e vira um dicionario vazio).
+    if(!mapear||st.st_size==0){
+        buffer=malloc(st.st_size>0?st.st_size:1);
+        d->dados=buffer;
+        d->tamanhoDados=0;
+        d->mapeado=0;
+        // Se o arquivo encolher durante a leitura, fica o que foi lido.
+        while(buffer!=NULL&&d->tamanhoDados<(size_t)st.st_size){
+            lidos=read(fd,buffer+d->tamanhoDados,st.st_size-d->tamanhoDados);
+            if(lidos<0&&errno==EINTR)   continue;
+            if(lidos<=0)    break;
+            d->tamanhoDados+=lidos;
+        }
+        close(fd);
+        if(buffer==NULL)    return -1;
+    }
+    else{
+        mapa=mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+        // O descritor pode ser fechado: o mapeamento continua valido.
+        close(fd);
+        if(mapa==MAP_FAILED)    return -1;
+        madvise(mapa,st.st_size,MADV_SEQUENTIAL);
+        d->dados=mapa;
+        d->mapeado=1;
+    }
+#endif
+    // O indice usa deslocamentos de 32 bits.
+    if(d->tamanhoDados>UINT32_MAX){
+        fecharDicionario(d);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Valida um dicionario binario e aponta as tabelas para dentro dos dados.
+ *
+ * Uma unica passada confere cada palavra: ela precisa estar dentro do
+ * texto, ter entre 1 e TAM_MAX_MASCARA letras, todas de A a Z, e a sua
+ * entrada em letras precisa ser exatamente o conjunto dessas letras (a
+ * sessao usa essa tabela para recusar letras sem olhar a palavra).
+ *
+ * @param d O dicionario, com dados e tamanhoDados preenchidos.
+ * @return 0 em caso de sucesso, -1 se o arquivo for invalido.
+ */
+static int validarBinario (Dicionario *d){
+    CabecalhoDicionario c;
+    const unsigned char *p;
+    uint64_t tabelas;
+    uint32_t i,letras;
+    int j;
+    memcpy(&c,d->dados,sizeof(c));
+    d->binario=1;
+    tabelas=sizeof(c)+(uint64_t)c.quantidade*(2*sizeof(uint32_t)+sizeof(uint8_t));
+    if(c.versao!=VERSAO_DICIONARIO||c.tamanho!=d->tamanhoDados||c.quantidade>INT32_MAX||
+       tabelas>c.inicioTexto||c.inicioTexto>d->tamanhoDados){
+        fecharDicionario(d);
+        return -1;
+    }
+    d->inicio=(const uint32_t *)(d->dados+sizeof(c));
+    d->letras=d->inicio+c.quantidade;
+    d->tamanho=(const uint8_t *)(d->letras+c.quantidade);
+    for(i=0;i<c.quantidade;i++){
+        if(d->tamanho[i]==0||d->tamanho[i]>TAM_MAX_MASCARA||d->inicio[i]<c.inicioTexto||
+           d->inicio[i]+(uint64_t)d->tamanho[i]>d->tamanhoDados){
+            fecharDicionario(d);
+            return -1;
+        }
+        p=(const unsigned char *)d->dados+d->inicio[i];
+        letras=0;
+        for(j=0;j<d->tamanho[i];j++){
+            if(p[j]<'A'||p[j]>'Z')  break;
+            letras|=1u<<(p[j]-'A');
+        }
+        if(j<d->tamanho[i]||letras!=d->letras[i]){
+            fecharDicionario(d);
+            return -1;
+        }
+    }
+    d->quantidade=(int)c.quantidade;
+#ifndef _WIN32
+    if(d->mapeado)  madvise((void *)d->dados,d->tamanhoDados,MADV_RANDOM);
+#endif
+    return 0;
+}
+
+/**
+ * @brief Constroi o indice de linhas dos dados ja carregados.
+ *
+ * Uma unica passada localiza as quebras de linha com memchr e guarda,
+ * para cada linha nao vazia, o deslocamento e o comprimento da palavra
+ * ja sem os espacos das extremidades (como apararString faria).
+ *
+ * @param d O dicionario, com dados e tamanhoDados preenchidos.
+ * @return 0 em caso de sucesso, -1 em caso de falta de memoria.
+ */
+static int indexarDados (Dicionario *d){
+    size_t pos=0,fim,ini;
+    int capacidade=1024;
+    const char *quebra;
+    uint32_t *inicio;
+    uint8_t *tamanho;
+    // Dicionario binario: as tabelas ja estao no arquivo.
+    if(d->tamanhoDados>=sizeof(CabecalhoDicionario)&&memcmp(d->dados,MAGICA_DICIONARIO,8)==0)
+        return validarBinario(d);
+    inicio=malloc(capacidade*sizeof(uint32_t));
+    tamanho=malloc(capacidade*sizeof(uint8_t));
+    d->inicio=inicio;
+    d->tamanho=tamanho;
+    if(inicio==NULL||tamanho==NULL){
+        fecharDicionario(d);
+        return -1;
+    }
+    while(pos<d->tamanhoDados){
+        // Encontra o fim da linha atual (ou do arquivo).
+        quebra=memchr(d->dados+pos,'\n',d->tamanhoDados-pos);
+        fim=quebra!=NULL?(size_t)(quebra-d->dados):d->tamanhoDados;
+        ini=pos;
+        pos=fim+1;
+        // Apara os espacos (e o '\r' de arquivos do Windows) das extremidades.
+        while(ini<fim&&isspace((unsigned char)d->dados[ini]))   ini++;
+        while(fim>ini&&isspace((unsigned char)d->dados[fim-1])) fim--;
+        if(fim==ini||fim-ini>TAM_MAX_MASCARA)   continue;
+        // Dobra a capacidade do indice quando necessario.
+        if(d->quantidade==capacidade){
+            uint32_t *novoInicio;
+            uint8_t *novoTamanho;
+            capacidade*=2;
+            novoInicio=realloc(inicio,capacidade*sizeof(uint32_t));
+            if(novoInicio!=NULL)    d->inicio=inicio=novoInicio;
+            novoTamanho=realloc(tamanho,capacidade*sizeof(uint8_t));
+            if(novoTamanho!=NULL)   d->tamanho=tamanho=novoTamanho;
+            if(novoInicio==NULL||novoTamanho==NULL){
+                fecharDicionario(d);
+                return -1;
+            }
+        }
+        inicio[d->quantidade]=(uint32_t)ini;
+        tamanho[d->quantidade]=(uint8_t)(fim-ini);
+        d->quantidade++;
+    }
+#ifndef _WIN32
+    // Depois da indexacao o acesso passa a ser aleatorio.
+    if(d->mapeado)  madvise((void *)d->dados,d->tamanhoDados,MADV_RANDOM);
+#endif
+    return 0;
+}
+
+/**
+ * @brief Abre um arquivo de palavras e constroi o indice de linhas.
+ * @param d O dicionario a ser preenchido.
+ * @param nomeArquivo O nome do arquivo de palavras.
+ * @return 0 em caso de sucesso, -1 se o arquivo nao puder ser lido (ou for um dicionario binario invalido).
+ */
+int abrirDicionario (Dicionario *d, const char *nomeArquivo){
+    memset(d,0,sizeof(*d));
+    if(carregarDados(d,nomeArquivo,1)<0)    return -1;
+    return indexarDados(d);
+}
+
+/**
+ * @brief Le uma copia de um arquivo de palavras e constroi o indice de linhas.
+ *
+ * Ao contrario de abrirDicionario, o conteudo e copiado para a memoria
+ * do processo: o dicionario nao muda nem deixa de ser valido se o
+ * arquivo for reescrito ou truncado depois.
+ *
+ * @param d O dicionario a ser preenchido.
+ * @param nomeArquivo O nome do arquivo de palavras.
+ * @return 0 em caso de sucesso, -1 se o arquivo nao puder ser lido.
+ */
+int lerDicionario (Dicionario *d, const char *nomeArquivo){
+    memset(d,0,sizeof(*d));
+    if(carregarDados(d,nomeArquivo,0)<0)    return -1;
+    return indexarDados(d);
+}
+
+/**
+ * @brief Abre o banco de palavras embutido no executavel.
+ *
+ * As tabelas sao constantes do programa: o dicionario apenas aponta
+ * para elas, e fecharDicionario nao libera nada.
+ *
+ * @param d O dicionario a ser preenchido.
+ * @return 0 em caso de sucesso, -1 se o executavel foi compilado sem -DFORCA_PALAVRAS_EMBUTIDAS.
+ */
+int abrirDicionarioEmbutido (Dicionario *d){
+    memset(d,0,sizeof(*d));
+#ifdef FORCA_PALAVRAS_EMBUTIDAS
+    d->dados=dadosEmbutidos;
+    d->tamanhoDados=sizeof(dadosEmbutidos)-1;
+    d->inicio=inicioEmbutidos;
+    d->tamanho=tamanhoEmbutidos;
+    d->letras=letrasEmbutidas;
+    d->quantidade=QUANTIDADE_EMBUTIDAS;
+    d->embutido=1;
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+/**
+ * @brief Libera a memoria e o mapeamento de um dicionario.
+ * @param d O dicionario a ser fechado.
+ */
+void fecharDicionario (Dicionario *d){
+    if(d->embutido){
+        memset(d,0,sizeof(*d));
+        return;
+    }
+#ifndef _WIN32
+    if(d->mapeado)  munmap((void *)d->dados,d->tamanhoDados);
+    else
+#endif
+    free((void *)d->dados);
+    // As tabelas de um dicionario binario estao dentro dos dados.
+    if(!d->binario){
+        free((void *)d->inicio);
+        free((void *)d->tamanho);
+    }
+    memset(d,0,sizeof(*d));
+}
+
+/**
+ * @brief Retorna a palavra de indice informado, sem copia.
+ * @param d O dicionario.
+ * @param indice O indice da palavra (0 a quantidade-1).
+ * @param tamanho Recebe o comprimento da palavra.
+ * @return Ponteiro para o inicio da palavra (nao terminada em '\0').
+ */
+const char *obterPalavra (const Dicionario *d, int indice, int *tamanho){
+    *tamanho=d->tamanho[indice];
+    return d->dados+d->inicio[indice];
+}
+
+/**
+ * @brief Sorteia uma palavra do dicionario em tempo constante, sem copia.
+ * @param d O dicionario.
+ * @param a O gerador usado no sorteio.
+ * @param tamanho Recebe o comprimento da palavra.
+ * @return Ponteiro para o inicio da palavra (nao terminada em '\0').
+ */
+const char *sortearPalavra (const Dicionario *d, Aleatorio *a, int *tamanho){
+    return obterPalavra(d,(int)sortearIntervalo(a,(uint32_t)d->quantidade),tamanho);
+}
+
+/**
+ * @brief Retorna o dicionario compartilhado do processo, abrindo-o na primeira chamada.
+ *
+ * Deve ser chamada pela primeira vez antes da criacao de threads. O
+ * arquivo tem prioridade sobre o banco embutido, de modo que o banco de
+ * um executavel pode ser trocado sem recompila-lo.
+ *
+ * @param nomeArquivo O nome do arquivo de palavras.
+ * @return Ponteiro para o dicionario, ou NULL se nao houver palavras.
+ */
+Dicionario *obterDicionarioPadrao (const char *nomeArquivo){
+    if(!dicionarioPadraoAberto){
+        if(abrirDicionario(&dicionarioPadrao,nomeArquivo)==0&&dicionarioPadrao.quantidade>0)
+            dicionarioPadraoAberto=1;
+        else{
+            fecharDicionario(&dicionarioPadrao);
+            // Sem o arquivo, usa o banco embutido (se o executavel tiver um).
+            if(abrirDicionarioEmbutido(&dicionarioPadrao)<0)    return NULL;
+            dicionarioPadraoAberto=1;
+        }
+    }
+    return &dicionarioPadrao;
+}
\ No newline at end of file
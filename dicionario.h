@@ -0,0 +1,144 @@
+/**
+ * @file dicionario.h
+ * @brief Arquivo de cabecalho do banco de palavras indexado.
+ *
+ * O arquivo de palavras e lido (mapeado em memoria) uma unica vez e
+ * recebe um indice de deslocamentos por linha, de modo que o sorteio
+ * de uma palavra custa O(1) e nao copia nada.
+ *
+ * Compilado com -DFORCA_PALAVRAS_EMBUTIDAS, o executavel tambem traz o
+ * banco gerado por ferramentas/gerar_palavras.c (palavras_embutidas.h),
+ * ja indexado e com as letras de cada palavra: abri-lo nao le nenhum
+ * arquivo. O arquivo de palavras, quando existe, continua tendo
+ * prioridade (ver obterDicionarioPadrao).
+ *
+ * O arquivo de palavras tambem pode ser um dicionario binario, gerado por
+ * ferramentas/montar_dicionario.c e reconhecido pela MAGICA_DICIONARIO no
+ * inicio: as tabelas ja estao no arquivo e sao usadas direto do
+ * mapeamento, sem indexar nenhuma linha; a abertura so confere, em uma
+ * passada, os limites, as letras e a tabela de letras de cada palavra.
+ * Formato (inteiros na ordem de bytes da maquina que gravou):
+ *
+ *   CabecalhoDicionario
+ *   uint32_t inicio[quantidade]    deslocamento de cada palavra no arquivo
+ *   uint32_t letras[quantidade]    letras de cada palavra (bit 0 = A)
+ *   uint8_t tamanho[quantidade]    comprimento de cada palavra
+ *   texto                          as palavras (A a Z), cada uma seguida de '\n'
+ */
+
+#ifndef DICIONARIO_H
+#define DICIONARIO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "aleatorio.h"
+
+// Identificacao e versao do dicionario binario.
+#define MAGICA_DICIONARIO "FORCADIC"
+#define VERSAO_DICIONARIO 1
+
+/**
+ * @struct CabecalhoDicionario
+ * @brief Inicio de um dicionario binario.
+ */
+typedef struct{
+    char magica[8];             // MAGICA_DICIONARIO (sem '\0').
+    uint32_t versao;            // VERSAO_DICIONARIO.
+    uint32_t quantidade;        // Palavras no arquivo.
+    uint32_t inicioTexto;       // Posicao do texto das palavras no arquivo.
+    uint32_t tamanho;           // Tamanho total do arquivo (detecta gravacoes truncadas).
+    uint32_t reservado[2];
+} CabecalhoDicionario;
+
+/**
+ * @struct Dicionario
+ * @brief Banco de palavras carregado em memoria com indice por linha.
+ *
+ * As palavras nao sao terminadas em '\0': cada uma e descrita pelo seu
+ * deslocamento dentro de dados e pelo seu comprimento ja aparado.
+ */
+typedef struct{
+    const char *dados;      // Conteudo bruto do arquivo (mapeado ou alocado).
+    size_t tamanhoDados;    // Tamanho do conteudo em bytes.
+    const uint32_t *inicio; // Deslocamento do inicio de cada palavra em dados.
+    const uint8_t *tamanho; // Comprimento de cada palavra, sem espacos.
+    const uint32_t *letras; // Letras de cada palavra (bit 0 = A), ou NULL se nao calculadas.
+    int quantidade;         // Numero de palavras indexadas.
+    int mapeado;            // 1 se dados veio de mmap, 0 se foi alocado.
+    int embutido;           // 1 se as tabelas sao as embutidas no executavel.
+    int binario;            // 1 se as tabelas estao dentro de dados (dicionario binario).
+} Dicionario;
+
+/**
+ * @brief Abre um arquivo de palavras e constroi o indice de linhas.
+ *
+ * Linhas vazias (ou so com espacos) e palavras maiores que
+ * TAM_MAX_MASCARA caracteres sao ignoradas. Um dicionario binario e
+ * apenas validado.
+ *
+ * @param d O dicionario a ser preenchido.
+ * @param nomeArquivo O nome do arquivo de palavras.
+ * @return 0 em caso de sucesso, -1 se o arquivo nao puder ser lido (ou for um dicionario binario invalido).
+ */
+int abrirDicionario (Dicionario *d, const char *nomeArquivo);
+
+/**
+ * @brief Le uma copia de um arquivo de palavras e constroi o indice de linhas.
+ *
+ * Igual a abrirDicionario, mas sem mapear o arquivo: o dicionario
+ * continua valido mesmo que o arquivo seja reescrito ou truncado
+ * depois (ver recarga.h).
+ *
+ * @param d O dicionario a ser preenchido.
+ * @param nomeArquivo O nome do arquivo de palavras.
+ * @return 0 em caso de sucesso, -1 se o arquivo nao puder ser lido.
+ */
+int lerDicionario (Dicionario *d, const char *nomeArquivo);
+
+/**
+ * @brief Abre o banco de palavras embutido no executavel.
+ *
+ * Nao le nenhum arquivo nem aloca memoria: as tabelas sao as geradas
+ * por ferramentas/gerar_palavras.c.
+ *
+ * @param d O dicionario a ser preenchido.
+ * @return 0 em caso de sucesso, -1 se o executavel foi compilado sem -DFORCA_PALAVRAS_EMBUTIDAS.
+ */
+int abrirDicionarioEmbutido (Dicionario *d);
+
+/**
+ * @brief Libera a memoria e o mapeamento de um dicionario.
+ * @param d O dicionario a ser fechado.
+ */
+void fecharDicionario (Dicionario *d);
+
+/**
+ * @brief Retorna a palavra de indice informado, sem copia.
+ * @param d O dicionario.
+ * @param indice O indice da palavra (0 a quantidade-1).
+ * @param tamanho Recebe o comprimento da palavra.
+ * @return Ponteiro para o inicio da palavra (nao terminada em '\0').
+ */
+const char *obterPalavra (const Dicionario *d, int indice, int *tamanho);
+
+/**
+ * @brief Sorteia uma palavra do dicionario em tempo constante, sem copia.
+ * @param d O dicionario.
+ * @param a O gerador usado no sorteio.
+ * @param tamanho Recebe o comprimento da palavra.
+ * @return Ponteiro para o inicio da palavra (nao terminada em '\0').
+ */
+const char *sortearPalavra (const Dicionario *d, Aleatorio *a, int *tamanho);
+
+/**
+ * @brief Retorna o dicionario compartilhado do processo, abrindo-o na primeira chamada.
+ *
+ * Se o arquivo nao existir (ou nao tiver palavras), usa o banco embutido,
+ * quando houver.
+ *
+ * @param nomeArquivo O nome do arquivo de palavras.
+ * @return Ponteiro para o dicionario, ou NULL se nao houver palavras.
+ */
+Dicionario *obterDicionarioPadrao (const char *nomeArquivo);
+
+#endif
\ No newline at end of file
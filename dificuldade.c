@@ -0,0 +1,252 @@
+/**
+ * @file dificuldade.c
+ * @brief Implementacao do indice de palavras por dificuldade.
+ *
+ * A raridade de uma letra e a sua informacao em bits, log2(palavras /
+ * palavras com a letra), em ponto fixo com 4 bits de fracao e sem
+ * biblioteca de matematica. Como as pontuacoes sao inteiros pequenos,
+ * os limites dos niveis saem de um histograma e a ordenacao por (nivel,
+ * comprimento) e uma contagem, ambas lineares no numero de palavras.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "forca.h"
+#include "dificuldade.h"
+#include "metricas.h"
+
+// Bits de fracao da raridade das letras.
+#define FRACAO_RARIDADE 4
+// Maior raridade possivel de uma letra (log2 de ate 2^31 palavras).
+#define MAX_RARIDADE (32<<FRACAO_RARIDADE)
+// Pontuacoes possiveis (uma palavra tem no maximo TAM_ALFABETO letras distintas).
+#define TAM_HISTOGRAMA (TAM_ALFABETO*MAX_RARIDADE)
+
+/**
+ * @brief Calcula log2 em ponto fixo, com FRACAO_RARIDADE bits de fracao.
+ *
+ * A parte inteira e a posicao do bit mais alto; a fracao sao os bits
+ * seguintes, uma aproximacao linear entre potencias de 2.
+ *
+ * @param x O valor (maior que 0).
+ * @return log2(x) multiplicado por 2^FRACAO_RARIDADE.
+ */
+static int log2Fixo (uint32_t x){
+    int expoente=31-__builtin_clz(x);
+    uint32_t fracao=(uint32_t)(((uint64_t)x<<(32-expoente))>>(32-FRACAO_RARIDADE))&((1u<<FRACAO_RARIDADE)-1);
+    return (expoente<<FRACAO_RARIDADE)+(int)fracao;
+}
+
+/**
+ * @brief Calcula o conjunto de letras de uma palavra (bit 0 = A).
+ * @param palavra A palavra.
+ * @param tamanho O comprimento da palavra.
+ * @return O conjunto de letras.
+ */
+static uint32_t letrasDaPalavra (const char *palavra, int tamanho){
+    uint32_t letras=0;
+    int i,c;
+    for(i=0;i<tamanho;i++){
+        c=toupper((unsigned char)palavra[i])-'A';
+        if(c>=0&&c<TAM_ALFABETO)    letras|=1u<<c;
+    }
+    return letras;
+}
+
+/**
+ * @brief Soma a raridade de cada letra de um conjunto.
+ * @param x O indice.
+ * @param letras O conjunto de letras.
+ * @return A pontuacao.
+ */
+static int pontuarLetras (const IndiceDificuldade *x, uint32_t letras){
+    int pontuacao=0;
+    for(;letras!=0;letras&=letras-1)    pontuacao+=x->raridade[__builtin_ctz(letras)];
+    return pontuacao;
+}
+
+/**
+ * @brief Pontua as palavras de um dicionario e monta o indice.
+ *
+ * Uma passada calcula as letras de cada palavra (ou usa as do banco
+ * embutido ou binario) e a presenca de cada letra; a segunda pontua as palavras e
+ * monta o histograma; a terceira distribui os indices por (nivel,
+ * comprimento).
+ *
+ * @param x O indice.
+ * @param d O dicionario (deve permanecer aberto enquanto o indice for usado).
+ * @return 0 em caso de sucesso, -1 em caso de falta de memoria.
+ */
+int criarIndiceDificuldade (IndiceDificuldade *x, const Dicionario *d){
+    int i,c,k,n,acumulado,presenca[TAM_ALFABETO]={0},posicao[NIVEIS_DIFICULDADE*(TAM_MAX_MASCARA+1)];
+    uint32_t *letras = malloc((d->quantidade>0?d->quantidade:1)*sizeof(uint32_t));
+    uint16_t *pontuacoes = malloc((d->quantidade>0?d->quantidade:1)*sizeof(uint16_t));
+    int *histograma = calloc(TAM_HISTOGRAMA,sizeof(int));
+    const char *palavra;
+    memset(x,0,sizeof(*x));
+    x->dicionario=d;
+    x->ordem=malloc((d->quantidade>0?d->quantidade:1)*sizeof(int));
+    if(letras==NULL||pontuacoes==NULL||histograma==NULL||x->ordem==NULL){
+        free(letras);
+        free(pontuacoes);
+        free(histograma);
+        destruirIndiceDificuldade(x);
+        return -1;
+    }
+    for(i=0;i<d->quantidade;i++){
+        if(d->letras!=NULL) letras[i]=d->letras[i];
+        else{
+            palavra=obterPalavra(d,i,&n);
+            letras[i]=letrasDaPalavra(palavra,n);
+        }
+        for(c=0;c<TAM_ALFABETO;c++) presenca[c]+=(letras[i]>>c)&1;
+    }
+    // Raridade: bits de informacao de saber que a palavra tem a letra.
+    for(c=0;c<TAM_ALFABETO;c++)
+        x->raridade[c]=presenca[c]>0?log2Fixo((uint32_t)d->quantidade)-log2Fixo((uint32_t)presenca[c]):0;
+    for(i=0;i<d->quantidade;i++){
+        pontuacoes[i]=(uint16_t)pontuarLetras(x,letras[i]);
+        histograma[pontuacoes[i]]++;
+    }
+    // Limites dos niveis: as pontuacoes que dividem o dicionario em partes iguais.
+    for(i=0,k=1,acumulado=0;i<TAM_HISTOGRAMA&&k<NIVEIS_DIFICULDADE;i++){
+        while(k<NIVEIS_DIFICULDADE&&acumulado>=(long long)d->quantidade*k/NIVEIS_DIFICULDADE) x->limites[k++-1]=i;
+        acumulado+=histograma[i];
+    }
+    while(k<NIVEIS_DIFICULDADE) x->limites[k++-1]=TAM_HISTOGRAMA;
+    // Ordenacao por contagem: o inicio de cada (nivel, comprimento) e a soma dos anteriores.
+    for(i=0;i<d->quantidade;i++)
+        x->inicio[nivelDaPontuacao(x,pontuacoes[i])*(TAM_MAX_MASCARA+1)+d->tamanho[i]+1]++;
+    for(k=1;k<=NIVEIS_DIFICULDADE*(TAM_MAX_MASCARA+1);k++)  x->inicio[k]+=x->inicio[k-1];
+    memcpy(posicao,x->inicio,sizeof(posicao));
+    for(i=0;i<d->quantidade;i++)
+        x->ordem[posicao[nivelDaPontuacao(x,pontuacoes[i])*(TAM_MAX_MASCARA+1)+d->tamanho[i]]++]=i;
+    free(letras);
+    free(pontuacoes);
+    free(histograma);
+    return 0;
+}
+
+/**
+ * @brief Libera o indice.
+ * @param x O indice.
+ */
+void destruirIndiceDificuldade (IndiceDificuldade *x){
+    free(x->ordem);
+    memset(x,0,sizeof(*x));
+}
+
+/**
+ * @brief Calcula a pontuacao de dificuldade de uma palavra.
+ * @param x O indice.
+ * @param palavra A palavra.
+ * @param tamanho O comprimento da palavra.
+ * @return A pontuacao (maior e mais dificil).
+ */
+int pontuarPalavra (const IndiceDificuldade *x, const char *palavra, int tamanho){
+    return pontuarLetras(x,letrasDaPalavra(palavra,tamanho));
+}
+
+/**
+ * @brief Retorna o nivel de uma pontuacao.
+ * @param x O indice.
+ * @param pontuacao A pontuacao.
+ * @return O nivel (0 a NIVEIS_DIFICULDADE-1).
+ */
+int nivelDaPontuacao (const IndiceDificuldade *x, int pontuacao){
+    int nivel=0;
+    while(nivel<NIVEIS_DIFICULDADE-1&&pontuacao>=x->limites[nivel])    nivel++;
+    return nivel;
+}
+
+/**
+ * @brief Calcula o trecho de ordem com as palavras de um nivel e de uma faixa de comprimentos.
+ * @param x O indice.
+ * @param minimo O menor comprimento aceito.
+ * @param maximo O maior comprimento aceito.
+ * @param nivel O nivel.
+ * @param fim Recebe o fim do trecho (exclusivo).
+ * @return O inicio do trecho.
+ */
+static int trechoDificuldade (const IndiceDificuldade *x, int minimo, int maximo, int nivel, int *fim){
+    int base=nivel*(TAM_MAX_MASCARA+1);
+    if(nivel<0||nivel>=NIVEIS_DIFICULDADE||minimo>maximo||maximo<0||minimo>TAM_MAX_MASCARA){
+        *fim=0;
+        return 0;
+    }
+    if(minimo<0)    minimo=0;
+    if(maximo>TAM_MAX_MASCARA)  maximo=TAM_MAX_MASCARA;
+    *fim=x->inicio[base+maximo+1];
+    return x->inicio[base+minimo];
+}
+
+/**
+ * @brief Conta as palavras de um nivel com comprimento na faixa informada, em O(1).
+ * @param x O indice.
+ * @param minimo O menor comprimento aceito.
+ * @param maximo O maior comprimento aceito.
+ * @param nivel O nivel (0 a NIVEIS_DIFICULDADE-1), ou -1 para qualquer nivel.
+ * @return O numero de palavras.
+ */
+int contarPorDificuldade (const IndiceDificuldade *x, int minimo, int maximo, int nivel){
+    int fim,inicio,k,total=0;
+    if(nivel>=0){
+        inicio=trechoDificuldade(x,minimo,maximo,nivel,&fim);
+        return fim-inicio;
+    }
+    for(k=0;k<NIVEIS_DIFICULDADE;k++)   total+=contarPorDificuldade(x,minimo,maximo,k);
+    return total;
+}
+
+/**
+ * @brief Sorteia uma palavra de um nivel com comprimento na faixa informada, em O(1).
+ * @param x O indice.
+ * @param a O gerador usado no sorteio.
+ * @param minimo O menor comprimento aceito.
+ * @param maximo O maior comprimento aceito.
+ * @param nivel O nivel (0 a NIVEIS_DIFICULDADE-1), ou -1 para qualquer nivel.
+ * @param tamanho Recebe o comprimento da palavra.
+ * @return Ponteiro para o inicio da palavra (nao terminada em '\0'), ou NULL se nenhuma palavra passa no filtro.
+ */
+const char *sortearPorDificuldade (const IndiceDificuldade *x, Aleatorio *a, int minimo, int maximo, int nivel, int *tamanho){
+    int inicio[NIVEIS_DIFICULDADE],fim[NIVEIS_DIFICULDADE],k,sorteio,pulou,escolhido,total=0;
+    int primeiro=nivel>=0?nivel:0,ultimo=nivel>=0?nivel:NIVEIS_DIFICULDADE-1;
+    for(k=primeiro;k<=ultimo;k++){
+        inicio[k]=trechoDificuldade(x,minimo,maximo,k,&fim[k]);
+        total+=fim[k]-inicio[k];
+    }
+    if(total==0)    return NULL;
+    sorteio=(int)sortearIntervalo(a,(uint32_t)total);
+    // Sem nivel, o sorteio cai no trecho de um dos niveis, na proporcao do seu
+    // tamanho; a escolha e feita sem desvios, que errariam a previsao.
+    for(k=primeiro,escolhido=primeiro,pulou=1;k<ultimo;k++){
+        pulou&=sorteio>=fim[k]-inicio[k];
+        sorteio-=pulou*(fim[k]-inicio[k]);
+        escolhido+=pulou;
+    }
+    return obterPalavra(x->dicionario,x->ordem[inicio[escolhido]+sorteio],tamanho);
+}
+
+/**
+ * @brief Copia uma palavra sorteada com filtro, como carregarPalavras.
+ * @param x O indice.
+ * @param a O gerador usado no sorteio.
+ * @param minimo O menor comprimento aceito.
+ * @param maximo O maior comprimento aceito.
+ * @param nivel O nivel (0 a NIVEIS_DIFICULDADE-1), ou -1 para qualquer nivel.
+ * @param palavra A string que recebera a palavra sorteada.
+ * @return 0 em caso de sucesso, -1 se nenhuma palavra passa no filtro.
+ */
+int carregarPorDificuldade (const IndiceDificuldade *x, Aleatorio *a, int minimo, int maximo, int nivel, char *palavra){
+    const char *origem;
+    int n;
+    MEDICAO(inicio);
+    INICIAR_MEDICAO(inicio);
+    origem=sortearPorDificuldade(x,a,minimo,maximo,nivel,&n);
+    if(origem==NULL)    return -1;
+    memcpy(palavra,origem,n);
+    palavra[n]='\0';
+    ENCERRAR_MEDICAO(FASE_SORTEIO,inicio);
+    return 0;
+}
\ No newline at end of file
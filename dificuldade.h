@@ -0,0 +1,107 @@
+/**
+ * @file dificuldade.h
+ * @brief Arquivo de cabecalho do indice de palavras por dificuldade.
+ *
+ * Cada palavra recebe uma pontuacao: a soma, sobre as suas letras
+ * distintas, da raridade de cada letra no dicionario (quanto menos
+ * palavras tem a letra, mais ela vale). Assim pesam tanto o numero de
+ * letras distintas quanto a frequencia delas. As pontuacoes sao
+ * divididas em NIVEIS_DIFICULDADE niveis com o mesmo numero de palavras.
+ *
+ * O indice guarda as palavras ordenadas por nivel e, dentro do nivel,
+ * por comprimento, com o inicio de cada par (nivel, comprimento). Uma
+ * faixa de comprimentos de um nivel e entao um trecho contiguo, e o
+ * sorteio de uma palavra com filtro custa O(1), sem varrer nem
+ * descartar palavras. Sem nivel, o sorteio escolhe entre os trechos
+ * dos NIVEIS_DIFICULDADE niveis, na proporcao do tamanho de cada um.
+ */
+
+#ifndef DIFICULDADE_H
+#define DIFICULDADE_H
+
+#include "forca.h"
+#include "dicionario.h"
+#include "aleatorio.h"
+
+// Numero de niveis de dificuldade (0 = facil, 1 = medio, 2 = dificil).
+#define NIVEIS_DIFICULDADE 3
+
+/**
+ * @struct IndiceDificuldade
+ * @brief Palavras do dicionario ordenadas por nivel e por comprimento.
+ */
+typedef struct{
+    const Dicionario *dicionario;
+    int *ordem;     // Indices das palavras, por nivel e depois por comprimento.
+    // Inicio em ordem de cada (nivel, comprimento); a ultima posicao e o total.
+    int inicio[NIVEIS_DIFICULDADE*(TAM_MAX_MASCARA+1)+1];
+    int limites[NIVEIS_DIFICULDADE-1];  // Pontuacao minima de cada nivel a partir do segundo.
+    int raridade[TAM_ALFABETO];         // Quanto cada letra soma a pontuacao.
+} IndiceDificuldade;
+
+/**
+ * @brief Pontua as palavras de um dicionario e monta o indice.
+ * @param x O indice.
+ * @param d O dicionario (deve permanecer aberto enquanto o indice for usado).
+ * @return 0 em caso de sucesso, -1 em caso de falta de memoria.
+ */
+int criarIndiceDificuldade (IndiceDificuldade *x, const Dicionario *d);
+
+/**
+ * @brief Libera o indice.
+ * @param x O indice.
+ */
+void destruirIndiceDificuldade (IndiceDificuldade *x);
+
+/**
+ * @brief Calcula a pontuacao de dificuldade de uma palavra.
+ * @param x O indice.
+ * @param palavra A palavra.
+ * @param tamanho O comprimento da palavra.
+ * @return A pontuacao (maior e mais dificil).
+ */
+int pontuarPalavra (const IndiceDificuldade *x, const char *palavra, int tamanho);
+
+/**
+ * @brief Retorna o nivel de uma pontuacao.
+ * @param x O indice.
+ * @param pontuacao A pontuacao.
+ * @return O nivel (0 a NIVEIS_DIFICULDADE-1).
+ */
+int nivelDaPontuacao (const IndiceDificuldade *x, int pontuacao);
+
+/**
+ * @brief Conta as palavras de um nivel com comprimento na faixa informada, em O(1).
+ * @param x O indice.
+ * @param minimo O menor comprimento aceito.
+ * @param maximo O maior comprimento aceito.
+ * @param nivel O nivel (0 a NIVEIS_DIFICULDADE-1), ou -1 para qualquer nivel.
+ * @return O numero de palavras.
+ */
+int contarPorDificuldade (const IndiceDificuldade *x, int minimo, int maximo, int nivel);
+
+/**
+ * @brief Sorteia uma palavra de um nivel com comprimento na faixa informada, em O(1).
+ * @param x O indice.
+ * @param a O gerador usado no sorteio.
+ * @param minimo O menor comprimento aceito.
+ * @param maximo O maior comprimento aceito.
+ * @param nivel O nivel (0 a NIVEIS_DIFICULDADE-1), ou -1 para qualquer nivel.
+ * @param tamanho Recebe o comprimento da palavra.
+ * @return Ponteiro para o inicio da palavra (nao terminada em '\0'), ou NULL se nenhuma palavra passa no filtro.
+ */
+const char *sortearPorDificuldade (const IndiceDificuldade *x, Aleatorio *a, int minimo, int maximo, int nivel, int *tamanho);
+
+/**
+ * @brief Copia uma palavra sorteada com filtro, como carregarPalavras.
+ * @param x O indice.
+ * @param a O gerador usado no sorteio.
+ * @param minimo O menor comprimento aceito.
+ * @param maximo O maior comprimento aceito.
+ * @param nivel O nivel (0 a NIVEIS_DIFICULDADE-1), ou -1 para qualquer nivel.
+ * @param palavra A string que recebera a palavra sorteada.
+ * @return 0 em caso de sucesso, -1 se nenhuma palavra passa no filtro.
+ */
+int carregarPorDificuldade (const IndiceDificuldade *x, Aleatorio *a, int minimo, int maximo, int nivel, char *palavra);
+
+#endif
\ No newline at end of file
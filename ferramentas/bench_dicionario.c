@@ -0,0 +1,100 @@
+/**
+ * @file bench_dicionario.c
+ * @brief Microbenchmark do sorteio de palavras.
+ *
+ * Gera bancos de palavras sinteticos de tamanhos crescentes e compara
+ * o sorteio pelo indice do dicionario com o metodo antigo, que reabria
+ * o arquivo e lia linha a linha ate a linha sorteada.
+ *
+ * Compilacao: gcc -O2 -pthread -I. ferramentas/bench_dicionario.c forca.c dicionario.c registro.c aleatorio.c perfis.c -o bench_dicionario
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "forca.h"
+#include "dicionario.h"
+
+// Arquivo temporario onde os bancos sinteticos sao gerados.
+#define ARQUIVO_TESTE "/tmp/forca_bench_palavras.txt"
+
+/**
+ * @brief Gera um banco com n palavras aleatorias de 4 a 14 letras.
+ * @param n O numero de palavras.
+ */
+static void gerarBanco (int n){
+    int i,j,t;
+    FILE *arq = fopen(ARQUIVO_TESTE,"w");
+    if(arq==NULL){
+        printf("Erro ao abrir o arquivo: %s\n",ARQUIVO_TESTE);
+        exit(1);
+    }
+    for(i=0;i<n;i++){
+        t=4+rand()%11;
+        for(j=0;j<t;j++)    fputc('A'+rand()%26,arq);
+        fputc('\n',arq);
+    }
+    fclose(arq);
+}
+
+/**
+ * @brief Sorteio antigo: reabre o arquivo e le ate a linha sorteada.
+ * @param palavra A string que recebera a palavra.
+ * @param tamanho O numero de palavras do arquivo.
+ */
+static void sortearAntigo (char *palavra, int tamanho){
+    int linhaAleatoria=rand()%tamanho,i;
+    FILE *arq = fopen(ARQUIVO_TESTE,"r");
+    for(i=0;i<linhaAleatoria+1;i++)
+        fgets(palavra,TAM_MAX_PALAVRA,arq);
+    apararString(palavra);
+    fclose(arq);
+}
+
+int main (){
+    int tamanhos[]={1000,10000,100000,1000000,5000000},i,k,n,repeticoes;
+    char palavra[TAM_MAX_PALAVRA];
+    volatile unsigned long soma=0;
+    long long t0,t1;
+    Dicionario d;
+    Aleatorio a;
+    srand(42);
+    semearAleatorio(&a,42);
+    printf("%10s %12s %16s %16s\n","palavras","indexar(ms)","indice(ns/sort)","antigo(ns/sort)");
+    for(i=0;i<5;i++){
+        gerarBanco(tamanhos[i]);
+        t0=relogioNs();
+        if(abrirDicionario(&d,ARQUIVO_TESTE)<0){
+            printf("Erro ao abrir o arquivo: %s\n",ARQUIVO_TESTE);
+            return 1;
+        }
+        t1=relogioNs();
+        printf("%10d %12.2f",d.quantidade,(t1-t0)/1e6);
+        // Sorteio pelo indice: mesmo trabalho de carregarPalavras, com a copia.
+        repeticoes=2000000;
+        t0=relogioNs();
+        for(k=0;k<repeticoes;k++){
+            const char *p=sortearPalavra(&d,&a,&n);
+            memcpy(palavra,p,n);
+            palavra[n]='\0';
+            soma+=palavra[0];
+        }
+        t1=relogioNs();
+        printf(" %16.1f",(double)(t1-t0)/repeticoes);
+        // O metodo antigo e O(N) por sorteio: limita as repeticoes.
+        if(tamanhos[i]<=100000){
+            repeticoes=tamanhos[i]<=10000?2000:100;
+            t0=relogioNs();
+            for(k=0;k<repeticoes;k++){
+                sortearAntigo(palavra,d.quantidade);
+                soma+=palavra[0];
+            }
+            t1=relogioNs();
+            printf(" %16.1f\n",(double)(t1-t0)/repeticoes);
+        }
+        else    printf(" %16s\n","-");
+        fecharDicionario(&d);
+    }
+    remove(ARQUIVO_TESTE);
+    return 0;
+}
\ No newline at end of file
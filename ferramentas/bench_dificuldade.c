@@ -0,0 +1,149 @@
+/**
+ * @file bench_dificuldade.c
+ * @brief Microbenchmark do sorteio de palavras com filtro de dificuldade e comprimento.
+ *
+ * Monta o indice de dificuldade sobre um arquivo de palavras (ou um banco
+ * sintetico com N palavras de 3 a 16 letras, sorteadas com a frequencia
+ * aproximada do portugues) e mede quantos sorteios por segundo cada
+ * filtro alcanca pelo indice e pelo caminho ingenuo, que sorteia uma
+ * palavra qualquer e a descarta ate que ela passe no filtro.
+ *
+ * Compilacao: gcc -O2 -pthread -I. ferramentas/bench_dificuldade.c dificuldade.c forca.c dicionario.c registro.c aleatorio.c perfis.c -o bench_dificuldade
+ * Uso: ./bench_dificuldade [palavras ou arquivo] [sorteios]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "forca.h"
+#include "dicionario.h"
+#include "dificuldade.h"
+
+// Arquivo temporario onde o banco sintetico e gerado.
+#define ARQUIVO_TESTE "/tmp/forca_bench_dificuldade.txt"
+// Frequencia aproximada (por mil) de cada letra, de A a Z.
+static const int FREQUENCIAS[TAM_ALFABETO]={146,10,39,50,126,10,13,13,62,4,1,28,47,50,107,25,12,65,78,43,46,17,1,2,1,5};
+// Limite de tentativas do caminho ingenuo em cada filtro (filtros raros descartam quase tudo).
+#define MAX_TENTATIVAS 20000000LL
+
+/**
+ * @struct Filtro
+ * @brief Um caso medido: nivel e faixa de comprimentos.
+ */
+typedef struct{
+    const char *nome;
+    int nivel;      // -1 = qualquer nivel.
+    int minimo;
+    int maximo;
+} Filtro;
+
+/**
+ * @brief Gera um banco com n palavras de 3 a 16 letras.
+ * @param n O numero de palavras.
+ * @param a O gerador.
+ */
+static void gerarBanco (int n, Aleatorio *a){
+    int i,j,c,t,total=0,sorteio;
+    FILE *arq = fopen(ARQUIVO_TESTE,"w");
+    if(arq==NULL){
+        printf("Erro ao abrir o arquivo: %s\n",ARQUIVO_TESTE);
+        exit(1);
+    }
+    for(c=0;c<TAM_ALFABETO;c++) total+=FREQUENCIAS[c];
+    for(i=0;i<n;i++){
+        t=3+(int)sortearIntervalo(a,14);
+        for(j=0;j<t;j++){
+            sorteio=(int)sortearIntervalo(a,(uint32_t)total);
+            for(c=0;sorteio>=FREQUENCIAS[c];c++)    sorteio-=FREQUENCIAS[c];
+            fputc('A'+c,arq);
+        }
+        fputc('\n',arq);
+    }
+    fclose(arq);
+}
+
+/**
+ * @brief Confere se uma palavra passa em um filtro (caminho ingenuo).
+ * @param x O indice (para a pontuacao).
+ * @param f O filtro.
+ * @param palavra A palavra.
+ * @param n O comprimento da palavra.
+ * @return 1 se a palavra passa, 0 caso contrario.
+ */
+static int passaNoFiltro (const IndiceDificuldade *x, const Filtro *f, const char *palavra, int n){
+    if(n<f->minimo||n>f->maximo)    return 0;
+    return f->nivel<0||nivelDaPontuacao(x,pontuarPalavra(x,palavra,n))==f->nivel;
+}
+
+int main (int argc, char *argv[]){
+    const char *arquivo=ARQUIVO_TESTE;
+    int palavras=1000000,sorteios=argc>2?atoi(argv[2]):2000000,sintetico=1,i,k,n,disponiveis,nivel;
+    long long inicio,duracao,tentativas;
+    volatile unsigned long soma=0;
+    const char *p;
+    Dicionario d;
+    IndiceDificuldade x;
+    Aleatorio a;
+    Filtro filtros[]={{"sem filtro",-1,0,TAM_MAX_MASCARA},{"facil",0,0,TAM_MAX_MASCARA},
+                      {"dificil",2,0,TAM_MAX_MASCARA},{"4 a 6 letras",-1,4,6},{"facil, 4 a 6 letras",0,4,6},
+                      {"dificil, 12 a 16 letras",2,12,16},{"facil, 14 a 16 letras",0,14,16}};
+    // Um numero e o tamanho do banco sintetico; qualquer outra coisa e um arquivo de palavras.
+    if(argc>1&&(palavras=atoi(argv[1]))<=0){
+        arquivo=argv[1];
+        sintetico=0;
+    }
+    if(sorteios<=0) sorteios=1;
+    semearAleatorio(&a,42);
+    if(sintetico)   gerarBanco(palavras,&a);
+    if(abrirDicionario(&d,arquivo)<0||d.quantidade==0){
+        printf("Erro ao abrir o arquivo: %s\n",arquivo);
+        return 1;
+    }
+    inicio=relogioNs();
+    if(criarIndiceDificuldade(&x,&d)<0){
+        printf("Memoria insuficiente.\n");
+        return 1;
+    }
+    printf("%d palavras; indice montado em %.1f ms (limites dos niveis: %d, %d)\n",d.quantidade,
+           (relogioNs()-inicio)/1e6,x.limites[0],x.limites[1]);
+    for(nivel=0;nivel<NIVEIS_DIFICULDADE;nivel++){
+        p=sortearPorDificuldade(&x,&a,0,TAM_MAX_MASCARA,nivel,&n);
+        printf("  nivel %d: %d palavras, por exemplo %.*s\n",nivel,contarPorDificuldade(&x,0,TAM_MAX_MASCARA,nivel),n,p);
+    }
+    printf("%-26s %10s %16s %16s\n","filtro","palavras","indice (M/s)","descarte (M/s)");
+
+    for(k=0;k<(int)(sizeof(filtros)/sizeof(filtros[0]));k++){
+        disponiveis=contarPorDificuldade(&x,filtros[k].minimo,filtros[k].maximo,filtros[k].nivel);
+        printf("%-26s %10d",filtros[k].nome,disponiveis);
+        if(disponiveis==0){
+            printf("\n");
+            continue;
+        }
+        inicio=relogioNs();
+        for(i=0;i<sorteios;i++){
+            p=sortearPorDificuldade(&x,&a,filtros[k].minimo,filtros[k].maximo,filtros[k].nivel,&n);
+            soma+=(unsigned char)p[0]+n;
+        }
+        duracao=relogioNs()-inicio;
+        printf(" %16.1f",sorteios/(duracao/1e3));
+
+        // Caminho ingenuo: sorteia qualquer palavra e descarta ate uma passar no filtro.
+        inicio=relogioNs();
+        for(i=0,tentativas=0;i<sorteios&&tentativas<MAX_TENTATIVAS;i++){
+            do{
+                p=sortearPalavra(&d,&a,&n);
+                tentativas++;
+            }while(!passaNoFiltro(&x,&filtros[k],p,n));
+            soma+=(unsigned char)p[0]+n;
+        }
+        duracao=relogioNs()-inicio;
+        printf(" %16.3f   (%.1f tentativas por sorteio)\n",i/(duracao/1e3),(double)tentativas/i);
+    }
+    printf("(controle %lu)\n",soma);
+
+    destruirIndiceDificuldade(&x);
+    fecharDicionario(&d);
+    if(sintetico)   remove(ARQUIVO_TESTE);
+    return 0;
+}
\ No newline at end of file
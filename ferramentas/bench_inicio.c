@@ -0,0 +1,145 @@
+/**
+ * @file bench_inicio.c
+ * @brief Microbenchmark do tempo de inicializacao do banco de palavras.
+ *
+ * Mede, dentro do processo, quanto custa ter a primeira palavra sorteada:
+ * abrindo e indexando o arquivo de palavras (abrirDicionario) e abrindo o
+ * banco embutido (abrirDicionarioEmbutido, quando compilado com
+ * -DFORCA_PALAVRAS_EMBUTIDAS). Se um executavel do jogo for informado,
+ * mede tambem o processo inteiro: cada execucao roda "executavel
+ * --rapido" com a entrada vazia, que carrega as palavras e os perfis e
+ * termina na pergunta do nome.
+ *
+ * Compilacao: gcc -O2 -pthread -I. ferramentas/bench_inicio.c forca.c dicionario.c registro.c aleatorio.c perfis.c -o bench_inicio
+ * Com o banco embutido: o mesmo comando com -DFORCA_PALAVRAS_EMBUTIDAS e -o bench_inicio_embutido
+ * Uso: ./bench_inicio [repeticoes] [arquivo de palavras] [executavel do jogo]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "forca.h"
+#include "dicionario.h"
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/wait.h>
+#endif
+
+/**
+ * @brief Compara duas duracoes (para qsort).
+ * @param a A primeira duracao.
+ * @param b A segunda duracao.
+ * @return Negativo, zero ou positivo, como em strcmp.
+ */
+static int compararDuracoes (const void *a, const void *b){
+    long long x=*(const long long *)a,y=*(const long long *)b;
+    return (x>y)-(x<y);
+}
+
+/**
+ * @brief Ordena as duracoes e imprime a mediana e o percentil 99.
+ * @param nome O caso medido.
+ * @param duracoes As duracoes, em ns.
+ * @param n O numero de duracoes.
+ */
+static void relatar (const char *nome, long long *duracoes, int n){
+    qsort(duracoes,n,sizeof(long long),compararDuracoes);
+    printf("%-22s p50 %10.1f us   p99 %10.1f us\n",nome,duracoes[n/2]/1e3,duracoes[(int)(n*0.99)]/1e3);
+}
+
+/**
+ * @brief Sorteia e copia a primeira palavra de um dicionario aberto e o fecha.
+ * @param d O dicionario.
+ * @param a O gerador do sorteio.
+ * @return A soma de controle da palavra sorteada (evita que o sorteio seja descartado).
+ */
+static int sortearPrimeira (Dicionario *d, Aleatorio *a){
+    char palavra[TAM_MAX_PALAVRA];
+    const char *origem;
+    int n;
+    origem=sortearPalavra(d,a,&n);
+    memcpy(palavra,origem,n);
+    palavra[n]='\0';
+    fecharDicionario(d);
+    return palavra[0]+n;
+}
+
+#ifndef _WIN32
+/**
+ * @brief Roda o jogo ate a pergunta do nome e mede a duracao do processo.
+ * @param executavel O executavel do jogo.
+ * @return A duracao, em ns, ou -1 em caso de erro.
+ */
+static long long executarJogo (const char *executavel){
+    long long inicio=relogioNs();
+    int estado,nulo;
+    pid_t pid = fork();
+    if(pid<0)   return -1;
+    if(pid==0){
+        // Entrada vazia: o jogo termina ao pedir o nome; a saida e descartada.
+        nulo=open("/dev/null",O_RDWR);
+        dup2(nulo,0);
+        dup2(nulo,1);
+        execl(executavel,executavel,"--rapido",(char *)NULL);
+        _exit(127);
+    }
+    if(waitpid(pid,&estado,0)<0||!WIFEXITED(estado)||WEXITSTATUS(estado)!=0)   return -1;
+    return relogioNs()-inicio;
+}
+#endif
+
+int main (int argc, char *argv[]){
+    int repeticoes=argc>1?atoi(argv[1]):200,i,controle=0;
+    const char *arquivo=argc>2?argv[2]:ARQUIVO_PALAVRAS,*executavel=argc>3?argv[3]:NULL;
+    long long *duracoes,inicio;
+    Dicionario d;
+    Aleatorio a;
+    if(repeticoes<=0)   repeticoes=1;
+    duracoes=malloc(repeticoes*sizeof(long long));
+    if(duracoes==NULL)  return 1;
+    semearAleatorio(&a,42);
+
+    // Arquivo: mapeamento, indexacao de todas as linhas e o primeiro sorteio.
+    for(i=0;i<repeticoes;i++){
+        inicio=relogioNs();
+        if(abrirDicionario(&d,arquivo)<0||d.quantidade==0){
+            printf("Erro ao abrir o arquivo: %s\n",arquivo);
+            return 1;
+        }
+        controle+=sortearPrimeira(&d,&a);
+        duracoes[i]=relogioNs()-inicio;
+    }
+    relatar("arquivo",duracoes,repeticoes);
+
+    // Banco embutido: as tabelas ja estao no executavel.
+    if(abrirDicionarioEmbutido(&d)<0)   printf("%-22s nao compilado (use -DFORCA_PALAVRAS_EMBUTIDAS)\n","embutido");
+    else{
+        printf("%-22s %d palavras\n","embutido",d.quantidade);
+        fecharDicionario(&d);
+        for(i=0;i<repeticoes;i++){
+            inicio=relogioNs();
+            abrirDicionarioEmbutido(&d);
+            controle+=sortearPrimeira(&d,&a);
+            duracoes[i]=relogioNs()-inicio;
+        }
+        relatar("embutido",duracoes,repeticoes);
+    }
+
+#ifndef _WIN32
+    // Processo inteiro, como o jogo e iniciado num conteiner.
+    if(executavel!=NULL){
+        for(i=0;i<repeticoes;i++){
+            duracoes[i]=executarJogo(executavel);
+            if(duracoes[i]<0){
+                printf("Erro ao executar: %s\n",executavel);
+                return 1;
+            }
+        }
+        relatar("processo",duracoes,repeticoes);
+    }
+#endif
+    printf("(controle %d)\n",controle);
+    free(duracoes);
+    return 0;
+}
\ No newline at end of file
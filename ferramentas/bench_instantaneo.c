@@ -0,0 +1,218 @@
+/**
+ * @file bench_instantaneo.c
+ * @brief Microbenchmark da gravacao e da retomada de instantaneos das partidas.
+ *
+ * Abre N partidas com a SessaoCompacta numa arena (como o servidor), joga
+ * algumas letras em cada uma e mede:
+ *
+ * - a gravacao direta do instantaneo, incluindo o fsync;
+ * - a gravacao em um processo filho criado com fork, como no servidor:
+ *   o tempo em que o pai fica parado (so o fork) e o tempo total do filho;
+ * - a abertura do arquivo (mmap e validacao do indice);
+ * - a retomada de todas as partidas, em ordem aleatoria de chaves: busca
+ *   no indice, conferencia da palavra e copia para uma arena nova.
+ *
+ * As partidas retomadas sao comparadas com as originais.
+ *
+ * Compilacao: gcc -O2 -pthread -I. ferramentas/bench_instantaneo.c instantaneo.c sessao.c arena.c forca.c dicionario.c registro.c aleatorio.c perfis.c -o bench_instantaneo
+ * Uso: ./bench_instantaneo [partidas] [arquivo do instantaneo]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "forca.h"
+#include "dicionario.h"
+#include "sessao.h"
+#include "arena.h"
+#include "instantaneo.h"
+
+// Arquivo temporario com as palavras.
+#define ARQUIVO_TESTE "/tmp/forca_bench_instantaneo.txt"
+// Instantaneo padrao.
+#define ARQUIVO_INSTANTANEO "/tmp/forca_bench_instantaneo.bin"
+// Letras jogadas em cada partida antes da gravacao.
+#define LETRAS_POR_PARTIDA 4
+
+/**
+ * @brief Gera um arquivo com n palavras de 6 a 12 letras.
+ * @param nome O arquivo.
+ * @param n O numero de palavras.
+ * @param a O gerador.
+ */
+static void gerarArquivo (const char *nome, int n, Aleatorio *a){
+    int i,j,t;
+    FILE *arq = fopen(nome,"w");
+    if(arq==NULL){
+        printf("Erro ao abrir o arquivo: %s\n",nome);
+        exit(1);
+    }
+    for(i=0;i<n;i++){
+        t=6+(int)sortearIntervalo(a,7);
+        for(j=0;j<t;j++)    fputc('A'+(int)sortearIntervalo(a,TAM_ALFABETO),arq);
+        fputc('\n',arq);
+    }
+    fclose(arq);
+}
+
+/**
+ * @brief Grava todas as partidas em um instantaneo.
+ * @param nome O arquivo.
+ * @param sessoes A arena das partidas.
+ * @param ids As partidas na arena.
+ * @param chaves As chaves de retomada.
+ * @param n O numero de partidas.
+ * @param d O dicionario.
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+static int gravarTodas (const char *nome, const Arena *sessoes, const uint32_t *ids, const uint64_t *chaves, int n,
+                        const Dicionario *d){
+    GravacaoInstantaneo g;
+    const SessaoCompacta *s;
+    const char *palavra;
+    char jogador[32];
+    int i,tam;
+    if(iniciarGravacao(&g,nome)<0)  return -1;
+    for(i=0;i<n;i++){
+        s=enderecoArena(sessoes,ids[i]);
+        palavra=obterPalavra(d,(int)s->palavra,&tam);
+        snprintf(jogador,sizeof(jogador),"jogador%d",i);
+        gravarPartida(&g,chaves[i],s,jogador,palavra,tam);
+    }
+    return concluirGravacao(&g);
+}
+
+/**
+ * @brief Tamanho de um arquivo.
+ * @param nome O arquivo.
+ * @return O tamanho, em bytes (0 se o arquivo nao existir).
+ */
+static long long tamanhoArquivo (const char *nome){
+    long long n;
+    FILE *arq = fopen(nome,"rb");
+    if(arq==NULL)   return 0;
+    fseek(arq,0,SEEK_END);
+    n=ftell(arq);
+    fclose(arq);
+    return n;
+}
+
+int main (int argc, char *argv[]){
+    int n=argc>1?atoi(argv[1]):1000000,i,j,tam,diferentes=0,status;
+    const char *nome=argc>2?argv[2]:ARQUIVO_INSTANTANEO,*palavra,*jogador,*original;
+    const RegistroInstantaneo *r;
+    const SessaoCompacta *a,*b;
+    long long inicio,pausa,bytes;
+    uint32_t *ids,*retomadas,k;
+    uint64_t *chaves,*ordem,t;
+    Arena sessoes,novas;
+    Instantaneo in;
+    Dicionario d;
+    Aleatorio al;
+    int64_t p;
+    pid_t filho;
+    if(n<=0)    n=1;
+    semearAleatorio(&al,42);
+    gerarArquivo(ARQUIVO_TESTE,100000,&al);
+    if(abrirDicionario(&d,ARQUIVO_TESTE)<0){
+        printf("Erro ao abrir o arquivo: %s\n",ARQUIVO_TESTE);
+        return 1;
+    }
+    ids=malloc(n*sizeof(uint32_t));
+    retomadas=malloc(n*sizeof(uint32_t));
+    chaves=malloc(n*sizeof(uint64_t));
+    ordem=malloc(n*sizeof(uint64_t));
+    if(ids==NULL||retomadas==NULL||chaves==NULL||ordem==NULL){
+        printf("Sem memoria para %d partidas.\n",n);
+        return 1;
+    }
+    iniciarArena(&sessoes,sizeof(SessaoCompacta));
+    iniciarArena(&novas,sizeof(SessaoCompacta));
+    for(i=0;i<n;i++){
+        ids[i]=alocarArena(&sessoes);
+        iniciarSessaoCompacta(enderecoArena(&sessoes,ids[i]),&d,sortearIntervalo(&al,(uint32_t)d.quantidade),(uint32_t)i);
+        for(j=0;j<LETRAS_POR_PARTIDA;j++)
+            chutarLetraCompacta(enderecoArena(&sessoes,ids[i]),&d,'A'+(int)sortearIntervalo(&al,TAM_ALFABETO));
+        chaves[i]=proximoAleatorio(&al)|1;
+        ordem[i]=chaves[i];
+    }
+    printf("%d partidas\n",n);
+
+    inicio=relogioNs();
+    if(gravarTodas(nome,&sessoes,ids,chaves,n,&d)<0){
+        printf("Erro ao gravar o arquivo: %s\n",nome);
+        return 1;
+    }
+    inicio=relogioNs()-inicio;
+    bytes=tamanhoArquivo(nome);
+    printf("gravacao direta:   %8.1f ms  %7.1f MB/s  %5.0f ns por partida  (%.1f MB, %.0f bytes por partida)\n",inicio/1e6,
+           bytes/(inicio/1e3),(double)inicio/n,bytes/1e6,(double)bytes/n);
+
+    // Como no servidor: o pai so espera o fork; o filho grava.
+    inicio=relogioNs();
+    fflush(stdout);
+    filho=fork();
+    if(filho==0)    _exit(gravarTodas(nome,&sessoes,ids,chaves,n,&d)<0);
+    pausa=relogioNs()-inicio;
+    if(filho<0||waitpid(filho,&status,0)!=filho||status!=0){
+        printf("Erro ao gravar o arquivo: %s\n",nome);
+        return 1;
+    }
+    printf("gravacao com fork: %8.2f ms de pausa do pai, %8.1f ms ate o fim do filho\n",pausa/1e6,(relogioNs()-inicio)/1e6);
+
+    inicio=relogioNs();
+    if(abrirInstantaneo(&in,nome)<0){
+        printf("Erro ao abrir o arquivo: %s\n",nome);
+        return 1;
+    }
+    printf("abertura:          %8.2f ms\n",(relogioNs()-inicio)/1e6);
+
+    // Os clientes voltam em qualquer ordem.
+    for(i=n-1;i>0;i--){
+        j=(int)sortearIntervalo(&al,(uint32_t)i+1);
+        t=ordem[i];
+        ordem[i]=ordem[j];
+        ordem[j]=t;
+    }
+    inicio=relogioNs();
+    for(i=0;i<n;i++){
+        if((p=buscarInstantaneo(&in,ordem[i]))<0||(r=lerPartida(&in,(uint64_t)p,&jogador,&palavra))==NULL)   break;
+        original=obterPalavra(&d,(int)r->sessao.palavra,&tam);
+        if(tam!=r->tamPalavra||memcmp(original,palavra,tam)!=0)  break;
+        retomadas[i]=alocarArena(&novas);
+        memcpy(enderecoArena(&novas,retomadas[i]),&r->sessao,sizeof(SessaoCompacta));
+    }
+    inicio=relogioNs()-inicio;
+    if(i<n){
+        printf("Partida %d nao retomada.\n",i);
+        return 1;
+    }
+    printf("retomada:          %8.1f ms  %5.0f ns por partida\n",inicio/1e6,(double)inicio/n);
+
+    // Confere as retomadas: jogador guarda o indice original da partida.
+    for(i=0;i<n;i++){
+        b=enderecoArena(&novas,retomadas[i]);
+        k=b->jogador;
+        if(k>=(uint32_t)n||chaves[k]!=ordem[i]){
+            diferentes++;
+            continue;
+        }
+        a=enderecoArena(&sessoes,ids[k]);
+        if(memcmp(a,b,sizeof(SessaoCompacta))!=0)  diferentes++;
+    }
+    printf("partidas diferentes das originais: %d\n",diferentes);
+
+    fecharInstantaneo(&in);
+    destruirArena(&novas);
+    destruirArena(&sessoes);
+    fecharDicionario(&d);
+    free(ids);
+    free(retomadas);
+    free(chaves);
+    free(ordem);
+    remove(nome);
+    remove(ARQUIVO_TESTE);
+    return diferentes!=0;
+}
\ No newline at end of file
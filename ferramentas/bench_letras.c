@@ -0,0 +1,105 @@
+/**
+ * @file bench_letras.c
+ * @brief Microbenchmark da avaliacao de palpites de letras.
+ *
+ * Compara as funcoes atuais (mascara de letras utilizadas e tabela de
+ * posicoes por palavra) com as versoes anteriores, que usavam um vetor
+ * int letras[27], percorriam a palavra a cada palpite e detectavam a
+ * vitoria com strcasecmp.
+ *
+ * Compilacao: gcc -O2 -pthread -I. ferramentas/bench_letras.c forca.c dicionario.c registro.c aleatorio.c perfis.c -o bench_letras
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include "forca.h"
+
+// Numero de partidas simuladas por palavra e por metodo.
+#define REPETICOES 200000
+// Ordem dos palpites: todas as letras, como numa partida sem limite de vidas.
+#define ORDEM_LETRAS "AEOSRINDMUTCLPVGHQBFZJXKWY"
+
+/**
+ * @brief Versao anterior de verificarLetra, com vetor de inteiros.
+ */
+static int verificarLetraAntiga (char letra, int letras[]){
+    if(letras[toupper(letra)-'A'])    return 1;
+    else    letras[toupper(letra)-'A']=1;
+    return 0;
+}
+
+/**
+ * @brief Versao anterior de testarLetra, que percorria a palavra inteira.
+ */
+static int testarLetraAntiga (char letra, char *palavra, char *palavraNaForca){
+    int count=0,i,tamanho=strlen(palavra);
+    for(i=0;i<tamanho;i++){
+        if(toupper(palavra[i])==toupper(letra)){
+            count++;
+            palavraNaForca[i] = toupper(letra);
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Joga partidas com o metodo antigo e retorna os palpites por segundo.
+ */
+static double medirAntigo (char *palavra){
+    char palavraNaForca[TAM_MAX_PALAVRA];
+    int letras[27],i,k,palpites=0;
+    long long t0=relogioNs();
+    for(k=0;k<REPETICOES;k++){
+        memset(letras,0,sizeof(letras));
+        reiniciarForca(palavraNaForca,strlen(palavra));
+        for(i=0;strcasecmp(palavra,palavraNaForca)!=0;i++){
+            if(!verificarLetraAntiga(ORDEM_LETRAS[i],letras))
+                testarLetraAntiga(ORDEM_LETRAS[i],palavra,palavraNaForca);
+            palpites++;
+        }
+    }
+    return palpites/((relogioNs()-t0)/1e9);
+}
+
+/**
+ * @brief Joga partidas com as mascaras e retorna os palpites por segundo.
+ * @param palavra A palavra secreta.
+ * @param comPreparo 1 para remontar a tabela a cada partida, como em iniciarSessao.
+ */
+static double medirMascaras (char *palavra, int comPreparo){
+    MascaraPalavra m;
+    uint64_t reveladas;
+    uint32_t letras;
+    int i,k,palpites=0;
+    long long t0;
+    prepararMascara(palavra,&m);
+    t0=relogioNs();
+    for(k=0;k<REPETICOES;k++){
+        if(comPreparo)  prepararMascara(palavra,&m);
+        letras=0;
+        reveladas=0;
+        for(i=0;reveladas!=m.completa;i++){
+            if(!verificarLetra(ORDEM_LETRAS[i],&letras))
+                testarLetra(ORDEM_LETRAS[i],&m,&reveladas,NULL);
+            palpites++;
+        }
+    }
+    return palpites/((relogioNs()-t0)/1e9);
+}
+
+int main (){
+    char *palavras[]={"SOL","COMPUTADOR","PARALELEPIPEDO","INCONSTITUCIONALISSIMAMENTE"};
+    double antigo,novo,comPreparo;
+    int i;
+    printf("%-28s %14s %14s %8s %14s\n","palavra","antigo","mascaras","ganho","+preparo");
+    for(i=0;i<4;i++){
+        antigo=medirAntigo(palavras[i]);
+        novo=medirMascaras(palavras[i],0);
+        comPreparo=medirMascaras(palavras[i],1);
+        printf("%-28s %14.0f %14.0f %7.1fx %14.0f\n",palavras[i],antigo,novo,novo/antigo,comPreparo);
+    }
+    printf("(palpites por segundo; +preparo inclui montar a tabela a cada partida)\n");
+    return 0;
+}
\ No newline at end of file
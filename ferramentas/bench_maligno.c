@@ -0,0 +1,212 @@
+/**
+ * @file bench_maligno.c
+ * @brief Microbenchmark do modo maligno (particao dos candidatos).
+ *
+ * Gera um banco sintetico com N palavras de um mesmo comprimento (letras
+ * sorteadas com a frequencia aproximada do portugues), monta as tabelas
+ * do modo maligno e joga partidas inteiras chutando letras em ordem de
+ * frequencia, medindo a latencia de cada palpite. O primeiro palpite de
+ * cada partida separa o grupo inteiro, que e o pior caso.
+ *
+ * O primeiro palpite tambem e refeito pelo caminho ingenuo, que le cada
+ * palavra do dicionario e procura a letra na string, para conferir que a
+ * classe escolhida e a mesma e comparar o custo.
+ *
+ * Compilacao: gcc -O2 -pthread -I. ferramentas/bench_maligno.c maligno.c sessao.c forca.c dicionario.c registro.c aleatorio.c perfis.c -o bench_maligno
+ * Uso: ./bench_maligno [palavras] [comprimento] [partidas]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "forca.h"
+#include "dicionario.h"
+#include "sessao.h"
+#include "maligno.h"
+
+// Arquivo temporario onde o banco sintetico e gerado.
+#define ARQUIVO_TESTE "/tmp/forca_bench_maligno.txt"
+// Ordem dos palpites: letras mais frequentes do portugues primeiro.
+#define ORDEM_LETRAS "AEOSRIMNTUCLDPGBVHFQZJXKWY"
+// Frequencia aproximada (por mil) de cada letra, de A a Z.
+static const int FREQUENCIAS[TAM_ALFABETO]={146,10,39,50,126,10,13,13,62,4,1,28,47,50,107,25,12,65,78,43,46,17,1,2,1,5};
+// Capacidade da tabela do caminho ingenuo (classes de palavras de ate 15 letras).
+#define BITS_REFERENCIA 16
+
+/**
+ * @brief Gera um banco com n palavras de comprimento fixo.
+ * @param n O numero de palavras.
+ * @param tamanho O comprimento das palavras.
+ * @param a O gerador.
+ */
+static void gerarBanco (int n, int tamanho, Aleatorio *a){
+    int i,j,c,total=0,sorteio;
+    FILE *arq = fopen(ARQUIVO_TESTE,"w");
+    if(arq==NULL){
+        printf("Erro ao abrir o arquivo: %s\n",ARQUIVO_TESTE);
+        exit(1);
+    }
+    for(c=0;c<TAM_ALFABETO;c++) total+=FREQUENCIAS[c];
+    for(i=0;i<n;i++){
+        for(j=0;j<tamanho;j++){
+            sorteio=(int)sortearIntervalo(a,(uint32_t)total);
+            for(c=0;sorteio>=FREQUENCIAS[c];c++)    sorteio-=FREQUENCIAS[c];
+            fputc('A'+c,arq);
+        }
+        fputc('\n',arq);
+    }
+    fclose(arq);
+}
+
+/**
+ * @brief Compara duas duracoes (para qsort).
+ * @param a A primeira duracao.
+ * @param b A segunda duracao.
+ * @return Negativo, zero ou positivo, como em strcmp.
+ */
+static int compararDuracoes (const void *a, const void *b){
+    long long x=*(const long long *)a,y=*(const long long *)b;
+    return (x>y)-(x<y);
+}
+
+/**
+ * @brief Ordena as duracoes e imprime a mediana, o percentil 99 e o maximo.
+ * @param nome O caso medido.
+ * @param duracoes As duracoes, em ns.
+ * @param n O numero de duracoes.
+ */
+static void relatar (const char *nome, long long *duracoes, int n){
+    if(n==0)    return;
+    qsort(duracoes,n,sizeof(long long),compararDuracoes);
+    printf("%-26s p50 %9.1f us   p99 %9.1f us   max %9.1f us  (%d palpites)\n",nome,duracoes[n/2]/1e3,
+           duracoes[(int)(n*0.99)]/1e3,duracoes[n-1]/1e3,n);
+}
+
+/**
+ * @brief Separa um grupo inteiro pela letra lendo cada palavra do dicionario.
+ *
+ * E o trabalho do modo maligno sem as tabelas: a posicao da letra e
+ * procurada na string de cada palavra.
+ *
+ * @param d O dicionario.
+ * @param g O grupo.
+ * @param letra A letra (A-Z).
+ * @param maior Recebe o tamanho da classe escolhida.
+ * @return As posicoes da classe escolhida.
+ */
+static uint64_t particionarPorStrings (const Dicionario *d, const GrupoMaligno *g, char letra, int *maior){
+    static uint64_t chaves[1<<BITS_REFERENCIA];
+    static int contagens[1<<BITS_REFERENCIA];
+    const char *p;
+    uint64_t posicoes,melhor=0;
+    uint32_t h;
+    int k,i,n;
+    memset(contagens,0,sizeof(contagens));
+    *maior=0;
+    for(k=0;k<g->quantidade;k++){
+        p=obterPalavra(d,g->indices[k],&n);
+        for(i=0,posicoes=0;i<n;i++)
+            if((p[i]&~0x20)==letra) posicoes|=1ULL<<i;
+        if(posicoes==0){
+            (*maior)++;
+            continue;
+        }
+        h=(uint32_t)((posicoes*0x9e3779b97f4a7c15ULL)>>(64-BITS_REFERENCIA));
+        while(contagens[h]!=0&&chaves[h]!=posicoes)    h=(h+1)&((1u<<BITS_REFERENCIA)-1);
+        chaves[h]=posicoes;
+        contagens[h]++;
+    }
+    // Mesmo criterio de particionarMaligno: a maior, depois a que revela menos, depois a menor mascara.
+    for(h=0;h<1u<<BITS_REFERENCIA;h++){
+        if(contagens[h]==0) continue;
+        if(contagens[h]>*maior||(contagens[h]==*maior&&melhor!=0&&(__builtin_popcountll(chaves[h])<__builtin_popcountll(melhor)
+           ||(__builtin_popcountll(chaves[h])==__builtin_popcountll(melhor)&&chaves[h]<melhor)))){
+            *maior=contagens[h];
+            melhor=chaves[h];
+        }
+    }
+    return melhor;
+}
+
+int main (int argc, char *argv[]){
+    int palavras=argc>1?atoi(argv[1]):1000000,tamanho=argc>2?atoi(argv[2]):8,partidas=argc>3?atoi(argv[3]):20;
+    int i,n,total=0,primeiros=0,vitorias=0,maiorReferencia,divergencias=0;
+    long long *duracoes,*duracoesPrimeiro,inicio,memoria=0,referencia=0;
+    char palavra[TAM_MAX_PALAVRA];
+    const char *letra,*origem;
+    uint64_t posicoes,esperado;
+    const GrupoMaligno *g;
+    Dicionario d;
+    Maligno m;
+    EstadoMaligno e;
+    Sessao s;
+    Aleatorio a;
+    if(tamanho<1||tamanho>TAM_MAX_MASCARA||palavras<1||partidas<1){
+        printf("Uso: ./bench_maligno [palavras] [comprimento] [partidas]\n");
+        return 1;
+    }
+    semearAleatorio(&a,42);
+    gerarBanco(palavras,tamanho,&a);
+    if(abrirDicionario(&d,ARQUIVO_TESTE)<0){
+        printf("Erro ao abrir o arquivo: %s\n",ARQUIVO_TESTE);
+        return 1;
+    }
+    inicio=relogioNs();
+    if(criarMaligno(&m,&d)<0){
+        printf("Memoria insuficiente.\n");
+        return 1;
+    }
+    g=&m.grupos[tamanho];
+    memoria=(long long)g->quantidade*sizeof(int)+(long long)(TAM_ALFABETO+1)*g->blocos*sizeof(uint64_t)
+            +(long long)TAM_ALFABETO*g->blocos*tamanho*sizeof(uint64_t);
+    printf("%d palavras de %d letras; tabelas montadas em %.0f ms, %.1f MB (%.1f bytes por palavra)\n",g->quantidade,
+           tamanho,(relogioNs()-inicio)/1e6,memoria/1e6,(double)memoria/g->quantidade);
+
+    duracoes=malloc((size_t)partidas*TAM_ALFABETO*sizeof(long long));
+    duracoesPrimeiro=malloc(partidas*sizeof(long long));
+    if(duracoes==NULL||duracoesPrimeiro==NULL)  return 1;
+    for(i=0;i<partidas;i++){
+        origem=obterPalavra(&d,g->indices[sortearIntervalo(&a,(uint32_t)g->quantidade)],&n);
+        memcpy(palavra,origem,n);
+        palavra[n]='\0';
+        iniciarSessao(&s,"bench",palavra);
+        if(iniciarMaligno(&m,&e,palavra)<0){
+            printf("Memoria insuficiente.\n");
+            return 1;
+        }
+        for(letra=ORDEM_LETRAS;*letra!='\0'&&consultarSessao(&s)==SESSAO_EM_JOGO;letra++){
+            inicio=relogioNs();
+            chutarLetraMaligna(&e,&s,*letra);
+            duracoes[total]=relogioNs()-inicio;
+            if(letra==&ORDEM_LETRAS[0]) duracoesPrimeiro[primeiros++]=duracoes[total];
+            total++;
+        }
+        if(consultarSessao(&s)==SESSAO_VITORIA) vitorias++;
+        encerrarMaligno(&e);
+    }
+    relatar("primeiro palpite (grupo)",duracoesPrimeiro,primeiros);
+    relatar("todos os palpites",duracoes,total);
+    printf("vitorias do jogador: %d de %d partidas\n",vitorias,partidas);
+
+    // Caminho ingenuo, so para o primeiro palpite, comparado com as tabelas.
+    if(tamanho<BITS_REFERENCIA){
+        for(letra=ORDEM_LETRAS;*letra!='\0';letra++){
+            inicio=relogioNs();
+            esperado=particionarPorStrings(&d,g,*letra,&maiorReferencia);
+            referencia+=relogioNs()-inicio;
+            iniciarMaligno(&m,&e,palavra);
+            particionarMaligno(&e,*letra,&posicoes);
+            if(posicoes!=esperado||e.restantes!=maiorReferencia)   divergencias++;
+            encerrarMaligno(&e);
+        }
+        printf("%-26s %9.1f us por letra (lendo as strings), %d divergencias em %d letras\n","referencia ingenua",
+               referencia/1e3/TAM_ALFABETO,divergencias,TAM_ALFABETO);
+    }
+
+    free(duracoes);
+    free(duracoesPrimeiro);
+    destruirMaligno(&m);
+    fecharDicionario(&d);
+    remove(ARQUIVO_TESTE);
+    return divergencias!=0;
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+/**
+ * @file bench_metricas.c
+ * @brief Microbenchmark do custo da instrumentacao (metricas.h).
+ *
+ * Joga N partidas pela API de sessao, com o sorteio por carregarPalavras
+ * e os palpites por chutarLetra, em ordem fixa de frequencia das letras.
+ * Sao exatamente os caminhos instrumentados, entao comparar a mesma
+ * execucao compilada com e sem -DFORCA_METRICAS da o custo real das
+ * medicoes. Com as metricas, mede tambem o custo isolado de uma medicao e
+ * imprime o relatorio.
+ *
+ * Compilacao: gcc -O2 -pthread -I. ferramentas/bench_metricas.c sessao.c forca.c dicionario.c registro.c aleatorio.c perfis.c metricas.c -o bench_metricas
+ * Com metricas: o mesmo comando com -DFORCA_METRICAS e -o bench_metricas_ligadas
+ * Uso: ./bench_metricas [partidas] [threads] [arquivo de palavras] [semente]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "forca.h"
+#include "sessao.h"
+#include "metricas.h"
+
+// Ordem dos palpites: letras mais frequentes do portugues primeiro.
+#define ORDEM_LETRAS "AEOSRIMNTUCLDPGBVHFQZJXKWY"
+// Medicoes vazias usadas para estimar o custo isolado de uma medicao.
+#define MEDICOES_VAZIAS 10000000
+
+/**
+ * @struct ThreadPartidas
+ * @brief Parte das partidas jogadas por uma thread e seus resultados.
+ */
+typedef struct{
+    const char *arquivo;
+    long long primeira,partidas;    // Faixa de partidas desta thread.
+    uint64_t semente;
+    long long palpites,vitorias;
+    pthread_t thread;
+} ThreadPartidas;
+
+/**
+ * @brief Joga as partidas de uma thread.
+ * @param arg A ThreadPartidas.
+ * @return Sempre NULL.
+ */
+static void *jogarPartidas (void *arg){
+    ThreadPartidas *t = arg;
+    char palavra[TAM_MAX_PALAVRA],*arquivo=(char *)t->arquivo;
+    const char *letra;
+    Aleatorio a;
+    Sessao s;
+    long long i;
+    for(i=t->primeira;i<t->primeira+t->partidas;i++){
+        semearFluxo(&a,t->semente,(uint64_t)i);
+        carregarPalavras(arquivo,palavra,0,&a);
+        if(iniciarSessao(&s,"bench",palavra)<0) continue;
+        for(letra=ORDEM_LETRAS;*letra!='\0'&&consultarSessao(&s)==SESSAO_EM_JOGO;letra++){
+            chutarLetra(&s,*letra);
+            t->palpites++;
+        }
+        if(consultarSessao(&s)==SESSAO_VITORIA) t->vitorias++;
+    }
+    return NULL;
+}
+
+int main (int argc, char *argv[]){
+    long long partidas=argc>1?atoll(argv[1]):2000000,palpites=0,vitorias=0,inicio;
+    int threads=argc>2?atoi(argv[2]):0,i;
+    char *arquivo=argc>3?argv[3]:ARQUIVO_PALAVRAS;
+    uint64_t semente=argc>4?strtoull(argv[4],NULL,0):42;
+    double duracao;
+    ThreadPartidas *ts;
+    if(threads<=0)  threads=(int)sysconf(_SC_NPROCESSORS_ONLN);
+    // Carrega o dicionario compartilhado antes de criar as threads.
+    contarPalavras(arquivo);
+#ifdef FORCA_METRICAS
+    printf("metricas:  ligadas\n");
+#else
+    printf("metricas:  desligadas (compile com -DFORCA_METRICAS para comparar)\n");
+#endif
+    ts=calloc(threads,sizeof(ThreadPartidas));
+    inicio=relogioNs();
+    for(i=0;i<threads;i++){
+        ts[i].arquivo=arquivo;
+        ts[i].primeira=i>0?ts[i-1].primeira+ts[i-1].partidas:0;
+        ts[i].partidas=partidas/threads+(i<partidas%threads);
+        ts[i].semente=semente;
+        pthread_create(&ts[i].thread,NULL,jogarPartidas,&ts[i]);
+    }
+    for(i=0;i<threads;i++){
+        pthread_join(ts[i].thread,NULL);
+        palpites+=ts[i].palpites;
+        vitorias+=ts[i].vitorias;
+    }
+    duracao=(relogioNs()-inicio)/1e9;
+    printf("partidas:  %lld em %.3f s com %d threads (%.0f partidas/s, %.1f ns por partida)\n",partidas,duracao,
+           threads,partidas/duracao,duracao*1e9/partidas);
+    printf("palpites:  %lld (%.1f ns por palpite, com o sorteio), vitorias: %lld\n",palpites,duracao*1e9/palpites,vitorias);
+#ifdef FORCA_METRICAS
+    imprimirMetricas(stdout);
+    // Custo isolado de uma medicao: dois relogioNs() e a soma ao histograma.
+    {
+        MEDICAO(t0);
+        long long k;
+        inicio=relogioNs();
+        for(k=0;k<MEDICOES_VAZIAS;k++){
+            INICIAR_MEDICAO(t0);
+            ENCERRAR_MEDICAO(FASE_REGISTRO,t0);
+        }
+        printf("medicao:   %.1f ns cada (relogio + histograma)\n",(double)(relogioNs()-inicio)/MEDICOES_VAZIAS);
+        inicio=relogioNs();
+        for(k=0;k<MEDICOES_VAZIAS;k++)  registrarTempo(FASE_REGISTRO,k&1023);
+        printf("histograma: %.1f ns por registro (sem o relogio)\n",(double)(relogioNs()-inicio)/MEDICOES_VAZIAS);
+    }
+#endif
+    free(ts);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,114 @@
+/**
+ * @file bench_perfis.c
+ * @brief Microbenchmark do cadastro de perfis.
+ *
+ * Cadastra N jogadores, aplica atualizacoes em jogadores sorteados e
+ * mede a latencia da consulta de um perfil e do ranking. Cada
+ * atualizacao e feita por atualizarPerfil, o mesmo caminho usado ao fim
+ * de cada partida.
+ *
+ * Compilacao: gcc -O2 -pthread -I. ferramentas/bench_perfis.c forca.c dicionario.c registro.c aleatorio.c perfis.c -o bench_perfis
+ * Uso: ./bench_perfis [jogadores] [atualizacoes] [arquivo]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "forca.h"
+#include "aleatorio.h"
+#include "perfis.h"
+
+// Consultas individuais cronometradas.
+#define CONSULTAS 1000000
+
+/**
+ * @brief Monta o nome do jogador de numero i.
+ * @param nome Recebe o nome.
+ * @param i O numero do jogador.
+ */
+static void nomeJogador (char *nome, uint32_t i){
+    sprintf(nome,"jogador%08u",i);
+}
+
+/**
+ * @brief Compara dois tempos para o qsort.
+ * @param a Ponteiro para o primeiro tempo.
+ * @param b Ponteiro para o segundo tempo.
+ * @return Negativo, zero ou positivo, como em strcmp.
+ */
+static int compararTempos (const void *a, const void *b){
+    long long x=*(const long long *)a,y=*(const long long *)b;
+    return (x>y)-(x<y);
+}
+
+/**
+ * @brief Imprime a media e os percentis de um conjunto de tempos.
+ * @param nome O nome da operacao.
+ * @param tempos Os tempos, em ns (reordenados).
+ * @param n O numero de tempos.
+ */
+static void relatar (const char *nome, long long *tempos, int n){
+    long long soma=0;
+    int i;
+    for(i=0;i<n;i++)    soma+=tempos[i];
+    qsort(tempos,n,sizeof(long long),compararTempos);
+    printf("%-22s media %8.0f ns  p50 %8lld ns  p99 %8lld ns  p99.9 %8lld ns\n",nome,(double)soma/n,
+           tempos[n/2],tempos[(int)(n*0.99)],tempos[(int)(n*0.999)]);
+}
+
+int main (int argc, char *argv[]){
+    uint32_t jogadores=argc>1?(uint32_t)atol(argv[1]):10000000,i;
+    long long atualizacoes=argc>2?atoll(argv[2]):20000000,k,inicio,*tempos;
+    const char *arquivo=argc>3?argv[3]:"/tmp/forca_bench_perfis.dat";
+    const Perfil *ranking[TAM_RANKING];
+    char nome[TAM_MAX_PALAVRA];
+    volatile uint32_t soma=0;
+    double duracao;
+    Aleatorio a;
+    Perfis *p;
+    semearAleatorio(&a,42);
+    unlink(arquivo);
+    // Sem reserva de capacidade: inclui o custo de todos os crescimentos da tabela.
+    p=abrirPerfis(arquivo,0);
+    if(p==NULL){
+        printf("Erro ao abrir o arquivo: %s\n",arquivo);
+        return 1;
+    }
+    inicio=relogioNs();
+    for(i=0;i<jogadores;i++){
+        nomeJogador(nome,i);
+        atualizarPerfil(p,nome,sortearIntervalo(&a,2),(int)sortearIntervalo(&a,VIDAS+1));
+    }
+    duracao=(relogioNs()-inicio)/1e9;
+    printf("cadastro:    %u jogadores em %.2f s (%.0f/s, com crescimentos)\n",jogadores,duracao,jogadores/duracao);
+    inicio=relogioNs();
+    for(k=0;k<atualizacoes;k++){
+        nomeJogador(nome,sortearIntervalo(&a,jogadores));
+        atualizarPerfil(p,nome,sortearIntervalo(&a,2),(int)sortearIntervalo(&a,VIDAS+1));
+    }
+    duracao=(relogioNs()-inicio)/1e9;
+    printf("atualizacao: %lld partidas em %.2f s (%.0f/s)\n",atualizacoes,duracao,atualizacoes/duracao);
+    tempos=malloc(CONSULTAS*sizeof(long long));
+    for(k=0;k<CONSULTAS;k++){
+        nomeJogador(nome,sortearIntervalo(&a,jogadores));
+        inicio=relogioNs();
+        soma+=buscarPerfil(p,nome)->vitorias;
+        tempos[k]=relogioNs()-inicio;
+    }
+    relatar("buscarPerfil",tempos,CONSULTAS);
+    for(k=0;k<CONSULTAS;k++){
+        inicio=relogioNs();
+        soma+=consultarRanking(p,ranking,TAM_RANKING);
+        tempos[k]=relogioNs()-inicio;
+    }
+    relatar("consultarRanking(100)",tempos,CONSULTAS);
+    consultarRanking(p,ranking,3);
+    printf("lideres: %s (%u), %s (%u), %s (%u)\n",ranking[0]->nome,ranking[0]->vitorias,ranking[1]->nome,
+           ranking[1]->vitorias,ranking[2]->nome,ranking[2]->vitorias);
+    inicio=relogioNs();
+    fecharPerfis(p);
+    printf("fechamento (msync): %.2f s\n",(relogioNs()-inicio)/1e9);
+    free(tempos);
+    return 0;
+}
\ No newline at end of file
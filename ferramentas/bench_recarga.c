@@ -0,0 +1,231 @@
+/**
+ * @file bench_recarga.c
+ * @brief Microbenchmark das partidas durante a recarga do arquivo de palavras.
+ *
+ * Threads leitoras jogam partidas como o servidor: adquirem a versao
+ * atual, sorteiam a palavra, iniciam uma SessaoCompacta e chutam letras,
+ * marcando um ponto de quiescencia entre as partidas. Cada operacao
+ * (inicio de partida ou palpite) e cronometrada. O mesmo trabalho e medido
+ * sem recargas, com a thread principal publicando versoes sem parar
+ * (recarregarPalavras em laco) e com o arquivo sendo reescrito e renomeado
+ * periodicamente, de modo que a recarga venha do inotify.
+ *
+ * Se a troca de versoes bloqueasse os leitores, o percentil 99.9 e o
+ * maximo das fases com recarga subiriam na ordem do tempo de leitura do
+ * arquivo. Com menos nucleos que threads, o maximo inclui tambem o tempo
+ * em que o escalonador tirou a leitora da CPU.
+ *
+ * Compilacao: gcc -O2 -pthread -I. ferramentas/bench_recarga.c recarga.c sessao.c forca.c dicionario.c registro.c aleatorio.c perfis.c -o bench_recarga
+ * Uso: ./bench_recarga [palavras] [segundos por fase] [leitoras]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "forca.h"
+#include "sessao.h"
+#include "recarga.h"
+
+// Arquivo temporario com as palavras (reescrito durante a ultima fase).
+#define ARQUIVO_TESTE "/tmp/forca_bench_recarga.txt"
+#define ARQUIVO_NOVO "/tmp/forca_bench_recarga.txt.novo"
+// Ordem dos palpites: letras mais frequentes do portugues primeiro.
+#define ORDEM_LETRAS "AEOSRIMNTUCLDPGBVHFQZJXKWY"
+// Duracoes guardadas por thread em cada fase (as seguintes so sao contadas).
+#define MAX_AMOSTRAS 4000000
+// Intervalo, em ms, entre as reescritas do arquivo na fase com inotify.
+#define INTERVALO_REESCRITA 300
+
+/**
+ * @struct Leitora
+ * @brief Uma thread que joga partidas e as duracoes das suas operacoes.
+ */
+typedef struct{
+    Recarga *recarga;
+    int indice;
+    long long *duracoes;
+    int amostras;
+    long long operacoes;
+    unsigned long long versoesVistas;   // Trocas de versao percebidas entre as partidas.
+    pthread_t thread;
+} Leitora;
+
+// Pede o fim da fase atual.
+static atomic_int pararFase;
+
+/**
+ * @brief Gera um arquivo com n palavras de 4 a 12 letras.
+ * @param nome O arquivo.
+ * @param n O numero de palavras.
+ * @param a O gerador.
+ */
+static void gerarArquivo (const char *nome, int n, Aleatorio *a){
+    int i,j,t;
+    FILE *arq = fopen(nome,"w");
+    if(arq==NULL){
+        printf("Erro ao abrir o arquivo: %s\n",nome);
+        exit(1);
+    }
+    for(i=0;i<n;i++){
+        t=4+(int)sortearIntervalo(a,9);
+        for(j=0;j<t;j++)    fputc('A'+(int)sortearIntervalo(a,TAM_ALFABETO),arq);
+        fputc('\n',arq);
+    }
+    fclose(arq);
+}
+
+/**
+ * @brief Guarda a duracao de uma operacao.
+ * @param l A leitora.
+ * @param duracao A duracao, em ns.
+ */
+static void anotar (Leitora *l, long long duracao){
+    if(l->amostras<MAX_AMOSTRAS)    l->duracoes[l->amostras++]=duracao;
+    l->operacoes++;
+}
+
+/**
+ * @brief Joga partidas ate o fim da fase.
+ * @param arg A Leitora.
+ * @return Sempre NULL.
+ */
+static void *jogarPartidas (void *arg){
+    Leitora *l = arg;
+    SessaoCompacta s;
+    VersaoDicionario *v,*anterior=NULL;
+    Aleatorio a;
+    const char *letra;
+    long long inicio;
+    semearFluxo(&a,42,(uint64_t)l->indice);
+    while(!atomic_load_explicit(&pararFase,memory_order_relaxed)){
+        marcarQuiescencia(l->recarga,l->indice);
+        inicio=relogioNs();
+        v=adquirirVersao(l->recarga);
+        iniciarSessaoCompacta(&s,&v->dicionario,sortearIntervalo(&a,(uint32_t)v->dicionario.quantidade),0);
+        anotar(l,relogioNs()-inicio);
+        if(v!=anterior) l->versoesVistas++;
+        anterior=v;
+        for(letra=ORDEM_LETRAS;*letra!='\0'&&s.estado==SESSAO_EM_JOGO;letra++){
+            inicio=relogioNs();
+            chutarLetraCompacta(&s,&v->dicionario,*letra);
+            anotar(l,relogioNs()-inicio);
+        }
+        liberarVersao(v);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Compara duas duracoes (para qsort).
+ * @param a A primeira duracao.
+ * @param b A segunda duracao.
+ * @return Negativo, zero ou positivo, como em strcmp.
+ */
+static int compararDuracoes (const void *a, const void *b){
+    long long x=*(const long long *)a,y=*(const long long *)b;
+    return (x>y)-(x<y);
+}
+
+/**
+ * @brief Executa uma fase e imprime os percentis das operacoes de todas as leitoras.
+ * @param nome O nome da fase.
+ * @param r A recarga.
+ * @param ls As leitoras.
+ * @param n O numero de leitoras.
+ * @param segundos A duracao da fase.
+ * @param modo 0 = sem recarga, 1 = recarregarPalavras em laco, 2 = reescrita do arquivo.
+ */
+static void executarFase (const char *nome, Recarga *r, Leitora *ls, int n, int segundos, int modo){
+    long long fim,proxima,*todas,total=0,operacoes=0;
+    unsigned long long vistas=0;
+    int i,k;
+    EstatisticasRecarga antes,depois;
+    Aleatorio a;
+    semearAleatorio(&a,7);
+    consultarRecarga(r,&antes);
+    atomic_store(&pararFase,0);
+    for(i=0;i<n;i++){
+        ls[i].amostras=0;
+        ls[i].operacoes=0;
+        ls[i].versoesVistas=0;
+        pthread_create(&ls[i].thread,NULL,jogarPartidas,&ls[i]);
+    }
+    fim=relogioNs()+segundos*1000000000LL;
+    proxima=relogioNs();
+    while(relogioNs()<fim){
+        if(modo==1) recarregarPalavras(r);
+        else if(modo==2&&relogioNs()>=proxima){
+            // Grava um arquivo novo e o renomeia por cima, como fazem os editores.
+            gerarArquivo(ARQUIVO_NOVO,1000+(int)sortearIntervalo(&a,1000),&a);
+            rename(ARQUIVO_NOVO,ARQUIVO_TESTE);
+            proxima+=INTERVALO_REESCRITA*1000000LL;
+        }
+        else    usleep(1000);
+    }
+    atomic_store(&pararFase,1);
+    for(i=0;i<n;i++){
+        pthread_join(ls[i].thread,NULL);
+        total+=ls[i].amostras;
+        operacoes+=ls[i].operacoes;
+        vistas+=ls[i].versoesVistas;
+    }
+    // Espera a thread de recarga liberar o que ficou pendente.
+    usleep(3*INTERVALO_RECARGA*1000);
+    consultarRecarga(r,&depois);
+    todas=malloc(total*sizeof(long long));
+    for(i=0,k=0;i<n;i++){
+        memcpy(todas+k,ls[i].duracoes,ls[i].amostras*sizeof(long long));
+        k+=ls[i].amostras;
+    }
+    qsort(todas,total,sizeof(long long),compararDuracoes);
+    printf("%-22s %6.1f Mop/s  p50 %6.0f ns  p99 %6.0f ns  p99.9 %7.0f ns  max %9.0f ns\n",nome,operacoes/(segundos*1e6),
+           (double)todas[total/2],(double)todas[(long long)(total*0.99)],(double)todas[(long long)(total*0.999)],
+           (double)todas[total-1]);
+    printf("%-22s versoes publicadas %llu, liberadas %llu, pendentes %llu, trocas vistas pelas leitoras %llu\n","",
+           depois.recargas-antes.recargas,depois.liberadas-antes.liberadas,depois.pendentes,vistas);
+    free(todas);
+}
+
+int main (int argc, char *argv[]){
+    int palavras=argc>1?atoi(argv[1]):200000,segundos=argc>2?atoi(argv[2]):3,n=argc>3?atoi(argv[3]):2,i;
+    EstatisticasRecarga e;
+    Leitora *ls;
+    Recarga *r;
+    Aleatorio a;
+    if(palavras<=0) palavras=1;
+    if(segundos<=0) segundos=1;
+    if(n<=0)    n=1;
+    semearAleatorio(&a,42);
+    gerarArquivo(ARQUIVO_TESTE,palavras,&a);
+    r=iniciarRecarga(ARQUIVO_TESTE,n);
+    if(r==NULL){
+        printf("Erro ao abrir o arquivo: %s\n",ARQUIVO_TESTE);
+        return 1;
+    }
+    ls=calloc(n,sizeof(Leitora));
+    for(i=0;i<n;i++){
+        ls[i].recarga=r;
+        ls[i].indice=i;
+        ls[i].duracoes=malloc(MAX_AMOSTRAS*sizeof(long long));
+        if(ls[i].duracoes==NULL){
+            printf("Memoria insuficiente.\n");
+            return 1;
+        }
+    }
+    printf("%d palavras, %d leitora(s), %d s por fase\n",palavras,n,segundos);
+    executarFase("sem recarga",r,ls,n,segundos,0);
+    executarFase("recarga continua",r,ls,n,segundos,1);
+    executarFase("reescrita (inotify)",r,ls,n,segundos,2);
+    consultarRecarga(r,&e);
+    printf("recargas: %llu, falhas: %llu, maior leitura: %.2f ms, versoes liberadas: %llu, pendentes: %llu\n",
+           e.recargas,e.falhas,e.maiorLeitura/1e6,e.liberadas,e.pendentes);
+
+    encerrarRecarga(r);
+    for(i=0;i<n;i++)    free(ls[i].duracoes);
+    free(ls);
+    remove(ARQUIVO_TESTE);
+    return 0;
+}
\ No newline at end of file
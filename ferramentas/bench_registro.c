@@ -0,0 +1,89 @@
+/**
+ * @file bench_registro.c
+ * @brief Microbenchmark da gravacao de resultados.
+ *
+ * Varias threads registram partidas ao mesmo tempo, primeiro com a
+ * gravacao sincrona (um fopen/fprintf/fclose por partida) e depois com
+ * o registro assincrono em lotes, para cada politica de sincronia.
+ *
+ * Compilacao: gcc -O2 -pthread -I. ferramentas/bench_registro.c forca.c dicionario.c registro.c aleatorio.c perfis.c -o bench_registro
+ * Uso: ./bench_registro [threads] [partidas por thread]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "forca.h"
+#include "registro.h"
+
+// Arquivo temporario onde os resultados sao gravados.
+#define ARQUIVO_TESTE "/tmp/forca_bench_resultados.txt"
+
+static int partidasPorThread=100000;
+
+/**
+ * @brief Registra partidas pelo caminho de registrarResultado.
+ * @param arg Nao utilizado.
+ * @return Sempre NULL.
+ */
+static void *registrarPartidas (void *arg){
+    Jogador p={"jogador_de_teste",3};
+    int i;
+    (void)arg;
+    for(i=0;i<partidasPorThread;i++){
+        p.vidas=i%2;
+        registrarResultado(ARQUIVO_TESTE,"PARALELEPIPEDO",&p);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Executa as threads produtoras e retorna a duracao em segundos.
+ * @param threads O numero de threads.
+ * @return A duracao da rodada.
+ */
+static double executarRodada (int threads){
+    pthread_t *ts=malloc(threads*sizeof(pthread_t));
+    long long t0=relogioNs();
+    int i;
+    for(i=0;i<threads;i++)  pthread_create(&ts[i],NULL,registrarPartidas,NULL);
+    for(i=0;i<threads;i++)  pthread_join(ts[i],NULL);
+    free(ts);
+    return (relogioNs()-t0)/1e9;
+}
+
+int main (int argc, char *argv[]){
+    const char *nomes[]={"nunca","por lote","periodica"};
+    int threads=argc>1?atoi(argv[1]):4,i;
+    double total,produtores;
+    long long t0;
+    Registro *r;
+    EstatisticasRegistro e;
+    if(argc>2)  partidasPorThread=atoi(argv[2]);
+    total=(double)threads*partidasPorThread;
+    printf("%d threads, %d partidas por thread\n\n",threads,partidasPorThread);
+    // Gravacao sincrona: uma abertura de arquivo por partida.
+    remove(ARQUIVO_TESTE);
+    produtores=executarRodada(threads);
+    printf("%-23s %12.0f partidas/s\n","sincrono (fopen)",total/produtores);
+    for(i=0;i<3;i++){
+        remove(ARQUIVO_TESTE);
+        t0=relogioNs();
+        r=iniciarRegistro(ARQUIVO_TESTE,CAPACIDADE_REGISTRO,(PoliticaSincronia)i,10);
+        if(r==NULL){
+            printf("Erro ao abrir o arquivo: %s\n",ARQUIVO_TESTE);
+            return 1;
+        }
+        definirRegistroPadrao(r,ARQUIVO_TESTE);
+        produtores=executarRodada(threads);
+        consultarRegistro(r,&e);
+        encerrarRegistro(r);
+        definirRegistroPadrao(NULL,ARQUIVO_TESTE);
+        printf("assincrono, %-9s  %12.0f partidas/s nos produtores, %12.0f ate o disco\n",nomes[i],
+               total/produtores,total/((relogioNs()-t0)/1e9));
+        printf("    lotes: %llu, maior lote: %llu, fdatasync: %llu, esperas por anel cheio: %llu\n",
+               e.lotes,e.maiorLote,e.sincronizacoes,e.esperas);
+    }
+    remove(ARQUIVO_TESTE);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,242 @@
+/**
+ * @file bench_salas.c
+ * @brief Microbenchmark da difusao dos eventos das salas.
+ *
+ * Uma sala com N membros recebe palpites de letras, em rodizio entre os
+ * membros, e cada mudanca do estado compartilhado e entregue a todos. Sao
+ * comparadas duas formas de entrega:
+ *
+ * - quadros: o evento e codificado uma vez (codificarEventos) e cada
+ *   membro guarda so o ponteiro em uma FilaQuadros; o envio aponta o iovec
+ *   para os bytes do quadro (montarEnvio/consumirEnvio), como no servidor;
+ * - copias: o texto e formatado e copiado para o buffer de saida de cada
+ *   membro, como faria uma resposta comum.
+ *
+ * A cada LOTE eventos, as saidas de todos os membros sao esvaziadas: em
+ * memoria, apenas descartando o que seria enviado; com sockets, enviando
+ * por um socketpair por membro e lendo do outro lado.
+ *
+ * Compilacao: gcc -O2 -pthread -I. ferramentas/bench_salas.c sala.c sessao.c forca.c dicionario.c registro.c aleatorio.c perfis.c -o bench_salas
+ * Uso: ./bench_salas [eventos por medicao]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include "forca.h"
+#include "sala.h"
+
+// Arquivo temporario com as palavras.
+#define ARQUIVO_TESTE "/tmp/forca_bench_salas.txt"
+// Eventos entre dois esvaziamentos das saidas (uma volta do laco de eventos).
+#define LOTE 16
+// Tamanho do buffer de saida de cada membro na entrega por copias.
+#define TAM_SAIDA_TESTE (LOTE*TAM_MAX_QUADRO)
+
+/**
+ * @struct Destino
+ * @brief Saida de um membro da sala.
+ */
+typedef struct{
+    FilaQuadros fila;
+    char saida[TAM_SAIDA_TESTE];
+    int tamSaida;
+    int fd[2];              // Socketpair: o membro escreve em fd[0] e o cliente le de fd[1].
+} Destino;
+
+// Nomes dos membros (a sala guarda so os ponteiros).
+static char nomes[1000][20];
+
+/**
+ * @brief Gera um arquivo com n palavras de 6 a 12 letras.
+ * @param nome O arquivo.
+ * @param n O numero de palavras.
+ * @param a O gerador.
+ */
+static void gerarArquivo (const char *nome, int n, Aleatorio *a){
+    int i,j,t;
+    FILE *arq = fopen(nome,"w");
+    if(arq==NULL){
+        printf("Erro ao abrir o arquivo: %s\n",nome);
+        exit(1);
+    }
+    for(i=0;i<n;i++){
+        t=6+(int)sortearIntervalo(a,7);
+        for(j=0;j<t;j++)    fputc('A'+(int)sortearIntervalo(a,TAM_ALFABETO),arq);
+        fputc('\n',arq);
+    }
+    fclose(arq);
+}
+
+/**
+ * @brief Entrega um quadro a um membro guardando so o ponteiro.
+ * @param dono O Destino do membro.
+ * @param q O quadro.
+ * @return 0 em caso de sucesso, -1 se a fila estava cheia.
+ */
+static int entregarPonteiro (void *dono, Quadro *q){
+    Destino *d = dono;
+    return enfileirarQuadro(&d->fila,q,d->tamSaida);
+}
+
+/**
+ * @brief Formata e copia o texto de um evento para a saida de cada membro.
+ * @param s A sala.
+ * @param membro Quem chutou a letra.
+ * @param letra A letra.
+ * @param eventos Os EVENTO_* do palpite.
+ */
+static void entregarCopias (const Sala *s, int membro, char letra, int eventos){
+    char forca[TAM_MAX_MASCARA+1],palavra[TAM_MAX_MASCARA+1];
+    Destino *d;
+    int i,n;
+    montarForcaSala(s,forca,palavra);
+    for(i=0;i<s->numMembros;i++){
+        d=s->membros[i].dono;
+        n=0;
+        if(eventos&EVENTO_REVELOU)
+            n+=snprintf(d->saida+d->tamSaida+n,TAM_SAIDA_TESTE-d->tamSaida-n,"SALA REVELOU %s %c %s\n",s->membros[membro].nome,letra,forca);
+        if(eventos&EVENTO_ELIMINADO)
+            n+=snprintf(d->saida+d->tamSaida+n,TAM_SAIDA_TESTE-d->tamSaida-n,"SALA ELIMINADO %s\n",s->membros[membro].nome);
+        if(eventos&EVENTO_FIM)
+            n+=snprintf(d->saida+d->tamSaida+n,TAM_SAIDA_TESTE-d->tamSaida-n,"SALA FIM %s %s\n",
+                        s->vencedor>=0?s->membros[s->vencedor].nome:"-",palavra);
+        d->tamSaida+=n;
+    }
+}
+
+/**
+ * @brief Esvazia as saidas de todos os membros.
+ * @param ds Os destinos.
+ * @param n O numero de membros.
+ * @param sockets 1 para enviar pelos socketpairs, 0 para so descartar.
+ * @return Os bytes entregues.
+ */
+static long long esvaziarSaidas (Destino *ds, int n, int sockets){
+    struct iovec iov[2*MAX_QUADROS_PENDENTES+1];
+    char lixo[TAM_SAIDA_TESTE+LOTE*TAM_MAX_QUADRO];
+    long long total=0;
+    ssize_t enviados;
+    int i,k,j;
+    size_t bytes;
+    for(i=0;i<n;i++){
+        k=montarEnvio(&ds[i].fila,ds[i].saida,ds[i].tamSaida,iov);
+        if(k==0)    continue;
+        if(sockets){
+            enviados=writev(ds[i].fd[0],iov,k);
+            if(enviados<0)  enviados=0;
+            while(read(ds[i].fd[1],lixo,sizeof(lixo))==(ssize_t)sizeof(lixo));
+        }
+        else{
+            for(j=0,bytes=0;j<k;j++)    bytes+=iov[j].iov_len;
+            enviados=(ssize_t)bytes;
+        }
+        consumirEnvio(&ds[i].fila,(size_t)enviados,ds[i].tamSaida);
+        ds[i].tamSaida=0;
+        total+=enviados;
+    }
+    return total;
+}
+
+/**
+ * @brief Aplica palpites na sala e entrega os eventos, com uma das duas formas de entrega.
+ * @param s A sala (com os membros ja dentro).
+ * @param d O dicionario.
+ * @param ds Os destinos.
+ * @param eventos Palpites a aplicar.
+ * @param copias 1 para entregar por copias, 0 por quadros compartilhados.
+ * @param sockets 1 para enviar pelos socketpairs.
+ * @param bytes Recebe os bytes entregues.
+ * @return A duracao, em ns.
+ */
+static long long medir (Sala *s, const Dicionario *d, Destino *ds, int eventos, int copias, int sockets, long long *bytes){
+    const char *ordem="EAOSRINTUCLDMPGBVFHQZJXKWY";
+    Aleatorio a;
+    Quadro *q;
+    long long inicio;
+    int i,membro=0,letra=0,ev;
+    semearAleatorio(&a,11);
+    *bytes=0;
+    inicio=relogioNs();
+    for(i=0;i<eventos;i++){
+        if(s->rodada.estado!=SESSAO_EM_JOGO||ordem[letra]=='\0'){
+            novaRodada(s,d,sortearIntervalo(&a,(uint32_t)d->quantidade));
+            letra=0;
+        }
+        ev=0;
+        chutarLetraSala(s,membro,ordem[letra],&ev);
+        // Palpites que nao mudam o estado compartilhado nao geram eventos.
+        if(ev!=0){
+            if(copias)  entregarCopias(s,membro,ordem[letra],ev);
+            else if((q=codificarEventos(s,membro,ordem[letra],ev))!=NULL){
+                difundirQuadro(s,q,entregarPonteiro);
+                soltarQuadro(q);
+            }
+        }
+        letra++;
+        membro=(membro+1)%s->numMembros;
+        if(i%LOTE==LOTE-1)  *bytes+=esvaziarSaidas(ds,s->numMembros,sockets);
+    }
+    *bytes+=esvaziarSaidas(ds,s->numMembros,sockets);
+    return relogioNs()-inicio;
+}
+
+int main (int argc, char *argv[]){
+    int eventos=argc>1?atoi(argv[1]):20000,tamanhos[]={10,100,1000},i,j,t,sockets;
+    long long duracao,bytes;
+    struct rlimit limite;
+    Dicionario d;
+    Destino *ds;
+    Sala s;
+    Aleatorio a;
+    if(eventos<=0)  eventos=1;
+    semearAleatorio(&a,42);
+    gerarArquivo(ARQUIVO_TESTE,10000,&a);
+    if(abrirDicionario(&d,ARQUIVO_TESTE)<0){
+        printf("Erro ao abrir o arquivo: %s\n",ARQUIVO_TESTE);
+        return 1;
+    }
+    // Dois descritores por membro nos socketpairs.
+    getrlimit(RLIMIT_NOFILE,&limite);
+    limite.rlim_cur=limite.rlim_max;
+    setrlimit(RLIMIT_NOFILE,&limite);
+    printf("%d palpites por medicao, saidas esvaziadas a cada %d\n",eventos,LOTE);
+    for(sockets=0;sockets<2;sockets++){
+        printf("%s:\n",sockets?"socketpairs":"em memoria");
+        for(t=0;t<3;t++){
+            ds=calloc(tamanhos[t],sizeof(Destino));
+            iniciarSala(&s,"bench");
+            novaRodada(&s,&d,0);
+            for(i=0;i<tamanhos[t];i++){
+                snprintf(nomes[i],sizeof(nomes[i]),"jogador%d",i);
+                if(sockets&&socketpair(AF_UNIX,SOCK_STREAM,0,ds[i].fd)<0){
+                    printf("Erro ao criar o socketpair: %d membros\n",tamanhos[t]);
+                    return 1;
+                }
+                entrarSala(&s,&ds[i],nomes[i]);
+            }
+            for(j=0;j<2;j++){
+                duracao=medir(&s,&d,ds,eventos,j,sockets,&bytes);
+                printf("  %4d membros, %-8s %8.0f palpites/s  %7.1f MB/s  %5.0f ns por palpite e membro\n",tamanhos[t],
+                       j?"copias":"quadros",eventos/(duracao/1e9),bytes/(duracao/1e3),
+                       (double)duracao/((double)eventos*tamanhos[t]));
+            }
+            for(i=0;i<tamanhos[t];i++){
+                esvaziarFila(&ds[i].fila);
+                if(sockets){
+                    close(ds[i].fd[0]);
+                    close(ds[i].fd[1]);
+                }
+            }
+            destruirSala(&s);
+            free(ds);
+        }
+    }
+
+    fecharDicionario(&d);
+    remove(ARQUIVO_TESTE);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,193 @@
+/**
+ * @file bench_sessoes.c
+ * @brief Microbenchmark da memoria e do acesso a milhoes de partidas abertas.
+ *
+ * Abre N partidas com a SessaoCompacta numa arena (como o servidor) e N
+ * partidas com a Sessao completa alocada por malloc, e compara a memoria
+ * residente ocupada por partida e o custo de palpites em partidas
+ * sorteadas, que no servidor chegam em ordem aleatoria. Quando o kernel
+ * permite, conta tambem as falhas de cache (perf_event_open).
+ *
+ * As duas representacoes recebem a mesma sequencia de palpites e palavras;
+ * a soma dos resultados deve ser igual, o que confere que as regras sao
+ * as mesmas.
+ *
+ * Compilacao: gcc -O2 -pthread -I. ferramentas/bench_sessoes.c sessao.c arena.c forca.c dicionario.c registro.c aleatorio.c perfis.c -o bench_sessoes
+ * Uso: ./bench_sessoes [sessoes] [palpites] [arquivo de palavras]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "forca.h"
+#include "dicionario.h"
+#include "sessao.h"
+#include "arena.h"
+#ifdef __linux__
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <linux/perf_event.h>
+#endif
+
+/**
+ * @brief Le a memoria residente do processo.
+ * @return A memoria residente, em bytes (0 se indisponivel).
+ */
+static long long memoriaResidente (void){
+    long long paginas=0,residentes=0;
+    FILE *arq = fopen("/proc/self/statm","r");
+    if(arq==NULL)   return 0;
+    if(fscanf(arq,"%lld %lld",&paginas,&residentes)!=2)    residentes=0;
+    fclose(arq);
+    return residentes*sysconf(_SC_PAGESIZE);
+}
+
+/**
+ * @brief Abre um contador de falhas de cache da thread atual.
+ * @return O descritor do contador, ou -1 se indisponivel.
+ */
+static int abrirContador (void){
+#ifdef __linux__
+    struct perf_event_attr pe;
+    memset(&pe,0,sizeof(pe));
+    pe.type=PERF_TYPE_HARDWARE;
+    pe.size=sizeof(pe);
+    pe.config=PERF_COUNT_HW_CACHE_MISSES;
+    pe.disabled=1;
+    pe.exclude_kernel=1;
+    pe.exclude_hv=1;
+    return (int)syscall(SYS_perf_event_open,&pe,0,-1,-1,0);
+#else
+    return -1;
+#endif
+}
+
+/**
+ * @brief Zera e liga (ou desliga e le) o contador de falhas de cache.
+ * @param fd O descritor do contador (-1 e ignorado).
+ * @param ligar 1 para zerar e ligar, 0 para desligar.
+ * @return O valor lido ao desligar, ou -1.
+ */
+static long long alternarContador (int fd, int ligar){
+    long long valor=-1;
+    if(fd<0)    return -1;
+#ifdef __linux__
+    if(ligar){
+        ioctl(fd,PERF_EVENT_IOC_RESET,0);
+        ioctl(fd,PERF_EVENT_IOC_ENABLE,0);
+    }
+    else{
+        ioctl(fd,PERF_EVENT_IOC_DISABLE,0);
+        if(read(fd,&valor,sizeof(valor))!=sizeof(valor))    valor=-1;
+    }
+#endif
+    return valor;
+}
+
+/**
+ * @brief Imprime o resultado de uma rodada de palpites.
+ * @param nome A representacao medida.
+ * @param palpites O numero de palpites.
+ * @param ns A duracao, em ns.
+ * @param falhas As falhas de cache (-1 se indisponivel).
+ * @param soma A soma dos resultados dos palpites.
+ */
+static void relatar (const char *nome, long long palpites, long long ns, long long falhas, long long soma){
+    printf("%-16s %8.1f ns/palpite",nome,(double)ns/palpites);
+    if(falhas>=0)   printf("  %6.2f falhas de cache/palpite",(double)falhas/palpites);
+    else    printf("  falhas de cache indisponiveis");
+    printf("  (soma %lld)\n",soma);
+}
+
+int main (int argc, char *argv[]){
+    long long sessoes=argc>1?atoll(argv[1]):1000000,palpites=argc>2?atoll(argv[2]):10000000,k,antes,inicio,soma;
+    const char *arquivo=argc>3?argv[3]:ARQUIVO_PALAVRAS;
+    char palavra[TAM_MAX_PALAVRA];
+    const char *origem;
+    uint32_t *ids,placas;
+    Sessao **completas;
+    SessaoCompacta *c;
+    Dicionario d;
+    Aleatorio a;
+    Arena arena;
+    int contador=abrirContador(),n;
+    if(abrirDicionario(&d,arquivo)<0||d.quantidade==0){
+        printf("Erro ao abrir o arquivo: %s\n",arquivo);
+        return 1;
+    }
+    ids=calloc(sessoes,sizeof(uint32_t));
+    completas=calloc(sessoes,sizeof(Sessao *));
+    if(ids==NULL||completas==NULL)  return 1;
+    // Os vetores de referencias ja ocupam a memoria antes das medicoes.
+    memset(ids,0,sessoes*sizeof(uint32_t));
+    memset(completas,0,sessoes*sizeof(Sessao *));
+    printf("%lld partidas, %d palavras; sizeof(SessaoCompacta)=%zu, sizeof(Sessao)=%zu\n",
+           sessoes,d.quantidade,sizeof(SessaoCompacta),sizeof(Sessao));
+
+    // Partidas compactas numa arena.
+    semearAleatorio(&a,42);
+    iniciarArena(&arena,sizeof(SessaoCompacta));
+    antes=memoriaResidente();
+    inicio=relogioNs();
+    for(k=0;k<sessoes;k++){
+        ids[k]=alocarArena(&arena);
+        iniciarSessaoCompacta(enderecoArena(&arena,ids[k]),&d,sortearIntervalo(&a,d.quantidade),(uint32_t)k);
+    }
+    printf("compacta/arena:  %6.1f bytes residentes por partida, abertas em %.0f ms\n",
+           (double)(memoriaResidente()-antes)/sessoes,(relogioNs()-inicio)/1e6);
+
+    // Partidas completas, uma alocacao por partida, com as mesmas palavras.
+    semearAleatorio(&a,42);
+    antes=memoriaResidente();
+    inicio=relogioNs();
+    for(k=0;k<sessoes;k++){
+        origem=obterPalavra(&d,(int)sortearIntervalo(&a,d.quantidade),&n);
+        memcpy(palavra,origem,n);
+        palavra[n]='\0';
+        completas[k]=criarSessao("jogador",palavra);
+    }
+    printf("Sessao/malloc:   %6.1f bytes residentes por partida, abertas em %.0f ms\n",
+           (double)(memoriaResidente()-antes)/sessoes,(relogioNs()-inicio)/1e6);
+
+    // Palpites em partidas sorteadas; uma partida encerrada recomeca com outra palavra.
+    semearAleatorio(&a,7);
+    soma=0;
+    alternarContador(contador,1);
+    inicio=relogioNs();
+    for(k=0;k<palpites;k++){
+        c=enderecoArena(&arena,ids[sortearIntervalo(&a,(uint32_t)sessoes)]);
+        soma+=chutarLetraCompacta(c,&d,'A'+sortearIntervalo(&a,TAM_ALFABETO));
+        if(c->estado!=SESSAO_EM_JOGO)   iniciarSessaoCompacta(c,&d,sortearIntervalo(&a,d.quantidade),c->jogador);
+    }
+    relatar("compacta/arena",palpites,relogioNs()-inicio,alternarContador(contador,0),soma);
+    semearAleatorio(&a,7);
+    soma=0;
+    alternarContador(contador,1);
+    inicio=relogioNs();
+    for(k=0;k<palpites;k++){
+        Sessao *s = completas[sortearIntervalo(&a,(uint32_t)sessoes)];
+        soma+=chutarLetra(s,'A'+sortearIntervalo(&a,TAM_ALFABETO));
+        if(consultarSessao(s)!=SESSAO_EM_JOGO){
+            origem=obterPalavra(&d,(int)sortearIntervalo(&a,d.quantidade),&n);
+            memcpy(palavra,origem,n);
+            palavra[n]='\0';
+            iniciarSessao(s,"jogador",palavra);
+        }
+    }
+    relatar("Sessao/malloc",palpites,relogioNs()-inicio,alternarContador(contador,0),soma);
+
+    // Rotatividade: metade das partidas termina e outras tantas comecam.
+    placas=arena.numPlacas;
+    for(k=0;k<sessoes;k+=2)    liberarArena(&arena,ids[k]);
+    for(k=0;k<sessoes;k+=2)    ids[k]=alocarArena(&arena);
+    printf("rotatividade:    %u placas antes, %u depois (%u partidas em uso)\n",placas,arena.numPlacas,arena.emUso);
+
+    for(k=0;k<sessoes;k++)  destruirSessao(completas[k]);
+    destruirArena(&arena);
+    free(completas);
+    free(ids);
+    fecharDicionario(&d);
+    if(contador>=0) close(contador);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+/**
+ * @file bench_solucionador.c
+ * @brief Simulacao de partidas com o jogador automatico.
+ *
+ * Sorteia N palavras do dicionario e joga cada uma ate o fim com o
+ * solucionador, dividindo as partidas entre as threads. As regras sao as
+ * mesmas do jogo (VIDAS, PENALIDADE_REPETIDA e PENALIDADE_PALAVRA), pois
+ * as partidas passam pela API de sessao.
+ *
+ * A palavra da partida de numero i e sorteada pelo fluxo i da semente
+ * (aleatorio.h), de modo que o resultado nao depende do numero de
+ * threads e qualquer partida pode ser repetida isoladamente.
+ *
+ * Compilacao: gcc -O2 -pthread -I. ferramentas/bench_solucionador.c solucionador.c sessao.c forca.c dicionario.c registro.c aleatorio.c perfis.c -o bench_solucionador
+ * Uso: ./bench_solucionador [partidas] [threads] [arquivo de palavras] [semente]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "forca.h"
+#include "dicionario.h"
+#include "sessao.h"
+#include "solucionador.h"
+
+/**
+ * @struct ThreadSimulacao
+ * @brief Parte das partidas simuladas por uma thread e seus resultados.
+ */
+typedef struct{
+    const Solucionador *solucionador;
+    long long primeira,partidas;    // Faixa de partidas desta thread.
+    uint64_t semente;
+    long long vitorias,palpites,vidasRestantes,falhas;
+    pthread_t thread;
+} ThreadSimulacao;
+
+/**
+ * @brief Joga as partidas de uma thread.
+ * @param arg A ThreadSimulacao.
+ * @return Sempre NULL.
+ */
+static void *simularPartidas (void *arg){
+    ThreadSimulacao *t = arg;
+    const Dicionario *d = t->solucionador->dicionario;
+    char palavra[TAM_MAX_PALAVRA];
+    const char *origem;
+    Aleatorio a;
+    Sessao s;
+    long long i;
+    int n,palpites;
+    for(i=t->primeira;i<t->primeira+t->partidas;i++){
+        semearFluxo(&a,t->semente,(uint64_t)i);
+        origem=sortearPalavra(d,&a,&n);
+        memcpy(palavra,origem,n);
+        palavra[n]='\0';
+        iniciarSessao(&s,"solucionador",palavra);
+        palpites=jogarSessao(t->solucionador,&s);
+        if(palpites<0){
+            t->falhas++;
+            continue;
+        }
+        t->palpites+=palpites;
+        if(consultarSessao(&s)==SESSAO_VITORIA){
+            t->vitorias++;
+            t->vidasRestantes+=s.jogador.vidas;
+        }
+    }
+    return NULL;
+}
+
+int main (int argc, char *argv[]){
+    long long partidas=argc>1?atoll(argv[1]):1000000,vitorias=0,palpites=0,vidas=0,falhas=0;
+    int threads=argc>2?atoi(argv[2]):0,i;
+    const char *arquivo=argc>3?argv[3]:ARQUIVO_PALAVRAS;
+    uint64_t semente=argc>4?strtoull(argv[4],NULL,0):gerarSemente();
+    long long inicio;
+    double duracao;
+    Dicionario d;
+    Solucionador solucionador;
+    ThreadSimulacao *ts;
+    if(threads<=0)  threads=(int)sysconf(_SC_NPROCESSORS_ONLN);
+    if(abrirDicionario(&d,arquivo)<0||d.quantidade==0){
+        printf("Erro ao abrir o arquivo: %s\n",arquivo);
+        return 1;
+    }
+    inicio=relogioNs();
+    if(criarSolucionador(&solucionador,&d)<0){
+        printf("Erro ao montar o solucionador\n");
+        return 1;
+    }
+    printf("%d palavras; tabelas montadas em %.2f ms\n",d.quantidade,(relogioNs()-inicio)/1e6);
+    ts=calloc(threads,sizeof(ThreadSimulacao));
+    inicio=relogioNs();
+    for(i=0;i<threads;i++){
+        ts[i].solucionador=&solucionador;
+        ts[i].primeira=i>0?ts[i-1].primeira+ts[i-1].partidas:0;
+        ts[i].partidas=partidas/threads+(i<partidas%threads);
+        ts[i].semente=semente;
+        pthread_create(&ts[i].thread,NULL,simularPartidas,&ts[i]);
+    }
+    for(i=0;i<threads;i++){
+        pthread_join(ts[i].thread,NULL);
+        vitorias+=ts[i].vitorias;
+        palpites+=ts[i].palpites;
+        vidas+=ts[i].vidasRestantes;
+        falhas+=ts[i].falhas;
+    }
+    duracao=(relogioNs()-inicio)/1e9;
+    printf("partidas:  %lld em %.3f s com %d threads (%.0f partidas/s)\n",partidas,duracao,threads,partidas/duracao);
+    printf("vitorias:  %.2f%% (vidas=%d, penalidades: repetida=%d, palavra=%d)\n",
+           partidas?100.0*vitorias/partidas:0.0,VIDAS,PENALIDADE_REPETIDA,PENALIDADE_PALAVRA);
+    printf("semente:   %llu (soma de palpites: %lld)\n",(unsigned long long)semente,palpites);
+    printf("palpites:  %.2f por partida\n",partidas?(double)palpites/partidas:0.0);
+    if(vitorias>0)  printf("vidas:     %.2f restantes por vitoria\n",(double)vidas/vitorias);
+    if(falhas>0)    printf("falhas:    %lld\n",falhas);
+    destruirSolucionador(&solucionador);
+    fecharDicionario(&d);
+    free(ts);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+/**
+ * @file bench_tela.c
+ * @brief Microbenchmark do tempo de desenho de um quadro da partida.
+ *
+ * Joga partidas com chutes em ordem de frequencia e mede o tempo de
+ * cada quadro pelos dois caminhos: o antigo (system("clear") seguido
+ * de desenharForca(), com um printf por letra) e o novo (desenharQuadro(),
+ * que reescreve so as linhas alteradas com um unico write()).
+ *
+ * Os quadros vao para o stdout e o relatorio para o stderr. Para medir
+ * tambem o custo do terminal, rode direto no terminal (ou por SSH); para
+ * medir so o programa, redirecione o stdout para /dev/null.
+ *
+ * Compilacao: gcc -O2 -pthread -I. ferramentas/bench_tela.c tela.c sessao.c forca.c dicionario.c registro.c aleatorio.c perfis.c -o bench_tela
+ * Uso: ./bench_tela [quadros] > /dev/null
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "forca.h"
+#include "sessao.h"
+#include "tela.h"
+
+// Letras do portugues em ordem aproximada de frequencia.
+#define ORDEM_LETRAS "AEOSRINDMUTCLPVGHQBFZJXKWY"
+
+/**
+ * @brief Avanca a partida simulada em um chute, recomecando ao fim.
+ * @param s A sessao.
+ * @param proxima O indice do proximo chute em ORDEM_LETRAS.
+ * @return 1 se uma nova partida comecou, 0 caso contrario.
+ */
+static int avancarPartida (Sessao *s, int *proxima){
+    chutarLetra(s,ORDEM_LETRAS[(*proxima)++]);
+    if(consultarSessao(s)!=SESSAO_EM_JOGO||*proxima>=TAM_ALFABETO){
+        iniciarSessao(s,"bench","PARALELEPIPEDO");
+        *proxima=0;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Compara dois tempos para o qsort.
+ * @param a Ponteiro para o primeiro tempo.
+ * @param b Ponteiro para o segundo tempo.
+ * @return Negativo, zero ou positivo, como em strcmp.
+ */
+static int compararTempos (const void *a, const void *b){
+    long long x=*(const long long *)a,y=*(const long long *)b;
+    return (x>y)-(x<y);
+}
+
+/**
+ * @brief Imprime a media e os percentis dos tempos de quadro.
+ * @param nome O nome do caminho medido.
+ * @param tempos Os tempos de cada quadro, em ns (reordenados).
+ * @param n O numero de quadros.
+ */
+static void relatar (const char *nome, long long *tempos, int n){
+    long long soma=0;
+    int i;
+    for(i=0;i<n;i++)    soma+=tempos[i];
+    qsort(tempos,n,sizeof(long long),compararTempos);
+    fprintf(stderr,"%-28s media %9.1f us  p50 %9.1f us  p99 %9.1f us\n",nome,soma/1e3/n,
+            tempos[n/2]/1e3,tempos[(int)(n*0.99)]/1e3);
+}
+
+int main (int argc, char *argv[]){
+    int quadros=argc>1?atoi(argv[1]):2000,i,proxima=0;
+    long long inicio,*tempos;
+    static Tela tela;
+    Sessao s;
+    if(quadros<1)   quadros=1;
+    tempos=malloc(quadros*sizeof(long long));
+    // Caminho antigo: um processo para limpar a tela e um printf por caractere.
+    iniciarSessao(&s,"bench","PARALELEPIPEDO");
+    for(i=0;i<quadros;i++){
+        inicio=relogioNs();
+        if(system("clear")<0)   break;
+        desenharForca(&s.jogador,s.palavraNaForca,s.letras);
+        fflush(stdout);
+        tempos[i]=relogioNs()-inicio;
+        avancarPartida(&s,&proxima);
+    }
+    relatar("system(\"clear\")+printf",tempos,quadros);
+    // Caminho novo: so as linhas alteradas, em uma unica escrita.
+    iniciarTela(&tela);
+    iniciarSessao(&s,"bench","PARALELEPIPEDO");
+    proxima=0;
+    limparTela(&tela);
+    for(i=0;i<quadros;i++){
+        inicio=relogioNs();
+        desenharQuadro(&tela,&s.jogador,s.palavraNaForca,s.letras);
+        tempos[i]=relogioNs()-inicio;
+        if(avancarPartida(&s,&proxima)) limparTela(&tela);
+    }
+    relatar("desenharQuadro (1 write)",tempos,quadros);
+    free(tempos);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,550 @@
+/**
+ * @file cliente.c
+ * @brief Gerador de carga e medicao de latencia para o modo servidor.
+ *
+ * Simula jogadores conectados ao servidor (forca --servidor). Cada jogador
+ * segue o fluxo do jogo no terminal: pede uma partida (NOVO), chuta letras
+ * (L) em ordem de frequencia do portugues e, quando falta uma unica letra,
+ * tenta a palavra inteira (P). Cada jogador mantem apenas um comando
+ * pendente (carga em laco fechado) e, com --pensar, espera um tempo
+ * sorteado entre receber uma resposta e enviar o proximo comando. As
+ * esperas sao eventos de uma agenda por thread (agenda.h).
+ *
+ * Sem --chegadas, os N jogadores conectam no inicio e jogam ate o fim da
+ * medicao. Com --chegadas, novos jogadores chegam na taxa pedida (com
+ * intervalos sorteados), jogam --partidas partidas e desconectam; uma
+ * chegada que encontraria N jogadores ativos e contada como perdida.
+ *
+ * Ao final, o programa informa as partidas por segundo, os erros e os
+ * percentis da latencia dos palpites e dos NOVO (do envio do comando a
+ * resposta, sem o tempo de pensar) e, com --saida, grava o mesmo resumo
+ * em JSON.
+ *
+ * Compilacao: gcc -O2 -pthread -I. ferramentas/cliente.c forca.c dicionario.c registro.c aleatorio.c perfis.c agenda.c -o cliente
+ * Uso: ./cliente [--porta N | --unix caminho] [--conexoes N] [--threads N] [--segundos N]
+ *                [--pensar ms] [--chegadas por segundo] [--partidas N] [--semente N] [--saida arquivo.json]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "forca.h"
+#include "servidor.h"
+#include "agenda.h"
+#include "aleatorio.h"
+
+// Maior latencia registrada individualmente no histograma, em microssegundos.
+#define LATENCIA_MAX_US 1000000
+// Letras do portugues em ordem aproximada de frequencia.
+#define ORDEM_LETRAS "AEOSRINDMUTCLPVGHQBFZJXKWY"
+
+// Tipo do comando pendente de um jogador (define o histograma da resposta).
+#define COMANDO_NOME 0
+#define COMANDO_NOVO 1
+#define COMANDO_PALPITE 2
+
+struct ThreadCliente;
+
+/**
+ * @struct ConexaoCliente
+ * @brief Estado de um jogador simulado.
+ */
+typedef struct{
+    int fd;                         // -1 enquanto a vaga estiver livre.
+    struct ThreadCliente *thread;
+    char entrada[TAM_MAX_LINHA];    // Bytes recebidos ainda sem '\n'.
+    int tamEntrada;
+    int proximaLetra;               // Indice em ORDEM_LETRAS do proximo chute.
+    int partidas;                   // Partidas terminadas por este jogador.
+    int tipo;                       // COMANDO_* do comando pendente.
+    char comando[TAM_MAX_LINHA];    // Proximo comando, enviado ao fim do tempo de pensar.
+    long long enviadoEm;            // Instante do envio do comando pendente.
+    EventoAgenda pensa;             // Fim do tempo de pensar.
+    int proximaLivre;               // Proxima vaga livre (lista de vagas).
+} ConexaoCliente;
+
+/**
+ * @struct Resultado
+ * @brief Contadores de uma medicao.
+ */
+typedef struct{
+    long long respostas,partidas,vitorias,erros;
+    long long chegadas,perdidas;    // Jogadores que chegaram e que nao encontraram vaga.
+} Resultado;
+
+/**
+ * @struct ThreadCliente
+ * @brief Jogadores e estatisticas de uma thread do cliente.
+ */
+typedef struct ThreadCliente{
+    ConexaoCliente *conexoes;
+    int quantidade;
+    int livre;                      // Primeira vaga livre, ou -1.
+    int epoll;
+    long long fim;                  // Instante em que a medicao termina.
+    Resultado resultado;
+    unsigned int *palpites;         // Contagem por latencia dos palpites, em microssegundos.
+    unsigned int *novos;            // Contagem por latencia dos NOVO, em microssegundos.
+    Agenda agenda;
+    Aleatorio aleatorio;
+    EventoAgenda chegada;           // Proxima verificacao das chegadas.
+    long long proximaChegada;       // Instante da proxima chegada, em ns.
+    long long intervaloChegadas;    // Intervalo medio entre chegadas nesta thread, em ns.
+    pthread_t thread;
+} ThreadCliente;
+
+static int porta=PORTA_PADRAO;
+static const char *caminhoUnix=NULL;
+static int pensarMs=0;
+static int partidasPorJogador=0;
+
+static void encerrarJogador (ThreadCliente *t, ConexaoCliente *c);
+
+/**
+ * @brief Abre uma conexao com o servidor.
+ * @return O socket conectado, ou -1 em caso de erro.
+ */
+static int conectar (void){
+    int fd,um=1;
+    if(caminhoUnix!=NULL){
+        struct sockaddr_un endereco;
+        fd=socket(AF_UNIX,SOCK_STREAM,0);
+        memset(&endereco,0,sizeof(endereco));
+        endereco.sun_family=AF_UNIX;
+        strncpy(endereco.sun_path,caminhoUnix,sizeof(endereco.sun_path)-1);
+        if(fd<0||connect(fd,(struct sockaddr *)&endereco,sizeof(endereco))<0){
+            if(fd>=0)   close(fd);
+            return -1;
+        }
+    }
+    else{
+        struct sockaddr_in endereco;
+        fd=socket(AF_INET,SOCK_STREAM,0);
+        memset(&endereco,0,sizeof(endereco));
+        endereco.sin_family=AF_INET;
+        endereco.sin_port=htons(porta);
+        endereco.sin_addr.s_addr=htonl(INADDR_LOOPBACK);
+        if(fd<0||connect(fd,(struct sockaddr *)&endereco,sizeof(endereco))<0){
+            if(fd>=0)   close(fd);
+            return -1;
+        }
+        setsockopt(fd,IPPROTO_TCP,TCP_NODELAY,&um,sizeof(um));
+    }
+    return fd;
+}
+
+/**
+ * @brief Envia um comando e marca o instante do envio.
+ * @param c O jogador.
+ * @param comando A linha a ser enviada, com '\n'.
+ * @param tipo O COMANDO_* da linha.
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+static int enviarComando (ConexaoCliente *c, const char *comando, int tipo){
+    size_t n=strlen(comando);
+    c->tipo=tipo;
+    c->enviadoEm=relogioNs();
+    return send(c->fd,comando,n,MSG_NOSIGNAL)==(ssize_t)n?0:-1;
+}
+
+/**
+ * @brief Envia o comando guardado ao fim do tempo de pensar (acao da agenda).
+ * @param dados O jogador.
+ */
+static void enviarGuardado (void *dados){
+    ConexaoCliente *c = dados;
+    if(enviarComando(c,c->comando,c->tipo)<0){
+        c->thread->resultado.erros++;
+        encerrarJogador(c->thread,c);
+    }
+}
+
+/**
+ * @brief Envia o proximo comando, depois do tempo de pensar se ele estiver ativo.
+ * @param t A thread do cliente.
+ * @param c O jogador.
+ * @param comando A linha a ser enviada, com '\n'.
+ * @param tipo O COMANDO_* da linha.
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+static int agendarComando (ThreadCliente *t, ConexaoCliente *c, const char *comando, int tipo){
+    if(pensarMs<=0) return enviarComando(c,comando,tipo);
+    // Espera uniforme entre 0 e o dobro da media pedida.
+    strcpy(c->comando,comando);
+    c->tipo=tipo;
+    agendarEvento(&t->agenda,&c->pensa,(int)sortearIntervalo(&t->aleatorio,2*pensarMs+1),enviarGuardado,c);
+    return 0;
+}
+
+/**
+ * @brief Conecta um jogador em uma vaga livre e envia o seu nome.
+ * @param t A thread do cliente.
+ * @param c A vaga.
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+static int iniciarJogador (ThreadCliente *t, ConexaoCliente *c){
+    struct epoll_event ev;
+    c->fd=conectar();
+    if(c->fd<0) return -1;
+    c->thread=t;
+    c->tamEntrada=0;
+    c->partidas=0;
+    ev.events=EPOLLIN;
+    ev.data.ptr=c;
+    epoll_ctl(t->epoll,EPOLL_CTL_ADD,c->fd,&ev);
+    if(enviarComando(c,"NOME carga\n",COMANDO_NOME)<0){
+        epoll_ctl(t->epoll,EPOLL_CTL_DEL,c->fd,NULL);
+        close(c->fd);
+        c->fd=-1;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Desconecta um jogador e libera a sua vaga.
+ * @param t A thread do cliente.
+ * @param c O jogador.
+ */
+static void encerrarJogador (ThreadCliente *t, ConexaoCliente *c){
+    cancelarEvento(&t->agenda,&c->pensa);
+    epoll_ctl(t->epoll,EPOLL_CTL_DEL,c->fd,NULL);
+    close(c->fd);
+    c->fd=-1;
+    c->proximaLivre=t->livre;
+    t->livre=(int)(c-t->conexoes);
+}
+
+/**
+ * @brief Ocupa uma vaga livre com um novo jogador.
+ * @param t A thread do cliente.
+ * @return 0 em caso de sucesso, -1 se nao houver vaga ou a conexao falhar.
+ */
+static int ocuparVaga (ThreadCliente *t){
+    ConexaoCliente *c;
+    if(t->livre<0)  return -1;
+    c=&t->conexoes[t->livre];
+    t->livre=c->proximaLivre;
+    if(iniciarJogador(t,c)<0){
+        t->resultado.erros++;
+        c->proximaLivre=t->livre;
+        t->livre=(int)(c-t->conexoes);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Recebe os jogadores que chegaram desde a ultima verificacao (acao da agenda).
+ * @param dados A ThreadCliente.
+ */
+static void receberChegadas (void *dados){
+    ThreadCliente *t = dados;
+    long long agora=relogioNs();
+    while(t->proximaChegada<=agora){
+        t->resultado.chegadas++;
+        if(t->livre<0)  t->resultado.perdidas++;
+        else    ocuparVaga(t);
+        // Intervalos uniformes entre 0 e o dobro da media.
+        t->proximaChegada+=(long long)sortearIntervalo(&t->aleatorio,(uint32_t)(2*t->intervaloChegadas/1000+1))*1000;
+    }
+    agendarEvento(&t->agenda,&t->chegada,(int)((t->proximaChegada-agora)/1000000),receberChegadas,t);
+}
+
+/**
+ * @brief Decide o proximo comando a partir da resposta recebida.
+ * @param t A thread do cliente.
+ * @param c O jogador.
+ * @param linha A resposta do servidor.
+ * @return 0 em caso de sucesso, 1 se o jogador terminou as suas partidas, -1 se ele deve ser descartado.
+ */
+static int tratarResposta (ThreadCliente *t, ConexaoCliente *c, const char *linha){
+    char comando[TAM_MAX_LINHA],forca[TAM_MAX_MASCARA+1];
+    char *falta;
+    if(strncmp(linha,"FALHA",5)==0) t->resultado.erros++;
+    // Resposta ao NOME, ou partida terminada: comeca a proxima.
+    if(strcmp(linha,"OK")==0||strstr(linha,"VITORIA")!=NULL||strstr(linha,"DERROTA")!=NULL){
+        if(strstr(linha,"VITORIA")!=NULL)   t->resultado.vitorias++;
+        if(strcmp(linha,"OK")!=0){
+            t->resultado.partidas++;
+            c->partidas++;
+        }
+        if(partidasPorJogador>0&&c->partidas>=partidasPorJogador)   return 1;
+        c->proximaLetra=0;
+        return agendarComando(t,c,"NOVO\n",COMANDO_NOVO);
+    }
+    if(c->proximaLetra>=26){
+        t->resultado.erros++;
+        return agendarComando(t,c,"NOVO\n",COMANDO_NOVO);
+    }
+    // Com uma unica letra faltando, o jogador arrisca a palavra inteira.
+    if(sscanf(linha,"%*s %*s %*d %64s",forca)==1&&(falta=strchr(forca,'_'))!=NULL&&strchr(falta+1,'_')==NULL){
+        *falta=ORDEM_LETRAS[c->proximaLetra++];
+        snprintf(comando,sizeof(comando),"P %s\n",forca);
+    }
+    else    snprintf(comando,sizeof(comando),"L %c\n",ORDEM_LETRAS[c->proximaLetra++]);
+    return agendarComando(t,c,comando,COMANDO_PALPITE);
+}
+
+/**
+ * @brief Le as respostas de um jogador e reage a cada linha completa.
+ * @param t A thread do cliente.
+ * @param c O jogador.
+ */
+static void lerRespostas (ThreadCliente *t, ConexaoCliente *c){
+    char buffer[4096];
+    long long agora,latencia;
+    ssize_t lidos=recv(c->fd,buffer,sizeof(buffer),0);
+    int j,r;
+    if(lidos<=0){
+        t->resultado.erros++;
+        encerrarJogador(t,c);
+        return;
+    }
+    agora=relogioNs();
+    for(j=0;j<lidos;j++){
+        if(buffer[j]!='\n'){
+            if(c->tamEntrada<TAM_MAX_LINHA-1)   c->entrada[c->tamEntrada++]=buffer[j];
+            continue;
+        }
+        c->entrada[c->tamEntrada]='\0';
+        c->tamEntrada=0;
+        latencia=(agora-c->enviadoEm)/1000;
+        if(latencia>LATENCIA_MAX_US)    latencia=LATENCIA_MAX_US;
+        if(c->tipo==COMANDO_PALPITE)    t->palpites[latencia]++;
+        else if(c->tipo==COMANDO_NOVO)  t->novos[latencia]++;
+        t->resultado.respostas++;
+        r=tratarResposta(t,c,c->entrada);
+        if(r<0) t->resultado.erros++;
+        if(r!=0){
+            encerrarJogador(t,c);
+            // Sem chegadas, a populacao e fixa: outro jogador ocupa a vaga.
+            if(r>0&&t->intervaloChegadas==0)    ocuparVaga(t);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Laco de uma thread do cliente.
+ * @param arg A ThreadCliente.
+ * @return Sempre NULL.
+ */
+static void *executarThread (void *arg){
+    ThreadCliente *t = arg;
+    struct epoll_event eventos[256];
+    long long agora;
+    int i,n,espera;
+    if(t->intervaloChegadas>0){
+        t->proximaChegada=relogioNs();
+        receberChegadas(t);
+    }
+    while((agora=relogioNs())<t->fim){
+        // Acorda a tempo do proximo fim de espera ou da proxima chegada.
+        espera=tempoAteProximo(&t->agenda,agora);
+        if(espera<0||espera>100)    espera=100;
+        n=epoll_wait(t->epoll,eventos,256,espera);
+        for(i=0;i<n;i++){
+            ConexaoCliente *c = eventos[i].data.ptr;
+            if(c->fd>=0)    lerRespostas(t,c);
+        }
+        processarAgenda(&t->agenda,relogioNs());
+    }
+    for(i=0;i<t->quantidade;i++)
+        if(t->conexoes[i].fd>=0)    close(t->conexoes[i].fd);
+    close(t->epoll);
+    return NULL;
+}
+
+/**
+ * @struct Percentis
+ * @brief Resumo de um histograma de latencias, em microssegundos.
+ */
+typedef struct{
+    long long total;
+    int p50,p90,p99,p999,max;
+} Percentis;
+
+/**
+ * @brief Retorna a latencia (em us) abaixo da qual esta a fracao p das respostas.
+ * @param histograma O histograma combinado.
+ * @param total O total de respostas.
+ * @param p A fracao desejada (0 a 1).
+ * @return A latencia em microssegundos.
+ */
+static int percentil (const unsigned long long *histograma, long long total, double p){
+    long long alvo=(long long)(total*p),acumulado=0;
+    int i;
+    for(i=0;i<=LATENCIA_MAX_US;i++){
+        acumulado+=histograma[i];
+        if(acumulado>alvo)  return i;
+    }
+    return LATENCIA_MAX_US;
+}
+
+/**
+ * @brief Calcula os percentis de um histograma combinado.
+ * @param histograma O histograma.
+ * @param p Recebe o resumo.
+ */
+static void calcularPercentis (const unsigned long long *histograma, Percentis *p){
+    int i;
+    memset(p,0,sizeof(Percentis));
+    for(i=0;i<=LATENCIA_MAX_US;i++){
+        p->total+=histograma[i];
+        if(histograma[i]>0) p->max=i;
+    }
+    p->p50=percentil(histograma,p->total,0.5);
+    p->p90=percentil(histograma,p->total,0.9);
+    p->p99=percentil(histograma,p->total,0.99);
+    p->p999=percentil(histograma,p->total,0.999);
+}
+
+/**
+ * @brief Grava o resumo da medicao em JSON.
+ * @param nome O arquivo.
+ * @param r Os contadores.
+ * @param palpites Os percentis dos palpites.
+ * @param novos Os percentis dos NOVO.
+ * @param conexoes O numero de jogadores (maximo, com chegadas).
+ * @param threads O numero de threads.
+ * @param chegadas As chegadas por segundo (0 = populacao fixa).
+ * @param duracao A duracao da medicao, em segundos.
+ * @return 0 em caso de sucesso, -1 caso contrario.
+ */
+static int gravarJson (const char *nome, const Resultado *r, const Percentis *palpites, const Percentis *novos,
+                       int conexoes, int threads, double chegadas, double duracao){
+    const Percentis *ps[]={palpites,novos};
+    const char *nomes[]={"palpites","novos"};
+    int i;
+    FILE *arq = fopen(nome,"w");
+    if(arq==NULL){
+        printf("Erro ao abrir o arquivo: %s\n",nome);
+        return -1;
+    }
+    fprintf(arq,"{\n  \"transporte\": \"%s\",\n  \"conexoes\": %d,\n  \"threads\": %d,\n  \"pensar_ms\": %d,\n",
+            caminhoUnix!=NULL?"unix":"tcp",conexoes,threads,pensarMs);
+    fprintf(arq,"  \"chegadas_por_segundo\": %g,\n  \"partidas_por_jogador\": %d,\n  \"segundos\": %.3f,\n",
+            chegadas,partidasPorJogador,duracao);
+    fprintf(arq,"  \"respostas\": %lld,\n  \"respostas_por_segundo\": %.1f,\n",r->respostas,r->respostas/duracao);
+    fprintf(arq,"  \"partidas\": %lld,\n  \"partidas_por_segundo\": %.1f,\n  \"vitorias\": %lld,\n",
+            r->partidas,r->partidas/duracao,r->vitorias);
+    fprintf(arq,"  \"erros\": %lld,\n  \"chegadas\": %lld,\n  \"perdidas\": %lld,\n",r->erros,r->chegadas,r->perdidas);
+    for(i=0;i<2;i++)
+        fprintf(arq,"  \"latencia_%s_us\": {\"total\": %lld, \"p50\": %d, \"p90\": %d, \"p99\": %d, \"p999\": %d, \"max\": %d}%s\n",
+                nomes[i],ps[i]->total,ps[i]->p50,ps[i]->p90,ps[i]->p99,ps[i]->p999,ps[i]->max,i==0?",":"");
+    fprintf(arq,"}\n");
+    fclose(arq);
+    return 0;
+}
+
+int main (int argc, char *argv[]){
+    int conexoes=100,threads=1,segundos=10,i,j,abertas=0;
+    long long inicio;
+    unsigned long long *palpites,*novos;
+    uint64_t semente=42;
+    double duracao,chegadas=0;
+    const char *saida=NULL;
+    Resultado r;
+    Percentis pp,pn;
+    ThreadCliente *ts;
+    struct rlimit limite;
+    for(i=1;i<argc;i++){
+        if(strcmp(argv[i],"--porta")==0&&i+1<argc)   porta=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--unix")==0&&i+1<argc)   caminhoUnix=argv[++i];
+        else if(strcmp(argv[i],"--conexoes")==0&&i+1<argc)   conexoes=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--threads")==0&&i+1<argc)    threads=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--segundos")==0&&i+1<argc)   segundos=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--pensar")==0&&i+1<argc) pensarMs=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--chegadas")==0&&i+1<argc)   chegadas=atof(argv[++i]);
+        else if(strcmp(argv[i],"--partidas")==0&&i+1<argc)   partidasPorJogador=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--semente")==0&&i+1<argc)    semente=strtoull(argv[++i],NULL,10);
+        else if(strcmp(argv[i],"--saida")==0&&i+1<argc) saida=argv[++i];
+        else{
+            printf("Opcao invalida: %s\n",argv[i]);
+            return 1;
+        }
+    }
+    if(threads<1)   threads=1;
+    if(conexoes<threads)    conexoes=threads;
+    // Com chegadas, cada jogador joga uma partida se --partidas nao for informado.
+    if(chegadas>0&&partidasPorJogador<=0)   partidasPorJogador=1;
+    // Milhares de conexoes exigem um limite de descritores maior que o padrao.
+    if(getrlimit(RLIMIT_NOFILE,&limite)==0){
+        limite.rlim_cur=limite.rlim_max;
+        setrlimit(RLIMIT_NOFILE,&limite);
+    }
+    ts=calloc(threads,sizeof(ThreadCliente));
+    for(i=0;i<threads;i++){
+        ts[i].quantidade=conexoes/threads+(i<conexoes%threads);
+        ts[i].conexoes=calloc(ts[i].quantidade,sizeof(ConexaoCliente));
+        ts[i].palpites=calloc(LATENCIA_MAX_US+1,sizeof(unsigned int));
+        ts[i].novos=calloc(LATENCIA_MAX_US+1,sizeof(unsigned int));
+        ts[i].epoll=epoll_create1(0);
+        iniciarAgenda(&ts[i].agenda,1);
+        semearFluxo(&ts[i].aleatorio,semente,(uint64_t)i);
+        ts[i].intervaloChegadas=chegadas>0?(long long)(threads*1e9/chegadas):0;
+        ts[i].livre=-1;
+        for(j=ts[i].quantidade-1;j>=0;j--){
+            ts[i].conexoes[j].fd=-1;
+            ts[i].conexoes[j].proximaLivre=ts[i].livre;
+            ts[i].livre=j;
+        }
+        if(chegadas>0)  continue;
+        // Sem chegadas, todos os jogadores conectam antes da medicao.
+        for(j=0;j<ts[i].quantidade;j++){
+            if(ocuparVaga(&ts[i])<0){
+                printf("Erro ao conectar (%d conexoes abertas): %s\n",abertas,strerror(errno));
+                return 1;
+            }
+            abertas++;
+        }
+    }
+    if(chegadas>0)  printf("ate %d jogadores, %.0f chegadas/s, %d partida(s) cada; medindo por %d s...\n",
+                           conexoes,chegadas,partidasPorJogador,segundos);
+    else    printf("%d conexoes abertas; medindo por %d s...\n",abertas,segundos);
+    inicio=relogioNs();
+    for(i=0;i<threads;i++){
+        ts[i].fim=inicio+segundos*1000000000LL;
+        pthread_create(&ts[i].thread,NULL,executarThread,&ts[i]);
+    }
+    palpites=calloc(LATENCIA_MAX_US+1,sizeof(unsigned long long));
+    novos=calloc(LATENCIA_MAX_US+1,sizeof(unsigned long long));
+    memset(&r,0,sizeof(r));
+    for(i=0;i<threads;i++){
+        pthread_join(ts[i].thread,NULL);
+        r.respostas+=ts[i].resultado.respostas;
+        r.partidas+=ts[i].resultado.partidas;
+        r.vitorias+=ts[i].resultado.vitorias;
+        r.erros+=ts[i].resultado.erros;
+        r.chegadas+=ts[i].resultado.chegadas;
+        r.perdidas+=ts[i].resultado.perdidas;
+        for(j=0;j<=LATENCIA_MAX_US;j++){
+            palpites[j]+=ts[i].palpites[j];
+            novos[j]+=ts[i].novos[j];
+        }
+    }
+    duracao=(relogioNs()-inicio)/1e9;
+    calcularPercentis(palpites,&pp);
+    calcularPercentis(novos,&pn);
+    printf("respostas: %lld (%.0f/s)\n",r.respostas,r.respostas/duracao);
+    printf("partidas:  %lld (%.0f/s), vitorias: %.1f%%\n",r.partidas,r.partidas/duracao,r.partidas?100.0*r.vitorias/r.partidas:0.0);
+    printf("erros:     %lld\n",r.erros);
+    if(chegadas>0)  printf("chegadas:  %lld, perdidas (sem vaga): %lld\n",r.chegadas,r.perdidas);
+    if(pp.total>0)
+        printf("palpites (us): p50 %d  p90 %d  p99 %d  p99.9 %d  max %d\n",pp.p50,pp.p90,pp.p99,pp.p999,pp.max);
+    if(pn.total>0)
+        printf("NOVO (us):     p50 %d  p90 %d  p99 %d  p99.9 %d  max %d\n",pn.p50,pn.p90,pn.p99,pn.p999,pn.max);
+    if(saida!=NULL&&gravarJson(saida,&r,&pp,&pn,conexoes,threads,chegadas,duracao)<0)    return 1;
+    return 0;
+}
\ No newline at end of file
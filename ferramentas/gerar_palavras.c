@@ -0,0 +1,116 @@
+/**
+ * @file gerar_palavras.c
+ * @brief Gera o banco de palavras embutido (palavras_embutidas.h).
+ *
+ * Le o arquivo de palavras com abrirDicionario (mesmas regras de
+ * aparagem e de tamanho maximo do jogo) e escreve um cabecalho com as
+ * tabelas ja prontas: o texto das palavras, o deslocamento e o
+ * comprimento de cada uma e o conjunto das suas letras. Compilado com
+ * -DFORCA_PALAVRAS_EMBUTIDAS, dicionario.c inclui esse cabecalho e o
+ * executavel passa a sortear palavras sem ler nenhum arquivo.
+ *
+ * Compilacao: gcc -O2 -pthread -I. ferramentas/gerar_palavras.c forca.c dicionario.c registro.c aleatorio.c perfis.c -o gerar_palavras
+ * Uso: ./gerar_palavras [palavras.txt] [palavras_embutidas.h]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "forca.h"
+#include "dicionario.h"
+
+// Valores por linha nas tabelas numericas do cabecalho.
+#define VALORES_POR_LINHA 16
+
+/**
+ * @brief Escreve um caractere dentro de uma string literal de C.
+ *
+ * Aspas, barras, '?' (trigrafos) e bytes fora do ASCII imprimivel saem
+ * como sequencias de escape octais de tres digitos.
+ *
+ * @param arq O arquivo de saida.
+ * @param c O caractere.
+ */
+static void escreverCaractere (FILE *arq, unsigned char c){
+    if(c>=' '&&c<='~'&&c!='"'&&c!='\\'&&c!='?')  fputc(c,arq);
+    else    fprintf(arq,"\\%03o",c);
+}
+
+/**
+ * @brief Calcula o conjunto de letras de uma palavra.
+ * @param palavra A palavra (nao terminada em '\0').
+ * @param n O comprimento da palavra.
+ * @return As letras da palavra (bit 0 = A), sem diferenciar maiusculas.
+ */
+static uint32_t letrasDaPalavra (const char *palavra, int n){
+    uint32_t letras=0;
+    int i;
+    for(i=0;i<n;i++){
+        char c=palavra[i]&~0x20;
+        if(c>='A'&&c<='Z')  letras|=1u<<(c-'A');
+    }
+    return letras;
+}
+
+int main (int argc, char *argv[]){
+    const char *entrada=argc>1?argv[1]:ARQUIVO_PALAVRAS,*saida=argc>2?argv[2]:"palavras_embutidas.h",*p;
+    Dicionario d;
+    FILE *arq;
+    uint32_t deslocamento=0;
+    int i,j,n;
+    if(abrirDicionario(&d,entrada)<0||d.quantidade==0){
+        printf("Erro ao abrir o arquivo: %s\n",entrada);
+        return 1;
+    }
+    arq=fopen(saida,"w");
+    if(arq==NULL){
+        printf("Erro ao abrir o arquivo: %s\n",saida);
+        fecharDicionario(&d);
+        return 1;
+    }
+    fprintf(arq,"/**\n * @file palavras_embutidas.h\n");
+    fprintf(arq," * @brief Banco de palavras embutido, gerado a partir de %s.\n *\n",entrada);
+    fprintf(arq," * Gerado por ferramentas/gerar_palavras.c; nao edite. Incluido apenas\n");
+    fprintf(arq," * por dicionario.c, quando compilado com -DFORCA_PALAVRAS_EMBUTIDAS.\n */\n\n");
+    fprintf(arq,"#define QUANTIDADE_EMBUTIDAS %d\n\n",d.quantidade);
+
+    // Texto das palavras ja aparadas, uma por linha, como num arquivo.
+    fprintf(arq,"static const char dadosEmbutidos[] =\n");
+    for(i=0;i<d.quantidade;i++){
+        p=obterPalavra(&d,i,&n);
+        fprintf(arq,"    \"");
+        for(j=0;j<n;j++)    escreverCaractere(arq,(unsigned char)p[j]);
+        fprintf(arq,"\\n\"%s\n",i==d.quantidade-1?";":"");
+    }
+
+    // Deslocamento de cada palavra no texto acima.
+    fprintf(arq,"\nstatic const uint32_t inicioEmbutidos[QUANTIDADE_EMBUTIDAS] = {");
+    for(i=0;i<d.quantidade;i++){
+        obterPalavra(&d,i,&n);
+        fprintf(arq,"%s%u,",i%VALORES_POR_LINHA==0?"\n    ":"",deslocamento);
+        deslocamento+=n+1;
+    }
+    fprintf(arq,"\n};\n");
+
+    fprintf(arq,"\nstatic const uint8_t tamanhoEmbutidos[QUANTIDADE_EMBUTIDAS] = {");
+    for(i=0;i<d.quantidade;i++){
+        obterPalavra(&d,i,&n);
+        fprintf(arq,"%s%d,",i%VALORES_POR_LINHA==0?"\n    ":"",n);
+    }
+    fprintf(arq,"\n};\n");
+
+    fprintf(arq,"\nstatic const uint32_t letrasEmbutidas[QUANTIDADE_EMBUTIDAS] = {");
+    for(i=0;i<d.quantidade;i++){
+        p=obterPalavra(&d,i,&n);
+        fprintf(arq,"%s0x%07x,",i%VALORES_POR_LINHA==0?"\n    ":"",letrasDaPalavra(p,n));
+    }
+    fprintf(arq,"\n};\n");
+
+    if(fclose(arq)!=0){
+        printf("Erro ao gravar o arquivo: %s\n",saida);
+        fecharDicionario(&d);
+        return 1;
+    }
+    printf("%d palavras (%u bytes) gravadas em %s\n",d.quantidade,deslocamento,saida);
+    fecharDicionario(&d);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,686 @@
+/**
+ * @file montar_dicionario.c
+ * @brief Monta um dicionario binario (dicionario.h) a partir de textos grandes.
+ *
+ * Os arquivos de entrada sao mapeados em memoria e divididos em trechos de
+ * TAM_TRECHO bytes, que as threads pegam de um contador atomico. Cada
+ * trecho comeca e termina em um separador ASCII (espaco, pontuacao), de
+ * modo que nenhuma palavra e nenhum caractere UTF-8 fica dividido entre
+ * duas threads. As letras sao dobradas para A a Z: maiusculas, minusculas
+ * e as letras acentuadas do Latin-1 ("a", "A", "a" com til e "A" com
+ * crase viram "A"), em UTF-8 ou em Latin-1. Palavras com digitos ou
+ * outras letras (gregas, cirilicas etc.) sao descartadas, assim como as
+ * mais curtas que --minimo e as mais longas que --maximo (no maximo
+ * TAM_MAX_MASCARA, o limite do jogo).
+ *
+ * As palavras distintas ficam em um conjunto hash de enderecamento aberto
+ * compartilhado pelas threads e sem trava: cada posicao e um inteiro de
+ * 64 bits preenchido com compare-and-swap. Uma palavra de ate TAM_CURTA
+ * letras cabe inteira na posicao (5 bits por letra), e a comparacao com a
+ * que ja esta la e uma so comparacao de inteiros; as mais longas ficam em
+ * blocos de cada thread e a posicao guarda o ponteiro. Quando a ocupacao
+ * passa da metade, as threads param entre duas palavras e a ultima a
+ * parar dobra a tabela.
+ *
+ * No fim, as palavras sao ordenadas (o resultado nao depende do numero de
+ * threads) e gravadas com as tabelas de deslocamentos, comprimentos e
+ * letras, prontas para abrirDicionario usar sem indexar nada.
+ *
+ * Compilacao: gcc -O2 -pthread -I. ferramentas/montar_dicionario.c forca.c dicionario.c registro.c aleatorio.c perfis.c -o montar_dicionario
+ * Uso: ./montar_dicionario [--threads N] [--minimo N] [--maximo N] saida entrada...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "forca.h"
+#include "dicionario.h"
+
+// Bytes de cada trecho da entrada distribuido entre as threads.
+#define TAM_TRECHO (4<<20)
+// Letras de uma palavra guardada inteira em uma posicao da tabela (5 bits cada).
+#define TAM_CURTA 12
+// Bit que distingue uma palavra curta de um ponteiro para uma longa.
+#define CURTA (1ULL<<63)
+// Posicoes iniciais da tabela, no minimo.
+#define CAPACIDADE_MINIMA (1<<18)
+// Palavras novas contadas por uma thread antes de somar ao total compartilhado.
+#define LOTE_CONTAGEM 256
+// Bytes de cada bloco das palavras longas.
+#define TAM_BLOCO (1<<20)
+
+// Classes dos bytes da entrada (as letras ASCII sao classificadas pela propria letra maiuscula).
+#define CLASSE_SEPARADOR ' '
+#define CLASSE_INVALIDA '?'
+#define CLASSE_MULTIBYTE '+'
+
+// Dobra de U+00C0 a U+00FF (Latin-1, ou UTF-8 depois de 0xC3): '?' nao e letra de A a Z e ' ' separa.
+static const char dobraLatin1[] = "AAAAAA?CEEEEIIII?NOOOOO OUUUUY??"
+                                  "AAAAAA?CEEEEIIII?NOOOOO OUUUUY?Y";
+
+static unsigned char classes[256];
+
+/**
+ * @struct PalavraLonga
+ * @brief Palavra com mais de TAM_CURTA letras, guardada fora da tabela.
+ */
+typedef struct{
+    uint64_t hash;
+    uint64_t codigo;        // As TAM_CURTA primeiras letras, como nas palavras curtas (para a ordenacao).
+    uint8_t tamanho;
+    char texto[];
+} PalavraLonga;
+
+/**
+ * @struct Conjunto
+ * @brief Conjunto das palavras distintas, compartilhado pelas threads.
+ */
+typedef struct{
+    _Atomic uint64_t *posicoes; // 0 = livre; CURTA|codigo; ou ponteiro para PalavraLonga.
+    uint64_t capacidade;        // Sempre potencia de 2.
+    atomic_uint_fast64_t usados;    // Palavras inseridas (somadas em lotes).
+    atomic_int crescer;         // 1 quando a tabela deve dobrar.
+    pthread_mutex_t trava;      // Protege os campos abaixo.
+    pthread_cond_t sinal;
+    int ativas;                 // Threads que ainda usam a tabela.
+    int paradas;                // Threads esperando o crescimento.
+    uint64_t geracao;           // Crescimentos ja feitos.
+} Conjunto;
+
+/**
+ * @struct Entrada
+ * @brief Um arquivo de entrada mapeado.
+ */
+typedef struct{
+    const unsigned char *dados;
+    size_t tamanho;
+} Entrada;
+
+/**
+ * @struct Trecho
+ * @brief Parte de um arquivo de entrada (antes do ajuste aos separadores).
+ */
+typedef struct{
+    int entrada;
+    size_t inicio,fim;
+} Trecho;
+
+/**
+ * @struct Trabalho
+ * @brief Dados de uma thread.
+ */
+typedef struct{
+    Conjunto *conjunto;
+    const Entrada *entradas;
+    const Trecho *trechos;
+    int numTrechos;
+    atomic_int *proximoTrecho;
+    int minimo,maximo;
+    char *bloco;            // Bloco atual das palavras longas (o primeiro campo aponta o anterior).
+    size_t usadoBloco;
+    int lote;               // Palavras novas ainda nao somadas a conjunto->usados.
+    uint64_t lidas,curtas,longas,invalidas,novas;
+    pthread_t thread;
+} Trabalho;
+
+/**
+ * @brief Preenche a tabela de classes dos bytes.
+ */
+static void montarClasses (void){
+    int c;
+    for(c=0;c<256;c++){
+        if(c>='A'&&c<='Z')  classes[c]=(unsigned char)c;
+        else if(c>='a'&&c<='z') classes[c]=(unsigned char)(c-'a'+'A');
+        else if((c>='0'&&c<='9')||c=='_')   classes[c]=CLASSE_INVALIDA;
+        else if(c>=0x80)    classes[c]=CLASSE_MULTIBYTE;
+        else    classes[c]=CLASSE_SEPARADOR;
+    }
+}
+
+/**
+ * @brief Espalha os bits de um valor (finalizador do splitmix64).
+ * @param z O valor.
+ * @return O hash.
+ */
+static uint64_t misturar (uint64_t z){
+    z=(z^(z>>30))*0xbf58476d1ce4e5b9ULL;
+    z=(z^(z>>27))*0x94d049bb133111ebULL;
+    return z^(z>>31);
+}
+
+/**
+ * @brief Calcula o hash de uma posicao ocupada da tabela.
+ * @param v O conteudo da posicao.
+ * @return O hash.
+ */
+static uint64_t hashPosicao (uint64_t v){
+    return (v&CURTA)?misturar(v):((const PalavraLonga *)(uintptr_t)v)->hash;
+}
+
+/**
+ * @brief Dobra a tabela, reinserindo as palavras (com as threads paradas).
+ * @param c O conjunto.
+ */
+static void crescerConjunto (Conjunto *c){
+    uint64_t capacidade=c->capacidade*2,i,j,v;
+    _Atomic uint64_t *nova = calloc(capacidade,sizeof(uint64_t));
+    if(nova==NULL){
+        printf("Sem memoria para %llu palavras.\n",(unsigned long long)c->capacidade);
+        exit(1);
+    }
+    for(i=0;i<c->capacidade;i++){
+        v=atomic_load_explicit(&c->posicoes[i],memory_order_relaxed);
+        if(v==0)    continue;
+        for(j=hashPosicao(v)&(capacidade-1);atomic_load_explicit(&nova[j],memory_order_relaxed)!=0;j=(j+1)&(capacidade-1));
+        atomic_store_explicit(&nova[j],v,memory_order_relaxed);
+    }
+    free((void *)c->posicoes);
+    c->posicoes=nova;
+    c->capacidade=capacidade;
+    c->paradas=0;
+    c->geracao++;
+    atomic_store(&c->crescer,0);
+    pthread_cond_broadcast(&c->sinal);
+}
+
+/**
+ * @brief Espera o crescimento da tabela; a ultima thread a chegar o faz.
+ * @param c O conjunto.
+ */
+static void pararParaCrescer (Conjunto *c){
+    uint64_t geracao;
+    pthread_mutex_lock(&c->trava);
+    geracao=c->geracao;
+    if(++c->paradas==c->ativas) crescerConjunto(c);
+    else
+        while(c->geracao==geracao)  pthread_cond_wait(&c->sinal,&c->trava);
+    pthread_mutex_unlock(&c->trava);
+}
+
+/**
+ * @brief Retira uma thread que terminou; se as outras ja esperam o crescimento, ela o faz.
+ * @param c O conjunto.
+ */
+static void sairDoConjunto (Conjunto *c){
+    pthread_mutex_lock(&c->trava);
+    c->ativas--;
+    if(c->ativas>0&&c->paradas==c->ativas&&atomic_load(&c->crescer))   crescerConjunto(c);
+    pthread_mutex_unlock(&c->trava);
+}
+
+/**
+ * @brief Copia uma palavra longa para o bloco da thread.
+ * @param t A thread.
+ * @param texto A palavra.
+ * @param n O comprimento.
+ * @param codigo As TAM_CURTA primeiras letras.
+ * @param hash O hash.
+ * @return A copia.
+ */
+static PalavraLonga *guardarLonga (Trabalho *t, const char *texto, int n, uint64_t codigo, uint64_t hash){
+    size_t tamanho=(sizeof(PalavraLonga)+n+7)&~(size_t)7;
+    PalavraLonga *p;
+    char *novo;
+    if(t->bloco==NULL||t->usadoBloco+tamanho>TAM_BLOCO){
+        novo=malloc(TAM_BLOCO);
+        if(novo==NULL){
+            printf("Sem memoria para as palavras longas.\n");
+            exit(1);
+        }
+        // Os blocos formam uma lista, liberada no fim.
+        *(char **)novo=t->bloco;
+        t->bloco=novo;
+        t->usadoBloco=sizeof(uint64_t);
+    }
+    p=(PalavraLonga *)(t->bloco+t->usadoBloco);
+    t->usadoBloco+=tamanho;
+    p->hash=hash;
+    p->codigo=codigo;
+    p->tamanho=(uint8_t)n;
+    memcpy(p->texto,texto,n);
+    return p;
+}
+
+/**
+ * @brief Insere uma palavra no conjunto, se ela ainda nao estiver la.
+ * @param t A thread.
+ * @param texto A palavra (A a Z).
+ * @param n O comprimento.
+ * @param codigo As TAM_CURTA primeiras letras, 5 bits cada, a primeira nos bits mais altos.
+ * @return 1 se a palavra e nova, 0 se ja estava no conjunto.
+ */
+static int inserirPalavra (Trabalho *t, const char *texto, int n, uint64_t codigo){
+    Conjunto *c = t->conjunto;
+    const PalavraLonga *existente;
+    PalavraLonga *longa=NULL;
+    uint64_t valor,hash,atual,mascara=c->capacidade-1,i;
+    int k;
+    if(n<=TAM_CURTA){
+        valor=CURTA|codigo;
+        hash=misturar(valor);
+    }
+    else{
+        hash=codigo;
+        for(k=TAM_CURTA;k<n;k++)    hash=(hash^(unsigned char)texto[k])*0x100000001b3ULL;
+        hash=misturar(hash);
+        valor=0;
+    }
+    for(i=hash&mascara;;i=(i+1)&mascara){
+        atual=atomic_load_explicit(&c->posicoes[i],memory_order_acquire);
+        if(atual==0){
+            // A palavra longa so e copiada quando ha uma posicao livre para ela.
+            if(valor==0){
+                longa=guardarLonga(t,texto,n,codigo,hash);
+                valor=(uint64_t)(uintptr_t)longa;
+            }
+            if(atomic_compare_exchange_strong_explicit(&c->posicoes[i],&atual,valor,memory_order_release,memory_order_acquire))
+                return 1;
+            // Outra thread ocupou a posicao: atual agora tem o que ela gravou.
+        }
+        if(n<=TAM_CURTA){
+            if(atual==valor)    return 0;
+            continue;
+        }
+        if(atual&CURTA) continue;
+        existente=(const PalavraLonga *)(uintptr_t)atual;
+        if(existente->hash==hash&&existente->tamanho==n&&memcmp(existente->texto,texto,n)==0){
+            // A copia feita para esta insercao e a ultima do bloco: e devolvida.
+            if(longa!=NULL) t->usadoBloco-=(sizeof(PalavraLonga)+n+7)&~(size_t)7;
+            return 0;
+        }
+    }
+}
+
+/**
+ * @brief Aplica os limites a uma palavra lida e a insere no conjunto.
+ * @param t A thread.
+ * @param texto A palavra (A a Z; so as TAM_MAX_MASCARA primeiras letras).
+ * @param n O comprimento.
+ * @param codigo As TAM_CURTA primeiras letras.
+ * @param invalida 1 se a palavra tinha caracteres que nao sao letras de A a Z.
+ */
+static void terminarPalavra (Trabalho *t, const char *texto, int n, uint64_t codigo, int invalida){
+    Conjunto *c = t->conjunto;
+    uint64_t total;
+    t->lidas++;
+    if(invalida)    t->invalidas++;
+    else if(n<t->minimo)    t->curtas++;
+    else if(n>t->maximo)    t->longas++;
+    else if(inserirPalavra(t,texto,n,codigo)){
+        t->novas++;
+        // Um contador compartilhado por palavra nova seria disputado por todas as threads.
+        if(++t->lote==LOTE_CONTAGEM){
+            total=atomic_fetch_add(&c->usados,LOTE_CONTAGEM)+LOTE_CONTAGEM;
+            t->lote=0;
+            if(total>=c->capacidade/2)  atomic_store(&c->crescer,1);
+        }
+    }
+    if(atomic_load_explicit(&c->crescer,memory_order_relaxed))  pararParaCrescer(c);
+}
+
+/**
+ * @brief Dobra o caractere nao ASCII que comeca em *p.
+ * @param p O caractere; avanca para o seguinte.
+ * @param fim O fim do trecho.
+ * @return A letra (A a Z), CLASSE_SEPARADOR ou CLASSE_INVALIDA.
+ */
+static unsigned char dobrarMultibyte (const unsigned char **p, const unsigned char *fim){
+    const unsigned char *q=*p;
+    int n=1;
+    // Sem byte de continuacao em seguida, o byte e um caractere Latin-1.
+    if(q+1>=fim||(q[1]&0xC0)!=0x80){
+        *p=q+1;
+        return q[0]>=0xC0?(unsigned char)dobraLatin1[q[0]-0xC0]:CLASSE_INVALIDA;
+    }
+    if(q[0]==0xC3){
+        *p=q+2;
+        return (unsigned char)dobraLatin1[q[1]-0x80];
+    }
+    // U+0080 a U+00BF: espaco sem quebra, aspas angulares etc. separam; ordinais e micro nao.
+    if(q[0]==0xC2){
+        *p=q+2;
+        return q[1]==0xAA||q[1]==0xB5||q[1]==0xBA?CLASSE_INVALIDA:CLASSE_SEPARADOR;
+    }
+    // U+2000 a U+206F: aspas curvas, travessoes, reticencias.
+    if(q[0]==0xE2&&(q[1]==0x80||q[1]==0x81)&&q+2<fim){
+        *p=q+3;
+        return CLASSE_SEPARADOR;
+    }
+    // Qualquer outro caractere invalida a palavra.
+    if(q[0]>=0xC0)  n=q[0]>=0xF0?4:q[0]>=0xE0?3:2;
+    for(q++;n>1&&q<fim&&(*q&0xC0)==0x80;n--)    q++;
+    *p=q;
+    return CLASSE_INVALIDA;
+}
+
+/**
+ * @brief Separa e insere as palavras de um trecho (que termina em um separador ou no fim do arquivo).
+ * @param t A thread.
+ * @param p O inicio do trecho.
+ * @param fim O fim do trecho.
+ */
+static void separarPalavras (Trabalho *t, const unsigned char *p, const unsigned char *fim){
+    char texto[TAM_MAX_MASCARA];
+    uint64_t codigo=0;
+    unsigned char k;
+    int n=0,invalida=0;
+    while(p<fim){
+        k=classes[*p];
+        if(k==CLASSE_MULTIBYTE) k=dobrarMultibyte(&p,fim);
+        else    p++;
+        if(k==CLASSE_SEPARADOR){
+            if(n>0||invalida){
+                terminarPalavra(t,texto,n,codigo,invalida);
+                n=invalida=0;
+                codigo=0;
+            }
+            continue;
+        }
+        if(k==CLASSE_INVALIDA){
+            invalida=1;
+            continue;
+        }
+        if(n<TAM_MAX_MASCARA)   texto[n]=(char)k;
+        if(n<TAM_CURTA) codigo|=(uint64_t)(k-'A'+1)<<(5*(TAM_CURTA-1-n));
+        n++;
+    }
+    if(n>0||invalida)   terminarPalavra(t,texto,n,codigo,invalida);
+}
+
+/**
+ * @brief Avanca ate o proximo separador ASCII.
+ * @param e O arquivo.
+ * @param pos A posicao.
+ * @return A posicao do separador, ou o fim do arquivo.
+ */
+static size_t ajustarCorte (const Entrada *e, size_t pos){
+    while(pos<e->tamanho&&classes[e->dados[pos]]!=CLASSE_SEPARADOR) pos++;
+    return pos;
+}
+
+/**
+ * @brief Processa trechos ate acabarem.
+ * @param arg O Trabalho da thread.
+ * @return Sempre NULL.
+ */
+static void *executarTrabalho (void *arg){
+    Trabalho *t = arg;
+    const Trecho *r;
+    const Entrada *e;
+    size_t inicio,fim;
+    int i;
+    while((i=atomic_fetch_add(t->proximoTrecho,1))<t->numTrechos){
+        r=&t->trechos[i];
+        e=&t->entradas[r->entrada];
+        // Cada trecho vai do primeiro separador a partir do seu inicio ao primeiro a partir do seu fim.
+        inicio=r->inicio==0?0:ajustarCorte(e,r->inicio);
+        fim=ajustarCorte(e,r->fim);
+        if(inicio<fim)  separarPalavras(t,e->dados+inicio,e->dados+fim);
+    }
+    atomic_fetch_add(&t->conjunto->usados,t->lote);
+    t->lote=0;
+    sairDoConjunto(t->conjunto);
+    return NULL;
+}
+
+/**
+ * @brief Chave de ordenacao de uma posicao ocupada: as TAM_CURTA primeiras letras.
+ * @param v O conteudo da posicao.
+ * @return A chave.
+ */
+static uint64_t chaveOrdem (uint64_t v){
+    return (v&CURTA)?v&~CURTA:((const PalavraLonga *)(uintptr_t)v)->codigo;
+}
+
+/**
+ * @brief Ordena as palavras em ordem alfabetica.
+ * @param a O conteudo de uma posicao ocupada.
+ * @param b O conteudo de outra posicao ocupada.
+ * @return Negativo se a vier antes de b, positivo se vier depois, 0 se forem iguais.
+ */
+static int compararPalavras (const void *a, const void *b){
+    uint64_t x=*(const uint64_t *)a,y=*(const uint64_t *)b,cx=chaveOrdem(x),cy=chaveOrdem(y);
+    const PalavraLonga *lx,*ly;
+    int m,r;
+    if(cx!=cy)  return cx<cy?-1:1;
+    // Mesmas TAM_CURTA primeiras letras: a palavra curta e o inicio da longa.
+    if(x&CURTA) return (y&CURTA)?0:-1;
+    if(y&CURTA) return 1;
+    lx=(const PalavraLonga *)(uintptr_t)x;
+    ly=(const PalavraLonga *)(uintptr_t)y;
+    m=lx->tamanho<ly->tamanho?lx->tamanho:ly->tamanho;
+    r=memcmp(lx->texto+TAM_CURTA,ly->texto+TAM_CURTA,m-TAM_CURTA);
+    return r!=0?r:lx->tamanho-ly->tamanho;
+}
+
+/**
+ * @brief Escreve o texto de uma palavra.
+ * @param v O conteudo da posicao.
+ * @param texto Recebe a palavra (sem '\0').
+ * @return O comprimento.
+ */
+static int escreverPalavra (uint64_t v, char *texto){
+    const PalavraLonga *l;
+    int n=0,letra;
+    if(!(v&CURTA)){
+        l=(const PalavraLonga *)(uintptr_t)v;
+        memcpy(texto,l->texto,l->tamanho);
+        return l->tamanho;
+    }
+    while(n<TAM_CURTA&&(letra=(int)((v>>(5*(TAM_CURTA-1-n)))&31))!=0)
+        texto[n++]=(char)('A'+letra-1);
+    return n;
+}
+
+/**
+ * @brief Grava o dicionario binario e o poe no lugar do arquivo de saida.
+ * @param nome O arquivo de saida.
+ * @param palavras As palavras, ja ordenadas.
+ * @param n O numero de palavras.
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+static int gravarDicionario (const char *nome, const uint64_t *palavras, uint64_t n){
+    CabecalhoDicionario c;
+    char texto[TAM_MAX_MASCARA+1],*temporario;
+    uint32_t *inicio,*letras;
+    uint8_t *tamanho;
+    uint64_t i,posicao;
+    int k,m,erro;
+    FILE *arq;
+    memset(&c,0,sizeof(c));
+    memcpy(c.magica,MAGICA_DICIONARIO,sizeof(c.magica));
+    c.versao=VERSAO_DICIONARIO;
+    c.quantidade=(uint32_t)n;
+    c.inicioTexto=(uint32_t)(sizeof(c)+n*(2*sizeof(uint32_t)+sizeof(uint8_t)));
+    inicio=malloc((n>0?n:1)*sizeof(uint32_t));
+    letras=malloc((n>0?n:1)*sizeof(uint32_t));
+    tamanho=malloc(n>0?n:1);
+    temporario=malloc(strlen(nome)+6);
+    if(inicio==NULL||letras==NULL||tamanho==NULL||temporario==NULL){
+        free(inicio);
+        free(letras);
+        free(tamanho);
+        free(temporario);
+        return -1;
+    }
+    posicao=c.inicioTexto;
+    for(i=0;i<n;i++){
+        m=escreverPalavra(palavras[i],texto);
+        inicio[i]=(uint32_t)posicao;
+        tamanho[i]=(uint8_t)m;
+        letras[i]=0;
+        for(k=0;k<m;k++)    letras[i]|=1u<<(texto[k]-'A');
+        posicao+=m+1;
+    }
+    c.tamanho=(uint32_t)posicao;
+    // O arquivo so substitui o anterior quando estiver completo (o servidor pode estar recarregando-o).
+    sprintf(temporario,"%s.novo",nome);
+    arq=fopen(temporario,"wb");
+    erro=arq==NULL||posicao>UINT32_MAX||n>INT32_MAX;
+    if(arq!=NULL){
+        setvbuf(arq,NULL,_IOFBF,TAM_BLOCO);
+        fwrite(&c,sizeof(c),1,arq);
+        fwrite(inicio,sizeof(uint32_t),n,arq);
+        fwrite(letras,sizeof(uint32_t),n,arq);
+        fwrite(tamanho,1,n,arq);
+        for(i=0;i<n;i++){
+            m=escreverPalavra(palavras[i],texto);
+            texto[m]='\n';
+            fwrite(texto,1,m+1,arq);
+        }
+        erro|=ferror(arq)||fflush(arq)!=0||fsync(fileno(arq))!=0;
+        erro|=fclose(arq)!=0;
+        if(!erro)   erro=rename(temporario,nome)!=0;
+        if(erro)    remove(temporario);
+    }
+    free(inicio);
+    free(letras);
+    free(tamanho);
+    free(temporario);
+    return erro?-1:0;
+}
+
+int main (int argc, char *argv[]){
+    const char *saida=NULL;
+    Entrada *entradas;
+    Trecho *trechos;
+    Trabalho *trabalhos;
+    Conjunto c;
+    struct stat st;
+    uint64_t *palavras,n=0,i,lidas=0,curtas=0,longas=0,invalidas=0,total=0;
+    long long t0,t1,t2,t3;
+    atomic_int proximoTrecho=0;
+    int threads=0,minimo=4,maximo=TAM_MAX_MASCARA,numEntradas=0,numTrechos=0,argumentos=0,j,fd;
+    size_t pos;
+    char *bloco,*anterior;
+    montarClasses();
+    entradas=calloc(argc,sizeof(Entrada));
+    if(entradas==NULL)  return 1;
+    for(j=1;j<argc;j++){
+        if(strcmp(argv[j],"--threads")==0&&j+1<argc)    threads=atoi(argv[++j]);
+        else if(strcmp(argv[j],"--minimo")==0&&j+1<argc)    minimo=atoi(argv[++j]);
+        else if(strcmp(argv[j],"--maximo")==0&&j+1<argc)    maximo=atoi(argv[++j]);
+        else if(saida==NULL)    saida=argv[j];
+        else{
+            argumentos++;
+            // As entradas sao mapeadas inteiras; o kernel le as paginas conforme as threads avancam.
+            fd=open(argv[j],O_RDONLY);
+            if(fd<0||fstat(fd,&st)<0){
+                printf("Erro ao abrir o arquivo: %s\n",argv[j]);
+                return 1;
+            }
+            if(st.st_size>0){
+                entradas[numEntradas].dados=mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+                if(entradas[numEntradas].dados==MAP_FAILED){
+                    printf("Erro ao abrir o arquivo: %s\n",argv[j]);
+                    return 1;
+                }
+                madvise((void *)entradas[numEntradas].dados,st.st_size,MADV_SEQUENTIAL);
+                entradas[numEntradas].tamanho=st.st_size;
+                total+=st.st_size;
+                numTrechos+=(int)((st.st_size+TAM_TRECHO-1)/TAM_TRECHO);
+                numEntradas++;
+            }
+            close(fd);
+        }
+    }
+    if(saida==NULL||argumentos==0){
+        printf("Uso: %s [--threads N] [--minimo N] [--maximo N] saida entrada...\n",argv[0]);
+        return 1;
+    }
+    if(minimo<1)    minimo=1;
+    if(maximo>TAM_MAX_MASCARA||maximo<minimo)   maximo=TAM_MAX_MASCARA;
+    if(threads<=0)  threads=(int)sysconf(_SC_NPROCESSORS_ONLN);
+    if(threads<=0)  threads=1;
+    trechos=malloc((numTrechos>0?numTrechos:1)*sizeof(Trecho));
+    numTrechos=0;
+    for(j=0;j<numEntradas;j++)
+        for(pos=0;pos<entradas[j].tamanho;pos+=TAM_TRECHO){
+            trechos[numTrechos].entrada=j;
+            trechos[numTrechos].inicio=pos;
+            trechos[numTrechos].fim=pos+TAM_TRECHO<entradas[j].tamanho?pos+TAM_TRECHO:entradas[j].tamanho;
+            numTrechos++;
+        }
+
+    // A tabela comeca pequena e dobra quando precisa: uma tabela grande demais para as palavras distintas
+    // espalha as sondagens por mais memoria e perde o cache.
+    memset(&c,0,sizeof(c));
+    c.capacidade=CAPACIDADE_MINIMA;
+    c.posicoes=calloc(c.capacidade,sizeof(uint64_t));
+    trabalhos=calloc(threads,sizeof(Trabalho));
+    if(c.posicoes==NULL||trechos==NULL||trabalhos==NULL){
+        printf("Sem memoria para a tabela de palavras.\n");
+        return 1;
+    }
+    pthread_mutex_init(&c.trava,NULL);
+    pthread_cond_init(&c.sinal,NULL);
+    c.ativas=threads;
+    t0=relogioNs();
+    for(j=0;j<threads;j++){
+        trabalhos[j].conjunto=&c;
+        trabalhos[j].entradas=entradas;
+        trabalhos[j].trechos=trechos;
+        trabalhos[j].numTrechos=numTrechos;
+        trabalhos[j].proximoTrecho=&proximoTrecho;
+        trabalhos[j].minimo=minimo;
+        trabalhos[j].maximo=maximo;
+        pthread_create(&trabalhos[j].thread,NULL,executarTrabalho,&trabalhos[j]);
+    }
+    for(j=0;j<threads;j++){
+        pthread_join(trabalhos[j].thread,NULL);
+        lidas+=trabalhos[j].lidas;
+        curtas+=trabalhos[j].curtas;
+        longas+=trabalhos[j].longas;
+        invalidas+=trabalhos[j].invalidas;
+        n+=trabalhos[j].novas;
+    }
+    t1=relogioNs();
+
+    palavras=malloc((n>0?n:1)*sizeof(uint64_t));
+    if(palavras==NULL){
+        printf("Sem memoria para %llu palavras.\n",(unsigned long long)n);
+        return 1;
+    }
+    n=0;
+    for(i=0;i<c.capacidade;i++)
+        if(c.posicoes[i]!=0)    palavras[n++]=c.posicoes[i];
+    qsort(palavras,n,sizeof(uint64_t),compararPalavras);
+    t2=relogioNs();
+    if(n>0&&gravarDicionario(saida,palavras,n)<0){
+        printf("Erro ao gravar o arquivo: %s\n",saida);
+        return 1;
+    }
+    t3=relogioNs();
+
+    printf("Entrada: %.1f MB em %d arquivo(s), %llu palavras lidas\n",total/1e6,numEntradas,(unsigned long long)lidas);
+    printf("Descartadas: %llu com menos de %d letras, %llu com mais de %d, %llu com outros caracteres\n",
+           (unsigned long long)curtas,minimo,(unsigned long long)longas,maximo,(unsigned long long)invalidas);
+    printf("Distintas: %llu (tabela de %llu posicoes, %llu crescimento(s))\n",(unsigned long long)n,
+           (unsigned long long)c.capacidade,(unsigned long long)c.geracao);
+    printf("Leitura e deduplicacao: %.3f s com %d thread(s) (%.1f MB/s)\n",(t1-t0)/1e9,threads,total/((t1-t0)/1e3));
+    printf("Ordenacao: %.3f s  Gravacao: %.3f s  Total: %.3f s (%.1f MB/s)\n",(t2-t1)/1e9,(t3-t2)/1e9,(t3-t0)/1e9,
+           total/((t3-t0)/1e3));
+    if(n>0) printf("%llu palavras gravadas em %s\n",(unsigned long long)n,saida);
+    else    printf("Nenhuma palavra encontrada: %s nao foi gravado.\n",saida);
+
+    for(j=0;j<threads;j++)
+        for(bloco=trabalhos[j].bloco;bloco!=NULL;bloco=anterior){
+            anterior=*(char **)bloco;
+            free(bloco);
+        }
+    for(j=0;j<numEntradas;j++)  munmap((void *)entradas[j].dados,entradas[j].tamanho);
+    pthread_mutex_destroy(&c.trava);
+    pthread_cond_destroy(&c.sinal);
+    free((void *)c.posicoes);
+    free(palavras);
+    free(trabalhos);
+    free(trechos);
+    free(entradas);
+    return n>0?0:1;
+}
\ No newline at end of file
@@ -1,278 +1,359 @@
-/**
- * @file forca.c
- * @brief Implementacao das funcoes de logica do jogo da forca.
- *
- * Contem o corpo de todas as funcoes declaradas em forca.h,
- * que controlam o funcionamento interno do jogo.
- */
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <ctype.h>
-#include <time.h>
-#include "forca.h"
-// Inclusoes para funcionalidades dependentes de sistema operacional (delay).
-#ifdef _WIN32
-    #include <windows.h>
-#else
-    #include <unistd.h>
-#endif
-
-/**
- * @brief Remove espaços em branco do inicio e do fim de uma string.
- *
- * Modifica a string original para remover todos os
- * caracteres de espaço, tabulacao ou quebra de linha de suas extremidades.
- *
- * @param str A string a ser modificada.
- */
-void apararString (char *str) {
-    int i;
-    // Checagem de segurança para string nula ou vazia.
-    if (str==NULL||str[0]=='\0')  return;
-    // Remove espacos do final: percorre do fim para o comeco.
-    for(i=strlen(str)-1;i>=0&&isspace((unsigned char)str[i]);i--);
-    str[i+1]='\0';
-    // Remove espacos do inicio: encontra o primeiro caractere valido.
-    for(i=0;str[i]!='\0'&&isspace((unsigned char)str[i]);i++);
-    // Se encontrou espacos no inicio, move o resto da string para frente.
-    if(i>0) memmove(str,&str[i],strlen(&str[i])+1);
-}
-
-/**
- * @brief Limpa o buffer de entrada (stdin) ate a proxima quebra de linha.
- *
- * Util para consumir caracteres indesejados deixados por funcoes como scanf,
- * garantindo que a proxima leitura de entrada funcione como esperado.
- */
-void limparBuffer (void){
-    int c;
-    while((c = getchar()) != '\n' && c != EOF);
-}
-
-/**
- * @brief Pausa a execucao do programa por um determinado tempo.
- *
- * Funcao multiplataforma que usa Sleep() no Windows e usleep() em
- * sistemas POSIX (Linux, macOS).
- *
- * @param milissegundos O tempo de pausa em milissegundos.
- */
-void delayMS (int milissegundos) {
-    #ifdef _WIN32
-        Sleep(milissegundos);
-    #else
-        usleep(milissegundos * 1000);
-    #endif
-}
-
-/**
- * @brief Conta o numero de palavras (linhas) em um arquivo.
- * @param nomeArquivo O nome do arquivo a ser lido.
- * @return O numero de linhas no arquivo.
- */
-int contarPalavras (char *nomeArquivo){
-    int count=0;
-    char buffer[TAM_MAX_PALAVRA];
-    FILE *arq = fopen(nomeArquivo,"r");
-    // Tratamento de erro caso o arquivo de palavras nao seja encontrado.
-    if(arq==NULL){
-        printf("Erro ao abrir o arquivo: %s\n",nomeArquivo);
-        exit(1);
-    }
-    // Le cada linha do arquivo para conta-las.
-    while(fgets(buffer,TAM_MAX_PALAVRA,arq)!=NULL)
-        count++;
-    fclose(arq);
-    return count;
-}
-
-/**
- * @brief Preenche um vetor de inteiros com o valor zero.
- * @param v O vetor a ser zerado.
- * @param n O tamanho do vetor.
- */
-void zerarVetor (int v[], int n){
-    int i;
-    for(i=0;i<n;i++)
-        v[i]=0;
-}
-
-/**
- * @brief Carrega uma palavra aleatoria de um arquivo.
- *
- * Sorteia uma linha do arquivo e le a palavra contida nela,
- * tratando a string para remover espaços ou quebras de linha.
- *
- * @param nomeArquivo O nome do arquivo de palavras.
- * @param palavra A string que recebera a palavra sorteada.
- * @param tamanho O numero total de palavras no arquivo.
- */
-void carregarPalavras (char *nomeArquivo, char *palavra, int tamanho){
-    // Sorteia um numero de 0 a (tamanho-1) para a linha.
-    int linhaAleatoria=rand()%tamanho,i;
-    FILE *arq = fopen(nomeArquivo,"r");
-    if(arq==NULL){
-        printf("Erro ao abrir o arquivo: %s\n",nomeArquivo);
-        exit(1);
-    }
-    // Le o arquivo linha por linha ate chegar na linha sorteada.
-    for(i=0;i<linhaAleatoria+1;i++)
-        fgets(palavra,TAM_MAX_PALAVRA,arq);
-    // Limpa a palavra lida de possiveis espaços ou \n.
-    apararString(palavra);
-    fclose(arq);
-}
-
-/**
- * @brief Prepara a string da forca com underscores.
- * @param str A string a ser preenchida com '_'.
- * @param tamanho O comprimento da palavra secreta.
- */
-void reiniciarForca (char *str, int tamanho){
-    int i;
-    for(i=0;i<tamanho;i++)
-        str[i]='_';
-    // Adiciona o '\0' para finalizar a string.
-    str[i]='\0';
-}
-
-/**
- * @brief Inicia uma nova partida, reiniciando vidas e exibindo uma contagem regressiva.
- * @param p Ponteiro para a struct do jogador.
- */
-void iniciarPartida (Jogador *p){
-    p->vidas=VIDAS;
-    printf("Boa sorte, %s!\nLa vamos nos ...\n\n",p->nome);
-    // Contagem regressiva para criar um suspense.
-    delayMS(DELAY_1s);
-    printf("3 ...\n");
-    delayMS(DELAY_1s);
-    printf("2 ...\n");
-    delayMS(DELAY_1s);
-    printf("1 ...\n");
-    delayMS(DELAY_1s);
-}
-
-/**
- * @brief Desenha o estado atual do jogo na tela.
- *
- * Exibe o boneco da forca, as letras ja utilizadas e a palavra
- * com os acertos e os underscores.
- *
- * @param p A struct do jogador (para saber as vidas).
- * @param palavra A string que mostra os acertos e os underscores.
- * @param letras O vetor que controla as letras ja utilizadas.
- * @param n O tamanho do vetor de letras.
- */
-void desenharForca (Jogador p, char *palavra, int letras[], int n){
-    int i;
-    char c='A';
-    // Matriz de strings contendo a arte da forca para cada estado de vida.
-    // O indice do vetor corresponde ao numero de vidas.
-    const char *desenhos[]={
-        // 0 vidas. (Fim de jogo)
-        " ___________________\n|/                  |\n|                 -----\n|                | \" \" |\n|                |  |  |\n|                | ___ |\n|                 -----\n|                   |\n|                  /|\\\n|                 / | \\\n|                /  |  \\\n|                   |\n|                   |\n|                   |\n|                   |\n|                  / \\\n|                 /   \\\n|                /     \\\n|              _/       \\_\n|\n|\n|\n|\n",
-        // 1 vida.
-        " ___________________\n|/                  |\n|                 -----\n|                | \" \" |\n|                |  |  |\n|                | ___ |\n|                 -----\n|                   |\n|                  /|\\\n|                 / | \\\n|                /  |  \\\n|                   |\n|                   |\n|                   |\n|                   |\n|                  /\n|                 /\n|                /\n|              _/\n|\n|\n|\n|\n",
-        // 2 vidas.
-        " ___________________\n|/                  |\n|                 -----\n|                | \" \" |\n|                |  |  |\n|                | ___ |\n|                 -----\n|                   |\n|                  /|\\\n|                 / | \\\n|                /  |  \\\n|                   |\n|                   |\n|                   |\n|                   |\n|\n|\n|\n|\n|\n|\n|\n|\n",
-        // 3 vidas.
-        " ___________________\n|/                  |\n|                 -----\n|                | \" \" |\n|                |  |  |\n|                | ___ |\n|                 -----\n|                   |\n|                  /|\n|                 / |\n|                /  |\n|                   |\n|                   |\n|                   |\n|                   |\n|\n|\n|\n|\n|\n|\n|\n|\n",
-        // 4 vidas.
-        " ___________________\n|/                  |\n|                 -----\n|                | \" \" |\n|                |  |  |\n|                | ___ |\n|                 -----\n|                   |\n|                   |\n|                   |\n|                   |\n|                   |\n|                   |\n|                   |\n|                   |\n|\n|\n|\n|\n|\n|\n|\n|\n",
-        // 5 vidas.
-        " ___________________\n|/                  |\n|                 -----\n|                | \" \" |\n|                |  |  |\n|                | ___ |\n|                 -----\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n",
-        // 6 vidas.
-        " ___________________ \n|/                  |\n|                 -----\n|                |     |\n|                |     |\n|                |     |\n|                 -----\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n",
-        // 7 vidas.
-        " ___________________ \n|/                  |\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n"
-    };
-    printf("\n\n\tLetras utilizadas: ");
-    for(i=0;i<n;i++){
-        if(letras[i])   printf("%c ",c+i);
-    }
-    printf("\n\n");
-    // Seleciona o desenho correto com base nas vidas do jogador.
-    i=p.vidas;
-    if(i<0) i=0; // Garante que o indice nao seja negativo.
-    printf("%s",desenhos[i]);
-    // Imprime a palavra na forca.
-    printf("|\tPalavra: ");
-    for(i=0;palavra[i]!='\0';i++)
-        printf("%c ",toupper(palavra[i]));
-    printf("\n\n");
-}
-
-/**
- * @brief Verifica se uma letra ja foi utilizada e a marca como usada.
- *
- * Usa um vetor de inteiros, onde o indice
- * corresponde a letra do alfabeto (A=0, B=1, ...).
- *
- * @param letra A letra a ser verificada.
- * @param letras O vetor de controle de letras.
- * @return 1 se a letra ja foi usada, 0 caso contrario.
- */
-int verificarLetra (char letra, int letras[]){
-    // Calcula o indice (0-25) com base no caractere ASCII 'A'.
-    if(letras[toupper(letra)-'A'])    return 1;
-    // Se nao foi usada, marca como 1 (true) e retorna 0.
-    else    letras[toupper(letra)-'A']=1;
-    return 0;
-}
-
-/**
- * @brief Testa se a letra digitada existe na palavra secreta.
- *
- * Se a letra for encontrada, a funcao tambem atualiza a string
- * de exibicao (palavraNaForca) com a letra nos locais corretos.
- *
- * @param letra A letra digitada pelo jogador.
- * @param palavra A palavra secreta.
- * @param palavraNaForca A string de exibicao a ser atualizada.
- * @return O numero de vezes que a letra foi encontrada.
- */
-int testarLetra (char letra, char *palavra, char *palavraNaForca){
-    int count=0,i,tamanho=strlen(palavra);
-    // Itera por toda a palavra secreta.
-    for(i=0;i<tamanho;i++){
-        // Compara as letras ignorando maiusculas/minusculas.
-        if(toupper(palavra[i])==toupper(letra)){
-            count++;
-            // Atualiza a palavra de exibicao com a letra correta.
-            palavraNaForca[i] = toupper(letra);
-        }
-    }
-    return count;
-}
-
-/**
- * @brief Registra o resultado da partida no arquivo de resultados.
- *
- * Salva a data/hora, nome do jogador, palavra da partida e o
- * resultado (Vitoria/Derrota) em uma nova linha do arquivo.
- *
- * @param nomeArquivo O nome do arquivo de resultados.
- * @param palavra A palavra secreta da partida.
- * @param p A struct do jogador com o resultado.
- */
-void registrarResultado (char *nomeArquivo, char *palavra, Jogador p){
-    time_t tempo;
-    struct tm *infoTempo;
-    char dataHora[TAM_MAX_PALAVRA];
-    // Obtem e formata a data e hora atuais.
-    time(&tempo);
-    infoTempo = localtime(&tempo);
-    strftime(dataHora,TAM_MAX_PALAVRA,"%d/%m/%Y %H:%M",infoTempo);
-    // Abre o arquivo em modo "append" (adicionar ao final).
-    FILE *arq = fopen(nomeArquivo,"a");
-    if(arq==NULL){
-        printf("Erro ao abrir o arquivo: %s\n",nomeArquivo);
-        exit(1);
-    }
-    // Escreve a linha no arquivo formatada.
-    fprintf(arq,"[%s]\t%s\t%s\t%s\n",dataHora,p.nome,palavra,p.vidas>0?"Vitoria":"Derrota");
-    fclose(arq);
+/**
+ * @file forca.c
+ * @brief Implementacao das funcoes de logica do jogo da forca.
+ *
+ * Contem o corpo de todas as funcoes declaradas em forca.h,
+ * que controlam o funcionamento interno do jogo.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include "forca.h"
+#include "dicionario.h"
+#include "registro.h"
+#include "perfis.h"
+#include "metricas.h"
+// Inclusoes para funcionalidades dependentes de sistema operacional (delay).
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <unistd.h>
+#endif
+
+/**
+ * @brief Remove espaços em branco do inicio e do fim de uma string.
+ *
+ * Modifica a string original para remover todos os
+ * caracteres de espaço, tabulacao ou quebra de linha de suas extremidades.
+ *
+ * @param str A string a ser modificada.
+ */
+void apararString (char *str) {
+    int i;
+    // Checagem de segurança para string nula ou vazia.
+    if (str==NULL||str[0]=='\0')  return;
+    // Remove espacos do final: percorre do fim para o comeco.
+    for(i=strlen(str)-1;i>=0&&isspace((unsigned char)str[i]);i--);
+    str[i+1]='\0';
+    // Remove espacos do inicio: encontra o primeiro caractere valido.
+    for(i=0;str[i]!='\0'&&isspace((unsigned char)str[i]);i++);
+    // Se encontrou espacos no inicio, move o resto da string para frente.
+    if(i>0) memmove(str,&str[i],strlen(&str[i])+1);
+}
+
+/**
+ * @brief Limpa o buffer de entrada (stdin) ate a proxima quebra de linha.
+ *
+ * Util para consumir caracteres indesejados deixados por funcoes como scanf,
+ * garantindo que a proxima leitura de entrada funcione como esperado.
+ */
+void limparBuffer (void){
+    int c;
+    while((c = getchar()) != '\n' && c != EOF);
+}
+
+// 1 quando as pausas estao desligadas (modo rapido).
+static int modoRapido=0;
+
+/**
+ * @brief Liga ou desliga o modo rapido, em que delayMS() retorna na hora.
+ *
+ * Serve para automacao e medicoes: a partida segue sem nenhuma pausa.
+ *
+ * @param ativo 1 para desligar as pausas, 0 para restaura-las.
+ */
+void definirModoRapido (int ativo){
+    modoRapido=ativo;
+}
+
+/**
+ * @brief Pausa a execucao do programa por um determinado tempo.
+ *
+ * Funcao multiplataforma que usa Sleep() no Windows e usleep() em
+ * sistemas POSIX (Linux, macOS). No modo rapido, nao pausa.
+ *
+ * @param milissegundos O tempo de pausa em milissegundos.
+ */
+void delayMS (int milissegundos) {
+    if(modoRapido)  return;
+    #ifdef _WIN32
+        Sleep(milissegundos);
+    #else
+        usleep(milissegundos * 1000);
+    #endif
+}
+
+/**
+ * @brief Le um relogio monotonico de alta resolucao.
+ *
+ * Usa QueryPerformanceCounter() no Windows e clock_gettime() com
+ * CLOCK_MONOTONIC em sistemas POSIX.
+ *
+ * @return O tempo atual em nanossegundos, a partir de uma origem arbitraria.
+ */
+long long relogioNs (void){
+    #ifdef _WIN32
+        LARGE_INTEGER freq,contador;
+        QueryPerformanceFrequency(&freq);
+        QueryPerformanceCounter(&contador);
+        return (long long)(contador.QuadPart*(1e9/freq.QuadPart));
+    #else
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC,&ts);
+        return (long long)ts.tv_sec*1000000000LL+ts.tv_nsec;
+    #endif
+}
+
+/**
+ * @brief Conta o numero de palavras de um arquivo, carregando-o no dicionario compartilhado.
+ *
+ * O arquivo e lido e indexado uma unica vez (ver dicionario.h); as
+ * chamadas seguintes apenas consultam o indice.
+ *
+ * @param nomeArquivo O nome do arquivo a ser lido.
+ * @return O numero de palavras no arquivo.
+ */
+int contarPalavras (char *nomeArquivo){
+    Dicionario *d = obterDicionarioPadrao(nomeArquivo);
+    // Tratamento de erro caso o arquivo de palavras nao seja encontrado.
+    if(d==NULL||d->quantidade==0){
+        printf("Erro ao abrir o arquivo: %s\n",nomeArquivo);
+        exit(1);
+    }
+    return d->quantidade;
+}
+
+/**
+ * @brief Copia uma palavra aleatoria do dicionario compartilhado.
+ *
+ * O sorteio usa o indice de linhas do dicionario, sem reabrir o
+ * arquivo; a palavra ja vem sem espacos ou quebras de linha. O indice
+ * e uniforme (sem o vies de rand()%tamanho) e depende so do gerador.
+ *
+ * @param nomeArquivo O nome do arquivo de palavras.
+ * @param palavra A string que recebera a palavra sorteada.
+ * @param tamanho O numero total de palavras no arquivo.
+ * @param a O gerador usado no sorteio.
+ */
+void carregarPalavras (char *nomeArquivo, char *palavra, int tamanho, Aleatorio *a){
+    int n;
+    const char *origem;
+    MEDICAO(inicio);
+    Dicionario *d = obterDicionarioPadrao(nomeArquivo);
+    INICIAR_MEDICAO(inicio);
+    if(d==NULL||d->quantidade==0){
+        printf("Erro ao abrir o arquivo: %s\n",nomeArquivo);
+        exit(1);
+    }
+    // Sorteia um indice de 0 a (tamanho-1), limitado ao que foi indexado.
+    if(tamanho<=0||tamanho>d->quantidade)   tamanho=d->quantidade;
+    origem=obterPalavra(d,(int)sortearIntervalo(a,(uint32_t)tamanho),&n);
+    memcpy(palavra,origem,n);
+    palavra[n]='\0';
+    ENCERRAR_MEDICAO(FASE_SORTEIO,inicio);
+}
+
+/**
+ * @brief Monta a tabela de posicoes de cada letra da palavra secreta.
+ *
+ * Para cada letra de A a Z, liga na sua mascara os bits das posicoes
+ * em que ela aparece. Caracteres que nao sao letras (hifen, por exemplo)
+ * ficam fora da mascara completa, pois nao precisam ser adivinhados.
+ *
+ * @param palavra A palavra secreta.
+ * @param m A tabela a ser preenchida.
+ * @return 0 em caso de sucesso, -1 se a palavra tiver mais de TAM_MAX_MASCARA caracteres.
+ */
+int prepararMascara (const char *palavra, MascaraPalavra *m){
+    int i,c;
+    memset(m,0,sizeof(*m));
+    for(i=0;palavra[i]!='\0';i++){
+        if(i>=TAM_MAX_MASCARA)  return -1;
+        c=toupper((unsigned char)palavra[i]);
+        if(c>='A'&&c<='Z'){
+            m->posicoes[c-'A']|=1ULL<<i;
+            m->completa|=1ULL<<i;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Prepara a string da forca com underscores.
+ * @param str A string a ser preenchida com '_'.
+ * @param tamanho O comprimento da palavra secreta.
+ */
+void reiniciarForca (char *str, int tamanho){
+    int i;
+    for(i=0;i<tamanho;i++)
+        str[i]='_';
+    // Adiciona o '\0' para finalizar a string.
+    str[i]='\0';
+}
+
+/**
+ * @brief Inicia uma nova partida, reiniciando vidas e exibindo uma contagem regressiva.
+ * @param p Ponteiro para a struct do jogador.
+ */
+void iniciarPartida (Jogador *p){
+    p->vidas=VIDAS;
+    printf("Boa sorte, %s!\nLa vamos nos ...\n\n",p->nome);
+    // Contagem regressiva para criar um suspense.
+    delayMS(DELAY_1s);
+    printf("3 ...\n");
+    delayMS(DELAY_1s);
+    printf("2 ...\n");
+    delayMS(DELAY_1s);
+    printf("1 ...\n");
+    delayMS(DELAY_1s);
+}
+
+// Matriz de strings contendo a arte da forca para cada estado de vida.
+// O indice do vetor corresponde ao numero de vidas.
+static const char *desenhos[]={
+    // 0 vidas. (Fim de jogo)
+    " ___________________\n|/                  |\n|                 -----\n|                | \" \" |\n|                |  |  |\n|                | ___ |\n|                 -----\n|                   |\n|                  /|\\\n|                 / | \\\n|                /  |  \\\n|                   |\n|                   |\n|                   |\n|                   |\n|                  / \\\n|                 /   \\\n|                /     \\\n|              _/       \\_\n|\n|\n|\n|\n",
+    // 1 vida.
+    " ___________________\n|/                  |\n|                 -----\n|                | \" \" |\n|                |  |  |\n|                | ___ |\n|                 -----\n|                   |\n|                  /|\\\n|                 / | \\\n|                /  |  \\\n|                   |\n|                   |\n|                   |\n|                   |\n|                  /\n|                 /\n|                /\n|              _/\n|\n|\n|\n|\n",
+    // 2 vidas.
+    " ___________________\n|/                  |\n|                 -----\n|                | \" \" |\n|                |  |  |\n|                | ___ |\n|                 -----\n|                   |\n|                  /|\\\n|                 / | \\\n|                /  |  \\\n|                   |\n|                   |\n|                   |\n|                   |\n|\n|\n|\n|\n|\n|\n|\n|\n",
+    // 3 vidas.
+    " ___________________\n|/                  |\n|                 -----\n|                | \" \" |\n|                |  |  |\n|                | ___ |\n|                 -----\n|                   |\n|                  /|\n|                 / |\n|                /  |\n|                   |\n|                   |\n|                   |\n|                   |\n|\n|\n|\n|\n|\n|\n|\n|\n",
+    // 4 vidas.
+    " ___________________\n|/                  |\n|                 -----\n|                | \" \" |\n|                |  |  |\n|                | ___ |\n|                 -----\n|                   |\n|                   |\n|                   |\n|                   |\n|                   |\n|                   |\n|                   |\n|                   |\n|\n|\n|\n|\n|\n|\n|\n|\n",
+    // 5 vidas.
+    " ___________________\n|/                  |\n|                 -----\n|                | \" \" |\n|                |  |  |\n|                | ___ |\n|                 -----\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n",
+    // 6 vidas.
+    " ___________________ \n|/                  |\n|                 -----\n|                |     |\n|                |     |\n|                |     |\n|                 -----\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n",
+    // 7 vidas.
+    " ___________________ \n|/                  |\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n|\n"
+};
+
+/**
+ * @brief Retorna a arte da forca para um numero de vidas.
+ * @param vidas O numero de vidas do jogador (valores negativos contam como 0).
+ * @return O desenho, com uma quebra de linha ao fim de cada linha.
+ */
+const char *obterDesenho (int vidas){
+    // Garante que o indice nao saia do vetor.
+    if(vidas<0) vidas=0;
+    if(vidas>VIDAS) vidas=VIDAS;
+    return desenhos[vidas];
+}
+
+/**
+ * @brief Desenha o estado atual do jogo na tela.
+ *
+ * Exibe o boneco da forca, as letras ja utilizadas e a palavra
+ * com os acertos e os underscores.
+ *
+ * @param p O jogador (para saber as vidas).
+ * @param palavra A string que mostra os acertos e os underscores.
+ * @param letras A mascara das letras ja utilizadas (bit 0 = A).
+ */
+void desenharForca (const Jogador *p, const char *palavra, uint32_t letras){
+    int i;
+    char c='A';
+    MEDICAO(inicio);
+    INICIAR_MEDICAO(inicio);
+    printf("\n\n\tLetras utilizadas: ");
+    for(i=0;i<TAM_ALFABETO;i++){
+        if(letras&(1u<<i))  printf("%c ",c+i);
+    }
+    printf("\n\n");
+    // Seleciona o desenho correto com base nas vidas do jogador.
+    printf("%s",obterDesenho(p->vidas));
+    // Imprime a palavra na forca.
+    printf("|\tPalavra: ");
+    for(i=0;palavra[i]!='\0';i++)
+        printf("%c ",toupper(palavra[i]));
+    printf("\n\n");
+    ENCERRAR_MEDICAO(FASE_DESENHO,inicio);
+}
+
+/**
+ * @brief Verifica se uma letra ja foi utilizada e a marca como usada.
+ *
+ * Usa uma mascara de 32 bits, onde o bit de numero i
+ * corresponde a letra do alfabeto (A=0, B=1, ...).
+ *
+ * @param letra A letra a ser verificada (A-Z ou a-z).
+ * @param letras A mascara das letras ja utilizadas.
+ * @return 1 se a letra ja foi usada, 0 caso contrario.
+ */
+int verificarLetra (char letra, uint32_t *letras){
+    // Calcula o bit (0-25) com base no caractere ASCII 'A' (o bit 0x20 distingue as minusculas).
+    uint32_t bit=1u<<((letra&~0x20)-'A');
+    if(*letras&bit) return 1;
+    // Se nao foi usada, liga o bit e retorna 0.
+    *letras|=bit;
+    return 0;
+}
+
+/**
+ * @brief Testa se a letra digitada existe na palavra secreta e revela suas posicoes.
+ *
+ * A avaliacao e uma unica consulta a tabela de posicoes seguida de um
+ * OU com a mascara de posicoes reveladas. A string de exibicao, quando
+ * informada, e atualizada apenas nas posicoes encontradas.
+ *
+ * @param letra A letra digitada pelo jogador (A-Z ou a-z).
+ * @param m A tabela de posicoes da palavra secreta.
+ * @param reveladas A mascara de posicoes ja reveladas, a ser atualizada.
+ * @param palavraNaForca A string de exibicao a ser atualizada (pode ser NULL).
+ * @return O numero de vezes que a letra foi encontrada.
+ */
+int testarLetra (char letra, const MascaraPalavra *m, uint64_t *reveladas, char *palavraNaForca){
+    uint64_t achadas=m->posicoes[(letra&~0x20)-'A'],resto;
+    *reveladas|=achadas;
+    // Percorre apenas os bits ligados, do menos para o mais significativo.
+    if(palavraNaForca!=NULL)
+        for(resto=achadas;resto!=0;resto&=resto-1)
+            palavraNaForca[__builtin_ctzll(resto)]=letra&~0x20;
+    return __builtin_popcountll(achadas);
+}
+
+/**
+ * @brief Registra o resultado da partida no arquivo de resultados.
+ *
+ * Salva a data/hora, nome do jogador, palavra da partida e o
+ * resultado (Vitoria/Derrota) em uma nova linha do arquivo. Se houver
+ * um registro assincrono para o arquivo (ver registro.h), a linha e
+ * apenas enfileirada e gravada depois, em lote. O cadastro de perfis
+ * padrao (ver perfis.h), se houver, tambem e atualizado.
+ *
+ * @param nomeArquivo O nome do arquivo de resultados.
+ * @param palavra A palavra secreta da partida.
+ * @param p O jogador, com as vidas que restaram.
+ */
+void registrarResultado (const char *nomeArquivo, const char *palavra, const Jogador *p){
+    time_t tempo;
+    struct tm *infoTempo;
+    char dataHora[TAM_MAX_PALAVRA];
+    MEDICAO(inicio);
+    Registro *r = obterRegistroPadrao(nomeArquivo);
+    INICIAR_MEDICAO(inicio);
+    if(r!=NULL){
+        enfileirarResultado(r,palavra,p);
+        ENCERRAR_MEDICAO(FASE_REGISTRO,inicio);
+        return;
+    }
+    // Obtem e formata a data e hora atuais.
+    time(&tempo);
+    infoTempo = localtime(&tempo);
+    strftime(dataHora,TAM_MAX_PALAVRA,"%d/%m/%Y %H:%M",infoTempo);
+    // Abre o arquivo em modo "append" (adicionar ao final).
+    FILE *arq = fopen(nomeArquivo,"a");
+    if(arq==NULL){
+        printf("Erro ao abrir o arquivo: %s\n",nomeArquivo);
+        exit(1);
+    }
+    // Escreve a linha no arquivo formatada.
+    fprintf(arq,"[%s]\t%s\t%s\t%s\n",dataHora,p->nome,palavra,p->vidas>0?"Vitoria":"Derrota");
+    fclose(arq);
+    if(obterPerfisPadrao()!=NULL)   atualizarPerfil(obterPerfisPadrao(),p->nome,p->vidas>0,p->vidas);
+    ENCERRAR_MEDICAO(FASE_REGISTRO,inicio);
 }
\ No newline at end of file
@@ -0,0 +1,339 @@
+/**
+ * @file instantaneo.c
+ * @brief Implementacao dos instantaneos das partidas.
+ *
+ * Os registros saem em sequencia por um buffer grande de stdio; so as
+ * chaves e as posicoes (16 bytes por partida) ficam em memoria ate o fim,
+ * quando sao ordenadas por radix sort e gravadas como indice. Quem grava
+ * apenas le as partidas: no servidor, a gravacao roda em um processo
+ * filho criado com fork, que ve a memoria do pai no instante do fork
+ * (copia na escrita) sem trava-lo.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "forca.h"
+#include "instantaneo.h"
+// Inclusoes para o mapeamento do arquivo em memoria.
+#ifdef _WIN32
+    #include <process.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+// Buffer de escrita dos registros.
+#define TAM_BUFFER_GRAVACAO (1<<20)
+// Bits da chave ordenados em cada passada do radix sort.
+#define BITS_DIGITO 16
+// Meia largura inicial da janela da busca no indice.
+#define JANELA_BUSCA 512
+
+/**
+ * @brief Grava bytes no arquivo do instantaneo, contando a posicao.
+ * @param g A gravacao.
+ * @param dados Os bytes.
+ * @param n O numero de bytes.
+ */
+static void escrever (GravacaoInstantaneo *g, const void *dados, size_t n){
+    if(n>0&&fwrite(dados,1,n,g->arq)!=n)    g->falhou=1;
+    g->posicao+=n;
+}
+
+/**
+ * @brief Comeca a gravacao de um instantaneo.
+ * @param g A gravacao.
+ * @param nome O arquivo final (so e substituido em concluirGravacao).
+ * @return 0 em caso de sucesso, -1 se o arquivo temporario nao puder ser criado.
+ */
+int iniciarGravacao (GravacaoInstantaneo *g, const char *nome){
+    CabecalhoInstantaneo c;
+    size_t n=strlen(nome)+32;
+    memset(g,0,sizeof(*g));
+    g->nome=malloc(n);
+    g->nomeTemporario=malloc(n);
+    if(g->nome==NULL||g->nomeTemporario==NULL){
+        cancelarGravacao(g);
+        return -1;
+    }
+    strcpy(g->nome,nome);
+    // O numero do processo separa gravacoes simultaneas (o filho do fork e o encerramento).
+    snprintf(g->nomeTemporario,n,"%s.%ld.novo",nome,(long)getpid());
+    g->arq=fopen(g->nomeTemporario,"wb");
+    if(g->arq==NULL){
+        cancelarGravacao(g);
+        return -1;
+    }
+    setvbuf(g->arq,NULL,_IOFBF,TAM_BUFFER_GRAVACAO);
+    // O cabecalho definitivo so e gravado no fim, quando os totais sao conhecidos.
+    memset(&c,0,sizeof(c));
+    escrever(g,&c,sizeof(c));
+    return 0;
+}
+
+/**
+ * @brief Acrescenta uma partida ao instantaneo.
+ * @param g A gravacao.
+ * @param chave A chave de retomada.
+ * @param s A partida.
+ * @param nome O nome do jogador (ate 255 bytes).
+ * @param palavra A palavra secreta (nao precisa terminar em '\0').
+ * @param tamPalavra Bytes da palavra.
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+int gravarPartida (GravacaoInstantaneo *g, uint64_t chave, const SessaoCompacta *s, const char *nome,
+                   const char *palavra, int tamPalavra){
+    static const char zeros[8];
+    RegistroInstantaneo r;
+    IndiceInstantaneo *indice;
+    size_t tamNome=strlen(nome),resto;
+    if(tamNome>255||tamPalavra<0||tamPalavra>255)   return -1;
+    if(g->quantidade==g->capacidade){
+        g->capacidade=g->capacidade?g->capacidade*2:4096;
+        indice=realloc(g->indice,g->capacidade*sizeof(IndiceInstantaneo));
+        if(indice==NULL){
+            g->falhou=1;
+            return -1;
+        }
+        g->indice=indice;
+    }
+    g->indice[g->quantidade].chave=chave;
+    g->indice[g->quantidade++].posicao=g->posicao;
+    memset(&r,0,sizeof(r));
+    r.chave=chave;
+    r.sessao=*s;
+    r.tamNome=(uint8_t)tamNome;
+    r.tamPalavra=(uint8_t)tamPalavra;
+    escrever(g,&r,sizeof(r));
+    escrever(g,nome,tamNome);
+    escrever(g,palavra,tamPalavra);
+    // Cada registro comeca em um multiplo de 8, para ser lido direto do mapeamento.
+    resto=(tamNome+tamPalavra)%8;
+    if(resto!=0)    escrever(g,zeros,8-resto);
+    return g->falhou?-1:0;
+}
+
+/**
+ * @brief Ordena o indice pela chave (radix sort, BITS_DIGITO bits por passada).
+ * @param indice O indice.
+ * @param n O numero de entradas.
+ * @return 0 em caso de sucesso, -1 se nao houver memoria.
+ */
+static int ordenarIndice (IndiceInstantaneo *indice, uint64_t n){
+    IndiceInstantaneo *aux,*origem=indice,*destino,*troca;
+    uint64_t *contagem,i,soma,t;
+    int deslocamento;
+    if(n<2) return 0;
+    aux=malloc(n*sizeof(IndiceInstantaneo));
+    contagem=malloc(((size_t)1<<BITS_DIGITO)*sizeof(uint64_t));
+    if(aux==NULL||contagem==NULL){
+        free(aux);
+        free(contagem);
+        return -1;
+    }
+    destino=aux;
+    // Passadas pares: o resultado termina de volta no vetor original.
+    for(deslocamento=0;deslocamento<64;deslocamento+=BITS_DIGITO){
+        memset(contagem,0,((size_t)1<<BITS_DIGITO)*sizeof(uint64_t));
+        for(i=0;i<n;i++)    contagem[(origem[i].chave>>deslocamento)&((1u<<BITS_DIGITO)-1)]++;
+        for(i=0,soma=0;i<((uint64_t)1<<BITS_DIGITO);i++){
+            t=contagem[i];
+            contagem[i]=soma;
+            soma+=t;
+        }
+        for(i=0;i<n;i++)    destino[contagem[(origem[i].chave>>deslocamento)&((1u<<BITS_DIGITO)-1)]++]=origem[i];
+        troca=origem;
+        origem=destino;
+        destino=troca;
+    }
+    free(aux);
+    free(contagem);
+    return 0;
+}
+
+/**
+ * @brief Grava o indice e o cabecalho, forca o arquivo ao disco e o poe no lugar do final.
+ * @param g A gravacao.
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+int concluirGravacao (GravacaoInstantaneo *g){
+    CabecalhoInstantaneo c;
+    if(ordenarIndice(g->indice,g->quantidade)<0)    g->falhou=1;
+    memset(&c,0,sizeof(c));
+    memcpy(c.magica,MAGICA_INSTANTANEO,sizeof(c.magica));
+    c.versao=VERSAO_INSTANTANEO;
+    c.tamCabecalho=sizeof(c);
+    c.quantidade=g->quantidade;
+    c.inicioIndice=g->posicao;
+    c.tamanho=g->posicao+g->quantidade*sizeof(IndiceInstantaneo);
+    c.criadoEm=(int64_t)time(NULL);
+    escrever(g,g->indice,g->quantidade*sizeof(IndiceInstantaneo));
+    if(fseek(g->arq,0,SEEK_SET)!=0) g->falhou=1;
+    escrever(g,&c,sizeof(c));
+    if(fflush(g->arq)!=0)   g->falhou=1;
+#ifndef _WIN32
+    // O instantaneo so substitui o anterior depois de estar no disco.
+    if(!g->falhou&&fsync(fileno(g->arq))!=0)    g->falhou=1;
+#endif
+    if(fclose(g->arq)!=0)   g->falhou=1;
+    g->arq=NULL;
+    if(!g->falhou&&rename(g->nomeTemporario,g->nome)!=0)    g->falhou=1;
+    if(g->falhou){
+        cancelarGravacao(g);
+        return -1;
+    }
+    free(g->indice);
+    free(g->nome);
+    free(g->nomeTemporario);
+    memset(g,0,sizeof(*g));
+    return 0;
+}
+
+/**
+ * @brief Abandona uma gravacao, apagando o arquivo temporario.
+ * @param g A gravacao.
+ */
+void cancelarGravacao (GravacaoInstantaneo *g){
+    if(g->arq!=NULL)    fclose(g->arq);
+    if(g->nomeTemporario!=NULL) remove(g->nomeTemporario);
+    free(g->indice);
+    free(g->nome);
+    free(g->nomeTemporario);
+    memset(g,0,sizeof(*g));
+}
+
+/**
+ * @brief Abre um instantaneo e valida o cabecalho e o indice.
+ *
+ * Os registros nao sao percorridos: cada um e validado quando lido
+ * (lerPartida), de modo que abrir um arquivo com milhoes de partidas
+ * custa o mapeamento e uma passada pelo indice.
+ *
+ * @param in O instantaneo.
+ * @param nome O arquivo.
+ * @return 0 em caso de sucesso, -1 se o arquivo nao existir ou for invalido.
+ */
+int abrirInstantaneo (Instantaneo *in, const char *nome){
+    const CabecalhoInstantaneo *c;
+    uint64_t i;
+#ifdef _WIN32
+    long n;
+    char *buffer;
+    FILE *arq = fopen(nome,"rb");
+    memset(in,0,sizeof(*in));
+    if(arq==NULL)   return -1;
+    fseek(arq,0,SEEK_END);
+    n=ftell(arq);
+    rewind(arq);
+    buffer=malloc(n>0?n:1);
+    if(buffer==NULL||n<0||fread(buffer,1,n,arq)!=(size_t)n){
+        free(buffer);
+        fclose(arq);
+        return -1;
+    }
+    fclose(arq);
+    in->dados=buffer;
+    in->tamanho=n;
+#else
+    struct stat st;
+    void *mapa;
+    int fd = open(nome,O_RDONLY);
+    memset(in,0,sizeof(*in));
+    if(fd<0)    return -1;
+    if(fstat(fd,&st)<0||(size_t)st.st_size<sizeof(CabecalhoInstantaneo)){
+        close(fd);
+        return -1;
+    }
+    mapa=mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    if(mapa==MAP_FAILED)    return -1;
+    // As partidas sao retomadas em qualquer ordem, conforme os jogadores voltam.
+    madvise(mapa,st.st_size,MADV_RANDOM);
+    in->dados=mapa;
+    in->tamanho=st.st_size;
+#endif
+    c=(const CabecalhoInstantaneo *)in->dados;
+    if(in->tamanho<sizeof(CabecalhoInstantaneo)||memcmp(c->magica,MAGICA_INSTANTANEO,sizeof(c->magica))!=0||
+       c->versao!=VERSAO_INSTANTANEO||c->tamCabecalho!=sizeof(CabecalhoInstantaneo)||c->tamanho!=in->tamanho||
+       c->inicioIndice<sizeof(CabecalhoInstantaneo)||c->inicioIndice%8!=0||
+       c->quantidade>(in->tamanho-c->inicioIndice)/sizeof(IndiceInstantaneo)||
+       c->inicioIndice+c->quantidade*sizeof(IndiceInstantaneo)!=in->tamanho){
+        fecharInstantaneo(in);
+        return -1;
+    }
+    in->quantidade=c->quantidade;
+    in->indice=(const IndiceInstantaneo *)(in->dados+c->inicioIndice);
+    // A busca binaria depende da ordem do indice.
+    for(i=1;i<in->quantidade;i++)
+        if(in->indice[i-1].chave>=in->indice[i].chave){
+            fecharInstantaneo(in);
+            return -1;
+        }
+    return 0;
+}
+
+/**
+ * @brief Procura uma partida pela chave de retomada.
+ * @param in O instantaneo.
+ * @param chave A chave.
+ * @return A posicao da partida no indice, ou -1 se ela nao estiver no arquivo.
+ */
+int64_t buscarInstantaneo (const Instantaneo *in, uint64_t chave){
+    uint64_t inicio,fim,meio,janela,q=in->quantidade;
+    if(q==0)    return -1;
+    // As chaves sao sorteadas uniformemente: a posicao proporcional a chave
+    // fica a poucas centenas de entradas da certa, e a busca binaria percorre
+    // so uma janela ao redor dela (alargada enquanto nao contiver a chave).
+    meio=(uint64_t)((double)chave/18446744073709551616.0*(double)q);
+    if(meio>=q) meio=q-1;
+    for(janela=JANELA_BUSCA;;janela*=2){
+        inicio=meio>janela?meio-janela:0;
+        fim=q-meio>janela?meio+janela:q;
+        if((inicio==0||in->indice[inicio-1].chave<chave)&&(fim==q||in->indice[fim].chave>=chave))   break;
+    }
+    while(inicio<fim){
+        meio=inicio+(fim-inicio)/2;
+        if(in->indice[meio].chave<chave)    inicio=meio+1;
+        else    fim=meio;
+    }
+    return inicio<in->quantidade&&in->indice[inicio].chave==chave?(int64_t)inicio:-1;
+}
+
+/**
+ * @brief Le uma partida do instantaneo, sem copia.
+ * @param in O instantaneo.
+ * @param i A posicao da partida no indice.
+ * @param nome Recebe o nome do jogador (nao terminado em '\0').
+ * @param palavra Recebe a palavra secreta (nao terminada em '\0').
+ * @return O registro, ou NULL se ele estiver fora do arquivo.
+ */
+const RegistroInstantaneo *lerPartida (const Instantaneo *in, uint64_t i, const char **nome, const char **palavra){
+    const RegistroInstantaneo *r;
+    uint64_t posicao=in->indice[i].posicao,limite=(const char *)in->indice-in->dados;
+    if(posicao<sizeof(CabecalhoInstantaneo)||posicao%8!=0||posicao+sizeof(RegistroInstantaneo)>limite)  return NULL;
+    r=(const RegistroInstantaneo *)(in->dados+posicao);
+    if(posicao+sizeof(RegistroInstantaneo)+r->tamNome+r->tamPalavra>limite||r->chave!=in->indice[i].chave)
+        return NULL;
+    *nome=(const char *)(r+1);
+    *palavra=*nome+r->tamNome;
+    return r;
+}
+
+/**
+ * @brief Fecha um instantaneo aberto.
+ * @param in O instantaneo.
+ */
+void fecharInstantaneo (Instantaneo *in){
+    if(in->dados!=NULL){
+#ifdef _WIN32
+        free((char *)in->dados);
+#else
+        munmap((void *)in->dados,in->tamanho);
+#endif
+    }
+    memset(in,0,sizeof(*in));
+}
\ No newline at end of file
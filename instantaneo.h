@@ -0,0 +1,168 @@
+/**
+ * @file instantaneo.h
+ * @brief Arquivo de cabecalho dos instantaneos das partidas (gravacao e retomada).
+ *
+ * Um instantaneo guarda as partidas em andamento em um arquivo binario
+ * versionado, para que um novo processo as retome. O arquivo e gravado em
+ * uma unica passada sequencial (um registro por partida, na ordem em que
+ * as partidas sao percorridas), seguida de um indice ordenado pela chave
+ * de retomada. A leitura mapeia o arquivo em memoria e valida apenas o
+ * cabecalho e a ordem do indice: cada partida e encontrada por busca
+ * binaria (numa janela ao redor da posicao estimada pela chave, ja que as
+ * chaves sao aleatorias) e lida no proprio mapeamento, sem copiar o arquivo.
+ *
+ * Formato (inteiros na ordem de bytes da maquina que gravou):
+ *
+ *   CabecalhoInstantaneo
+ *   registros: RegistroInstantaneo, nome, palavra, ate multiplo de 8 bytes
+ *   indice: IndiceInstantaneo[quantidade], em ordem crescente de chave
+ *
+ * A palavra e guardada por extenso, alem do seu indice na SessaoCompacta:
+ * se o arquivo de palavras mudar entre a gravacao e a retomada, a partida
+ * continua com a mesma palavra.
+ */
+
+#ifndef INSTANTANEO_H
+#define INSTANTANEO_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "sessao.h"
+
+// Identificacao e versao do formato.
+#define MAGICA_INSTANTANEO "FORCAINS"
+#define VERSAO_INSTANTANEO 1
+
+/**
+ * @struct CabecalhoInstantaneo
+ * @brief Inicio do arquivo de instantaneo.
+ */
+typedef struct{
+    char magica[8];             // MAGICA_INSTANTANEO (sem '\0').
+    uint32_t versao;            // VERSAO_INSTANTANEO.
+    uint32_t tamCabecalho;      // sizeof(CabecalhoInstantaneo).
+    uint64_t quantidade;        // Partidas no arquivo.
+    uint64_t inicioIndice;      // Posicao do indice no arquivo.
+    uint64_t tamanho;           // Tamanho total do arquivo (detecta gravacoes truncadas).
+    int64_t criadoEm;           // Instante da gravacao (segundos desde 1970).
+    uint64_t reservado[2];
+} CabecalhoInstantaneo;
+
+/**
+ * @struct RegistroInstantaneo
+ * @brief Parte fixa de uma partida no arquivo, seguida do nome e da palavra.
+ */
+typedef struct{
+    uint64_t chave;             // Chave de retomada da partida.
+    SessaoCompacta sessao;      // Estado da partida (o indice da palavra vale para o dicionario da gravacao).
+    uint8_t tamNome;            // Bytes do nome do jogador.
+    uint8_t tamPalavra;         // Bytes da palavra secreta.
+    uint8_t reservado[6];
+} RegistroInstantaneo;
+
+/**
+ * @struct IndiceInstantaneo
+ * @brief Entrada do indice: a chave e a posicao do registro no arquivo.
+ */
+typedef struct{
+    uint64_t chave;
+    uint64_t posicao;
+} IndiceInstantaneo;
+
+/**
+ * @struct GravacaoInstantaneo
+ * @brief Um instantaneo sendo gravado.
+ */
+typedef struct{
+    FILE *arq;
+    char *nomeTemporario;       // O arquivo e gravado ao lado do final e renomeado no fim.
+    char *nome;
+    IndiceInstantaneo *indice;
+    uint64_t quantidade;
+    uint64_t capacidade;
+    uint64_t posicao;           // Bytes ja gravados.
+    int falhou;                 // 1 se alguma escrita falhou.
+} GravacaoInstantaneo;
+
+/**
+ * @struct Instantaneo
+ * @brief Um instantaneo aberto para leitura.
+ */
+typedef struct{
+    const char *dados;          // O arquivo (mapeado, ou lido por inteiro no Windows).
+    size_t tamanho;
+    uint64_t quantidade;        // Partidas no arquivo.
+    const IndiceInstantaneo *indice;
+} Instantaneo;
+
+/**
+ * @brief Comeca a gravacao de um instantaneo.
+ * @param g A gravacao.
+ * @param nome O arquivo final (so e substituido em concluirGravacao).
+ * @return 0 em caso de sucesso, -1 se o arquivo temporario nao puder ser criado.
+ */
+int iniciarGravacao (GravacaoInstantaneo *g, const char *nome);
+
+/**
+ * @brief Acrescenta uma partida ao instantaneo.
+ * @param g A gravacao.
+ * @param chave A chave de retomada.
+ * @param s A partida.
+ * @param nome O nome do jogador (ate 255 bytes).
+ * @param palavra A palavra secreta (nao precisa terminar em '\0').
+ * @param tamPalavra Bytes da palavra.
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+int gravarPartida (GravacaoInstantaneo *g, uint64_t chave, const SessaoCompacta *s, const char *nome,
+                   const char *palavra, int tamPalavra);
+
+/**
+ * @brief Grava o indice e o cabecalho, forca o arquivo ao disco e o poe no lugar do final.
+ *
+ * Libera a gravacao mesmo em caso de erro (e, nesse caso, apaga o
+ * arquivo temporario e mantem o final como estava).
+ *
+ * @param g A gravacao.
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+int concluirGravacao (GravacaoInstantaneo *g);
+
+/**
+ * @brief Abandona uma gravacao, apagando o arquivo temporario.
+ * @param g A gravacao.
+ */
+void cancelarGravacao (GravacaoInstantaneo *g);
+
+/**
+ * @brief Abre um instantaneo e valida o cabecalho e o indice.
+ * @param in O instantaneo.
+ * @param nome O arquivo.
+ * @return 0 em caso de sucesso, -1 se o arquivo nao existir ou for invalido.
+ */
+int abrirInstantaneo (Instantaneo *in, const char *nome);
+
+/**
+ * @brief Procura uma partida pela chave de retomada.
+ * @param in O instantaneo.
+ * @param chave A chave.
+ * @return A posicao da partida no indice, ou -1 se ela nao estiver no arquivo.
+ */
+int64_t buscarInstantaneo (const Instantaneo *in, uint64_t chave);
+
+/**
+ * @brief Le uma partida do instantaneo, sem copia.
+ * @param in O instantaneo.
+ * @param i A posicao da partida no indice.
+ * @param nome Recebe o nome do jogador (nao terminado em '\0').
+ * @param palavra Recebe a palavra secreta (nao terminada em '\0').
+ * @return O registro, ou NULL se ele estiver fora do arquivo.
+ */
+const RegistroInstantaneo *lerPartida (const Instantaneo *in, uint64_t i, const char **nome, const char **palavra);
+
+/**
+ * @brief Fecha um instantaneo aberto.
+ * @param in O instantaneo.
+ */
+void fecharInstantaneo (Instantaneo *in);
+
+#endif
\ No newline at end of file
@@ -1,141 +1,370 @@
-/**
- * @file main.c
- * @brief Arquivo principal do jogo da Forca.
- *
- * Responsavel por inicializar o jogo, controlar o laço principal
- * das partidas, coletar a entrada do usuario e chamar as funcoes
- * de logica do jogo.
- */
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <ctype.h>
-#include <time.h>
-#include "forca.h"
-
-int main (){
-    // Inicializa a semente para geracao de numeros aleatorios.
-    srand(time(NULL));
-
-    // Declaracao das variaveis principais do jogo.
-    Jogador p;
-    char palavra[TAM_MAX_PALAVRA],palavraNaForca[TAM_MAX_PALAVRA],palavraTeste[TAM_MAX_PALAVRA],letra,c;
-    int tamanhoArquivo = contarPalavras (ARQUIVO_PALAVRAS), letras[TAM_LETRAS];
-
-    // Pede o nome do jogador apenas uma vez, no inicio do programa.
-    do{
-        printf("\nAntes de comecarmos, digite seu nome, pode ser apelido: ");
-        fgets(p.nome,TAM_MAX_PALAVRA,stdin);
-        apararString(p.nome);
-    }while(p.nome[0]=='\0'); // Garante que nao foi digitada uma string vazia.
-
-    // Laço principal do jogo: permite jogar multiplas partidas.
-    do{
-        // Limpa a tela para uma nova partida.
-        #ifdef _WIN32
-            system("cls");
-        #else
-            system("clear");
-        #endif
-
-        // Prepara as variaveis para uma nova rodada.
-        zerarVetor(letras,TAM_LETRAS);
-        carregarPalavras(ARQUIVO_PALAVRAS,palavra,tamanhoArquivo);
-        reiniciarForca(palavraNaForca,strlen(palavra));
-        iniciarPartida (&p); // Inicia vidas e contagem regressiva.
-
-        // Laço de uma unica partida: continua enquanto o jogador tem vidas e nao acertou a palavra.
-        while(p.vidas>0 && strcasecmp(palavra,palavraNaForca)!=0){
-            // Limpa a tela a cada jogada para manter a interface limpa.
-            #ifdef _WIN32
-                system("cls");
-            #else
-                system("clear");
-            #endif
-
-            // Mostra o estado atual do jogo (forca, palavra, letras usadas).
-            desenharForca(p,palavraNaForca,letras,TAM_LETRAS);
-
-            // Pergunta ao jogador sua proxima acao (Letra ou Palavra).
-            do{
-                printf("Digite uma letra ou tente uma palavra (L/P): ");
-                scanf(" %c",&c);
-                limparBuffer();
-            }while(toupper(c)!='L'&&toupper(c)!='P');
-            printf("\n");
-
-            // Se o jogador escolheu 'L' (Letra).
-            if(toupper(c)=='L'){
-                // Pede por uma letra valida.
-                do{
-                    printf("Digite uma letra valida: ");
-                    scanf(" %c",&letra);
-                    limparBuffer();
-                }while(!isalpha(letra));
-
-                // Verifica se a letra ja foi usada.
-                if(verificarLetra(letra,letras)){
-                    printf("\nLetra ja utilizada!");
-                    p.vidas-=2; // Penalidade maior por erro repetido.
-                }
-                else{
-                    // Se a letra nao esta na palavra, perde uma vida.
-                    if(testarLetra(letra,palavra,palavraNaForca)==0){
-                        p.vidas--;
-                        printf("\nLetra errada!");
-                    }
-                }
-            }
-            // Se o jogador escolheu 'P' (Palavra).
-            else{
-                // Pede para o jogador digitar seu palpite.
-                do{
-                    printf("Digite uma palavra: ");
-                    fgets(palavraTeste,TAM_MAX_PALAVRA,stdin);
-                    apararString(palavraTeste);
-                }while(palavraTeste[0]=='\0'); // Garante que nao foi digitada uma string vazia.
-
-                // Compara a palavra do palpite com a palavra secreta.
-                if(strcasecmp(palavra,palavraTeste)==0){
-                    delayMS(DELAY_3s);
-                    break; // Se acertou, sai do laço da partida.
-                }
-                else{
-                    printf("\nPalavra errada!");
-                    p.vidas-=2; // Penalidade maior por errar a palavra.
-                }
-            }
-            // Um delay para o jogador poder ler a mensagem (letra errada, etc.).
-            delayMS(DELAY_3s);
-        }
-
-        // --- Fim da Partida ---
-        // Limpa a tela para mostrar o resultado final.
-        #ifdef _WIN32
-            system("cls");
-        #else
-            system("clear");
-        #endif
-
-        // Desenha o estado final do jogo, revelando a palavra.
-        desenharForca(p,palavra,letras,TAM_LETRAS);
-
-        // Exibe a mensagem de vitoria ou derrota.
-        if(p.vidas>0) printf("\n\nParabens, %s! Voce acertou em cheio.\n",p.nome);
-        else    printf("\n\nSinto muito, %s! Voce foi enforcado, fim de linha.\n",p.nome);
-
-        // Salva o resultado no arquivo de resultados.
-        registrarResultado(ARQUIVO_RESULTADOS,palavra,p);
-
-        // Pergunta se o jogador quer jogar novamente.
-        do{
-            printf("\nQuer jogar novamente (S/N): ");
-            scanf(" %c",&c);
-            limparBuffer();
-        }while(toupper(c)!='S'&&toupper(c)!='N');
-
-    }while(toupper(c)=='S');
-
-    return 0;
+/**
+ * @file main.c
+ * @brief Arquivo principal do jogo da Forca.
+ *
+ * Responsavel por inicializar o jogo, controlar o laço principal
+ * das partidas, coletar a entrada do usuario e repassar os palpites
+ * ao motor de partidas (sessao.h), que aplica as regras do jogo.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "forca.h"
+#include "sessao.h"
+#include "maligno.h"
+#include "dificuldade.h"
+#include "recarga.h"
+#include "tela.h"
+#include "servidor.h"
+#include "analise.h"
+#include "perfis.h"
+#include "metricas.h"
+
+/**
+ * @brief Confere se as metricas foram compiladas, avisando caso contrario.
+ * @param arquivo O arquivo de metricas pedido na linha de comando.
+ * @return O arquivo, ou NULL se as metricas nao estiverem disponiveis.
+ */
+static const char *aceitarMetricas (const char *arquivo){
+#ifdef FORCA_METRICAS
+    return arquivo;
+#else
+    (void)arquivo;
+    printf("Metricas indisponiveis: compile com -DFORCA_METRICAS.\n");
+    return NULL;
+#endif
+}
+
+/**
+ * @brief Le as opcoes do modo servidor e o executa.
+ *
+ * Opcoes: --porta N, --unix caminho, --threads N, --sem-registro,
+ * --sincronia nunca|lote|periodica, --ritmo, --semente N, --metricas arquivo,
+ * --recarregar e --instantaneo arquivo.
+ *
+ * @param argc O numero de argumentos.
+ * @param argv Os argumentos da linha de comando.
+ * @return O codigo de saida do programa.
+ */
+static int iniciarServidor (int argc, char *argv[]){
+    ConfigServidor config={PORTA_PADRAO,NULL,0,1,SINCRONIA_NUNCA,0,0,NULL,0,NULL};
+    int i;
+    for(i=2;i<argc;i++){
+        if(strcmp(argv[i],"--porta")==0&&i+1<argc)   config.porta=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--unix")==0&&i+1<argc)   config.caminhoUnix=argv[++i];
+        else if(strcmp(argv[i],"--threads")==0&&i+1<argc)    config.threads=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--sem-registro")==0) config.registrar=0;
+        else if(strcmp(argv[i],"--ritmo")==0)   config.ritmo=1;
+        else if((strcmp(argv[i],"--semente")==0||strcmp(argv[i],"--seed")==0)&&i+1<argc)
+            config.semente=strtoull(argv[++i],NULL,0);
+        else if(strcmp(argv[i],"--metricas")==0&&i+1<argc)   config.arquivoMetricas=aceitarMetricas(argv[++i]);
+        else if(strcmp(argv[i],"--recarregar")==0)  config.recarregar=1;
+        else if(strcmp(argv[i],"--instantaneo")==0&&i+1<argc)    config.arquivoInstantaneo=argv[++i];
+        else if(strcmp(argv[i],"--sincronia")==0&&i+1<argc){
+            i++;
+            if(strcmp(argv[i],"lote")==0)   config.sincronia=SINCRONIA_POR_LOTE;
+            else if(strcmp(argv[i],"periodica")==0) config.sincronia=SINCRONIA_PERIODICA;
+            else    config.sincronia=SINCRONIA_NUNCA;
+        }
+        else{
+            printf("Opcao invalida: %s\n",argv[i]);
+            return 1;
+        }
+    }
+    return executarServidor(&config);
+}
+
+/**
+ * @brief Le as opcoes da analise de resultados e a executa.
+ *
+ * Uso: --analise [arquivo] [--threads N].
+ *
+ * @param argc O numero de argumentos.
+ * @param argv Os argumentos da linha de comando.
+ * @return O codigo de saida do programa.
+ */
+static int iniciarAnalise (int argc, char *argv[]){
+    const char *arquivo=ARQUIVO_RESULTADOS;
+    int i,threads=0;
+    for(i=2;i<argc;i++){
+        if(strcmp(argv[i],"--threads")==0&&i+1<argc) threads=atoi(argv[++i]);
+        else    arquivo=argv[i];
+    }
+    return analisarResultados(arquivo,threads);
+}
+
+/**
+ * @brief Mostra o historico de um jogador e a sua posicao no ranking.
+ * @param f O perfil do jogador.
+ */
+static void mostrarPerfil (const Perfil *f){
+    printf("%s: %u vitorias, %u derrotas, sequencia atual %u (melhor %u)",f->nome,f->vitorias,f->derrotas,
+           f->sequenciaAtual,f->melhorSequencia);
+    if(f->vitorias>0)   printf(", media de %.1f vidas restantes",(double)f->vidasRestantes/f->vitorias);
+    if(f->posicaoRanking>=0)    printf(", %do no ranking",f->posicaoRanking+1);
+    printf(".\n");
+}
+
+/**
+ * @brief Consulta o cadastro de perfis (ver perfis.h).
+ *
+ * Uso: --perfil nome, ou --ranking [K].
+ *
+ * @param argc O numero de argumentos.
+ * @param argv Os argumentos da linha de comando.
+ * @return O codigo de saida do programa.
+ */
+static int consultarPerfis (int argc, char *argv[]){
+    const Perfil *ranking[TAM_RANKING];
+    int i,k;
+    // So consulta: nao cria o arquivo nem disputa a trava com um jogo em andamento.
+    Perfis *perfis = abrirPerfisLeitura(ARQUIVO_PERFIS);
+    if(perfis==NULL){
+        printf("Erro ao abrir o arquivo: %s\n",ARQUIVO_PERFIS);
+        return 1;
+    }
+    if(strcmp(argv[1],"--perfil")==0){
+        const Perfil *f = argc>2?buscarPerfil(perfis,argv[2]):NULL;
+        if(f!=NULL) mostrarPerfil(f);
+        else    printf("Jogador nao encontrado.\n");
+    }
+    else{
+        k=consultarRanking(perfis,ranking,argc>2?atoi(argv[2]):10);
+        printf("%zu jogadores cadastrados.\n",contarPerfis(perfis));
+        for(i=0;i<k;i++)    printf("%3d. %-30s %u vitorias, %u derrotas\n",i+1,ranking[i]->nome,ranking[i]->vitorias,ranking[i]->derrotas);
+    }
+    fecharPerfis(perfis);
+    return 0;
+}
+
+/**
+ * @brief Le as opcoes do jogo no terminal.
+ *
+ * Opcoes: --rapido (ou --fast), --semente N (ou --seed N), --metricas arquivo,
+ * --maligno, --nivel facil|medio|dificil, --comprimento N ou N-M e --recarregar.
+ *
+ * @param argc O numero de argumentos.
+ * @param argv Os argumentos da linha de comando.
+ * @param semente Recebe a semente informada (inalterada se nao houver).
+ * @param metricas Recebe o arquivo de metricas informado (inalterado se nao houver).
+ * @param maligno Recebe 1 se o modo maligno foi pedido (inalterado se nao).
+ * @param nivel Recebe o nivel de dificuldade pedido (inalterado se nao houver).
+ * @param minimo Recebe o menor comprimento pedido (inalterado se nao houver).
+ * @param maximo Recebe o maior comprimento pedido (inalterado se nao houver).
+ * @param recarregar Recebe 1 se a recarga das palavras foi pedida (inalterado se nao).
+ * @return 0 em caso de sucesso, 1 se houver uma opcao invalida.
+ */
+static int lerOpcoesJogo (int argc, char *argv[], uint64_t *semente, const char **metricas, int *maligno, int *nivel,
+                          int *minimo, int *maximo, int *recarregar){
+    const char *niveis[NIVEIS_DIFICULDADE]={"facil","medio","dificil"};
+    char *fim;
+    int i,k;
+    for(i=1;i<argc;i++){
+        // Modo rapido: sem contagem regressiva nem pausas entre as jogadas.
+        if(strcmp(argv[i],"--rapido")==0||strcmp(argv[i],"--fast")==0) definirModoRapido(1);
+        else if((strcmp(argv[i],"--semente")==0||strcmp(argv[i],"--seed")==0)&&i+1<argc)
+            *semente=strtoull(argv[++i],NULL,0);
+        else if(strcmp(argv[i],"--metricas")==0&&i+1<argc)  *metricas=aceitarMetricas(argv[++i]);
+        // Modo maligno: a palavra secreta muda para escapar dos palpites (ver maligno.h).
+        else if(strcmp(argv[i],"--maligno")==0) *maligno=1;
+        // Filtros do sorteio: nivel de dificuldade e faixa de comprimentos (ver dificuldade.h).
+        else if(strcmp(argv[i],"--nivel")==0&&i+1<argc){
+            for(k=0,i++;k<NIVEIS_DIFICULDADE&&strcmp(argv[i],niveis[k])!=0;k++);
+            if(k==NIVEIS_DIFICULDADE){
+                printf("Nivel invalido: %s (use facil, medio ou dificil)\n",argv[i]);
+                return 1;
+            }
+            *nivel=k;
+        }
+        else if(strcmp(argv[i],"--comprimento")==0&&i+1<argc){
+            *minimo=*maximo=(int)strtol(argv[++i],&fim,10);
+            if(*fim=='-')   *maximo=(int)strtol(fim+1,&fim,10);
+            if(*fim!='\0'||*minimo<1||*maximo<*minimo){
+                printf("Comprimento invalido: %s (use N ou N-M)\n",argv[i]);
+                return 1;
+            }
+        }
+        // Recarga: uma edicao de ARQUIVO_PALAVRAS vale a partir da proxima partida (ver recarga.h).
+        else if(strcmp(argv[i],"--recarregar")==0)  *recarregar=1;
+        else{
+            printf("Opcao invalida: %s\n",argv[i]);
+            return 1;
+        }
+    }
+    // O modo maligno e os filtros montam tabelas sobre uma unica versao das palavras.
+    if(*recarregar&&(*maligno||*nivel>=0||*minimo>0||*maximo<TAM_MAX_MASCARA)){
+        printf("A opcao --recarregar nao pode ser usada com --maligno, --nivel ou --comprimento.\n");
+        return 1;
+    }
+    return 0;
+}
+
+int main (int argc, char *argv[]){
+    // Modo servidor: as partidas sao jogadas pela rede (ver servidor.h).
+    if(argc>1&&strcmp(argv[1],"--servidor")==0)
+        return iniciarServidor(argc,argv);
+    // Relatorio de vitorias por jogador, por palavra e por hora (ver analise.h).
+    if(argc>1&&strcmp(argv[1],"--analise")==0)
+        return iniciarAnalise(argc,argv);
+    // Historico de um jogador ou ranking de vitorias (ver perfis.h).
+    if(argc>1&&(strcmp(argv[1],"--perfil")==0||strcmp(argv[1],"--ranking")==0))
+        return consultarPerfis(argc,argv);
+
+    // Cada partida sorteia a palavra com o seu proprio gerador. A semente de
+    // uma partida sai do gerador da anterior, de modo que --semente repete
+    // a partida informada e todas as seguintes.
+    uint64_t semente=gerarSemente();
+    const char *metricas=NULL;
+    int maligno=0,nivel=-1,minimo=0,maximo=TAM_MAX_MASCARA,recarregar=0;
+    if(lerOpcoesJogo(argc,argv,&semente,&metricas,&maligno,&nivel,&minimo,&maximo,&recarregar)!=0)    return 1;
+
+    // Declaracao das variaveis principais do jogo.
+    Jogador p;
+    Sessao s;
+    Aleatorio gerador;
+    static Tela tela;
+    ResultadoJogada r;
+    char palavra[TAM_MAX_PALAVRA],palavraTeste[TAM_MAX_PALAVRA],letra,c;
+    // Com recarga, as palavras vem das versoes da recarga, e nao do dicionario compartilhado.
+    Recarga *recarga = recarregar?iniciarRecarga(ARQUIVO_PALAVRAS,1):NULL;
+    int tamanhoArquivo = recarregar?0:contarPalavras (ARQUIVO_PALAVRAS);
+    Maligno tabelasMalignas;
+    EstadoMaligno e;
+    IndiceDificuldade indice;
+    if(recarregar&&recarga==NULL){
+        printf("Erro ao abrir o arquivo: %s\n",ARQUIVO_PALAVRAS);
+        return 1;
+    }
+    // O indice so e montado se o sorteio tiver filtro; sem --nivel, vale qualquer nivel (-1).
+    int filtrar=nivel>=0||minimo>0||maximo<TAM_MAX_MASCARA;
+    if(filtrar){
+        if(criarIndiceDificuldade(&indice,obterDicionarioPadrao(ARQUIVO_PALAVRAS))<0){
+            printf("Memoria insuficiente para o indice de dificuldade.\n");
+            return 1;
+        }
+        if(contarPorDificuldade(&indice,minimo,maximo,nivel)==0){
+            printf("Nenhuma palavra com o nivel e o comprimento pedidos.\n");
+            return 1;
+        }
+    }
+    // As tabelas do modo maligno sao montadas uma vez, sobre o dicionario ja carregado.
+    if(maligno&&criarMaligno(&tabelasMalignas,obterDicionarioPadrao(ARQUIVO_PALAVRAS))<0){
+        printf("Memoria insuficiente para o modo maligno.\n");
+        return 1;
+    }
+    iniciarTela(&tela);
+    // Cada resultado tambem atualiza o perfil do jogador.
+    definirPerfisPadrao(abrirPerfis(ARQUIVO_PERFIS,0));
+
+    // Pede o nome do jogador apenas uma vez, no inicio do programa.
+    do{
+        printf("\nAntes de comecarmos, digite seu nome, pode ser apelido: ");
+        // Fim da entrada (por exemplo, um roteiro no modo rapido): encerra o programa.
+        if(fgets(p.nome,TAM_MAX_PALAVRA,stdin)==NULL)   return 0;
+        apararString(p.nome);
+    }while(p.nome[0]=='\0'); // Garante que nao foi digitada uma string vazia.
+
+    // Laço principal do jogo: permite jogar multiplas partidas.
+    do{
+        // Limpa a tela para uma nova partida (sequencia ANSI, sem criar processo).
+        limparTela(&tela);
+
+        // Prepara a sessao para uma nova rodada.
+        semearAleatorio(&gerador,semente);
+        if(filtrar) carregarPorDificuldade(&indice,&gerador,minimo,maximo,nivel,palavra);
+        else if(recarga!=NULL){
+            // O jogo no terminal e a unica leitora; entre as partidas nao usa nenhuma versao.
+            marcarQuiescencia(recarga,0);
+            carregarPalavraAtual(recarga,&gerador,palavra);
+        }
+        else    carregarPalavras(ARQUIVO_PALAVRAS,palavra,tamanhoArquivo,&gerador);
+        // Palavra vazia ou longa demais (arquivo de palavras corrompido): com a mesma
+        // semente um novo sorteio poderia repetir a palavra, entao o jogo termina.
+        if(iniciarSessao(&s,p.nome,palavra)<0){
+            printf("Erro na palavra sorteada: \"%s\"\n",palavra);
+            return 1;
+        }
+        // Sem memoria para os candidatos, a partida segue com a palavra sorteada.
+        if(maligno) iniciarMaligno(&tabelasMalignas,&e,palavra);
+        iniciarPartida (&s.jogador); // Inicia vidas e contagem regressiva.
+
+        // Laço de uma unica partida: continua enquanto a sessao aceitar palpites.
+        while(consultarSessao(&s)==SESSAO_EM_JOGO){
+            // Mostra o estado atual do jogo (forca, palavra, letras usadas). So as
+            // linhas alteradas sao reescritas, e as perguntas anteriores sao apagadas.
+            desenharQuadro(&tela,&s.jogador,s.palavraNaForca,s.letras);
+
+            // Pergunta ao jogador sua proxima acao (Letra ou Palavra).
+            do{
+                printf("Digite uma letra ou tente uma palavra (L/P): ");
+                if(scanf(" %c",&c)!=1)  return 0;
+                limparBuffer();
+            }while(toupper(c)!='L'&&toupper(c)!='P');
+            printf("\n");
+
+            // Se o jogador escolheu 'L' (Letra).
+            if(toupper(c)=='L'){
+                // Pede por uma letra valida e aplica o palpite na sessao.
+                do{
+                    printf("Digite uma letra valida: ");
+                    if(scanf(" %c",&letra)!=1)  return 0;
+                    limparBuffer();
+                }while((r=maligno?chutarLetraMaligna(&e,&s,letra):chutarLetra(&s,letra))==JOGADA_INVALIDA);
+
+                if(r==JOGADA_REPETIDA)  printf("\nLetra ja utilizada!");
+                else if(r==JOGADA_ERRO) printf("\nLetra errada!");
+            }
+            // Se o jogador escolheu 'P' (Palavra).
+            else{
+                // Pede para o jogador digitar seu palpite.
+                do{
+                    printf("Digite uma palavra: ");
+                    if(fgets(palavraTeste,TAM_MAX_PALAVRA,stdin)==NULL) return 0;
+                    apararString(palavraTeste);
+                }while(palavraTeste[0]=='\0'); // Garante que nao foi digitada uma string vazia.
+
+                // Compara a palavra do palpite com a palavra secreta.
+                if((maligno?chutarPalavraMaligna(&e,&s,palavraTeste):chutarPalavra(&s,palavraTeste))==JOGADA_ERRO)
+                    printf("\nPalavra errada!");
+            }
+            // Um delay para o jogador poder ler a mensagem (letra errada, etc.).
+            delayMS(DELAY_3s);
+        }
+
+        // --- Fim da Partida ---
+        if(maligno) encerrarMaligno(&e);
+        // Desenha o estado final do jogo, revelando a palavra.
+        desenharQuadro(&tela,&s.jogador,s.palavra,s.letras);
+
+        // Exibe a mensagem de vitoria ou derrota.
+        if(consultarSessao(&s)==SESSAO_VITORIA) printf("\n\nParabens, %s! Voce acertou em cheio.\n",p.nome);
+        else    printf("\n\nSinto muito, %s! Voce foi enforcado, fim de linha.\n",p.nome);
+        printf("(semente desta partida: %llu)\n",(unsigned long long)semente);
+        semente=proximoAleatorio(&gerador);
+
+        // Salva o resultado no arquivo de resultados e mostra o historico atualizado.
+        registrarResultado(ARQUIVO_RESULTADOS,s.palavra,&s.jogador);
+        if(obterPerfisPadrao()!=NULL&&buscarPerfil(obterPerfisPadrao(),p.nome)!=NULL)
+            mostrarPerfil(buscarPerfil(obterPerfisPadrao(),p.nome));
+#ifdef FORCA_METRICAS
+        // Atualiza o relatorio de metricas a cada partida.
+        if(metricas!=NULL)  gravarMetricas(metricas);
+#endif
+
+        // Pergunta se o jogador quer jogar novamente.
+        do{
+            printf("\nQuer jogar novamente (S/N): ");
+            if(scanf(" %c",&c)!=1)  return 0;
+            limparBuffer();
+        }while(toupper(c)!='S'&&toupper(c)!='N');
+
+    }while(toupper(c)=='S');
+
+    if(maligno) destruirMaligno(&tabelasMalignas);
+    if(filtrar) destruirIndiceDificuldade(&indice);
+    encerrarRecarga(recarga);
+    fecharPerfis(obterPerfisPadrao());
+    return 0;
 }
\ No newline at end of file
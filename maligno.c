@@ -0,0 +1,432 @@
+/**
+ * @file maligno.c
+ * @brief Implementacao do modo maligno (palavra secreta adaptativa).
+ *
+ * Para cada comprimento, guarda o conjunto de bits das palavras que
+ * contem cada letra e, para cada letra e bloco de 64 palavras, um
+ * conjunto por posicao. Um palpite percorre os blocos contando com
+ * popcount os candidatos sem a letra e os que a tem uma unica vez; os que
+ * tem a letra repetida so sao agrupados um a um (numa tabela de
+ * espalhamento com enderecamento aberto, reaproveitada entre palpites)
+ * quando o limite superior das suas classes passa da melhor classe ja
+ * contada. A classe escolhida vira uma sequencia de ANDs por bloco.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include "forca.h"
+#include "maligno.h"
+
+/**
+ * @brief Converte um caractere no indice da letra.
+ * @param c O caractere.
+ * @return 0 a 25 para A-Z ou a-z, -1 caso contrario.
+ */
+static int indiceLetra (char c){
+    int i=toupper((unsigned char)c)-'A';
+    return i>=0&&i<TAM_ALFABETO?i:-1;
+}
+
+/**
+ * @brief Monta as tabelas do modo maligno a partir de um dicionario.
+ *
+ * Duas passadas pelo dicionario, como em criarSolucionador: a primeira
+ * conta as palavras de cada comprimento, a segunda preenche as tabelas.
+ *
+ * @param m As tabelas.
+ * @param d O dicionario (deve permanecer aberto enquanto as tabelas forem usadas).
+ * @return 0 em caso de sucesso, -1 em caso de falta de memoria.
+ */
+int criarMaligno (Maligno *m, const Dicionario *d){
+    int i,j,n,c,t,k,letras,preenchidas[TAM_MAX_MASCARA+1]={0};
+    const char *palavra;
+    uint64_t bit;
+    memset(m,0,sizeof(*m));
+    m->dicionario=d;
+    for(i=0;i<d->quantidade;i++)    m->grupos[d->tamanho[i]].quantidade++;
+    for(t=1;t<=TAM_MAX_MASCARA;t++){
+        GrupoMaligno *g = &m->grupos[t];
+        if(g->quantidade==0)    continue;
+        g->blocos=(g->quantidade+63)/64;
+        g->indices=malloc(g->quantidade*sizeof(int));
+        g->contem=calloc((size_t)TAM_ALFABETO*g->blocos,sizeof(uint64_t));
+        g->soLetras=calloc(g->blocos,sizeof(uint64_t));
+        g->naPosicao=calloc((size_t)TAM_ALFABETO*g->blocos*t,sizeof(uint64_t));
+        if(g->indices==NULL||g->contem==NULL||g->soLetras==NULL||g->naPosicao==NULL){
+            destruirMaligno(m);
+            return -1;
+        }
+    }
+    for(i=0;i<d->quantidade;i++){
+        palavra=obterPalavra(d,i,&n);
+        GrupoMaligno *g = &m->grupos[n];
+        k=preenchidas[n]++;
+        bit=1ULL<<(k%64);
+        g->indices[k]=i;
+        for(j=0,letras=0;j<n;j++){
+            c=indiceLetra(palavra[j]);
+            if(c<0) continue;
+            letras++;
+            g->contem[(size_t)c*g->blocos+k/64]|=bit;
+            g->naPosicao[((size_t)c*g->blocos+k/64)*n+j]|=bit;
+        }
+        if(letras==n)   g->soLetras[k/64]|=bit;
+    }
+    return 0;
+}
+
+/**
+ * @brief Libera as tabelas do modo maligno.
+ * @param m As tabelas.
+ */
+void destruirMaligno (Maligno *m){
+    int t;
+    for(t=0;t<=TAM_MAX_MASCARA;t++){
+        free(m->grupos[t].indices);
+        free(m->grupos[t].contem);
+        free(m->grupos[t].soLetras);
+        free(m->grupos[t].naPosicao);
+    }
+    memset(m,0,sizeof(*m));
+}
+
+/**
+ * @brief Confere se uma palavra tem os mesmos simbolos (nao letras) nas mesmas posicoes.
+ * @param a A primeira palavra.
+ * @param b A segunda palavra (nao terminada em '\0').
+ * @param n O comprimento das duas.
+ * @return 1 se os simbolos coincidem, 0 caso contrario.
+ */
+static int mesmosSimbolos (const char *a, const char *b, int n){
+    int i;
+    for(i=0;i<n;i++){
+        if((indiceLetra(a[i])<0)!=(indiceLetra(b[i])<0))    return 0;
+        if(indiceLetra(a[i])<0&&a[i]!=b[i]) return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Inicia os candidatos de uma partida a partir da palavra sorteada.
+ * @param m As tabelas.
+ * @param e O estado a ser preenchido.
+ * @param palavra A palavra sorteada para a partida.
+ * @return 0 em caso de sucesso, -1 em caso de falta de memoria.
+ */
+int iniciarMaligno (const Maligno *m, EstadoMaligno *e, const char *palavra){
+    const GrupoMaligno *g;
+    const char *outra;
+    int n=(int)strlen(palavra),b,k,tamanho,soLetras;
+    memset(e,0,sizeof(*e));
+    e->maligno=m;
+    e->tamanho=n<=TAM_MAX_MASCARA?n:0;
+    e->grupo=g=&m->grupos[e->tamanho];
+    e->candidatos=calloc(g->blocos>0?g->blocos:1,sizeof(uint64_t));
+    e->bitsClasses=__builtin_ctz(CLASSES_INICIAIS);
+    e->classes=calloc(CLASSES_INICIAIS,sizeof(ClasseMaligna));
+    if(e->candidatos==NULL||e->classes==NULL){
+        encerrarMaligno(e);
+        return -1;
+    }
+    for(k=0,soLetras=1;k<n;k++)
+        if(indiceLetra(palavra[k])<0)   soLetras=0;
+    if(soLetras)
+        memcpy(e->candidatos,g->soLetras,g->blocos*sizeof(uint64_t));
+    else{
+        // Palavras com simbolos sao raras: basta comparar as do grupo que tambem os tem.
+        for(k=0;k<g->quantidade;k++){
+            if(g->soLetras[k/64]&(1ULL<<(k%64)))   continue;
+            outra=obterPalavra(m->dicionario,g->indices[k],&tamanho);
+            if(mesmosSimbolos(palavra,outra,n)) e->candidatos[k/64]|=1ULL<<(k%64);
+        }
+    }
+    for(b=0;b<g->blocos;b++)    e->restantes+=__builtin_popcountll(e->candidatos[b]);
+    return 0;
+}
+
+/**
+ * @brief Remonta as posicoes da letra nas palavras de um bloco a partir dos conjuntos por posicao.
+ *
+ * Percorre so os bits ligados, entao custa o numero de ocorrencias da
+ * letra nas palavras pedidas, e nao palavras vezes comprimento.
+ *
+ * @param bloco Os conjuntos por posicao do bloco, para a letra.
+ * @param tamanho O comprimento das palavras.
+ * @param palavras As palavras do bloco que interessam.
+ * @param padroes Recebe, para cada palavra pedida (0 a 63), a mascara das posicoes.
+ */
+static void montarPadroes (const uint64_t *bloco, int tamanho, uint64_t palavras, uint64_t padroes[64]){
+    uint64_t resto;
+    int j;
+    for(resto=palavras;resto!=0;resto&=resto-1)  padroes[__builtin_ctzll(resto)]=0;
+    for(j=0;j<tamanho;j++)
+        for(resto=palavras&bloco[j];resto!=0;resto&=resto-1)    padroes[__builtin_ctzll(resto)]|=1ULL<<j;
+}
+
+/**
+ * @brief Localiza a posicao de uma mascara na tabela de classes.
+ * @param classes A tabela.
+ * @param bits A tabela tem 2^bits posicoes.
+ * @param posicoes A mascara procurada.
+ * @return A posicao da classe, ou a posicao livre onde ela deve entrar.
+ */
+static inline uint32_t localizarClasse (const ClasseMaligna *classes, int bits, uint64_t posicoes){
+    uint32_t h=(uint32_t)((posicoes*0x9e3779b97f4a7c15ULL)>>(64-bits)),limite=(1u<<bits)-1;
+    while(classes[h].quantidade!=0&&classes[h].posicoes!=posicoes)  h=(h+1)&limite;
+    return h;
+}
+
+/**
+ * @brief Dobra a tabela de classes, reinserindo as classes ja contadas.
+ * @param e O estado da partida.
+ * @return 0 em caso de sucesso, -1 em caso de falta de memoria.
+ */
+static int crescerClasses (EstadoMaligno *e){
+    ClasseMaligna *novas = calloc((size_t)2<<e->bitsClasses,sizeof(ClasseMaligna));
+    uint32_t i;
+    if(novas==NULL) return -1;
+    for(i=0;i<1u<<e->bitsClasses;i++)
+        if(e->classes[i].quantidade!=0)
+            novas[localizarClasse(novas,e->bitsClasses+1,e->classes[i].posicoes)]=e->classes[i];
+    free(e->classes);
+    e->classes=novas;
+    e->bitsClasses++;
+    return 0;
+}
+
+/**
+ * @brief Compara duas classes pelo criterio do modo maligno.
+ *
+ * Vence a maior; no empate, a que revela menos posicoes e depois a de
+ * menor mascara, para que a escolha nao dependa da ordem da tabela.
+ *
+ * @param quantidade O tamanho da classe candidata.
+ * @param posicoes As posicoes da classe candidata.
+ * @param maior O tamanho da melhor classe ate agora.
+ * @param melhor As posicoes da melhor classe ate agora.
+ * @return 1 se a candidata supera a melhor, 0 caso contrario.
+ */
+static int superaClasse (int quantidade, uint64_t posicoes, int maior, uint64_t melhor){
+    if(quantidade!=maior)   return quantidade>maior;
+    if(__builtin_popcountll(posicoes)!=__builtin_popcountll(melhor))
+        return __builtin_popcountll(posicoes)<__builtin_popcountll(melhor);
+    return posicoes<melhor;
+}
+
+/**
+ * @brief Agrupa os candidatos com a letra repetida pelas suas posicoes.
+ * @param e O estado da partida.
+ * @param c O indice da letra.
+ * @return 0 em caso de sucesso, -1 em caso de falta de memoria.
+ */
+static int agruparRepetidas (EstadoMaligno *e, int c){
+    const GrupoMaligno *g = e->grupo;
+    const uint64_t *bloco;
+    uint64_t um,dois,resto,padrao,padroes[64];
+    uint32_t h;
+    int b,j;
+    memset(e->classes,0,sizeof(ClasseMaligna)<<e->bitsClasses);
+    e->numClasses=0;
+    for(b=0;b<g->blocos;b++){
+        if(e->candidatos[b]==0) continue;
+        bloco=&g->naPosicao[((size_t)c*g->blocos+b)*e->tamanho];
+        for(j=0,um=0,dois=0;j<e->tamanho;j++){
+            dois|=um&bloco[j];
+            um|=bloco[j];
+        }
+        montarPadroes(bloco,e->tamanho,e->candidatos[b]&dois,padroes);
+        for(resto=e->candidatos[b]&dois;resto!=0;resto&=resto-1){
+            padrao=padroes[__builtin_ctzll(resto)];
+            h=localizarClasse(e->classes,e->bitsClasses,padrao);
+            if(e->classes[h].quantidade++==0){
+                e->classes[h].posicoes=padrao;
+                // Mantem a tabela no maximo meio cheia.
+                e->numClasses++;
+                if(e->numClasses*2>(1<<e->bitsClasses)&&crescerClasses(e)<0)    return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Separa os candidatos pelo padrao de uma letra e fica com a maior classe.
+ *
+ * Os candidatos sem a letra e os que a tem uma unica vez (em cada
+ * posicao) sao contados por bloco com popcount. Uma classe com a letra
+ * repetida na posicao j nao passa do numero de repetidas com a letra em
+ * j; so quando esse limite supera a melhor classe as repetidas sao
+ * agrupadas uma a uma.
+ *
+ * @param e O estado da partida.
+ * @param letra A letra chutada (A-Z ou a-z).
+ * @param posicoes Recebe as posicoes que a letra revela (0 se a letra nao aparece).
+ * @return 0 em caso de sucesso, -1 em caso de falta de memoria.
+ */
+int particionarMaligno (EstadoMaligno *e, char letra, uint64_t *posicoes){
+    const GrupoMaligno *g = e->grupo;
+    const uint64_t *bloco;
+    const ClasseMaligna *classe;
+    uint64_t x,um,dois,mantidos,melhor=0;
+    int unicas[TAM_MAX_MASCARA]={0},repetidas[TAM_MAX_MASCARA]={0};
+    int c=indiceLetra(letra),b,j,h,maior=0,limite=0;
+    *posicoes=0;
+    if(c<0||e->restantes==0)    return 0;
+    for(b=0;b<g->blocos;b++){
+        x=e->candidatos[b];
+        if(x==0)    continue;
+        bloco=&g->naPosicao[((size_t)c*g->blocos+b)*e->tamanho];
+        // um: a letra aparece; dois: aparece mais de uma vez.
+        for(j=0,um=0,dois=0;j<e->tamanho;j++){
+            dois|=um&bloco[j];
+            um|=bloco[j];
+        }
+        maior+=__builtin_popcountll(x&~um);
+        for(j=0;j<e->tamanho;j++){
+            unicas[j]+=__builtin_popcountll(x&bloco[j]&~dois);
+            repetidas[j]+=__builtin_popcountll(x&bloco[j]&dois);
+        }
+    }
+    // A classe dos que nao tem a letra comeca como a melhor.
+    for(j=0;j<e->tamanho;j++){
+        if(superaClasse(unicas[j],1ULL<<j,maior,melhor)){
+            maior=unicas[j];
+            melhor=1ULL<<j;
+        }
+        if(repetidas[j]>limite) limite=repetidas[j];
+    }
+    // Uma classe com a letra repetida revela mais posicoes: so vence se for maior.
+    if(limite>maior){
+        if(agruparRepetidas(e,c)<0) return -1;
+        for(h=0;h<1<<e->bitsClasses;h++){
+            classe=&e->classes[h];
+            if(classe->quantidade!=0&&superaClasse(classe->quantidade,classe->posicoes,maior,melhor)){
+                maior=classe->quantidade;
+                melhor=classe->posicoes;
+            }
+        }
+    }
+    // Mantem so os candidatos com a letra exatamente nas posicoes escolhidas.
+    for(b=0;b<g->blocos;b++){
+        if(e->candidatos[b]==0) continue;
+        bloco=&g->naPosicao[((size_t)c*g->blocos+b)*e->tamanho];
+        mantidos=e->candidatos[b];
+        for(j=0;j<e->tamanho;j++)
+            mantidos&=melhor&(1ULL<<j)?bloco[j]:~bloco[j];
+        e->candidatos[b]=mantidos;
+    }
+    e->restantes=maior;
+    *posicoes=melhor;
+    return 0;
+}
+
+/**
+ * @brief Localiza uma palavra entre os candidatos.
+ * @param e O estado da partida.
+ * @param palavra A palavra procurada.
+ * @return A posicao da palavra no grupo, ou -1 se ela nao for candidata.
+ */
+static int localizarCandidato (const EstadoMaligno *e, const char *palavra){
+    const GrupoMaligno *g = e->grupo;
+    const char *outra;
+    uint64_t resto;
+    int b,k,n;
+    for(b=0;b<g->blocos;b++)
+        for(resto=e->candidatos[b];resto!=0;resto&=resto-1){
+            k=b*64+__builtin_ctzll(resto);
+            outra=obterPalavra(e->maligno->dicionario,g->indices[k],&n);
+            if(strlen(palavra)==(size_t)n&&strncasecmp(outra,palavra,n)==0)    return k;
+        }
+    return -1;
+}
+
+/**
+ * @brief Remove um candidato, se ainda restarem outros.
+ * @param e O estado da partida.
+ * @param palavra A palavra chutada.
+ * @return 1 se a palavra foi descartada, 0 caso contrario.
+ */
+int descartarMaligno (EstadoMaligno *e, const char *palavra){
+    int k;
+    if(e->restantes<=1) return 0;
+    k=localizarCandidato(e,palavra);
+    if(k<0) return 0;
+    e->candidatos[k/64]&=~(1ULL<<(k%64));
+    e->restantes--;
+    return 1;
+}
+
+/**
+ * @brief Copia um dos candidatos restantes (o primeiro do grupo).
+ * @param e O estado da partida.
+ * @param palavra Recebe a palavra (pelo menos TAM_MAX_MASCARA+1 bytes).
+ * @return 0 em caso de sucesso, -1 se nao houver candidatos.
+ */
+int copiarCandidatoMaligno (const EstadoMaligno *e, char *palavra){
+    const char *origem;
+    int b,n;
+    if(e->restantes==0) return -1;
+    for(b=0;e->candidatos[b]==0;b++);
+    origem=obterPalavra(e->maligno->dicionario,e->grupo->indices[b*64+__builtin_ctzll(e->candidatos[b])],&n);
+    memcpy(palavra,origem,n);
+    palavra[n]='\0';
+    return 0;
+}
+
+/**
+ * @brief Libera o estado de uma partida do modo maligno.
+ * @param e O estado da partida.
+ */
+void encerrarMaligno (EstadoMaligno *e){
+    free(e->candidatos);
+    free(e->classes);
+    e->candidatos=NULL;
+    e->classes=NULL;
+    e->restantes=0;
+}
+
+/**
+ * @brief Aplica um palpite de letra a uma sessao no modo maligno.
+ *
+ * Letras invalidas ou repetidas nao mudam os candidatos. Sem memoria
+ * para a tabela de classes, a partida segue com a palavra atual.
+ *
+ * @param e O estado maligno da partida.
+ * @param s A sessao.
+ * @param letra A letra chutada.
+ * @return O efeito do palpite.
+ */
+ResultadoJogada chutarLetraMaligna (EstadoMaligno *e, Sessao *s, char letra){
+    char palavra[TAM_MAX_PALAVRA];
+    uint64_t posicoes;
+    int c=indiceLetra(letra);
+    if(consultarSessao(s)==SESSAO_EM_JOGO&&c>=0&&!(s->letras&(1u<<c))&&e->restantes>0){
+        if(particionarMaligno(e,letra,&posicoes)<0) e->restantes=0;
+        // A palavra atual so e trocada se ficou fora da classe escolhida.
+        else if(s->mascara.posicoes[c]!=posicoes&&copiarCandidatoMaligno(e,palavra)==0)
+            trocarPalavraSessao(s,palavra);
+    }
+    return chutarLetra(s,letra);
+}
+
+/**
+ * @brief Aplica um palpite da palavra inteira a uma sessao no modo maligno.
+ *
+ * Se a palavra chutada e um candidato e ainda ha outros, ela e descartada
+ * e, se era a palavra da sessao, trocada por outro candidato: o palpite
+ * so acerta quando nao resta alternativa.
+ *
+ * @param e O estado maligno da partida.
+ * @param s A sessao.
+ * @param palavra A palavra chutada.
+ * @return O efeito do palpite.
+ */
+ResultadoJogada chutarPalavraMaligna (EstadoMaligno *e, Sessao *s, const char *palavra){
+    char outra[TAM_MAX_PALAVRA];
+    if(consultarSessao(s)==SESSAO_EM_JOGO&&palavra!=NULL&&descartarMaligno(e,palavra)
+       &&strcasecmp(s->palavra,palavra)==0&&copiarCandidatoMaligno(e,outra)==0)
+        trocarPalavraSessao(s,outra);
+    return chutarPalavra(s,palavra);
+}
\ No newline at end of file
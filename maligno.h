@@ -0,0 +1,170 @@
+/**
+ * @file maligno.h
+ * @brief Arquivo de cabecalho do modo maligno (palavra secreta adaptativa).
+ *
+ * No modo maligno a palavra secreta nao e sorteada de uma vez: o jogo
+ * mantem o conjunto de palavras do dicionario ainda compativeis com o que
+ * foi revelado e, a cada letra, separa esses candidatos pelo padrao que
+ * a letra revelaria, ficando com a maior classe. A Sessao continua
+ * aplicando as regras; a sua palavra apenas e trocada por um candidato
+ * da classe escolhida antes de cada palpite.
+ *
+ * Para cada comprimento de palavra, as tabelas guardam a mascara das
+ * posicoes de cada letra em cada palavra, fatiada por posicao em
+ * conjuntos de bits de 64 palavras. Assim as classes mais comuns (sem a
+ * letra, ou com a letra uma unica vez) sao contadas com popcount, bloco
+ * a bloco, e so as palavras com a letra repetida passam, uma a uma, por
+ * uma tabela de espalhamento, e apenas quando alguma delas ainda pode
+ * formar a maior classe. Nenhuma string e lida nem alocada.
+ */
+
+#ifndef MALIGNO_H
+#define MALIGNO_H
+
+#include <stdint.h>
+#include "forca.h"
+#include "dicionario.h"
+#include "sessao.h"
+
+// Capacidade inicial da tabela de classes (potencia de 2).
+#define CLASSES_INICIAIS 64
+
+/**
+ * @struct GrupoMaligno
+ * @brief Palavras do dicionario de um mesmo comprimento e as posicoes de cada letra.
+ */
+typedef struct{
+    int quantidade;         // Numero de palavras do grupo.
+    int blocos;             // Numero de uint64_t de cada conjunto de bits.
+    int *indices;           // Indice de cada palavra no dicionario.
+    uint64_t *contem;       // [letra][bloco]: palavras que contem a letra.
+    uint64_t *soLetras;     // [bloco]: palavras sem hifen, espaco ou outros simbolos.
+    uint64_t *naPosicao;    // [letra][bloco][posicao]: palavras com a letra na posicao.
+} GrupoMaligno;
+
+/**
+ * @struct Maligno
+ * @brief Tabelas do modo maligno, montadas uma vez e somente lidas depois.
+ *
+ * Pode ser compartilhado entre threads; o estado de cada partida fica
+ * em um EstadoMaligno.
+ */
+typedef struct{
+    const Dicionario *dicionario;
+    GrupoMaligno grupos[TAM_MAX_MASCARA+1];
+} Maligno;
+
+/**
+ * @struct ClasseMaligna
+ * @brief Candidatos que uma letra revelaria nas mesmas posicoes.
+ */
+typedef struct{
+    uint64_t posicoes;      // Posicoes reveladas pela letra.
+    int quantidade;         // Candidatos da classe (0 = posicao livre da tabela).
+} ClasseMaligna;
+
+/**
+ * @struct EstadoMaligno
+ * @brief Candidatos restantes em uma partida do modo maligno.
+ */
+typedef struct{
+    const Maligno *maligno;
+    const GrupoMaligno *grupo;  // Grupo do comprimento da palavra secreta.
+    int tamanho;                // Comprimento da palavra secreta.
+    uint64_t *candidatos;       // Conjunto de bits dos candidatos restantes.
+    int restantes;              // Numero de candidatos restantes.
+    ClasseMaligna *classes;     // Tabela de espalhamento das classes do ultimo palpite.
+    int bitsClasses;            // A tabela tem 2^bitsClasses posicoes.
+    int numClasses;             // Classes ocupadas na tabela.
+} EstadoMaligno;
+
+/**
+ * @brief Monta as tabelas do modo maligno a partir de um dicionario.
+ * @param m As tabelas.
+ * @param d O dicionario (deve permanecer aberto enquanto as tabelas forem usadas).
+ * @return 0 em caso de sucesso, -1 em caso de falta de memoria.
+ */
+int criarMaligno (Maligno *m, const Dicionario *d);
+
+/**
+ * @brief Libera as tabelas do modo maligno.
+ * @param m As tabelas.
+ */
+void destruirMaligno (Maligno *m);
+
+/**
+ * @brief Inicia os candidatos de uma partida a partir da palavra sorteada.
+ *
+ * Os candidatos sao as palavras do dicionario com o mesmo comprimento e
+ * os mesmos simbolos (hifens, por exemplo) nas mesmas posicoes, que a
+ * forca ja mostra desde o inicio.
+ *
+ * @param m As tabelas.
+ * @param e O estado a ser preenchido.
+ * @param palavra A palavra sorteada para a partida.
+ * @return 0 em caso de sucesso, -1 em caso de falta de memoria.
+ */
+int iniciarMaligno (const Maligno *m, EstadoMaligno *e, const char *palavra);
+
+/**
+ * @brief Separa os candidatos pelo padrao de uma letra e fica com a maior classe.
+ *
+ * Em caso de empate, prefere a classe que revela menos posicoes (a dos
+ * candidatos sem a letra, se houver) e depois a de menor mascara.
+ *
+ * @param e O estado da partida.
+ * @param letra A letra chutada (A-Z ou a-z).
+ * @param posicoes Recebe as posicoes que a letra revela (0 se a letra nao aparece).
+ * @return 0 em caso de sucesso, -1 em caso de falta de memoria.
+ */
+int particionarMaligno (EstadoMaligno *e, char letra, uint64_t *posicoes);
+
+/**
+ * @brief Remove um candidato, se ainda restarem outros.
+ *
+ * Usado quando o jogador chuta a palavra inteira: enquanto houver outra
+ * palavra compativel, o palpite passa a estar errado.
+ *
+ * @param e O estado da partida.
+ * @param palavra A palavra chutada.
+ * @return 1 se a palavra foi descartada, 0 caso contrario.
+ */
+int descartarMaligno (EstadoMaligno *e, const char *palavra);
+
+/**
+ * @brief Copia um dos candidatos restantes.
+ * @param e O estado da partida.
+ * @param palavra Recebe a palavra (pelo menos TAM_MAX_MASCARA+1 bytes).
+ * @return 0 em caso de sucesso, -1 se nao houver candidatos.
+ */
+int copiarCandidatoMaligno (const EstadoMaligno *e, char *palavra);
+
+/**
+ * @brief Libera o estado de uma partida do modo maligno.
+ * @param e O estado da partida.
+ */
+void encerrarMaligno (EstadoMaligno *e);
+
+/**
+ * @brief Aplica um palpite de letra a uma sessao no modo maligno.
+ *
+ * Escolhe a classe, troca a palavra da sessao por um candidato dela
+ * (se a atual ficou de fora) e aplica o palpite com chutarLetra.
+ *
+ * @param e O estado maligno da partida.
+ * @param s A sessao.
+ * @param letra A letra chutada.
+ * @return O efeito do palpite.
+ */
+ResultadoJogada chutarLetraMaligna (EstadoMaligno *e, Sessao *s, char letra);
+
+/**
+ * @brief Aplica um palpite da palavra inteira a uma sessao no modo maligno.
+ * @param e O estado maligno da partida.
+ * @param s A sessao.
+ * @param palavra A palavra chutada.
+ * @return O efeito do palpite.
+ */
+ResultadoJogada chutarPalavraMaligna (EstadoMaligno *e, Sessao *s, const char *palavra);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,285 @@
+/**
+ * @file metricas.c
+ * @brief Implementacao da instrumentacao das fases do jogo.
+ *
+ * Cada thread aloca, no primeiro uso, um bloco com os seus histogramas e
+ * contadores e o encadeia numa lista global; a partir dai so ela escreve
+ * no bloco. O relatorio percorre a lista e soma os blocos. Os blocos nunca
+ * sao liberados, para que as medicoes de uma thread encerrada continuem
+ * no total.
+ */
+
+#ifdef FORCA_METRICAS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "metricas.h"
+
+// Nomes das fases e dos contadores no relatorio.
+static const char *nomesFases[NUM_FASES]={"sorteio","palpite","desenho","registro"};
+static const char *nomesContadores[NUM_CONTADORES]={"partidas","vitorias","derrotas","letra_errada","letra_repetida","palavra_errada"};
+// Limites dos histogramas exportados, em segundos (serie 1-2-5 de 100 ns a 10 s).
+static const double limitesSegundos[]={1e-7,2e-7,5e-7,1e-6,2e-6,5e-6,1e-5,2e-5,5e-5,1e-4,2e-4,5e-4,
+                                       1e-3,2e-3,5e-3,1e-2,2e-2,5e-2,1e-1,2e-1,5e-1,1,2,5,10};
+#define NUM_LIMITES (int)(sizeof(limitesSegundos)/sizeof(limitesSegundos[0]))
+
+/**
+ * @struct MetricasThread
+ * @brief Histogramas e contadores de uma thread.
+ *
+ * Os campos sao atomicos apenas para que o relatorio possa le-los
+ * enquanto a thread escreve; a escrita e uma leitura e um armazenamento
+ * relaxados, sem travar o barramento, pois ha um unico escritor.
+ */
+typedef struct MetricasThread{
+    _Atomic unsigned long long faixas[NUM_FASES][FAIXAS_METRICAS];
+    _Atomic unsigned long long somas[NUM_FASES];    // Soma das duracoes, em ns.
+    _Atomic unsigned long long contadores[NUM_CONTADORES];
+    struct MetricasThread *proxima;
+} MetricasThread;
+
+// Bloco da thread atual (NULL ate a primeira medicao).
+static __thread MetricasThread *locais=NULL;
+// Lista de blocos de todas as threads.
+static MetricasThread *todas=NULL;
+static pthread_mutex_t travaLista=PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Retorna o bloco da thread atual, criando-o no primeiro uso.
+ * @return O bloco, ou NULL se nao houver memoria.
+ */
+static MetricasThread *obterLocais (void){
+    MetricasThread *m = locais;
+    if(__builtin_expect(m!=NULL,1)) return m;
+    m=calloc(1,sizeof(MetricasThread));
+    if(m==NULL) return NULL;
+    pthread_mutex_lock(&travaLista);
+    m->proxima=todas;
+    todas=m;
+    pthread_mutex_unlock(&travaLista);
+    locais=m;
+    return m;
+}
+
+/**
+ * @brief Soma n a um contador escrito apenas pela thread atual.
+ * @param x O contador.
+ * @param n O valor a somar.
+ */
+static inline void somarLocal (_Atomic unsigned long long *x, unsigned long long n){
+    atomic_store_explicit(x,atomic_load_explicit(x,memory_order_relaxed)+n,memory_order_relaxed);
+}
+
+/**
+ * @brief Calcula a faixa do histograma de uma duracao.
+ *
+ * Ate SUB_METRICAS ns cada valor tem a sua faixa; acima disso, a faixa e
+ * dada pela posicao do bit mais alto e pelos BITS_SUB_METRICAS bits seguintes.
+ *
+ * @param ns A duracao, em ns.
+ * @return O indice da faixa.
+ */
+static inline int faixaDe (long long ns){
+    uint64_t v=ns>0?(uint64_t)ns:0;
+    int e;
+    if(v<SUB_METRICAS)  return (int)v;
+    e=63-__builtin_clzll(v);
+    return SUB_METRICAS+(e-BITS_SUB_METRICAS)*SUB_METRICAS+(int)((v>>(e-BITS_SUB_METRICAS))&(SUB_METRICAS-1));
+}
+
+/**
+ * @brief Calcula o menor valor de uma faixa do histograma.
+ * @param i O indice da faixa.
+ * @return O limite inferior, em ns.
+ */
+static uint64_t inicioFaixa (int i){
+    int e;
+    if(i<SUB_METRICAS)  return (uint64_t)i;
+    e=(i-SUB_METRICAS)/SUB_METRICAS+BITS_SUB_METRICAS;
+    return (uint64_t)(SUB_METRICAS+(i-SUB_METRICAS)%SUB_METRICAS)<<(e-BITS_SUB_METRICAS);
+}
+
+/**
+ * @brief Calcula o maior valor de uma faixa do histograma.
+ * @param i O indice da faixa.
+ * @return O limite superior, em ns.
+ */
+static uint64_t fimFaixa (int i){
+    return i+1<FAIXAS_METRICAS?inicioFaixa(i+1)-1:UINT64_MAX;
+}
+
+/**
+ * @brief Soma uma medicao ao histograma da fase, na thread atual.
+ * @param fase A fase medida.
+ * @param ns A duracao, em ns.
+ */
+void registrarTempo (FaseMetrica fase, long long ns){
+    MetricasThread *m = obterLocais();
+    if(m==NULL) return;
+    somarLocal(&m->faixas[fase][faixaDe(ns)],1);
+    somarLocal(&m->somas[fase],ns>0?(unsigned long long)ns:0);
+}
+
+/**
+ * @brief Soma n ocorrencias a um contador, na thread atual.
+ * @param contador O contador.
+ * @param n O numero de ocorrencias.
+ */
+void somarContador (ContadorMetrica contador, unsigned long long n){
+    MetricasThread *m = obterLocais();
+    if(m!=NULL) somarLocal(&m->contadores[contador],n);
+}
+
+/**
+ * @brief Soma os histogramas de uma fase de todas as threads.
+ * @param fase A fase.
+ * @param faixas Recebe as contagens de cada faixa.
+ * @param soma Recebe a soma das duracoes, em ns.
+ * @return O numero total de medicoes.
+ */
+static unsigned long long somarFaixas (FaseMetrica fase, unsigned long long *faixas, unsigned long long *soma){
+    unsigned long long total=0;
+    MetricasThread *m;
+    int i;
+    memset(faixas,0,FAIXAS_METRICAS*sizeof(unsigned long long));
+    *soma=0;
+    pthread_mutex_lock(&travaLista);
+    for(m=todas;m!=NULL;m=m->proxima){
+        for(i=0;i<FAIXAS_METRICAS;i++)
+            faixas[i]+=atomic_load_explicit(&m->faixas[fase][i],memory_order_relaxed);
+        *soma+=atomic_load_explicit(&m->somas[fase],memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&travaLista);
+    for(i=0;i<FAIXAS_METRICAS;i++)  total+=faixas[i];
+    return total;
+}
+
+/**
+ * @brief Encontra o valor abaixo do qual esta uma fracao das medicoes.
+ * @param faixas As contagens de cada faixa.
+ * @param total O numero total de medicoes.
+ * @param q A fracao (0.5 para a mediana).
+ * @return O limite superior da faixa do percentil, em ns.
+ */
+static long long percentil (const unsigned long long *faixas, unsigned long long total, double q){
+    unsigned long long alvo=(unsigned long long)(q*total+0.999999),acumulado=0;
+    int i;
+    if(alvo==0) alvo=1;
+    for(i=0;i<FAIXAS_METRICAS;i++){
+        acumulado+=faixas[i];
+        if(acumulado>=alvo) return (long long)fimFaixa(i);
+    }
+    return 0;
+}
+
+/**
+ * @brief Calcula os percentis de uma fase somando todas as threads.
+ * @param fase A fase.
+ * @param r Recebe o resumo.
+ */
+void resumirFase (FaseMetrica fase, ResumoFase *r){
+    unsigned long long faixas[FAIXAS_METRICAS],soma;
+    int i;
+    memset(r,0,sizeof(*r));
+    r->quantidade=somarFaixas(fase,faixas,&soma);
+    if(r->quantidade==0)    return;
+    r->media=(double)soma/r->quantidade;
+    r->p50=percentil(faixas,r->quantidade,0.5);
+    r->p99=percentil(faixas,r->quantidade,0.99);
+    r->p999=percentil(faixas,r->quantidade,0.999);
+    for(i=FAIXAS_METRICAS-1;i>0&&faixas[i]==0;i--);
+    r->maximo=(long long)fimFaixa(i);
+}
+
+/**
+ * @brief Soma o valor de um contador em todas as threads.
+ * @param contador O contador.
+ * @return O total.
+ */
+unsigned long long totalContador (ContadorMetrica contador){
+    unsigned long long total=0;
+    MetricasThread *m;
+    pthread_mutex_lock(&travaLista);
+    for(m=todas;m!=NULL;m=m->proxima)
+        total+=atomic_load_explicit(&m->contadores[contador],memory_order_relaxed);
+    pthread_mutex_unlock(&travaLista);
+    return total;
+}
+
+/**
+ * @brief Grava todas as metricas no formato texto do Prometheus.
+ *
+ * Cada fase vira um histograma com limites de 100 ns a 10 s na serie
+ * 1-2-5. Uma faixa interna so e contada num limite se estiver inteira
+ * abaixo dele. Os percentis calculados sobre as faixas internas, mais
+ * precisos, sao exportados a parte.
+ *
+ * @param nomeArquivo O arquivo de destino.
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+int gravarMetricas (const char *nomeArquivo){
+    unsigned long long faixas[FAIXAS_METRICAS],soma,total,acumulado;
+    char temporario[4096];
+    ResumoFase r;
+    int f,i,k;
+    FILE *arq;
+    snprintf(temporario,sizeof(temporario),"%s.tmp",nomeArquivo);
+    arq=fopen(temporario,"w");
+    if(arq==NULL){
+        printf("Erro ao abrir o arquivo: %s\n",temporario);
+        return -1;
+    }
+    fprintf(arq,"# HELP forca_fase_segundos Latencia das fases do jogo.\n# TYPE forca_fase_segundos histogram\n");
+    for(f=0;f<NUM_FASES;f++){
+        total=somarFaixas(f,faixas,&soma);
+        acumulado=0;
+        i=0;
+        for(k=0;k<NUM_LIMITES;k++){
+            for(;i<FAIXAS_METRICAS&&fimFaixa(i)<=(uint64_t)(limitesSegundos[k]*1e9+0.5);i++)  acumulado+=faixas[i];
+            fprintf(arq,"forca_fase_segundos_bucket{fase=\"%s\",le=\"%g\"} %llu\n",nomesFases[f],limitesSegundos[k],acumulado);
+        }
+        fprintf(arq,"forca_fase_segundos_bucket{fase=\"%s\",le=\"+Inf\"} %llu\n",nomesFases[f],total);
+        fprintf(arq,"forca_fase_segundos_sum{fase=\"%s\"} %.9f\n",nomesFases[f],soma/1e9);
+        fprintf(arq,"forca_fase_segundos_count{fase=\"%s\"} %llu\n",nomesFases[f],total);
+    }
+    fprintf(arq,"# HELP forca_fase_percentil_segundos Percentis das fases (limite superior da faixa).\n# TYPE forca_fase_percentil_segundos gauge\n");
+    for(f=0;f<NUM_FASES;f++){
+        resumirFase(f,&r);
+        fprintf(arq,"forca_fase_percentil_segundos{fase=\"%s\",percentil=\"0.5\"} %.9f\n",nomesFases[f],r.p50/1e9);
+        fprintf(arq,"forca_fase_percentil_segundos{fase=\"%s\",percentil=\"0.99\"} %.9f\n",nomesFases[f],r.p99/1e9);
+        fprintf(arq,"forca_fase_percentil_segundos{fase=\"%s\",percentil=\"0.999\"} %.9f\n",nomesFases[f],r.p999/1e9);
+    }
+    for(i=CONTADOR_PARTIDAS;i<=CONTADOR_DERROTAS;i++)
+        fprintf(arq,"# TYPE forca_%s_total counter\nforca_%s_total %llu\n",nomesContadores[i],nomesContadores[i],totalContador(i));
+    fprintf(arq,"# HELP forca_penalidades_total Palpites que custaram vidas, por tipo.\n# TYPE forca_penalidades_total counter\n");
+    for(i=CONTADOR_LETRA_ERRADA;i<NUM_CONTADORES;i++)
+        fprintf(arq,"forca_penalidades_total{tipo=\"%s\"} %llu\n",nomesContadores[i],totalContador(i));
+    if(fclose(arq)!=0||rename(temporario,nomeArquivo)!=0){
+        printf("Erro ao gravar o arquivo: %s\n",nomeArquivo);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Imprime um resumo legivel das fases e dos contadores.
+ * @param saida O arquivo de saida (por exemplo, stdout).
+ */
+void imprimirMetricas (FILE *saida){
+    ResumoFase r;
+    int i;
+    for(i=0;i<NUM_FASES;i++){
+        resumirFase(i,&r);
+        if(r.quantidade==0) continue;
+        fprintf(saida,"%-9s %10llu medicoes  media %9.0f ns  p50 %9lld  p99 %9lld  p99.9 %9lld  max %9lld ns\n",
+                nomesFases[i],r.quantidade,r.media,r.p50,r.p99,r.p999,r.maximo);
+    }
+    for(i=0;i<NUM_CONTADORES;i++)
+        fprintf(saida,"%s%s %llu",i==0?"":", ",nomesContadores[i],totalContador(i));
+    fprintf(saida,"\n");
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,135 @@
+/**
+ * @file metricas.h
+ * @brief Arquivo de cabecalho da instrumentacao das fases do jogo.
+ *
+ * Mede a latencia das fases quentes (sorteio da palavra, palpite,
+ * desenho e registro do resultado) em histogramas logaritmicos, no
+ * estilo HDR: cada potencia de 2 e dividida em SUB_METRICAS faixas, de
+ * modo que o erro relativo de qualquer percentil fica abaixo de 1/16.
+ * Conta tambem partidas, vitorias, derrotas e penalidades.
+ *
+ * Cada thread escreve apenas nos seus proprios contadores, sem travas
+ * nem operacoes atomicas de leitura-modificacao-escrita; o relatorio soma
+ * os contadores de todas as threads. Os tempos sao lidos com relogioNs().
+ *
+ * Tudo so e compilado com -DFORCA_METRICAS. Sem essa opcao, as macros
+ * abaixo se expandem para nada e nenhuma funcao deste arquivo existe.
+ */
+
+#ifndef METRICAS_H
+#define METRICAS_H
+
+#include <stdio.h>
+#include "forca.h"
+
+/**
+ * @enum FaseMetrica
+ * @brief Fases do jogo com latencia medida.
+ */
+typedef enum{
+    FASE_SORTEIO,       // Sorteio e copia da palavra secreta.
+    FASE_PALPITE,       // Aplicacao de um palpite (verificarLetra/testarLetra).
+    FASE_DESENHO,       // Desenho da forca, ou resposta do servidor.
+    FASE_REGISTRO,      // Registro do resultado da partida.
+    NUM_FASES
+} FaseMetrica;
+
+/**
+ * @enum ContadorMetrica
+ * @brief Eventos contados.
+ */
+typedef enum{
+    CONTADOR_PARTIDAS,
+    CONTADOR_VITORIAS,
+    CONTADOR_DERROTAS,
+    CONTADOR_LETRA_ERRADA,      // Penalidade de uma vida.
+    CONTADOR_LETRA_REPETIDA,    // Penalidade de PENALIDADE_REPETIDA vidas.
+    CONTADOR_PALAVRA_ERRADA,    // Penalidade de PENALIDADE_PALAVRA vidas.
+    NUM_CONTADORES
+} ContadorMetrica;
+
+// Bits de mantissa de cada faixa do histograma (16 faixas por potencia de 2).
+#define BITS_SUB_METRICAS 4
+#define SUB_METRICAS (1<<BITS_SUB_METRICAS)
+// Faixas do histograma: valores exatos ate SUB_METRICAS e depois 60 potencias de 2.
+#define FAIXAS_METRICAS (SUB_METRICAS+(64-BITS_SUB_METRICAS)*SUB_METRICAS)
+// Intervalo padrao, em segundos, entre gravacoes do relatorio no servidor.
+#define INTERVALO_METRICAS 10
+
+#ifdef FORCA_METRICAS
+
+/**
+ * @struct ResumoFase
+ * @brief Percentis de uma fase, somadas todas as threads.
+ */
+typedef struct{
+    unsigned long long quantidade;  // Medicoes realizadas.
+    double media;                   // Media, em ns.
+    long long p50,p99,p999,maximo;  // Percentis e maximo, em ns (limite superior da faixa).
+} ResumoFase;
+
+/**
+ * @brief Soma uma medicao ao histograma da fase, na thread atual.
+ * @param fase A fase medida.
+ * @param ns A duracao, em ns.
+ */
+void registrarTempo (FaseMetrica fase, long long ns);
+
+/**
+ * @brief Soma n ocorrencias a um contador, na thread atual.
+ * @param contador O contador.
+ * @param n O numero de ocorrencias.
+ */
+void somarContador (ContadorMetrica contador, unsigned long long n);
+
+/**
+ * @brief Calcula os percentis de uma fase somando todas as threads.
+ * @param fase A fase.
+ * @param r Recebe o resumo.
+ */
+void resumirFase (FaseMetrica fase, ResumoFase *r);
+
+/**
+ * @brief Soma o valor de um contador em todas as threads.
+ * @param contador O contador.
+ * @return O total.
+ */
+unsigned long long totalContador (ContadorMetrica contador);
+
+/**
+ * @brief Grava todas as metricas no formato texto do Prometheus.
+ *
+ * O arquivo e escrito em "<nomeArquivo>.tmp" e renomeado sobre o
+ * anterior, de modo que um coletor nunca le um relatorio pela metade.
+ *
+ * @param nomeArquivo O arquivo de destino.
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+int gravarMetricas (const char *nomeArquivo);
+
+/**
+ * @brief Imprime um resumo legivel das fases e dos contadores.
+ * @param saida O arquivo de saida (por exemplo, stdout).
+ */
+void imprimirMetricas (FILE *saida);
+
+// Declara a variavel que guarda o inicio de uma medicao.
+#define MEDICAO(t) long long t
+// Marca o inicio de uma medicao.
+#define INICIAR_MEDICAO(t) ((t)=relogioNs())
+// Encerra a medicao iniciada em t, somando-a a fase.
+#define ENCERRAR_MEDICAO(fase,t) registrarTempo((fase),relogioNs()-(t))
+// Soma uma ocorrencia a um contador.
+#define CONTAR(contador) somarContador((contador),1)
+
+#else
+
+// A variavel nunca e lida, e o compilador a descarta.
+#define MEDICAO(t) long long t __attribute__((unused))
+#define INICIAR_MEDICAO(t) ((void)0)
+#define ENCERRAR_MEDICAO(fase,t) ((void)0)
+#define CONTAR(contador) ((void)0)
+
+#endif
+
+#endif
\ No newline at end of file
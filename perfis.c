@@ -0,0 +1,502 @@
+/**
+ * @file perfis.c
+ * @brief Implementacao do cadastro de perfis de jogadores.
+ *
+ * Formato do arquivo: um cabecalho de TAM_CABECALHO_PERFIS bytes
+ * (identificacao, capacidade, quantidade e ranking) seguido da tabela,
+ * com "capacidade" registros Perfil. Quando a ocupacao passa de 70%, a
+ * tabela e reconstruida com o dobro da capacidade em um arquivo novo,
+ * que substitui o antigo com rename().
+ *
+ * O escritor segura flock(LOCK_EX) no arquivo enquanto o cadastro esta
+ * aberto. Como o rename troca o arquivo, quem obtem a trava confere se o
+ * arquivo travado ainda e o que esta no lugar do nome, e tenta de novo
+ * se nao for.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "perfis.h"
+
+// Cadastro atualizado por registrarResultado, quando definido.
+static Perfis *perfisPadrao=NULL;
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Tamanho do cabecalho do arquivo (uma pagina).
+#define TAM_CABECALHO_PERFIS 4096
+// Identificacao e versao do formato.
+#define MAGICO_PERFIS "FORCAPF"
+#define VERSAO_PERFIS 1
+
+_Static_assert(sizeof(Perfil)==128,"Perfil deve ocupar 128 bytes");
+
+/**
+ * @struct CabecalhoPerfis
+ * @brief Inicio do arquivo do cadastro.
+ */
+typedef struct{
+    char magico[8];
+    uint32_t versao;
+    uint32_t tamRegistro;           // sizeof(Perfil), para detectar arquivos incompativeis.
+    uint64_t capacidade;            // Numero de posicoes da tabela (potencia de 2).
+    uint64_t quantidade;            // Posicoes ocupadas.
+    int32_t tamRanking;             // Posicoes preenchidas do ranking.
+    uint32_t ranking[TAM_RANKING];  // Indice na tabela de cada colocado.
+} CabecalhoPerfis;
+
+_Static_assert(sizeof(CabecalhoPerfis)<=TAM_CABECALHO_PERFIS,"cabecalho grande demais");
+
+struct Perfis{
+    int fd;
+    char *mapa;                 // Arquivo inteiro mapeado.
+    size_t tamMapa;
+    CabecalhoPerfis *cabecalho;
+    Perfil *tabela;
+    int somenteLeitura;         // 1 se aberto com abrirPerfisLeitura (ou sem a trava).
+    char nomeArquivo[TAM_MAX_PALAVRA+8];
+};
+
+/**
+ * @brief Calcula o hash FNV-1a de um nome.
+ * @param nome O nome.
+ * @return O hash, nunca zero.
+ */
+static uint32_t hashNome (const char *nome){
+    uint32_t h=2166136261u;
+    for(;*nome!='\0';nome++){
+        h^=(unsigned char)*nome;
+        h*=16777619u;
+    }
+    return h!=0?h:1;
+}
+
+/**
+ * @brief Procura a posicao de um nome na tabela.
+ * @param p O cadastro.
+ * @param nome O nome.
+ * @param hash O hash do nome.
+ * @return A posicao do perfil, ou a posicao livre onde ele deve ser criado.
+ */
+static size_t localizarPerfil (const Perfis *p, const char *nome, uint32_t hash){
+    size_t mascara=p->cabecalho->capacidade-1,i=hash&mascara;
+    const Perfil *t = p->tabela;
+    // Comparacao limitada: o arquivo pode ser alterado por outro processo.
+    while(t[i].hash!=0&&(t[i].hash!=hash||strncmp(t[i].nome,nome,TAM_MAX_PALAVRA)!=0))
+        i=(i+1)&mascara;
+    return i;
+}
+
+/**
+ * @brief Cria, trava e mapeia um arquivo de cadastro vazio.
+ * @param p O cadastro a ser preenchido.
+ * @param nomeArquivo O arquivo.
+ * @param capacidade A capacidade (potencia de 2).
+ * @param exclusivo 1 para falhar (com errno EEXIST) se o arquivo ja existir, 0 para trunca-lo.
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+static int criarArquivo (Perfis *p, const char *nomeArquivo, size_t capacidade, int exclusivo){
+    p->tamMapa=TAM_CABECALHO_PERFIS+capacidade*sizeof(Perfil);
+    p->fd=open(nomeArquivo,O_RDWR|O_CREAT|(exclusivo?O_EXCL:O_TRUNC),0644);
+    if(p->fd<0) return -1;
+    // O arquivo fica esparso: as paginas so ocupam disco quando escritas.
+    if(flock(p->fd,LOCK_EX|LOCK_NB)<0||ftruncate(p->fd,(off_t)p->tamMapa)<0){
+        close(p->fd);
+        return -1;
+    }
+    p->mapa=mmap(NULL,p->tamMapa,PROT_READ|PROT_WRITE,MAP_SHARED,p->fd,0);
+    if(p->mapa==MAP_FAILED){
+        close(p->fd);
+        return -1;
+    }
+    p->cabecalho=(CabecalhoPerfis *)p->mapa;
+    p->tabela=(Perfil *)(p->mapa+TAM_CABECALHO_PERFIS);
+    memcpy(p->cabecalho->magico,MAGICO_PERFIS,sizeof(MAGICO_PERFIS));
+    p->cabecalho->versao=VERSAO_PERFIS;
+    p->cabecalho->tamRegistro=sizeof(Perfil);
+    p->cabecalho->capacidade=capacidade;
+    return 0;
+}
+
+/**
+ * @brief Libera o mapeamento e o descritor do arquivo.
+ * @param p O cadastro.
+ */
+static void desmapear (Perfis *p){
+    munmap(p->mapa,p->tamMapa);
+    close(p->fd);
+}
+
+/**
+ * @brief Reconstroi a tabela com uma nova capacidade.
+ *
+ * Os perfis sao reinseridos em um arquivo temporario, que substitui o
+ * original so depois de completo; uma falha no meio deixa o original
+ * intacto. O ranking e refeito a partir dos nomes, pois as posicoes mudam.
+ *
+ * @param p O cadastro.
+ * @param capacidade A nova capacidade (potencia de 2).
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+static int crescer (Perfis *p, size_t capacidade){
+    Perfis novo;
+    char temporario[sizeof(p->nomeArquivo)+8];
+    size_t i,j;
+    int k;
+    snprintf(temporario,sizeof(temporario),"%s.novo",p->nomeArquivo);
+    memset(&novo,0,sizeof(novo));
+    strcpy(novo.nomeArquivo,p->nomeArquivo);
+    if(criarArquivo(&novo,temporario,capacidade,0)<0) return -1;
+    for(i=0;i<p->cabecalho->capacidade;i++){
+        if(p->tabela[i].hash==0)    continue;
+        j=localizarPerfil(&novo,p->tabela[i].nome,p->tabela[i].hash);
+        novo.tabela[j]=p->tabela[i];
+    }
+    novo.cabecalho->quantidade=p->cabecalho->quantidade;
+    novo.cabecalho->tamRanking=p->cabecalho->tamRanking;
+    for(k=0;k<p->cabecalho->tamRanking;k++){
+        const Perfil *f = &p->tabela[p->cabecalho->ranking[k]];
+        novo.cabecalho->ranking[k]=(uint32_t)localizarPerfil(&novo,f->nome,f->hash);
+    }
+    // O arquivo novo precisa estar no disco antes de tomar o lugar do antigo.
+    if(msync(novo.mapa,novo.tamMapa,MS_SYNC)<0||fsync(novo.fd)<0||rename(temporario,p->nomeArquivo)<0){
+        desmapear(&novo);
+        unlink(temporario);
+        return -1;
+    }
+    desmapear(p);
+    *p=novo;
+    return 0;
+}
+
+/**
+ * @brief Valida o cabecalho e mapeia um arquivo de cadastro ja aberto.
+ *
+ * Alem da identificacao e do tamanho, confere tudo o que depois e usado
+ * como indice: a capacidade (potencia de 2, com posicoes livres para a
+ * sondagem terminar) e as posicoes do ranking. O nome de cada perfil
+ * ocupado precisa terminar em '\0' dentro de TAM_MAX_PALAVRA.
+ *
+ * @param p O cadastro, com fd e nomeArquivo preenchidos.
+ * @return 0 em caso de sucesso, -1 se o arquivo for invalido ou nao puder ser mapeado.
+ */
+static int mapearArquivo (Perfis *p){
+    struct stat info;
+    CabecalhoPerfis *c;
+    Perfil *t;
+    size_t i;
+    int k;
+    if(fstat(p->fd,&info)<0||(size_t)info.st_size<TAM_CABECALHO_PERFIS)  return -1;
+    p->tamMapa=(size_t)info.st_size;
+    p->mapa=mmap(NULL,p->tamMapa,p->somenteLeitura?PROT_READ:PROT_READ|PROT_WRITE,MAP_SHARED,p->fd,0);
+    if(p->mapa==MAP_FAILED) return -1;
+    c=(CabecalhoPerfis *)p->mapa;
+    if(memcmp(c->magico,MAGICO_PERFIS,sizeof(MAGICO_PERFIS))!=0||c->tamRegistro!=sizeof(Perfil)
+       ||c->capacidade==0||(c->capacidade&(c->capacidade-1))!=0||c->quantidade>=c->capacidade
+       ||c->capacidade>(p->tamMapa-TAM_CABECALHO_PERFIS)/sizeof(Perfil)
+       ||p->tamMapa!=TAM_CABECALHO_PERFIS+c->capacidade*sizeof(Perfil)
+       ||c->tamRanking<0||c->tamRanking>TAM_RANKING){
+        munmap(p->mapa,p->tamMapa);
+        return -1;
+    }
+    for(k=0;k<c->tamRanking;k++){
+        if(c->ranking[k]>=c->capacidade){
+            munmap(p->mapa,p->tamMapa);
+            return -1;
+        }
+    }
+    t=(Perfil *)(p->mapa+TAM_CABECALHO_PERFIS);
+    for(i=0;i<c->capacidade;i++){
+        if(t[i].hash!=0&&memchr(t[i].nome,'\0',TAM_MAX_PALAVRA)==NULL){
+            munmap(p->mapa,p->tamMapa);
+            return -1;
+        }
+    }
+    p->cabecalho=c;
+    p->tabela=t;
+    return 0;
+}
+
+/**
+ * @brief Abre um cadastro existente so para consulta, sem trava e sem cria-lo.
+ * @param nomeArquivo O arquivo do cadastro.
+ * @return O cadastro, ou NULL se o arquivo nao existir ou for invalido.
+ */
+Perfis *abrirPerfisLeitura (const char *nomeArquivo){
+    Perfis *p = calloc(1,sizeof(Perfis));
+    if(p==NULL||strlen(nomeArquivo)>=TAM_MAX_PALAVRA){
+        free(p);
+        return NULL;
+    }
+    strcpy(p->nomeArquivo,nomeArquivo);
+    p->somenteLeitura=1;
+    p->fd=open(nomeArquivo,O_RDONLY);
+    if(p->fd<0){
+        free(p);
+        return NULL;
+    }
+    if(mapearArquivo(p)<0){
+        printf("Arquivo de perfis invalido: %s\n",nomeArquivo);
+        close(p->fd);
+        free(p);
+        return NULL;
+    }
+    return p;
+}
+
+/**
+ * @brief Abre (ou cria) um cadastro de perfis.
+ *
+ * Se outro processo ja estiver com o cadastro aberto para escrita, o
+ * cadastro e aberto so para consulta (atualizarPerfil falha).
+ *
+ * @param nomeArquivo O arquivo do cadastro.
+ * @param capacidade Capacidade minima desejada, para evitar crescimentos (0 = padrao).
+ * @return O cadastro, ou NULL em caso de erro.
+ */
+Perfis *abrirPerfis (const char *nomeArquivo, size_t capacidade){
+    struct stat travado,atual;
+    size_t n=CAPACIDADE_PERFIS;
+    Perfis *p = calloc(1,sizeof(Perfis));
+    if(p==NULL||strlen(nomeArquivo)>=TAM_MAX_PALAVRA){
+        free(p);
+        return NULL;
+    }
+    strcpy(p->nomeArquivo,nomeArquivo);
+    // Capacidade para manter a ocupacao abaixo de 70%.
+    while(n*7<capacidade*10)    n*=2;
+    for(;;){
+        p->fd=open(nomeArquivo,O_RDWR);
+        if(p->fd<0){
+            if(errno==ENOENT&&criarArquivo(p,nomeArquivo,n,1)==0)   return p;
+            // Outro processo criou o arquivo primeiro: abre o dele.
+            if(errno==EEXIST)   continue;
+            free(p);
+            return NULL;
+        }
+        if(flock(p->fd,LOCK_EX|LOCK_NB)<0){
+            close(p->fd);
+            free(p);
+            printf("Cadastro de perfis em uso por outro processo: %s (somente consulta)\n",nomeArquivo);
+            return abrirPerfisLeitura(nomeArquivo);
+        }
+        // Um crescimento pode ter trocado o arquivo entre o open e a trava.
+        if(fstat(p->fd,&travado)==0&&stat(nomeArquivo,&atual)==0&&travado.st_dev==atual.st_dev&&travado.st_ino==atual.st_ino)
+            break;
+        close(p->fd);
+    }
+    if(mapearArquivo(p)<0){
+        printf("Arquivo de perfis invalido: %s\n",nomeArquivo);
+        close(p->fd);
+        free(p);
+        return NULL;
+    }
+    // Sem a capacidade pedida o cadastro nao e aberto; o arquivo original fica intacto.
+    if(n>p->cabecalho->capacidade&&crescer(p,n)<0){
+        printf("Erro ao gravar o arquivo: %s\n",nomeArquivo);
+        desmapear(p);
+        free(p);
+        return NULL;
+    }
+    return p;
+}
+
+/**
+ * @brief Grava as alteracoes pendentes no disco e fecha o cadastro.
+ * @param p O cadastro (pode ser NULL).
+ */
+void fecharPerfis (Perfis *p){
+    if(p==NULL) return;
+    if(!p->somenteLeitura)  msync(p->mapa,p->tamMapa,MS_SYNC);
+    desmapear(p);
+    free(p);
+}
+
+/**
+ * @brief Move um jogador que acabou de vencer para a sua posicao no ranking.
+ *
+ * Se ele nao estava no ranking, entra no lugar do ultimo colocado quando
+ * tem mais vitorias que este (ou ocupa uma posicao vaga). Em seguida sobe
+ * enquanto tiver mais vitorias que o colocado acima; empates mantem na
+ * frente quem chegou primeiro.
+ *
+ * @param p O cadastro.
+ * @param indice A posicao do jogador na tabela.
+ */
+static void subirNoRanking (Perfis *p, size_t indice){
+    CabecalhoPerfis *c = p->cabecalho;
+    Perfil *f = &p->tabela[indice],*acima;
+    int pos=f->posicaoRanking;
+    if(pos<0){
+        if(c->tamRanking<TAM_RANKING)   pos=c->tamRanking++;
+        else{
+            Perfil *ultimo = &p->tabela[c->ranking[TAM_RANKING-1]];
+            if(f->vitorias<=ultimo->vitorias)   return;
+            ultimo->posicaoRanking=-1;
+            pos=TAM_RANKING-1;
+        }
+        c->ranking[pos]=(uint32_t)indice;
+        f->posicaoRanking=(int16_t)pos;
+    }
+    while(pos>0){
+        acima=&p->tabela[c->ranking[pos-1]];
+        if(acima->vitorias>=f->vitorias)    break;
+        c->ranking[pos]=c->ranking[pos-1];
+        acima->posicaoRanking=(int16_t)pos;
+        pos--;
+    }
+    c->ranking[pos]=(uint32_t)indice;
+    f->posicaoRanking=(int16_t)pos;
+}
+
+/**
+ * @brief Soma o resultado de uma partida ao perfil do jogador, criando-o se preciso.
+ * @param p O cadastro.
+ * @param nome O nome do jogador.
+ * @param vitoria 1 para vitoria, 0 para derrota.
+ * @param vidas As vidas que restaram ao fim da partida.
+ * @return 0 em caso de sucesso, -1 se o cadastro nao puder crescer ou for so de consulta.
+ */
+int atualizarPerfil (Perfis *p, const char *nome, int vitoria, int vidas){
+    char chave[TAM_MAX_PALAVRA];
+    uint32_t hash;
+    size_t i;
+    Perfil *f;
+    if(p->somenteLeitura)   return -1;
+    strncpy(chave,nome,TAM_MAX_PALAVRA-1);
+    chave[TAM_MAX_PALAVRA-1]='\0';
+    hash=hashNome(chave);
+    i=localizarPerfil(p,chave,hash);
+    if(p->tabela[i].hash==0){
+        // Novo jogador: cresce antes, se a ocupacao passar de 70%.
+        if((p->cabecalho->quantidade+1)*10>p->cabecalho->capacidade*7){
+            if(crescer(p,p->cabecalho->capacidade*2)<0) return -1;
+            i=localizarPerfil(p,chave,hash);
+        }
+        f=&p->tabela[i];
+        memset(f,0,sizeof(*f));
+        strcpy(f->nome,chave);
+        f->posicaoRanking=-1;
+        f->hash=hash;
+        p->cabecalho->quantidade++;
+    }
+    f=&p->tabela[i];
+    if(!vitoria){
+        f->derrotas++;
+        f->sequenciaAtual=0;
+        return 0;
+    }
+    f->vitorias++;
+    f->vidasRestantes+=vidas>0?vidas:0;
+    if(f->sequenciaAtual<UINT16_MAX)    f->sequenciaAtual++;
+    if(f->sequenciaAtual>f->melhorSequencia)    f->melhorSequencia=f->sequenciaAtual;
+    subirNoRanking(p,i);
+    return 0;
+}
+
+/**
+ * @brief Procura o perfil de um jogador.
+ * @param p O cadastro.
+ * @param nome O nome do jogador.
+ * @return O perfil (valido ate a proxima atualizacao), ou NULL se nao existir.
+ */
+const Perfil *buscarPerfil (const Perfis *p, const char *nome){
+    uint32_t hash=hashNome(nome);
+    size_t i=localizarPerfil(p,nome,hash);
+    return p->tabela[i].hash!=0?&p->tabela[i]:NULL;
+}
+
+/**
+ * @brief Copia as primeiras posicoes do ranking de vitorias.
+ * @param p O cadastro.
+ * @param destino Recebe ponteiros para os perfis, do primeiro ao ultimo colocado.
+ * @param k O numero maximo de posicoes (no maximo TAM_RANKING sao mantidas).
+ * @return O numero de posicoes copiadas.
+ */
+int consultarRanking (const Perfis *p, const Perfil **destino, int k){
+    int i;
+    if(k>p->cabecalho->tamRanking)  k=p->cabecalho->tamRanking;
+    for(i=0;i<k;i++)    destino[i]=&p->tabela[p->cabecalho->ranking[i]];
+    return k;
+}
+
+/**
+ * @brief Retorna o numero de jogadores cadastrados.
+ * @param p O cadastro.
+ * @return O numero de perfis.
+ */
+size_t contarPerfis (const Perfis *p){
+    return (size_t)p->cabecalho->quantidade;
+}
+
+#else
+
+/**
+ * @brief Cadastro de perfis indisponivel no Windows (requer mmap).
+ */
+Perfis *abrirPerfis (const char *nomeArquivo, size_t capacidade){
+    (void)nomeArquivo;
+    (void)capacidade;
+    return NULL;
+}
+
+Perfis *abrirPerfisLeitura (const char *nomeArquivo){
+    (void)nomeArquivo;
+    return NULL;
+}
+
+void fecharPerfis (Perfis *p){
+    (void)p;
+}
+
+int atualizarPerfil (Perfis *p, const char *nome, int vitoria, int vidas){
+    (void)p;
+    (void)nome;
+    (void)vitoria;
+    (void)vidas;
+    return -1;
+}
+
+const Perfil *buscarPerfil (const Perfis *p, const char *nome){
+    (void)p;
+    (void)nome;
+    return NULL;
+}
+
+int consultarRanking (const Perfis *p, const Perfil **destino, int k){
+    (void)p;
+    (void)destino;
+    (void)k;
+    return 0;
+}
+
+size_t contarPerfis (const Perfis *p){
+    (void)p;
+    return 0;
+}
+
+#endif
+
+/**
+ * @brief Faz registrarResultado (e o registro assincrono) atualizar um cadastro.
+ * @param p O cadastro, ou NULL para nao atualizar nenhum.
+ */
+void definirPerfisPadrao (Perfis *p){
+    perfisPadrao=p;
+}
+
+/**
+ * @brief Retorna o cadastro atualizado a cada resultado, se houver.
+ * @return O cadastro, ou NULL.
+ */
+Perfis *obterPerfisPadrao (void){
+    return perfisPadrao;
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+/**
+ * @file perfis.h
+ * @brief Arquivo de cabecalho do cadastro de perfis de jogadores.
+ *
+ * O cadastro e um arquivo mapeado em memoria com uma tabela hash de
+ * enderecamento aberto (sondagem linear) de registros de tamanho fixo,
+ * indexada pelo nome do jogador. Cada partida encerrada atualiza o perfil
+ * do jogador em O(1), sem reler o historico de resultados.txt.
+ *
+ * O cabecalho do arquivo guarda tambem o ranking dos TAM_RANKING
+ * jogadores com mais vitorias. Como o numero de vitorias de um jogador
+ * nunca diminui, o ranking pode ser mantido de forma exata a cada
+ * atualizacao: so o jogador que acabou de vencer pode subir, e apenas
+ * o ultimo colocado pode sair. Consultar o ranking nao percorre a tabela.
+ *
+ * Um cadastro aceita um unico escritor por vez (no servidor, a thread de
+ * escrita do registro; no terminal, a propria partida). Entre processos,
+ * o escritor segura uma trava (flock) no arquivo; um segundo processo que
+ * abra o cadastro fica apenas com a consulta.
+ */
+
+#ifndef PERFIS_H
+#define PERFIS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "forca.h"
+
+// Define o nome do arquivo do cadastro de perfis.
+#define ARQUIVO_PERFIS "perfis.dat"
+// Numero de posicoes do ranking mantido no cabecalho.
+#define TAM_RANKING 100
+// Capacidade inicial da tabela (potencia de 2).
+#define CAPACIDADE_PERFIS 1024
+
+/**
+ * @struct Perfil
+ * @brief Historico de um jogador. Ocupa exatamente 128 bytes no arquivo.
+ */
+typedef struct{
+    uint32_t hash;              // Hash do nome (0 indica posicao livre).
+    uint32_t vitorias;
+    uint32_t derrotas;
+    uint32_t vidasRestantes;    // Soma das vidas que sobraram nas vitorias.
+    uint16_t sequenciaAtual;    // Vitorias seguidas ate a ultima partida.
+    uint16_t melhorSequencia;   // Maior sequencia de vitorias ja alcancada.
+    int16_t posicaoRanking;     // Posicao no ranking (0 = primeiro), ou -1.
+    uint16_t reservado;
+    char nome[TAM_MAX_PALAVRA]; // Nome do jogador, terminado em '\0'.
+    char reservado2[4];
+} Perfil;
+
+/**
+ * @struct Perfis
+ * @brief Um cadastro de perfis aberto.
+ */
+typedef struct Perfis Perfis;
+
+/**
+ * @brief Abre (ou cria) um cadastro de perfis.
+ *
+ * Se outro processo ja estiver com o cadastro aberto para escrita, o
+ * cadastro e aberto so para consulta (atualizarPerfil falha).
+ *
+ * @param nomeArquivo O arquivo do cadastro.
+ * @param capacidade Capacidade minima desejada, para evitar crescimentos (0 = padrao).
+ * @return O cadastro, ou NULL em caso de erro.
+ */
+Perfis *abrirPerfis (const char *nomeArquivo, size_t capacidade);
+
+/**
+ * @brief Abre um cadastro existente so para consulta, sem trava e sem cria-lo.
+ * @param nomeArquivo O arquivo do cadastro.
+ * @return O cadastro, ou NULL se o arquivo nao existir ou for invalido.
+ */
+Perfis *abrirPerfisLeitura (const char *nomeArquivo);
+
+/**
+ * @brief Grava as alteracoes pendentes no disco e fecha o cadastro.
+ * @param p O cadastro (pode ser NULL).
+ */
+void fecharPerfis (Perfis *p);
+
+/**
+ * @brief Soma o resultado de uma partida ao perfil do jogador, criando-o se preciso.
+ * @param p O cadastro.
+ * @param nome O nome do jogador.
+ * @param vitoria 1 para vitoria, 0 para derrota.
+ * @param vidas As vidas que restaram ao fim da partida.
+ * @return 0 em caso de sucesso, -1 se o cadastro nao puder crescer ou for so de consulta.
+ */
+int atualizarPerfil (Perfis *p, const char *nome, int vitoria, int vidas);
+
+/**
+ * @brief Procura o perfil de um jogador.
+ * @param p O cadastro.
+ * @param nome O nome do jogador.
+ * @return O perfil (valido ate a proxima atualizacao), ou NULL se nao existir.
+ */
+const Perfil *buscarPerfil (const Perfis *p, const char *nome);
+
+/**
+ * @brief Copia as primeiras posicoes do ranking de vitorias.
+ * @param p O cadastro.
+ * @param destino Recebe ponteiros para os perfis, do primeiro ao ultimo colocado.
+ * @param k O numero maximo de posicoes (no maximo TAM_RANKING sao mantidas).
+ * @return O numero de posicoes copiadas.
+ */
+int consultarRanking (const Perfis *p, const Perfil **destino, int k);
+
+/**
+ * @brief Retorna o numero de jogadores cadastrados.
+ * @param p O cadastro.
+ * @return O numero de perfis.
+ */
+size_t contarPerfis (const Perfis *p);
+
+/**
+ * @brief Faz registrarResultado (e o registro assincrono) atualizar um cadastro.
+ * @param p O cadastro, ou NULL para nao atualizar nenhum.
+ */
+void definirPerfisPadrao (Perfis *p);
+
+/**
+ * @brief Retorna o cadastro atualizado a cada resultado, se houver.
+ * @return O cadastro, ou NULL.
+ */
+Perfis *obterPerfisPadrao (void);
+
+#endif
\ No newline at end of file
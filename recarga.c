@@ -0,0 +1,424 @@
+/**
+ * @file recarga.c
+ * @brief Implementacao da recarga do arquivo de palavras com troca de versoes.
+ *
+ * A thread de recarga observa o diretorio do arquivo (editores costumam
+ * gravar um arquivo novo e renomea-lo por cima do antigo), espera
+ * ATRASO_RECARGA ms sem novas modificacoes e so entao rele o arquivo.
+ * A epoca global avanca a cada troca; cada leitor publica, no seu ponto
+ * de quiescencia, a ultima epoca que viu, em uma linha de cache propria.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "forca.h"
+#include "recarga.h"
+
+#ifdef __linux__
+
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+/**
+ * @struct EpocaLeitor
+ * @brief Ultima epoca vista por uma thread leitora, sozinha na sua linha de cache.
+ */
+typedef struct{
+    _Atomic unsigned long long epoca;
+    char preenchimento[64-sizeof(unsigned long long)];
+} EpocaLeitor;
+
+struct Recarga{
+    char nomeArquivo[TAM_MAX_PALAVRA];      // Caminho do arquivo de palavras.
+    _Atomic(VersaoDicionario *) atual;      // Versao entregue as novas partidas.
+    _Atomic unsigned long long epoca;       // Avanca a cada versao publicada.
+    EpocaLeitor *leitores;
+    int numLeitores;
+    pthread_mutex_t trava;                  // Serializa publicacoes e liberacoes (nunca os leitores).
+    pthread_mutex_t travaTrabalho;          // Segura pela thread fora do poll (ver pausarRecarga).
+    VersaoDicionario *retiradas;            // Versoes substituidas ainda nao liberadas.
+    int inotify;                            // Descritor do inotify (observa o diretorio).
+    const char *nomeBase;                   // Nome do arquivo dentro do diretorio.
+    atomic_int encerrar;                    // Pede o encerramento da thread.
+    pthread_t thread;
+    EstatisticasRecarga estatisticas;       // Protegidas pela trava.
+};
+
+/**
+ * @brief Le o arquivo de palavras em uma nova versao.
+ * @param r A recarga.
+ * @return A versao (com uma referencia, a de versao atual), ou NULL se o arquivo nao tiver palavras.
+ */
+static VersaoDicionario *lerVersao (Recarga *r){
+    VersaoDicionario *v = calloc(1,sizeof(VersaoDicionario));
+    if(v==NULL) return NULL;
+    if(lerDicionario(&v->dicionario,r->nomeArquivo)<0||v->dicionario.quantidade==0){
+        fecharDicionario(&v->dicionario);
+        free(v);
+        return NULL;
+    }
+    atomic_init(&v->referencias,1);
+    return v;
+}
+
+/**
+ * @brief Libera as versoes substituidas que ninguem mais pode estar usando.
+ *
+ * Uma versao retirada na epoca E esta livre quando nao tem referencias e
+ * todos os leitores ja publicaram uma epoca maior ou igual a E. Deve ser
+ * chamada com a trava.
+ *
+ * @param r A recarga.
+ */
+static void coletarVersoes (Recarga *r){
+    VersaoDicionario **p,*v;
+    unsigned long long minima=atomic_load(&r->epoca);
+    int i;
+    for(i=0;i<r->numLeitores;i++)
+        if(atomic_load_explicit(&r->leitores[i].epoca,memory_order_acquire)<minima)
+            minima=atomic_load_explicit(&r->leitores[i].epoca,memory_order_acquire);
+    for(p=&r->retiradas;*p!=NULL;){
+        v=*p;
+        if(atomic_load_explicit(&v->referencias,memory_order_acquire)==0&&minima>=v->epocaRetirada){
+            *p=v->proxima;
+            fecharDicionario(&v->dicionario);
+            free(v);
+            r->estatisticas.liberadas++;
+        }
+        else    p=&v->proxima;
+    }
+}
+
+/**
+ * @brief Rele o arquivo de palavras e publica a nova versao.
+ *
+ * A leitura e a indexacao sao feitas antes de pegar a trava. A versao
+ * antiga recebe a epoca da troca e vai para a lista das retiradas.
+ *
+ * @param r A recarga.
+ * @return 0 se uma nova versao foi publicada, -1 caso contrario.
+ */
+int recarregarPalavras (Recarga *r){
+    VersaoDicionario *nova,*antiga;
+    long long inicio=relogioNs(),duracao;
+    nova=lerVersao(r);
+    pthread_mutex_lock(&r->trava);
+    if(nova==NULL){
+        r->estatisticas.falhas++;
+        pthread_mutex_unlock(&r->trava);
+        return -1;
+    }
+    duracao=relogioNs()-inicio;
+    if(duracao>r->estatisticas.maiorLeitura)    r->estatisticas.maiorLeitura=duracao;
+    antiga=atomic_load(&r->atual);
+    nova->numero=antiga->numero+1;
+    // Depois da troca, quem ler o ponteiro ja recebe a nova versao.
+    atomic_store(&r->atual,nova);
+    antiga->epocaRetirada=atomic_fetch_add(&r->epoca,1)+1;
+    antiga->proxima=r->retiradas;
+    r->retiradas=antiga;
+    // A referencia de versao atual passa da antiga para a nova.
+    liberarVersao(antiga);
+    r->estatisticas.recargas++;
+    coletarVersoes(r);
+    pthread_mutex_unlock(&r->trava);
+    return 0;
+}
+
+/**
+ * @brief Le os eventos pendentes do inotify.
+ * @param r A recarga.
+ * @return 1 se algum evento se refere ao arquivo de palavras, 0 caso contrario.
+ */
+static int lerEventos (Recarga *r){
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    const struct inotify_event *evento;
+    ssize_t n;
+    int i,mudou=0;
+    while((n=read(r->inotify,buffer,sizeof(buffer)))>0){
+        for(i=0;i<n;i+=sizeof(struct inotify_event)+evento->len){
+            evento=(const struct inotify_event *)(buffer+i);
+            if(evento->len>0&&strcmp(evento->name,r->nomeBase)==0)  mudou=1;
+        }
+    }
+    return mudou;
+}
+
+/**
+ * @brief Laco da thread de recarga.
+ *
+ * Espera eventos do inotify; depois do primeiro evento sobre o arquivo,
+ * espera ATRASO_RECARGA ms sem novos eventos e rele o arquivo. Entre uma
+ * coisa e outra, tenta liberar as versoes substituidas.
+ *
+ * @param arg A recarga.
+ * @return Sempre NULL.
+ */
+static void *executarRecarga (void *arg){
+    Recarga *r = arg;
+    struct pollfd pfd;
+    long long prazo=0;
+    int pendente=0,espera,pronto;
+    pfd.fd=r->inotify;
+    pfd.events=POLLIN;
+    while(!atomic_load(&r->encerrar)){
+        espera=INTERVALO_RECARGA;
+        if(pendente){
+            espera=(int)((prazo-relogioNs())/1000000);
+            if(espera<0)    espera=0;
+        }
+        pronto=poll(&pfd,1,espera)>0;
+        pthread_mutex_lock(&r->travaTrabalho);
+        if(pronto&&lerEventos(r)){
+            // Cada nova modificacao adia a releitura: o arquivo pode estar pela metade.
+            pendente=1;
+            prazo=relogioNs()+ATRASO_RECARGA*1000000LL;
+        }
+        if(pendente&&relogioNs()>=prazo){
+            pendente=0;
+            if(recarregarPalavras(r)==0){
+                VersaoDicionario *v = atomic_load(&r->atual);
+                printf("Palavras recarregadas: %d palavras (versao %u).\n",v->dicionario.quantidade,v->numero);
+            }
+            else    printf("Erro ao abrir o arquivo: %s (mantida a versao anterior)\n",r->nomeArquivo);
+            fflush(stdout);
+        }
+        pthread_mutex_lock(&r->trava);
+        coletarVersoes(r);
+        pthread_mutex_unlock(&r->trava);
+        pthread_mutex_unlock(&r->travaTrabalho);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Le a primeira versao do arquivo de palavras e inicia a thread de recarga.
+ * @param nomeArquivo O arquivo de palavras.
+ * @param leitores O numero de threads que vao ler versoes.
+ * @return A recarga, ou NULL se o arquivo nao puder ser lido ou observado.
+ */
+Recarga *iniciarRecarga (const char *nomeArquivo, int leitores){
+    Recarga *r = calloc(1,sizeof(Recarga));
+    VersaoDicionario *v;
+    char diretorio[TAM_MAX_PALAVRA];
+    const char *barra;
+    int i;
+    if(r==NULL||strlen(nomeArquivo)>=TAM_MAX_PALAVRA||leitores<1){
+        free(r);
+        return NULL;
+    }
+    strcpy(r->nomeArquivo,nomeArquivo);
+    barra=strrchr(r->nomeArquivo,'/');
+    r->nomeBase=barra!=NULL?barra+1:r->nomeArquivo;
+    // Observa o diretorio, e nao o arquivo: um arquivo renomeado por cima tem outro inode.
+    if(barra!=NULL){
+        memcpy(diretorio,r->nomeArquivo,barra-r->nomeArquivo);
+        diretorio[barra==r->nomeArquivo?1:barra-r->nomeArquivo]='\0';
+    }
+    else    strcpy(diretorio,".");
+    r->leitores=aligned_alloc(64,leitores*sizeof(EpocaLeitor));
+    r->numLeitores=leitores;
+    r->inotify=inotify_init1(IN_NONBLOCK|IN_CLOEXEC);
+    v=r->leitores!=NULL?lerVersao(r):NULL;
+    if(v==NULL||r->inotify<0||inotify_add_watch(r->inotify,diretorio,IN_CLOSE_WRITE|IN_MOVED_TO|IN_MODIFY|IN_CREATE)<0){
+        if(v!=NULL){
+            fecharDicionario(&v->dicionario);
+            free(v);
+        }
+        if(r->inotify>=0)   close(r->inotify);
+        free(r->leitores);
+        free(r);
+        return NULL;
+    }
+    v->numero=1;
+    atomic_init(&r->atual,v);
+    atomic_init(&r->epoca,1);
+    for(i=0;i<leitores;i++) atomic_init(&r->leitores[i].epoca,1);
+    pthread_mutex_init(&r->trava,NULL);
+    pthread_mutex_init(&r->travaTrabalho,NULL);
+    if(pthread_create(&r->thread,NULL,executarRecarga,r)!=0){
+        pthread_mutex_destroy(&r->trava);
+        pthread_mutex_destroy(&r->travaTrabalho);
+        fecharDicionario(&v->dicionario);
+        free(v);
+        close(r->inotify);
+        free(r->leitores);
+        free(r);
+        return NULL;
+    }
+    return r;
+}
+
+/**
+ * @brief Retorna a versao atual, sem contar uma referencia.
+ * @param r A recarga.
+ * @return A versao atual.
+ */
+VersaoDicionario *consultarVersao (Recarga *r){
+    return atomic_load_explicit(&r->atual,memory_order_acquire);
+}
+
+/**
+ * @brief Adquire a versao atual, que continua valida ate liberarVersao.
+ * @param r A recarga.
+ * @return A versao atual.
+ */
+VersaoDicionario *adquirirVersao (Recarga *r){
+    // Entre a leitura e o incremento a versao nao pode ser liberada: a
+    // thread ainda nao passou por um ponto de quiescencia depois da leitura.
+    VersaoDicionario *v = atomic_load_explicit(&r->atual,memory_order_acquire);
+    atomic_fetch_add_explicit(&v->referencias,1,memory_order_relaxed);
+    return v;
+}
+
+/**
+ * @brief Libera uma versao adquirida com adquirirVersao.
+ * @param v A versao.
+ */
+void liberarVersao (VersaoDicionario *v){
+    atomic_fetch_sub_explicit(&v->referencias,1,memory_order_release);
+}
+
+/**
+ * @brief Marca um ponto de quiescencia da thread leitora.
+ * @param r A recarga.
+ * @param leitor O indice da thread leitora.
+ */
+void marcarQuiescencia (Recarga *r, int leitor){
+    unsigned long long epoca=atomic_load_explicit(&r->epoca,memory_order_acquire);
+    // So escreve quando a epoca muda, para nao disputar a linha de cache a toa.
+    if(atomic_load_explicit(&r->leitores[leitor].epoca,memory_order_relaxed)!=epoca)
+        atomic_store_explicit(&r->leitores[leitor].epoca,epoca,memory_order_release);
+}
+
+/**
+ * @brief Sorteia e copia uma palavra da versao atual.
+ * @param r A recarga.
+ * @param a O gerador usado no sorteio.
+ * @param palavra A string que recebera a palavra sorteada.
+ */
+void carregarPalavraAtual (Recarga *r, Aleatorio *a, char *palavra){
+    VersaoDicionario *v = adquirirVersao(r);
+    const char *origem;
+    int n;
+    origem=sortearPalavra(&v->dicionario,a,&n);
+    memcpy(palavra,origem,n);
+    palavra[n]='\0';
+    liberarVersao(v);
+}
+
+/**
+ * @brief Copia os contadores da recarga.
+ * @param r A recarga.
+ * @param e Recebe os contadores.
+ */
+void consultarRecarga (Recarga *r, EstatisticasRecarga *e){
+    VersaoDicionario *v;
+    pthread_mutex_lock(&r->trava);
+    *e=r->estatisticas;
+    for(e->pendentes=0,v=r->retiradas;v!=NULL;v=v->proxima)    e->pendentes++;
+    pthread_mutex_unlock(&r->trava);
+}
+
+/**
+ * @brief Espera a thread de recarga terminar o que esta fazendo e a impede de continuar.
+ * @param r A recarga (pode ser NULL).
+ */
+void pausarRecarga (Recarga *r){
+    if(r!=NULL) pthread_mutex_lock(&r->travaTrabalho);
+}
+
+/**
+ * @brief Deixa a thread de recarga continuar depois de pausarRecarga.
+ * @param r A recarga (pode ser NULL).
+ */
+void retomarRecarga (Recarga *r){
+    if(r!=NULL) pthread_mutex_unlock(&r->travaTrabalho);
+}
+
+/**
+ * @brief Encerra a thread de recarga e libera todas as versoes.
+ * @param r A recarga.
+ */
+void encerrarRecarga (Recarga *r){
+    VersaoDicionario *v;
+    if(r==NULL) return;
+    atomic_store(&r->encerrar,1);
+    pthread_join(r->thread,NULL);
+    close(r->inotify);
+    while((v=r->retiradas)!=NULL){
+        r->retiradas=v->proxima;
+        fecharDicionario(&v->dicionario);
+        free(v);
+    }
+    v=atomic_load(&r->atual);
+    fecharDicionario(&v->dicionario);
+    free(v);
+    pthread_mutex_destroy(&r->trava);
+    pthread_mutex_destroy(&r->travaTrabalho);
+    free(r->leitores);
+    free(r);
+}
+
+#else
+
+// Sem inotify, nao ha recarga: iniciarRecarga sempre falha e as demais nunca sao chamadas.
+
+Recarga *iniciarRecarga (const char *nomeArquivo, int leitores){
+    (void)nomeArquivo;
+    (void)leitores;
+    printf("A recarga do arquivo de palavras requer Linux (inotify).\n");
+    return NULL;
+}
+
+VersaoDicionario *consultarVersao (Recarga *r){
+    (void)r;
+    return NULL;
+}
+
+VersaoDicionario *adquirirVersao (Recarga *r){
+    (void)r;
+    return NULL;
+}
+
+void liberarVersao (VersaoDicionario *v){
+    (void)v;
+}
+
+void marcarQuiescencia (Recarga *r, int leitor){
+    (void)r;
+    (void)leitor;
+}
+
+void carregarPalavraAtual (Recarga *r, Aleatorio *a, char *palavra){
+    (void)r;
+    (void)a;
+    palavra[0]='\0';
+}
+
+int recarregarPalavras (Recarga *r){
+    (void)r;
+    return -1;
+}
+
+void consultarRecarga (Recarga *r, EstatisticasRecarga *e){
+    (void)r;
+    memset(e,0,sizeof(*e));
+}
+
+void pausarRecarga (Recarga *r){
+    (void)r;
+}
+
+void retomarRecarga (Recarga *r){
+    (void)r;
+}
+
+void encerrarRecarga (Recarga *r){
+    (void)r;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,156 @@
+/**
+ * @file recarga.h
+ * @brief Arquivo de cabecalho da recarga do arquivo de palavras sem reiniciar.
+ *
+ * Cada versao do arquivo de palavras e um dicionario imutavel, lido com
+ * lerDicionario (uma copia, e nao um mapeamento do arquivo). Uma thread
+ * observa o arquivo com inotify e, quando ele muda, monta a nova versao
+ * por conta propria e a publica trocando um ponteiro atomico. As threads
+ * de jogo nunca esperam por ela: pegam a versao atual ao iniciar uma
+ * partida e seguem com a mesma ate o fim, mesmo que outra seja publicada.
+ *
+ * Uma versao substituida e liberada quando (1) nenhuma partida a usa mais
+ * (contador de referencias) e (2) todas as threads leitoras passaram por
+ * um ponto de quiescencia depois da troca (epocas, como no RCU). A
+ * segunda condicao garante que nenhuma thread leu o ponteiro antigo e
+ * ainda nao contou a sua referencia. So a thread de recarga libera
+ * versoes; os leitores fazem apenas leituras e incrementos atomicos.
+ */
+
+#ifndef RECARGA_H
+#define RECARGA_H
+
+#include <stdatomic.h>
+#include "forca.h"
+#include "dicionario.h"
+#include "aleatorio.h"
+
+// Espera, em ms, depois da ultima modificacao do arquivo antes de rele-lo (agrupa as escritas).
+#define ATRASO_RECARGA 100
+// Intervalo, em ms, entre as tentativas de liberar versoes substituidas.
+#define INTERVALO_RECARGA 200
+
+/**
+ * @struct VersaoDicionario
+ * @brief Uma versao publicada do arquivo de palavras.
+ */
+typedef struct VersaoDicionario{
+    Dicionario dicionario;              // As palavras desta versao (imutaveis).
+    unsigned numero;                    // 1 para a versao lida na inicializacao.
+    atomic_int referencias;             // Partidas que a usam, mais uma enquanto ela e a atual.
+    unsigned long long epocaRetirada;   // Epoca em que deixou de ser a atual.
+    struct VersaoDicionario *proxima;   // Proxima versao substituida ainda nao liberada.
+} VersaoDicionario;
+
+/**
+ * @struct EstatisticasRecarga
+ * @brief Contadores da recarga.
+ */
+typedef struct{
+    unsigned long long recargas;        // Versoes publicadas depois da inicial.
+    unsigned long long falhas;          // Releituras descartadas (arquivo ilegivel ou vazio).
+    unsigned long long liberadas;       // Versoes substituidas ja liberadas.
+    unsigned long long pendentes;       // Versoes substituidas ainda em uso.
+    long long maiorLeitura;             // Maior tempo de leitura e indexacao de uma versao, em ns.
+} EstatisticasRecarga;
+
+// Estrutura opaca da recarga.
+typedef struct Recarga Recarga;
+
+/**
+ * @brief Le a primeira versao do arquivo de palavras e inicia a thread de recarga.
+ * @param nomeArquivo O arquivo de palavras.
+ * @param leitores O numero de threads que vao ler versoes (cada uma com um indice de 0 a leitores-1).
+ * @return A recarga, ou NULL se o arquivo nao puder ser lido ou observado.
+ */
+Recarga *iniciarRecarga (const char *nomeArquivo, int leitores);
+
+/**
+ * @brief Retorna a versao atual, sem contar uma referencia.
+ *
+ * Serve para comparar com a versao ja adquirida; o ponteiro so pode ser
+ * usado ate o proximo ponto de quiescencia da thread.
+ *
+ * @param r A recarga.
+ * @return A versao atual.
+ */
+VersaoDicionario *consultarVersao (Recarga *r);
+
+/**
+ * @brief Adquire a versao atual, que continua valida ate liberarVersao.
+ * @param r A recarga.
+ * @return A versao atual.
+ */
+VersaoDicionario *adquirirVersao (Recarga *r);
+
+/**
+ * @brief Libera uma versao adquirida com adquirirVersao.
+ * @param v A versao.
+ */
+void liberarVersao (VersaoDicionario *v);
+
+/**
+ * @brief Marca um ponto de quiescencia da thread leitora.
+ *
+ * Deve ser chamada periodicamente (por exemplo, a cada volta do laco de
+ * eventos), fora de qualquer uso de ponteiros obtidos com
+ * consultarVersao. Custa uma leitura e uma escrita atomicas.
+ *
+ * @param r A recarga.
+ * @param leitor O indice da thread leitora.
+ */
+void marcarQuiescencia (Recarga *r, int leitor);
+
+/**
+ * @brief Sorteia e copia uma palavra da versao atual.
+ * @param r A recarga.
+ * @param a O gerador usado no sorteio.
+ * @param palavra A string que recebera a palavra sorteada.
+ */
+void carregarPalavraAtual (Recarga *r, Aleatorio *a, char *palavra);
+
+/**
+ * @brief Rele o arquivo de palavras e publica a nova versao.
+ *
+ * E o que a thread de recarga faz quando o arquivo muda; pode ser
+ * chamada diretamente (por exemplo, em medicoes). Um arquivo ilegivel ou
+ * sem palavras e ignorado, e a versao atual continua valendo.
+ *
+ * @param r A recarga.
+ * @return 0 se uma nova versao foi publicada, -1 caso contrario.
+ */
+int recarregarPalavras (Recarga *r);
+
+/**
+ * @brief Copia os contadores da recarga.
+ * @param r A recarga.
+ * @param e Recebe os contadores.
+ */
+void consultarRecarga (Recarga *r, EstatisticasRecarga *e);
+
+/**
+ * @brief Espera a thread de recarga terminar o que esta fazendo e a impede de continuar.
+ *
+ * Enquanto pausada, ela so espera no poll, sem nenhuma trava (nem a do
+ * malloc, nem a do stdio): e o estado seguro para um fork.
+ *
+ * @param r A recarga (pode ser NULL).
+ */
+void pausarRecarga (Recarga *r);
+
+/**
+ * @brief Deixa a thread de recarga continuar depois de pausarRecarga.
+ * @param r A recarga (pode ser NULL).
+ */
+void retomarRecarga (Recarga *r);
+
+/**
+ * @brief Encerra a thread de recarga e libera todas as versoes.
+ *
+ * Deve ser chamada depois que as threads leitoras terminaram.
+ *
+ * @param r A recarga.
+ */
+void encerrarRecarga (Recarga *r);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,373 @@
+/**
+ * @file registro.c
+ * @brief Implementacao do registro assincrono de resultados.
+ *
+ * O anel segue o esquema de fila limitada com numero de sequencia por
+ * posicao: cada produtor reserva uma posicao com compare-and-swap, copia
+ * a entrada e a publica; a thread de escrita consome as posicoes em
+ * ordem, formata as linhas em um buffer e grava o lote de uma so vez.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "forca.h"
+#include "registro.h"
+#include "perfis.h"
+
+// Registro usado por registrarResultado, quando definido.
+static Registro *registroPadrao=NULL;
+static char arquivoRegistroPadrao[TAM_MAX_PALAVRA];
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+// Maior linha possivel: data, nome, palavra, resultado e separadores.
+#define TAM_MAX_LINHA_REGISTRO (32+TAM_MAX_PALAVRA+TAM_MAX_MASCARA+16)
+
+struct Registro{
+    EntradaRegistro *anel;          // Posicoes do anel.
+    size_t mascara;                 // Capacidade-1 (a capacidade e potencia de 2).
+    _Atomic size_t cauda;           // Proxima posicao a ser reservada pelos produtores.
+    size_t cabeca;                  // Proxima posicao a ser consumida (so a thread de escrita).
+    int fd;                         // Arquivo de resultados.
+    PoliticaSincronia politica;
+    long long intervaloNs;          // Intervalo entre sincronizacoes periodicas.
+    long long ultimaSincronia;      // Instante da ultima sincronizacao.
+    time_t minutoCache;             // Minuto cuja data esta em dataCache.
+    char dataCache[32];             // Data formatada do minuto em cache.
+    int tamDataCache;
+    char *lote;                     // Buffer de escrita de um lote.
+    atomic_int encerrar;            // Pede o encerramento da thread de escrita.
+    pthread_mutex_t travaTrabalho;  // Segura pela thread de escrita enquanto grava (ver pausarRegistro).
+    pthread_t thread;
+    _Atomic unsigned long long enfileiradas,gravadas,lotes,sincronizacoes,esperas,maiorLote;
+};
+
+/**
+ * @brief Formata a data de uma linha, reaproveitando a ultima formatacao.
+ *
+ * O formato tem resolucao de minutos, entao localtime/strftime so sao
+ * chamados quando o minuto muda.
+ *
+ * @param r O registro.
+ * @param quando O instante a ser formatado.
+ */
+static void atualizarData (Registro *r, time_t quando){
+    struct tm infoTempo;
+    if(quando/60==r->minutoCache)   return;
+    r->minutoCache=quando/60;
+    localtime_r(&quando,&infoTempo);
+    r->tamDataCache=strftime(r->dataCache,sizeof(r->dataCache),"%d/%m/%Y %H:%M",&infoTempo);
+}
+
+/**
+ * @brief Escreve uma linha no formato de registrarResultado.
+ * @param r O registro.
+ * @param e A entrada a ser formatada.
+ * @param destino O buffer de destino (com pelo menos TAM_MAX_LINHA_REGISTRO bytes).
+ * @return O numero de bytes escritos.
+ */
+static int formatarLinha (Registro *r, const EntradaRegistro *e, char *destino){
+    const char *resultado=e->vitoria?"Vitoria":"Derrota";
+    size_t n;
+    char *p=destino;
+    atualizarData(r,e->quando);
+    *p++='[';
+    memcpy(p,r->dataCache,r->tamDataCache);
+    p+=r->tamDataCache;
+    *p++=']';
+    *p++='\t';
+    n=strlen(e->nome);
+    memcpy(p,e->nome,n);
+    p+=n;
+    *p++='\t';
+    n=strlen(e->palavra);
+    memcpy(p,e->palavra,n);
+    p+=n;
+    *p++='\t';
+    memcpy(p,resultado,7);
+    p+=7;
+    *p++='\n';
+    return (int)(p-destino);
+}
+
+/**
+ * @brief Grava um lote no arquivo e aplica a politica de sincronia.
+ * @param r O registro.
+ * @param tamanho O numero de bytes do lote.
+ * @param linhas O numero de linhas do lote.
+ */
+static void gravarLote (Registro *r, size_t tamanho, unsigned long long linhas){
+    size_t enviado=0;
+    ssize_t n;
+    long long agora;
+    while(enviado<tamanho){
+        n=write(r->fd,r->lote+enviado,tamanho-enviado);
+        if(n<0){
+            if(errno==EINTR)    continue;
+            perror("Erro ao gravar os resultados");
+            return;
+        }
+        enviado+=n;
+    }
+    atomic_fetch_add_explicit(&r->lotes,1,memory_order_relaxed);
+    atomic_fetch_add_explicit(&r->gravadas,linhas,memory_order_relaxed);
+    if(linhas>atomic_load_explicit(&r->maiorLote,memory_order_relaxed))
+        atomic_store_explicit(&r->maiorLote,linhas,memory_order_relaxed);
+    if(r->politica==SINCRONIA_NUNCA)    return;
+    agora=relogioNs();
+    if(r->politica==SINCRONIA_POR_LOTE||agora-r->ultimaSincronia>=r->intervaloNs){
+        fdatasync(r->fd);
+        r->ultimaSincronia=agora;
+        atomic_fetch_add_explicit(&r->sincronizacoes,1,memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Consome todas as entradas publicadas e as grava em lotes.
+ * @param r O registro.
+ * @return O numero de entradas consumidas.
+ */
+static size_t esvaziarAnel (Registro *r){
+    Perfis *perfis=obterPerfisPadrao();
+    EntradaRegistro *e;
+    size_t tamanho=0,total=0;
+    unsigned long long linhas=0;
+    for(;;){
+        e=&r->anel[r->cabeca&r->mascara];
+        // A posicao so esta pronta quando o produtor a publicou (sequencia = cabeca+1).
+        if(atomic_load_explicit(&e->sequencia,memory_order_acquire)!=r->cabeca+1)  break;
+        if(TAM_LOTE_REGISTRO-tamanho<TAM_MAX_LINHA_REGISTRO){
+            gravarLote(r,tamanho,linhas);
+            tamanho=0;
+            linhas=0;
+        }
+        tamanho+=formatarLinha(r,e,r->lote+tamanho);
+        // Esta thread e o unico escritor do cadastro de perfis.
+        if(perfis!=NULL)    atualizarPerfil(perfis,e->nome,e->vitoria,e->vidas);
+        linhas++;
+        total++;
+        // Devolve a posicao aos produtores para a proxima volta do anel.
+        atomic_store_explicit(&e->sequencia,r->cabeca+r->mascara+1,memory_order_release);
+        r->cabeca++;
+    }
+    if(tamanho>0)   gravarLote(r,tamanho,linhas);
+    return total;
+}
+
+/**
+ * @brief Laco da thread de escrita.
+ * @param arg O Registro.
+ * @return Sempre NULL.
+ */
+static void *executarEscrita (void *arg){
+    Registro *r = arg;
+    struct timespec pausa={0,INTERVALO_REGISTRO*1000000L};
+    size_t gravadas;
+    int encerrar;
+    for(;;){
+        // O pedido de encerramento e lido antes de esvaziar, para nao perder entradas.
+        encerrar=atomic_load(&r->encerrar);
+        pthread_mutex_lock(&r->travaTrabalho);
+        gravadas=esvaziarAnel(r);
+        pthread_mutex_unlock(&r->travaTrabalho);
+        if(gravadas==0){
+            if(encerrar)    break;
+            nanosleep(&pausa,NULL);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Inicia o registro assincrono de um arquivo de resultados.
+ * @param nomeArquivo O arquivo de resultados (aberto em modo de acrescimo).
+ * @param capacidade Numero de posicoes do anel (arredondado para potencia de 2).
+ * @param politica Quando sincronizar os lotes com o disco.
+ * @param intervaloMs Intervalo minimo entre sincronizacoes em SINCRONIA_PERIODICA.
+ * @return O registro, ou NULL em caso de erro.
+ */
+Registro *iniciarRegistro (const char *nomeArquivo, size_t capacidade, PoliticaSincronia politica, int intervaloMs){
+    size_t i,n=2;
+    Registro *r = calloc(1,sizeof(Registro));
+    if(r==NULL) return NULL;
+    while(n<capacidade) n*=2;
+    r->anel=malloc(n*sizeof(EntradaRegistro));
+    r->lote=malloc(TAM_LOTE_REGISTRO);
+    r->fd=open(nomeArquivo,O_WRONLY|O_CREAT|O_APPEND,0644);
+    if(r->anel==NULL||r->lote==NULL||r->fd<0){
+        if(r->fd>=0)    close(r->fd);
+        free(r->anel);
+        free(r->lote);
+        free(r);
+        return NULL;
+    }
+    // A posicao i comeca livre para a reserva de numero i.
+    for(i=0;i<n;i++)    atomic_init(&r->anel[i].sequencia,i);
+    r->mascara=n-1;
+    r->politica=politica;
+    r->intervaloNs=intervaloMs*1000000LL;
+    r->ultimaSincronia=relogioNs();
+    r->minutoCache=-1;
+    pthread_mutex_init(&r->travaTrabalho,NULL);
+    if(pthread_create(&r->thread,NULL,executarEscrita,r)!=0){
+        pthread_mutex_destroy(&r->travaTrabalho);
+        close(r->fd);
+        free(r->anel);
+        free(r->lote);
+        free(r);
+        return NULL;
+    }
+    return r;
+}
+
+/**
+ * @brief Enfileira o resultado de uma partida, sem bloquear enquanto houver espaco.
+ * @param r O registro.
+ * @param palavra A palavra secreta da partida.
+ * @param p O jogador com o resultado.
+ */
+void enfileirarResultado (Registro *r, const char *palavra, const Jogador *p){
+    EntradaRegistro *e;
+    size_t pos=atomic_load_explicit(&r->cauda,memory_order_relaxed),seq;
+    int esperou=0;
+    for(;;){
+        e=&r->anel[pos&r->mascara];
+        seq=atomic_load_explicit(&e->sequencia,memory_order_acquire);
+        if(seq==pos){
+            // Posicao livre: tenta reserva-la.
+            if(atomic_compare_exchange_weak_explicit(&r->cauda,&pos,pos+1,memory_order_relaxed,memory_order_relaxed))
+                break;
+        }
+        else if((long)(seq-pos)<0){
+            // Anel cheio: a thread de escrita ainda nao liberou esta posicao.
+            if(!esperou){
+                atomic_fetch_add_explicit(&r->esperas,1,memory_order_relaxed);
+                esperou=1;
+            }
+            sched_yield();
+            pos=atomic_load_explicit(&r->cauda,memory_order_relaxed);
+        }
+        else    pos=atomic_load_explicit(&r->cauda,memory_order_relaxed);
+    }
+    e->quando=time(NULL);
+    e->vitoria=p->vidas>0;
+    e->vidas=p->vidas;
+    strncpy(e->nome,p->nome,TAM_MAX_PALAVRA-1);
+    e->nome[TAM_MAX_PALAVRA-1]='\0';
+    strncpy(e->palavra,palavra,TAM_MAX_MASCARA);
+    e->palavra[TAM_MAX_MASCARA]='\0';
+    // Publica a entrada para a thread de escrita.
+    atomic_store_explicit(&e->sequencia,pos+1,memory_order_release);
+    atomic_fetch_add_explicit(&r->enfileiradas,1,memory_order_relaxed);
+}
+
+/**
+ * @brief Copia os contadores atuais do registro.
+ * @param r O registro.
+ * @param e Recebe os contadores.
+ */
+void consultarRegistro (Registro *r, EstatisticasRegistro *e){
+    e->enfileiradas=atomic_load(&r->enfileiradas);
+    e->gravadas=atomic_load(&r->gravadas);
+    e->lotes=atomic_load(&r->lotes);
+    e->sincronizacoes=atomic_load(&r->sincronizacoes);
+    e->esperas=atomic_load(&r->esperas);
+    e->maiorLote=atomic_load(&r->maiorLote);
+}
+
+/**
+ * @brief Espera a thread de escrita terminar o lote atual e a impede de comecar outro.
+ * @param r O registro (pode ser NULL).
+ */
+void pausarRegistro (Registro *r){
+    if(r!=NULL) pthread_mutex_lock(&r->travaTrabalho);
+}
+
+/**
+ * @brief Deixa a thread de escrita voltar a gravar depois de pausarRegistro.
+ * @param r O registro (pode ser NULL).
+ */
+void retomarRegistro (Registro *r){
+    if(r!=NULL) pthread_mutex_unlock(&r->travaTrabalho);
+}
+
+/**
+ * @brief Grava os resultados pendentes, encerra a thread de escrita e libera o registro.
+ * @param r O registro.
+ */
+void encerrarRegistro (Registro *r){
+    if(r==NULL) return;
+    atomic_store(&r->encerrar,1);
+    pthread_join(r->thread,NULL);
+    pthread_mutex_destroy(&r->travaTrabalho);
+    if(r->politica!=SINCRONIA_NUNCA)    fdatasync(r->fd);
+    close(r->fd);
+    free(r->anel);
+    free(r->lote);
+    free(r);
+}
+
+#else
+
+/**
+ * @brief Registro assincrono indisponivel no Windows: a gravacao continua sincrona.
+ */
+Registro *iniciarRegistro (const char *nomeArquivo, size_t capacidade, PoliticaSincronia politica, int intervaloMs){
+    (void)nomeArquivo;
+    (void)capacidade;
+    (void)politica;
+    (void)intervaloMs;
+    return NULL;
+}
+
+void enfileirarResultado (Registro *r, const char *palavra, const Jogador *p){
+    (void)r;
+    (void)palavra;
+    (void)p;
+}
+
+void consultarRegistro (Registro *r, EstatisticasRegistro *e){
+    (void)r;
+    memset(e,0,sizeof(*e));
+}
+
+void pausarRegistro (Registro *r){
+    (void)r;
+}
+
+void retomarRegistro (Registro *r){
+    (void)r;
+}
+
+void encerrarRegistro (Registro *r){
+    (void)r;
+}
+
+#endif
+
+/**
+ * @brief Faz registrarResultado usar um registro assincrono para o seu arquivo.
+ * @param r O registro, ou NULL para voltar a gravacao sincrona.
+ * @param nomeArquivo O arquivo atendido pelo registro.
+ */
+void definirRegistroPadrao (Registro *r, const char *nomeArquivo){
+    registroPadrao=r;
+    strncpy(arquivoRegistroPadrao,nomeArquivo,TAM_MAX_PALAVRA-1);
+}
+
+/**
+ * @brief Retorna o registro assincrono associado a um arquivo, se houver.
+ * @param nomeArquivo O arquivo de resultados.
+ * @return O registro, ou NULL se o arquivo deve ser gravado de forma sincrona.
+ */
+Registro *obterRegistroPadrao (const char *nomeArquivo){
+    if(registroPadrao==NULL||strcmp(arquivoRegistroPadrao,nomeArquivo)!=0)   return NULL;
+    return registroPadrao;
+}
\ No newline at end of file
@@ -0,0 +1,136 @@
+/**
+ * @file registro.h
+ * @brief Arquivo de cabecalho do registro assincrono de resultados.
+ *
+ * As partidas encerradas sao colocadas em um anel circular sem travas
+ * (varios produtores, um consumidor). Uma thread de escrita esvazia o
+ * anel em lotes e grava cada lote com uma unica chamada a write(),
+ * mantendo o mesmo formato de linha de registrarResultado. Se houver um
+ * cadastro de perfis padrao (perfis.h), a mesma thread o atualiza.
+ */
+
+#ifndef REGISTRO_H
+#define REGISTRO_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <time.h>
+#include "forca.h"
+
+// Capacidade padrao do anel de resultados pendentes (potencia de 2).
+#define CAPACIDADE_REGISTRO 16384
+// Tamanho do buffer de escrita de um lote.
+#define TAM_LOTE_REGISTRO 65536
+// Intervalo, em milissegundos, entre verificacoes da thread de escrita ociosa.
+#define INTERVALO_REGISTRO 5
+
+/**
+ * @enum PoliticaSincronia
+ * @brief Quando forcar a gravacao dos lotes no disco (fdatasync).
+ */
+typedef enum{
+    SINCRONIA_NUNCA,        // Deixa a gravacao a cargo do sistema operacional.
+    SINCRONIA_POR_LOTE,     // Sincroniza depois de cada lote gravado.
+    SINCRONIA_PERIODICA     // Sincroniza no maximo uma vez por intervalo.
+} PoliticaSincronia;
+
+/**
+ * @struct EntradaRegistro
+ * @brief Uma partida encerrada aguardando gravacao.
+ */
+typedef struct{
+    _Atomic size_t sequencia;           // Controle de posse da posicao no anel.
+    time_t quando;                      // Instante em que a partida terminou.
+    int vitoria;                        // 1 para Vitoria, 0 para Derrota.
+    int vidas;                          // Vidas que restaram ao fim da partida.
+    char nome[TAM_MAX_PALAVRA];         // Nome do jogador.
+    char palavra[TAM_MAX_MASCARA+1];    // Palavra secreta.
+} EntradaRegistro;
+
+/**
+ * @struct EstatisticasRegistro
+ * @brief Contadores de vazao e de contrapressao do registro.
+ */
+typedef struct{
+    unsigned long long enfileiradas;    // Resultados aceitos no anel.
+    unsigned long long gravadas;        // Linhas ja escritas no arquivo.
+    unsigned long long lotes;           // Chamadas a write() realizadas.
+    unsigned long long sincronizacoes;  // Chamadas a fdatasync() realizadas.
+    unsigned long long esperas;         // Vezes em que um produtor encontrou o anel cheio.
+    unsigned long long maiorLote;       // Maior numero de linhas gravadas de uma vez.
+} EstatisticasRegistro;
+
+/**
+ * @struct Registro
+ * @brief Estado do registro assincrono de um arquivo de resultados.
+ */
+typedef struct Registro Registro;
+
+/**
+ * @brief Inicia o registro assincrono de um arquivo de resultados.
+ * @param nomeArquivo O arquivo de resultados (aberto em modo de acrescimo).
+ * @param capacidade Numero de posicoes do anel (arredondado para potencia de 2).
+ * @param politica Quando sincronizar os lotes com o disco.
+ * @param intervaloMs Intervalo minimo entre sincronizacoes em SINCRONIA_PERIODICA.
+ * @return O registro, ou NULL em caso de erro.
+ */
+Registro *iniciarRegistro (const char *nomeArquivo, size_t capacidade, PoliticaSincronia politica, int intervaloMs);
+
+/**
+ * @brief Enfileira o resultado de uma partida, sem bloquear enquanto houver espaco.
+ *
+ * Pode ser chamada por varias threads ao mesmo tempo. Se o anel estiver
+ * cheio, espera a thread de escrita liberar espaco.
+ *
+ * @param r O registro.
+ * @param palavra A palavra secreta da partida.
+ * @param p O jogador com o resultado.
+ */
+void enfileirarResultado (Registro *r, const char *palavra, const Jogador *p);
+
+/**
+ * @brief Copia os contadores atuais do registro.
+ * @param r O registro.
+ * @param e Recebe os contadores.
+ */
+void consultarRegistro (Registro *r, EstatisticasRegistro *e);
+
+/**
+ * @brief Espera a thread de escrita terminar o lote atual e a impede de comecar outro.
+ *
+ * Enquanto pausada, ela nao segura nenhuma trava alem da propria (nem
+ * a do malloc, nem a do stdio, nem o cadastro de perfis): e o estado
+ * seguro para um fork. Os produtores nao devem estar esperando espaco
+ * no anel, senao nunca sao atendidos.
+ *
+ * @param r O registro (pode ser NULL).
+ */
+void pausarRegistro (Registro *r);
+
+/**
+ * @brief Deixa a thread de escrita voltar a gravar depois de pausarRegistro.
+ * @param r O registro (pode ser NULL).
+ */
+void retomarRegistro (Registro *r);
+
+/**
+ * @brief Grava os resultados pendentes, encerra a thread de escrita e libera o registro.
+ * @param r O registro.
+ */
+void encerrarRegistro (Registro *r);
+
+/**
+ * @brief Faz registrarResultado usar um registro assincrono para o seu arquivo.
+ * @param r O registro, ou NULL para voltar a gravacao sincrona.
+ * @param nomeArquivo O arquivo atendido pelo registro.
+ */
+void definirRegistroPadrao (Registro *r, const char *nomeArquivo);
+
+/**
+ * @brief Retorna o registro assincrono associado a um arquivo, se houver.
+ * @param nomeArquivo O arquivo de resultados.
+ * @return O registro, ou NULL se o arquivo deve ser gravado de forma sincrona.
+ */
+Registro *obterRegistroPadrao (const char *nomeArquivo);
+
+#endif
\ No newline at end of file
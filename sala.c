@@ -0,0 +1,455 @@
+/**
+ * @file sala.c
+ * @brief Implementacao das salas e da entrega dos quadros sem copias.
+ *
+ * As regras de cada palpite sao as da partida compacta (sessao.c), com as
+ * vidas e as letras no membro e a forca na rodada compartilhada. Os
+ * quadros sao alocados com o texto logo depois do cabecalho; as filas
+ * guardam ponteiros, e montarEnvio intercala os quadros com o buffer de
+ * saida da conexao na ordem em que foram produzidos.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include "forca.h"
+#include "sala.h"
+
+/**
+ * @brief Cria um quadro com texto formatado e uma referencia (a do criador).
+ * @param formato O formato, como em printf.
+ * @return O quadro, ou NULL se faltar memoria ou o texto passar de TAM_MAX_QUADRO.
+ */
+Quadro *criarQuadro (const char *formato, ...){
+    char texto[TAM_MAX_QUADRO];
+    Quadro *q;
+    va_list args;
+    int n;
+    va_start(args,formato);
+    n=vsnprintf(texto,sizeof(texto),formato,args);
+    va_end(args);
+    if(n<=0||n>=TAM_MAX_QUADRO) return NULL;
+    q=malloc(sizeof(Quadro)+n);
+    if(q==NULL) return NULL;
+    atomic_init(&q->referencias,1);
+    q->tamanho=n;
+    memcpy(q->dados,texto,n);
+    return q;
+}
+
+/**
+ * @brief Conta mais uma referencia a um quadro.
+ * @param q O quadro.
+ */
+void reterQuadro (Quadro *q){
+    atomic_fetch_add_explicit(&q->referencias,1,memory_order_relaxed);
+}
+
+/**
+ * @brief Devolve uma referencia a um quadro, liberando-o na ultima.
+ * @param q O quadro.
+ */
+void soltarQuadro (Quadro *q){
+    if(atomic_fetch_sub_explicit(&q->referencias,1,memory_order_acq_rel)==1)   free(q);
+}
+
+/**
+ * @brief Prepara uma sala vazia, sem rodada.
+ * @param s A sala.
+ * @param nome O nome da sala.
+ */
+void iniciarSala (Sala *s, const char *nome){
+    memset(s,0,sizeof(*s));
+    strncpy(s->nome,nome,TAM_NOME_SALA-1);
+    s->vencedor=-1;
+}
+
+/**
+ * @brief Libera os membros de uma sala.
+ * @param s A sala.
+ */
+void destruirSala (Sala *s){
+    free(s->membros);
+    memset(s,0,sizeof(*s));
+}
+
+/**
+ * @brief Inicia uma nova rodada; todos os membros voltam ao jogo com todas as vidas.
+ * @param s A sala.
+ * @param d O dicionario (deve continuar aberto ate a proxima rodada).
+ * @param palavra O indice da palavra secreta.
+ * @return 0 em caso de sucesso, -1 se o indice for invalido.
+ */
+int novaRodada (Sala *s, const Dicionario *d, uint32_t palavra){
+    int i;
+    if(iniciarSessaoCompacta(&s->rodada,d,palavra,0)<0) return -1;
+    s->dicionario=d;
+    s->numeroRodada++;
+    s->vencedor=-1;
+    for(i=0;i<s->numMembros;i++){
+        s->membros[i].letras=0;
+        s->membros[i].vidas=VIDAS;
+        s->membros[i].estado=SESSAO_EM_JOGO;
+    }
+    s->emJogo=s->numMembros;
+    return 0;
+}
+
+/**
+ * @brief Acrescenta um membro a sala.
+ * @param s A sala.
+ * @param dono Quem recebe os quadros do membro.
+ * @param nome O nome do jogador.
+ * @return O indice do membro, ou -1 em caso de falta de memoria.
+ */
+int entrarSala (Sala *s, void *dono, const char *nome){
+    MembroSala *membros,*m;
+    if(s->numMembros==s->capacidade){
+        membros=realloc(s->membros,(s->capacidade>0?2*s->capacidade:8)*sizeof(MembroSala));
+        if(membros==NULL)   return -1;
+        s->membros=membros;
+        s->capacidade=s->capacidade>0?2*s->capacidade:8;
+    }
+    m=&s->membros[s->numMembros];
+    m->dono=dono;
+    m->nome=nome;
+    m->letras=0;
+    m->vidas=VIDAS;
+    // Depois do fim da rodada, o novo membro espera a proxima.
+    m->estado=s->numeroRodada>0&&s->rodada.estado==SESSAO_EM_JOGO?SESSAO_EM_JOGO:SESSAO_DERROTA;
+    if(m->estado==SESSAO_EM_JOGO)   s->emJogo++;
+    return s->numMembros++;
+}
+
+/**
+ * @brief Encerra a rodada, com ou sem vencedor.
+ * @param s A sala.
+ * @param vencedor O membro que completou a palavra, ou -1.
+ */
+static void encerrarRodada (Sala *s, int vencedor){
+    int i;
+    s->vencedor=vencedor;
+    s->rodada.estado=vencedor>=0?SESSAO_VITORIA:SESSAO_DERROTA;
+    for(i=0;i<s->numMembros;i++)
+        if(s->membros[i].estado==SESSAO_EM_JOGO)    s->membros[i].estado=i==vencedor?SESSAO_VITORIA:SESSAO_DERROTA;
+    s->emJogo=0;
+}
+
+/**
+ * @brief Retira um membro da sala.
+ * @param s A sala.
+ * @param membro O indice do membro.
+ * @param eventos Recebe EVENTO_FIM se a saida encerrou a rodada, ou 0.
+ * @return O dono do membro que mudou de indice, ou NULL se nenhum mudou.
+ */
+void *sairSala (Sala *s, int membro, int *eventos){
+    int ultimo=s->numMembros-1;
+    *eventos=0;
+    if(s->membros[membro].estado==SESSAO_EM_JOGO&&--s->emJogo==0&&s->rodada.estado==SESSAO_EM_JOGO){
+        s->membros[membro].estado=SESSAO_DERROTA;
+        encerrarRodada(s,-1);
+        *eventos=EVENTO_FIM;
+    }
+    if(s->vencedor==membro) s->vencedor=-1;
+    else if(s->vencedor==ultimo)    s->vencedor=membro;
+    s->numMembros--;
+    if(membro==ultimo)  return NULL;
+    s->membros[membro]=s->membros[ultimo];
+    return s->membros[membro].dono;
+}
+
+/**
+ * @brief Atualiza o membro e a rodada depois de um palpite.
+ * @param s A sala.
+ * @param membro O membro que deu o palpite.
+ * @param eventos Recebe EVENTO_ELIMINADO e EVENTO_FIM, quando for o caso.
+ */
+static void atualizarSala (Sala *s, int membro, int *eventos){
+    MembroSala *m = &s->membros[membro];
+    if(s->rodada.faltam==0){
+        encerrarRodada(s,membro);
+        *eventos|=EVENTO_FIM;
+    }
+    else if(m->vidas<=0){
+        m->estado=SESSAO_DERROTA;
+        *eventos|=EVENTO_ELIMINADO;
+        if(--s->emJogo==0){
+            encerrarRodada(s,-1);
+            *eventos|=EVENTO_FIM;
+        }
+    }
+}
+
+/**
+ * @brief Aplica o palpite de letra de um membro.
+ *
+ * Mesmas penalidades de chutarLetra. Uma letra que outro membro ja
+ * revelou conta como acerto, sem revelar nada de novo.
+ *
+ * @param s A sala.
+ * @param membro O indice do membro.
+ * @param letra A letra chutada.
+ * @param eventos Recebe os EVENTO_* causados pelo palpite.
+ * @return O efeito do palpite para o membro.
+ */
+ResultadoJogada chutarLetraSala (Sala *s, int membro, char letra, int *eventos){
+    MembroSala *m = &s->membros[membro];
+    ResultadoJogada r;
+    uint64_t novas;
+    uint32_t bit;
+    *eventos=0;
+    if(m->estado!=SESSAO_EM_JOGO||s->rodada.estado!=SESSAO_EM_JOGO)   return JOGADA_ENCERRADA;
+    if(!isascii((unsigned char)letra)||!isalpha((unsigned char)letra))  return JOGADA_INVALIDA;
+    bit=1u<<(toupper((unsigned char)letra)-'A');
+    if(m->letras&bit){
+        m->vidas-=PENALIDADE_REPETIDA;
+        r=JOGADA_REPETIDA;
+    }
+    else{
+        m->letras|=bit;
+        novas=posicoesCompacta(&s->rodada,s->dicionario,letra);
+        if(novas==0){
+            m->vidas--;
+            r=JOGADA_ERRO;
+        }
+        else{
+            novas&=~s->rodada.reveladas;
+            if(novas!=0){
+                s->rodada.reveladas|=novas;
+                s->rodada.faltam-=__builtin_popcountll(novas);
+                *eventos|=EVENTO_REVELOU;
+            }
+            r=JOGADA_ACERTO;
+        }
+    }
+    atualizarSala(s,membro,eventos);
+    return r;
+}
+
+/**
+ * @brief Aplica o palpite da palavra inteira de um membro.
+ *
+ * Mesmas penalidades de chutarPalavra; o acerto revela a palavra e
+ * encerra a rodada.
+ *
+ * @param s A sala.
+ * @param membro O indice do membro.
+ * @param palavra A palavra chutada.
+ * @param eventos Recebe os EVENTO_* causados pelo palpite.
+ * @return O efeito do palpite para o membro.
+ */
+ResultadoJogada chutarPalavraSala (Sala *s, int membro, const char *palavra, int *eventos){
+    MembroSala *m = &s->membros[membro];
+    const char *p;
+    int n,i;
+    *eventos=0;
+    if(m->estado!=SESSAO_EM_JOGO||s->rodada.estado!=SESSAO_EM_JOGO)   return JOGADA_ENCERRADA;
+    if(palavra==NULL||palavra[0]=='\0') return JOGADA_INVALIDA;
+    p=obterPalavra(s->dicionario,(int)s->rodada.palavra,&n);
+    if(strlen(palavra)==(size_t)n&&strncasecmp(p,palavra,n)==0){
+        for(i=0;i<n;i++)    s->rodada.reveladas|=1ULL<<i;
+        s->rodada.faltam=0;
+        *eventos|=EVENTO_REVELOU;
+        atualizarSala(s,membro,eventos);
+        return JOGADA_ACERTO;
+    }
+    m->vidas-=PENALIDADE_PALAVRA;
+    atualizarSala(s,membro,eventos);
+    return JOGADA_ERRO;
+}
+
+/**
+ * @brief Monta a forca compartilhada e a palavra secreta da rodada.
+ * @param s A sala (com uma rodada iniciada).
+ * @param palavraNaForca Recebe a forca (pelo menos TAM_MAX_MASCARA+1 bytes).
+ * @param palavra Recebe a palavra secreta (pode ser NULL; pelo menos TAM_MAX_MASCARA+1 bytes).
+ */
+void montarForcaSala (const Sala *s, char *palavraNaForca, char *palavra){
+    montarForcaCompacta(&s->rodada,s->dicionario,palavraNaForca,palavra);
+}
+
+/**
+ * @brief Copia o nome de um membro para um quadro (sem espacos, que separam os campos).
+ * @param s A sala.
+ * @param membro O indice do membro, ou -1.
+ * @param destino Recebe o nome (pelo menos TAM_MAX_PALAVRA bytes); "-" se nao houver membro.
+ */
+static void nomeDoMembro (const Sala *s, int membro, char *destino){
+    const char *nome = membro>=0?s->membros[membro].nome:"-";
+    int i;
+    if(nome==NULL||nome[0]=='\0')   nome="anonimo";
+    for(i=0;nome[i]!='\0'&&i<TAM_MAX_PALAVRA-1;i++) destino[i]=nome[i]==' '?'_':nome[i];
+    destino[i]='\0';
+}
+
+/**
+ * @brief Acrescenta texto formatado ao texto de um quadro em montagem.
+ * @param texto O texto.
+ * @param n Os bytes ja escritos, ou -1 se o texto ja passou do limite.
+ * @param formato O formato, como em printf.
+ * @return Os bytes escritos depois do acrescimo, ou -1 se o texto nao coube.
+ */
+static int acrescentarTexto (char *texto, int n, const char *formato, ...){
+    va_list args;
+    int r;
+    if(n<0) return -1;
+    va_start(args,formato);
+    r=vsnprintf(texto+n,TAM_MAX_QUADRO-n,formato,args);
+    va_end(args);
+    return r<0||r>=TAM_MAX_QUADRO-n?-1:n+r;
+}
+
+/**
+ * @brief Codifica em um unico quadro os eventos de uma mudanca da sala.
+ * @param s A sala.
+ * @param membro O membro que causou a mudanca, ou -1 (so para EVENTO_RODADA e EVENTO_FIM).
+ * @param letra A letra chutada, ou 0 para um palpite de palavra.
+ * @param eventos Os EVENTO_* da mudanca.
+ * @return O quadro, com a referencia do criador, ou NULL se nao houver eventos ou memoria
+ *         ou se o texto passar de TAM_MAX_QUADRO.
+ */
+Quadro *codificarEventos (const Sala *s, int membro, char letra, int eventos){
+    char texto[TAM_MAX_QUADRO],jogador[TAM_MAX_PALAVRA],forca[TAM_MAX_MASCARA+1],palavra[TAM_MAX_MASCARA+1];
+    int n=0;
+    if(eventos==0)  return NULL;
+    nomeDoMembro(s,membro,jogador);
+    if(s->numeroRodada>0)   montarForcaSala(s,forca,palavra);
+    else    forca[0]=palavra[0]='\0';
+    if(eventos&EVENTO_ENTROU)
+        n=acrescentarTexto(texto,n,"SALA ENTROU %s %d\n",jogador,s->numMembros);
+    if(eventos&EVENTO_SAIU)
+        n=acrescentarTexto(texto,n,"SALA SAIU %s %d\n",jogador,s->numMembros-1);
+    if(eventos&EVENTO_RODADA)
+        n=acrescentarTexto(texto,n,"SALA RODADA %u %s\n",s->numeroRodada,forca);
+    if(eventos&EVENTO_REVELOU)
+        n=acrescentarTexto(texto,n,"SALA REVELOU %s %c %s\n",jogador,
+                           letra!=0?toupper((unsigned char)letra):'-',forca);
+    if(eventos&EVENTO_ELIMINADO)
+        n=acrescentarTexto(texto,n,"SALA ELIMINADO %s\n",jogador);
+    if(eventos&EVENTO_FIM){
+        nomeDoMembro(s,s->vencedor,jogador);
+        n=acrescentarTexto(texto,n,"SALA FIM %s %s\n",jogador,palavra);
+    }
+    if(n<0) return NULL;
+    return criarQuadro("%s",texto);
+}
+
+/**
+ * @brief Entrega um quadro a todos os membros da sala.
+ * @param s A sala.
+ * @param q O quadro.
+ * @param entregar Chamada uma vez por membro.
+ * @return O numero de entregas aceitas (entregar retornou 0).
+ */
+int difundirQuadro (const Sala *s, Quadro *q, int (*entregar)(void *dono, Quadro *q)){
+    int i,aceitas=0;
+    for(i=0;i<s->numMembros;i++)
+        if(entregar(s->membros[i].dono,q)==0)   aceitas++;
+    return aceitas;
+}
+
+#ifdef __linux__
+
+/**
+ * @brief Poe um quadro na fila, retendo-o.
+ * @param f A fila.
+ * @param q O quadro.
+ * @param tamSaida Bytes do buffer de saida que devem sair antes do quadro.
+ * @return 0 em caso de sucesso, -1 se a fila estiver cheia.
+ */
+int enfileirarQuadro (FilaQuadros *f, Quadro *q, int tamSaida){
+    int k;
+    if(f->quantidade==MAX_QUADROS_PENDENTES)    return -1;
+    k=(f->primeiro+f->quantidade)%MAX_QUADROS_PENDENTES;
+    f->quadros[k]=q;
+    f->posicoes[k]=tamSaida;
+    f->quantidade++;
+    reterQuadro(q);
+    return 0;
+}
+
+/**
+ * @brief Monta os iovecs do proximo envio, na ordem em que o texto foi produzido.
+ * @param f A fila (pode ser NULL).
+ * @param saida O buffer de saida.
+ * @param tamSaida Bytes no buffer de saida.
+ * @param iov Recebe os trechos (pelo menos 2*MAX_QUADROS_PENDENTES+1).
+ * @return O numero de trechos.
+ */
+int montarEnvio (const FilaQuadros *f, char *saida, int tamSaida, struct iovec *iov){
+    int i,k,pos=0,n=0,inicio;
+    for(i=0;f!=NULL&&i<f->quantidade;i++){
+        k=(f->primeiro+i)%MAX_QUADROS_PENDENTES;
+        // O texto proprio produzido antes do quadro sai antes dele.
+        if(f->posicoes[k]>pos){
+            iov[n].iov_base=saida+pos;
+            iov[n++].iov_len=f->posicoes[k]-pos;
+            pos=f->posicoes[k];
+        }
+        inicio=i==0?f->enviado:0;
+        iov[n].iov_base=f->quadros[k]->dados+inicio;
+        iov[n++].iov_len=f->quadros[k]->tamanho-inicio;
+    }
+    if(tamSaida>pos){
+        iov[n].iov_base=saida+pos;
+        iov[n++].iov_len=tamSaida-pos;
+    }
+    return n;
+}
+
+/**
+ * @brief Descarta o que foi enviado, soltando os quadros ja enviados por inteiro.
+ * @param f A fila (pode ser NULL).
+ * @param enviados Bytes aceitos pelo socket.
+ * @param tamSaida Bytes no buffer de saida.
+ * @return Quantos bytes do inicio do buffer de saida foram enviados.
+ */
+int consumirEnvio (FilaQuadros *f, size_t enviados, int tamSaida){
+    int usados=0,i,k;
+    size_t resto;
+    while(f!=NULL&&f->quantidade>0&&enviados>0){
+        k=f->primeiro;
+        resto=(size_t)(f->posicoes[k]-usados);
+        if(enviados<resto){
+            usados+=(int)enviados;
+            enviados=0;
+            break;
+        }
+        usados+=(int)resto;
+        enviados-=resto;
+        resto=(size_t)(f->quadros[k]->tamanho-f->enviado);
+        if(enviados<resto){
+            f->enviado+=(int)enviados;
+            enviados=0;
+            break;
+        }
+        enviados-=resto;
+        f->enviado=0;
+        soltarQuadro(f->quadros[k]);
+        f->primeiro=(k+1)%MAX_QUADROS_PENDENTES;
+        f->quantidade--;
+    }
+    usados+=(int)enviados;
+    if(usados>tamSaida) usados=tamSaida;
+    // As posicoes dos quadros restantes passam a contar a partir do novo inicio do buffer.
+    for(i=0;f!=NULL&&i<f->quantidade;i++)   f->posicoes[(f->primeiro+i)%MAX_QUADROS_PENDENTES]-=usados;
+    return usados;
+}
+
+/**
+ * @brief Solta todos os quadros da fila.
+ * @param f A fila.
+ */
+void esvaziarFila (FilaQuadros *f){
+    while(f->quantidade>0){
+        soltarQuadro(f->quadros[f->primeiro]);
+        f->primeiro=(f->primeiro+1)%MAX_QUADROS_PENDENTES;
+        f->quantidade--;
+    }
+    f->enviado=0;
+}
+
+#endif
\ No newline at end of file
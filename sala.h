@@ -0,0 +1,266 @@
+/**
+ * @file sala.h
+ * @brief Arquivo de cabecalho das salas: varios jogadores disputando a mesma palavra.
+ *
+ * Uma sala tem uma rodada (SessaoCompacta) com a palavra secreta e as
+ * posicoes ja reveladas, compartilhadas por todos os membros. Cada membro
+ * tem as suas vidas e as suas letras utilizadas; uma letra acertada por
+ * um membro aparece na forca de todos. Vence a rodada quem completa a
+ * palavra (ou a acerta inteira); quem fica sem vidas e eliminado, e a
+ * rodada termina sem vencedor se todos forem eliminados.
+ *
+ * Cada mudanca do estado compartilhado e codificada uma unica vez em um
+ * Quadro com contador de referencias e entregue a todos os membros sem
+ * copias: a fila de saida de cada membro guarda apenas o ponteiro, e o
+ * envio aponta o iovec direto para os bytes do quadro. O quadro e liberado
+ * quando o ultimo membro termina de envia-lo.
+ *
+ * Uma sala nao e protegida contra uso simultaneo: no servidor, cada sala
+ * pertence a uma thread de trabalho, e as conexoes que entram nela passam
+ * para essa thread.
+ */
+
+#ifndef SALA_H
+#define SALA_H
+
+#include <stdatomic.h>
+#include "forca.h"
+#include "dicionario.h"
+#include "sessao.h"
+
+// Tamanho maximo do nome de uma sala (com o '\0').
+#define TAM_NOME_SALA 32
+// Tamanho maximo do texto de um quadro.
+#define TAM_MAX_QUADRO 512
+// Quadros que podem aguardar envio em uma fila (um cliente mais lento e desconectado).
+#define MAX_QUADROS_PENDENTES 64
+
+// Eventos que mudam o estado compartilhado da sala (cada um vira uma linha do quadro).
+#define EVENTO_REVELOU 1    // Novas posicoes da palavra foram reveladas.
+#define EVENTO_ELIMINADO 2  // O membro ficou sem vidas.
+#define EVENTO_FIM 4        // A rodada terminou.
+#define EVENTO_ENTROU 8     // O membro entrou na sala.
+#define EVENTO_SAIU 16      // O membro vai sair da sala.
+#define EVENTO_RODADA 32    // Uma nova rodada comecou.
+
+/**
+ * @struct Quadro
+ * @brief Texto de um evento, compartilhado pelas filas de todos os membros.
+ */
+typedef struct{
+    atomic_int referencias;     // Filas (e o criador) que ainda usam o quadro.
+    int tamanho;                // Bytes de texto.
+    char dados[];               // O texto, terminado em '\n' (sem '\0').
+} Quadro;
+
+/**
+ * @struct MembroSala
+ * @brief Estado de um jogador dentro da sala.
+ */
+typedef struct{
+    void *dono;             // Quem recebe os quadros do membro (a conexao, no servidor).
+    const char *nome;       // Nome do jogador (deve continuar valido enquanto ele estiver na sala).
+    uint32_t letras;        // Letras ja utilizadas pelo membro nesta rodada (bit 0 = A).
+    int8_t vidas;           // Vidas restantes do membro nesta rodada.
+    uint8_t estado;         // Situacao do membro na rodada (EstadoSessao).
+} MembroSala;
+
+/**
+ * @struct Sala
+ * @brief Rodada compartilhada e membros de uma sala.
+ */
+typedef struct{
+    char nome[TAM_NOME_SALA];
+    const Dicionario *dicionario;   // Dicionario da rodada atual.
+    SessaoCompacta rodada;      // Palavra, posicoes reveladas e situacao da rodada.
+    unsigned numeroRodada;      // 0 enquanto nenhuma rodada comecou.
+    int vencedor;               // Membro que venceu a rodada encerrada, ou -1.
+    MembroSala *membros;
+    int numMembros;
+    int capacidade;
+    int emJogo;                 // Membros ainda em jogo na rodada.
+} Sala;
+
+/**
+ * @brief Cria um quadro com texto formatado e uma referencia (a do criador).
+ * @param formato O formato, como em printf.
+ * @return O quadro, ou NULL se faltar memoria ou o texto passar de TAM_MAX_QUADRO.
+ */
+Quadro *criarQuadro (const char *formato, ...) __attribute__((format(printf,1,2)));
+
+/**
+ * @brief Conta mais uma referencia a um quadro.
+ * @param q O quadro.
+ */
+void reterQuadro (Quadro *q);
+
+/**
+ * @brief Devolve uma referencia a um quadro, liberando-o na ultima.
+ * @param q O quadro.
+ */
+void soltarQuadro (Quadro *q);
+
+/**
+ * @brief Prepara uma sala vazia, sem rodada.
+ * @param s A sala.
+ * @param nome O nome da sala.
+ */
+void iniciarSala (Sala *s, const char *nome);
+
+/**
+ * @brief Libera os membros de uma sala.
+ * @param s A sala.
+ */
+void destruirSala (Sala *s);
+
+/**
+ * @brief Inicia uma nova rodada; todos os membros voltam ao jogo com todas as vidas.
+ * @param s A sala.
+ * @param d O dicionario (deve continuar aberto ate a proxima rodada).
+ * @param palavra O indice da palavra secreta.
+ * @return 0 em caso de sucesso, -1 se o indice for invalido.
+ */
+int novaRodada (Sala *s, const Dicionario *d, uint32_t palavra);
+
+/**
+ * @brief Acrescenta um membro a sala.
+ *
+ * Durante uma rodada, o membro entra no jogo com todas as vidas; depois
+ * do fim, espera a proxima.
+ *
+ * @param s A sala.
+ * @param dono Quem recebe os quadros do membro.
+ * @param nome O nome do jogador.
+ * @return O indice do membro, ou -1 em caso de falta de memoria.
+ */
+int entrarSala (Sala *s, void *dono, const char *nome);
+
+/**
+ * @brief Retira um membro da sala.
+ *
+ * O ultimo membro passa a ocupar o indice do que saiu. Se o membro era o
+ * ultimo ainda em jogo, a rodada termina sem vencedor.
+ *
+ * @param s A sala.
+ * @param membro O indice do membro.
+ * @param eventos Recebe EVENTO_FIM se a saida encerrou a rodada, ou 0.
+ * @return O dono do membro que mudou de indice, ou NULL se nenhum mudou.
+ */
+void *sairSala (Sala *s, int membro, int *eventos);
+
+/**
+ * @brief Aplica o palpite de letra de um membro.
+ * @param s A sala.
+ * @param membro O indice do membro.
+ * @param letra A letra chutada.
+ * @param eventos Recebe os EVENTO_* causados pelo palpite.
+ * @return O efeito do palpite para o membro.
+ */
+ResultadoJogada chutarLetraSala (Sala *s, int membro, char letra, int *eventos);
+
+/**
+ * @brief Aplica o palpite da palavra inteira de um membro.
+ * @param s A sala.
+ * @param membro O indice do membro.
+ * @param palavra A palavra chutada.
+ * @param eventos Recebe os EVENTO_* causados pelo palpite.
+ * @return O efeito do palpite para o membro.
+ */
+ResultadoJogada chutarPalavraSala (Sala *s, int membro, const char *palavra, int *eventos);
+
+/**
+ * @brief Monta a forca compartilhada e a palavra secreta da rodada.
+ * @param s A sala (com uma rodada iniciada).
+ * @param palavraNaForca Recebe a forca (pelo menos TAM_MAX_MASCARA+1 bytes).
+ * @param palavra Recebe a palavra secreta (pode ser NULL; pelo menos TAM_MAX_MASCARA+1 bytes).
+ */
+void montarForcaSala (const Sala *s, char *palavraNaForca, char *palavra);
+
+/**
+ * @brief Codifica em um unico quadro os eventos de uma mudanca da sala.
+ *
+ * Linhas, na ordem: SALA ENTROU <jogador> <membros>, SALA SAIU <jogador>
+ * <membros restantes>, SALA RODADA <numero> <forca>, SALA REVELOU
+ * <jogador> <letra ou -> <forca>, SALA ELIMINADO <jogador> e SALA FIM
+ * <vencedor ou -> <palavra>.
+ *
+ * @param s A sala.
+ * @param membro O membro que causou a mudanca, ou -1 (so para EVENTO_RODADA e EVENTO_FIM).
+ * @param letra A letra chutada, ou 0 para um palpite de palavra.
+ * @param eventos Os EVENTO_* da mudanca.
+ * @return O quadro, com a referencia do criador, ou NULL se nao houver eventos ou memoria
+ *         ou se o texto passar de TAM_MAX_QUADRO.
+ */
+Quadro *codificarEventos (const Sala *s, int membro, char letra, int eventos);
+
+/**
+ * @brief Entrega um quadro a todos os membros da sala.
+ *
+ * A funcao de entrega recebe o dono de cada membro e deve reter o quadro
+ * se o guardar; a referencia do criador continua com quem chamou.
+ *
+ * @param s A sala.
+ * @param q O quadro.
+ * @param entregar Chamada uma vez por membro.
+ * @return O numero de entregas aceitas (entregar retornou 0).
+ */
+int difundirQuadro (const Sala *s, Quadro *q, int (*entregar)(void *dono, Quadro *q));
+
+#ifdef __linux__
+
+#include <sys/uio.h>
+
+/**
+ * @struct FilaQuadros
+ * @brief Quadros que aguardam envio em uma conexao, intercalados com o buffer de saida.
+ *
+ * O texto proprio da conexao (respostas aos comandos) continua em um
+ * buffer contiguo; cada quadro guarda quantos bytes desse buffer devem
+ * sair antes dele, de modo que a ordem em que tudo foi produzido e
+ * mantida sem copiar os quadros.
+ */
+typedef struct{
+    Quadro *quadros[MAX_QUADROS_PENDENTES];
+    int posicoes[MAX_QUADROS_PENDENTES];    // Bytes do buffer de saida que vao antes de cada quadro.
+    int primeiro;               // Posicao do primeiro quadro no anel.
+    int quantidade;             // Quadros na fila.
+    int enviado;                // Bytes do primeiro quadro ja enviados.
+} FilaQuadros;
+
+/**
+ * @brief Poe um quadro na fila, retendo-o.
+ * @param f A fila.
+ * @param q O quadro.
+ * @param tamSaida Bytes do buffer de saida que devem sair antes do quadro.
+ * @return 0 em caso de sucesso, -1 se a fila estiver cheia.
+ */
+int enfileirarQuadro (FilaQuadros *f, Quadro *q, int tamSaida);
+
+/**
+ * @brief Monta os iovecs do proximo envio, na ordem em que o texto foi produzido.
+ * @param f A fila (pode ser NULL).
+ * @param saida O buffer de saida.
+ * @param tamSaida Bytes no buffer de saida.
+ * @param iov Recebe os trechos (pelo menos 2*MAX_QUADROS_PENDENTES+1).
+ * @return O numero de trechos.
+ */
+int montarEnvio (const FilaQuadros *f, char *saida, int tamSaida, struct iovec *iov);
+
+/**
+ * @brief Descarta o que foi enviado, soltando os quadros ja enviados por inteiro.
+ * @param f A fila (pode ser NULL).
+ * @param enviados Bytes aceitos pelo socket.
+ * @param tamSaida Bytes no buffer de saida.
+ * @return Quantos bytes do inicio do buffer de saida foram enviados.
+ */
+int consumirEnvio (FilaQuadros *f, size_t enviados, int tamSaida);
+
+/**
+ * @brief Solta todos os quadros da fila.
+ * @param f A fila.
+ */
+void esvaziarFila (FilaQuadros *f);
+
+#endif
+
+#endif
\ No newline at end of file
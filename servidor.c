@@ -0,0 +1,1424 @@
+/**
+ * @file servidor.c
+ * @brief Implementacao do modo servidor com epoll.
+ *
+ * Cada thread de trabalho executa um laco de eventos independente: aceita
+ * conexoes, le linhas de comando, aplica os palpites na sessao da conexao
+ * e responde, sem nunca bloquear. As regras sao as mesmas de main.c,
+ * pois ambos usam o motor de partidas (sessao.h).
+ */
+
+// Necessario para accept4().
+#define _GNU_SOURCE
+#include <stdio.h>
+#include "forca.h"
+#include "servidor.h"
+
+#ifdef __linux__
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "dicionario.h"
+#include "sessao.h"
+#include "agenda.h"
+#include "arena.h"
+#include "perfis.h"
+#include "metricas.h"
+#include "recarga.h"
+#include "sala.h"
+#include "instantaneo.h"
+
+// Numero maximo de eventos tratados por chamada a epoll_wait.
+#define MAX_EVENTOS 256
+// Tamanho do buffer de saida de cada conexao.
+#define TAM_SAIDA 4096
+// Pausas do modo com ritmo, as mesmas do jogo no terminal (contagem regressiva e leitura da mensagem).
+#define PAUSA_NOVO (4*DELAY_1s)
+#define PAUSA_PALPITE DELAY_3s
+// Resolucao da agenda de pausas, em ms.
+#define RESOLUCAO_AGENDA 10
+// Baldes da tabela de salas (potencia de 2).
+#define TAM_TABELA_SALAS 1024
+
+struct Trabalhador;
+
+/**
+ * @struct SalaServidor
+ * @brief Uma sala e a thread de trabalho que a conduz.
+ */
+typedef struct SalaServidor{
+    Sala sala;
+    struct Trabalhador *dono;       // Unica thread que le ou altera a sala.
+    int reservas;                   // Conexoes a caminho da thread dona (protegido por travaSalas).
+    VersaoDicionario *versao;       // Versao das palavras da rodada, com recarga (NULL sem ela).
+    struct SalaServidor *proxima;   // Proxima sala no mesmo balde.
+} SalaServidor;
+
+/**
+ * @struct Conexao
+ * @brief Estado de um cliente conectado.
+ */
+typedef struct Conexao{
+    int fd;                         // Socket do cliente.
+    char entrada[TAM_MAX_LINHA];    // Bytes recebidos ainda sem '\n'.
+    int tamEntrada;                 // Quantidade de bytes em entrada.
+    char saida[TAM_SAIDA];          // Respostas ainda nao enviadas.
+    int tamSaida;                   // Quantidade de bytes em saida.
+    int esperandoEscrita;           // 1 se EPOLLOUT esta habilitado.
+    uint32_t sessao;                // Partida atual na arena da thread (0 = nenhuma).
+    VersaoDicionario *versao;       // Versao das palavras da partida atual, com recarga (NULL sem ela).
+    uint32_t numero;                // Numero da conexao na thread (identifica o jogador).
+    int encerrar;                   // 1 para fechar apos enviar a saida.
+    int pausada;                    // 1 se as respostas aguardam o fim de uma pausa.
+    Aleatorio aleatorio;            // Gerador do sorteio das palavras desta conexao.
+    EventoAgenda pausa;             // Evento que encerra a pausa.
+    struct Trabalhador *trabalhador;    // A thread dona da conexao.
+    char nome[TAM_MAX_PALAVRA];     // Nome informado pelo comando NOME.
+    SalaServidor *sala;             // Sala em que a conexao joga, ou NULL.
+    int membro;                     // Indice da conexao entre os membros da sala.
+    FilaQuadros *fila;              // Quadros das salas ainda nao enviados (alocada na primeira sala).
+    SalaServidor *destino;          // Sala de outra thread para onde a conexao esta indo.
+    char *pendente;                 // Bytes recebidos e nao executados antes da mudanca de thread.
+    int tamPendente;
+    struct Conexao *proximaChegada; // Proxima conexao na fila de chegada da thread dona.
+    struct Conexao *anteriorEnvio;  // Vizinhas na lista de conexoes com quadros a enviar.
+    struct Conexao *proximoEnvio;
+    int marcadaEnvio;               // 1 se a conexao esta nessa lista.
+    uint64_t chave;                 // Chave de retomada da partida da conexao (instantaneo.h).
+    struct Conexao *anteriorAberta; // Vizinhas na lista de conexoes abertas da thread.
+    struct Conexao *proximaAberta;
+} Conexao;
+
+/**
+ * @struct Trabalhador
+ * @brief Dados de uma thread de trabalho.
+ */
+typedef struct Trabalhador{
+    const ConfigServidor *config;
+    Dicionario *dicionario;     // As palavras, quando nao ha recarga.
+    Recarga *recarga;           // A recarga do arquivo de palavras, ou NULL.
+    int indice;                 // Indice da thread como leitora da recarga.
+    int escuta;                 // Socket de escuta usado por esta thread.
+    int epoll;                  // Instancia epoll da thread.
+    uint64_t semente;           // Semente base dos geradores das conexoes desta thread.
+    uint64_t conexoes;          // Conexoes ja aceitas (numero do fluxo da proxima).
+    Agenda agenda;              // Pausas pendentes das conexoes desta thread.
+    Arena sessoes;              // Partidas (SessaoCompacta) das conexoes desta thread.
+    int aviso;                  // eventfd que acorda a thread quando chegam conexoes de outras.
+    pthread_mutex_t travaChegadas;
+    Conexao *chegadas;          // Conexoes vindas de outras threads (protegido por travaChegadas).
+    Conexao *paraEnviar;        // Conexoes que receberam quadros desde o ultimo envio.
+    Conexao *abertas;           // Todas as conexoes da thread (percorridas pelo instantaneo).
+    Aleatorio chaves;           // Gerador das chaves de retomada.
+    pthread_t thread;
+} Trabalhador;
+
+// Sinaliza para todas as threads que o servidor deve parar.
+static volatile sig_atomic_t pararServidor=0;
+// Tabela das salas abertas, por nome. So a procura e a criacao usam a trava.
+static pthread_mutex_t travaSalas=PTHREAD_MUTEX_INITIALIZER;
+static SalaServidor *salas[TAM_TABELA_SALAS];
+// Pedido de instantaneo (SIGUSR1), atendido pela thread principal.
+static volatile sig_atomic_t pedidoInstantaneo=0;
+// Pausa das threads de trabalho durante o fork do instantaneo, e o fim delas.
+static atomic_int pausarTrabalhadores, pararTrabalhadores;
+static pthread_barrier_t barreiraInstantaneo;
+// Instantaneo lido na inicializacao e as partidas dele ja retomadas (uma marca por partida).
+static Instantaneo anterior;
+static atomic_uchar *retomadas;
+
+/**
+ * @brief Trata SIGINT/SIGTERM pedindo o encerramento do servidor.
+ * @param sinal O sinal recebido.
+ */
+static void tratarSinal (int sinal){
+    (void)sinal;
+    pararServidor=1;
+}
+
+/**
+ * @brief Trata SIGUSR1 pedindo um instantaneo das partidas.
+ * @param sinal O sinal recebido.
+ */
+static void pedirInstantaneo (int sinal){
+    (void)sinal;
+    pedidoInstantaneo=1;
+}
+
+/**
+ * @brief Cria um socket de escuta TCP com SO_REUSEPORT.
+ * @param porta A porta TCP.
+ * @return O socket, ou -1 em caso de erro.
+ */
+static int criarEscutaTCP (int porta){
+    int fd,um=1;
+    struct sockaddr_in endereco;
+    fd=socket(AF_INET,SOCK_STREAM|SOCK_NONBLOCK,0);
+    if(fd<0)    return -1;
+    setsockopt(fd,SOL_SOCKET,SO_REUSEADDR,&um,sizeof(um));
+    // Cada thread abre o seu socket na mesma porta: o kernel reparte as conexoes.
+    setsockopt(fd,SOL_SOCKET,SO_REUSEPORT,&um,sizeof(um));
+    memset(&endereco,0,sizeof(endereco));
+    endereco.sin_family=AF_INET;
+    endereco.sin_addr.s_addr=htonl(INADDR_ANY);
+    endereco.sin_port=htons(porta);
+    if(bind(fd,(struct sockaddr *)&endereco,sizeof(endereco))<0||listen(fd,SOMAXCONN)<0){
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Cria o socket de escuta Unix, compartilhado por todas as threads.
+ * @param caminho O caminho do socket no sistema de arquivos.
+ * @return O socket, ou -1 em caso de erro.
+ */
+static int criarEscutaUnix (const char *caminho){
+    int fd;
+    struct sockaddr_un endereco;
+    if(strlen(caminho)>=sizeof(endereco.sun_path))  return -1;
+    fd=socket(AF_UNIX,SOCK_STREAM|SOCK_NONBLOCK,0);
+    if(fd<0)    return -1;
+    memset(&endereco,0,sizeof(endereco));
+    endereco.sun_family=AF_UNIX;
+    strcpy(endereco.sun_path,caminho);
+    unlink(caminho);
+    if(bind(fd,(struct sockaddr *)&endereco,sizeof(endereco))<0||listen(fd,SOMAXCONN)<0){
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Acrescenta texto formatado ao buffer de saida da conexao.
+ * @param c A conexao.
+ * @param formato O formato, como em printf.
+ */
+static void responder (Conexao *c, const char *formato, ...) __attribute__((format(printf,2,3)));
+static void responder (Conexao *c, const char *formato, ...){
+    int n;
+    va_list args;
+    va_start(args,formato);
+    n=vsnprintf(c->saida+c->tamSaida,TAM_SAIDA-c->tamSaida,formato,args);
+    va_end(args);
+    // Um cliente que nao le as respostas e desconectado.
+    if(n<0||n>=TAM_SAIDA-c->tamSaida)   c->encerrar=1;
+    else    c->tamSaida+=n;
+}
+
+/**
+ * @brief Retorna a partida atual de uma conexao.
+ * @param t A thread de trabalho.
+ * @param c A conexao (com c->sessao diferente de 0).
+ * @return A sessao.
+ */
+static SessaoCompacta *sessaoDe (Trabalhador *t, Conexao *c){
+    return enderecoArena(&t->sessoes,c->sessao);
+}
+
+/**
+ * @brief Retorna as palavras da partida atual de uma conexao.
+ * @param t A thread de trabalho.
+ * @param c A conexao.
+ * @return A versao adquirida pela conexao, ou o dicionario da thread sem recarga.
+ */
+static const Dicionario *dicionarioDe (Trabalhador *t, Conexao *c){
+    return c->versao!=NULL?&c->versao->dicionario:t->dicionario;
+}
+
+/**
+ * @brief Acrescenta uma linha de estado ao buffer de saida.
+ * @param c A conexao.
+ * @param prefixo A primeira palavra da resposta.
+ * @param estado A situacao do jogador (EstadoSessao).
+ * @param vidas As vidas restantes.
+ * @param letras As letras ja utilizadas (bit 0 = A).
+ * @param forca A forca.
+ * @param palavra A palavra secreta (so aparece quando a partida termina).
+ */
+static void responderSituacao (Conexao *c, const char *prefixo, int estado, int vidas, uint32_t letras,
+                               const char *forca, const char *palavra){
+    const char *nomesEstado[]={"EM_JOGO","VITORIA","DERROTA"};
+    char usadas[TAM_ALFABETO+1];
+    int i,n=0;
+    for(i=0;i<TAM_ALFABETO;i++)
+        if(letras&(1u<<i))  usadas[n++]='A'+i;
+    if(n==0)    usadas[n++]='-';
+    usadas[n]='\0';
+    if(estado==SESSAO_EM_JOGO)
+        responder(c,"%s %s %d %s %s\n",prefixo,nomesEstado[estado],vidas,forca,usadas);
+    else
+        responder(c,"%s %s %d %s %s %s\n",prefixo,nomesEstado[estado],vidas,forca,usadas,palavra);
+}
+
+/**
+ * @brief Acrescenta a descricao do estado da partida ao buffer de saida.
+ * @param t A thread de trabalho.
+ * @param c A conexao.
+ * @param prefixo A primeira palavra da resposta.
+ */
+static void responderEstado (Trabalhador *t, Conexao *c, const char *prefixo){
+    char forca[TAM_MAX_MASCARA+1],palavra[TAM_MAX_MASCARA+1];
+    SessaoCompacta *s = sessaoDe(t,c);
+    MEDICAO(inicio);
+    INICIAR_MEDICAO(inicio);
+    montarForcaCompacta(s,dicionarioDe(t,c),forca,palavra);
+    responderSituacao(c,prefixo,s->estado,s->vidas,s->letras,forca,palavra);
+    ENCERRAR_MEDICAO(FASE_DESENHO,inicio);
+}
+
+/**
+ * @brief Acrescenta o estado do jogador na rodada da sala ao buffer de saida.
+ *
+ * O formato e o mesmo das partidas individuais, com a forca compartilhada
+ * e as vidas e letras do jogador.
+ *
+ * @param c A conexao (membro de uma sala).
+ * @param prefixo A primeira palavra da resposta.
+ */
+static void responderEstadoSala (Conexao *c, const char *prefixo){
+    char forca[TAM_MAX_MASCARA+1],palavra[TAM_MAX_MASCARA+1];
+    const MembroSala *m = &c->sala->sala.membros[c->membro];
+    MEDICAO(inicio);
+    INICIAR_MEDICAO(inicio);
+    montarForcaSala(&c->sala->sala,forca,palavra);
+    responderSituacao(c,prefixo,m->estado,m->vidas,m->letras,forca,palavra);
+    ENCERRAR_MEDICAO(FASE_DESENHO,inicio);
+}
+
+/**
+ * @brief Poe uma conexao na lista das que tem quadros a enviar.
+ * @param t A thread de trabalho.
+ * @param c A conexao.
+ */
+static void marcarEnvio (Trabalhador *t, Conexao *c){
+    if(c->marcadaEnvio) return;
+    c->marcadaEnvio=1;
+    c->anteriorEnvio=NULL;
+    c->proximoEnvio=t->paraEnviar;
+    if(t->paraEnviar!=NULL) t->paraEnviar->anteriorEnvio=c;
+    t->paraEnviar=c;
+}
+
+/**
+ * @brief Tira uma conexao da lista das que tem quadros a enviar.
+ * @param t A thread de trabalho.
+ * @param c A conexao.
+ */
+static void desmarcarEnvio (Trabalhador *t, Conexao *c){
+    if(!c->marcadaEnvio)    return;
+    if(c->anteriorEnvio!=NULL)  c->anteriorEnvio->proximoEnvio=c->proximoEnvio;
+    else    t->paraEnviar=c->proximoEnvio;
+    if(c->proximoEnvio!=NULL)   c->proximoEnvio->anteriorEnvio=c->anteriorEnvio;
+    c->marcadaEnvio=0;
+}
+
+/**
+ * @brief Escreve no socket o que ele aceitar das respostas e dos quadros pendentes.
+ * @param c A conexao.
+ * @return 0 em caso de sucesso (mesmo que parte fique pendente), -1 se o socket falhou.
+ */
+static int escreverSaida (Conexao *c){
+    struct iovec iov[2*MAX_QUADROS_PENDENTES+1];
+    struct msghdr msg;
+    ssize_t n;
+    int usados;
+    memset(&msg,0,sizeof(msg));
+    msg.msg_iov=iov;
+    // Os quadros das salas saem direto do quadro compartilhado, intercalados com as respostas.
+    while((msg.msg_iovlen=montarEnvio(c->fila,c->saida,c->tamSaida,iov))>0){
+        n=sendmsg(c->fd,&msg,MSG_NOSIGNAL);
+        if(n<0){
+            if(errno==EINTR)    continue;
+            if(errno==EAGAIN||errno==EWOULDBLOCK)   break;
+            return -1;
+        }
+        usados=consumirEnvio(c->fila,(size_t)n,c->tamSaida);
+        memmove(c->saida,c->saida+usados,c->tamSaida-usados);
+        c->tamSaida-=usados;
+    }
+    return 0;
+}
+
+/**
+ * @brief Poe um quadro na fila de um membro (funcao de entrega de difundirQuadro).
+ *
+ * O envio fica para o fim da volta do laco de eventos (enviarPendentes):
+ * fechar uma conexao aqui alteraria os membros da sala durante a entrega.
+ * Com a fila cheia (uma rajada de comandos de outro membro), a fila e
+ * escrita no socket antes de desistir do membro.
+ *
+ * @param dono A conexao do membro.
+ * @param q O quadro.
+ * @return 0 se o quadro foi enfileirado, -1 se a fila estava cheia.
+ */
+static int entregarQuadro (void *dono, Quadro *q){
+    Conexao *c = dono;
+    // Um cliente que nao le os quadros e desconectado, como o que nao le as respostas.
+    if(enfileirarQuadro(c->fila,q,c->tamSaida)<0&&(c->pausada||escreverSaida(c)<0||enfileirarQuadro(c->fila,q,c->tamSaida)<0)){
+        c->encerrar=1;
+        return -1;
+    }
+    marcarEnvio(c->trabalhador,c);
+    return 0;
+}
+
+/**
+ * @brief Entrega um quadro a todos os membros de uma sala e solta a referencia do criador.
+ * @param s A sala.
+ * @param q O quadro (NULL e ignorado).
+ */
+static void difundir (SalaServidor *s, Quadro *q){
+    if(q==NULL) return;
+    difundirQuadro(&s->sala,q,entregarQuadro);
+    soltarQuadro(q);
+}
+
+/**
+ * @brief Calcula o balde de uma sala na tabela (FNV-1a do nome).
+ * @param nome O nome da sala.
+ * @return O balde.
+ */
+static unsigned baldeSala (const char *nome){
+    uint32_t h=2166136261u;
+    for(;*nome!='\0';nome++)   h=(h^(unsigned char)*nome)*16777619u;
+    return h&(TAM_TABELA_SALAS-1);
+}
+
+/**
+ * @brief Procura uma sala pelo nome, criando-a na thread que pediu se ela nao existir.
+ *
+ * Se a sala pertence a outra thread, conta uma reserva: a sala nao e
+ * liberada enquanto a conexao nao chegar a thread dona.
+ *
+ * @param t A thread de trabalho que pediu.
+ * @param nome O nome da sala.
+ * @return A sala, ou NULL em caso de falta de memoria.
+ */
+static SalaServidor *reservarSala (Trabalhador *t, const char *nome){
+    SalaServidor *s;
+    unsigned balde=baldeSala(nome);
+    pthread_mutex_lock(&travaSalas);
+    for(s=salas[balde];s!=NULL&&strcmp(s->sala.nome,nome)!=0;s=s->proxima);
+    if(s==NULL&&(s=calloc(1,sizeof(SalaServidor)))!=NULL){
+        iniciarSala(&s->sala,nome);
+        s->dono=t;
+        s->proxima=salas[balde];
+        salas[balde]=s;
+    }
+    if(s!=NULL&&s->dono!=t) s->reservas++;
+    pthread_mutex_unlock(&travaSalas);
+    return s;
+}
+
+/**
+ * @brief Libera uma sala sem membros e sem conexoes a caminho (chamada pela thread dona).
+ * @param s A sala.
+ */
+static void liberarSalaVazia (SalaServidor *s){
+    SalaServidor **p;
+    int vazia;
+    pthread_mutex_lock(&travaSalas);
+    vazia=s->sala.numMembros==0&&s->reservas==0;
+    if(vazia){
+        for(p=&salas[baldeSala(s->sala.nome)];*p!=s;p=&(*p)->proxima);
+        *p=s->proxima;
+    }
+    pthread_mutex_unlock(&travaSalas);
+    if(!vazia)  return;
+    if(s->versao!=NULL) liberarVersao(s->versao);
+    destruirSala(&s->sala);
+    free(s);
+}
+
+/**
+ * @brief Sorteia a palavra e inicia uma nova rodada da sala.
+ * @param t A thread de trabalho (a dona da sala).
+ * @param s A sala.
+ * @param c A conexao cujo gerador sorteia a palavra.
+ * @return 0 em caso de sucesso, -1 caso contrario.
+ */
+static int iniciarRodada (Trabalhador *t, SalaServidor *s, Conexao *c){
+    const Dicionario *d;
+    // Com recarga, cada rodada usa a versao atual, como cada NOVO das partidas individuais.
+    if(t->recarga!=NULL&&s->versao!=consultarVersao(t->recarga)){
+        if(s->versao!=NULL) liberarVersao(s->versao);
+        s->versao=adquirirVersao(t->recarga);
+    }
+    d=s->versao!=NULL?&s->versao->dicionario:t->dicionario;
+    return novaRodada(&s->sala,d,sortearIntervalo(&c->aleatorio,(uint32_t)d->quantidade));
+}
+
+/**
+ * @brief Grava o resultado da partida encerrada de uma conexao.
+ * @param t A thread de trabalho.
+ * @param c A conexao.
+ */
+static void registrarPartida (Trabalhador *t, Conexao *c){
+    SessaoCompacta *s = sessaoDe(t,c);
+    char palavra[TAM_MAX_MASCARA+1];
+    const char *origem;
+    Jogador j;
+    int n;
+    strcpy(j.nome,c->nome[0]!='\0'?c->nome:"anonimo");
+    j.vidas=s->vidas;
+    origem=obterPalavra(dicionarioDe(t,c),(int)s->palavra,&n);
+    memcpy(palavra,origem,n);
+    palavra[n]='\0';
+    registrarResultado(ARQUIVO_RESULTADOS,palavra,&j);
+}
+
+/**
+ * @brief Encerra como derrota a partida em andamento de uma conexao e grava o resultado.
+ *
+ * Chamada antes de a partida ser trocada (NOVO) ou liberada (SALA): sem
+ * isso, um jogador prestes a perder escaparia da derrota.
+ *
+ * @param t A thread de trabalho.
+ * @param c A conexao.
+ */
+static void abandonarPartida (Trabalhador *t, Conexao *c){
+    SessaoCompacta *s;
+    if(c->sessao==0)    return;
+    s=sessaoDe(t,c);
+    if(s->estado!=SESSAO_EM_JOGO)   return;
+    s->vidas=0;
+    s->estado=SESSAO_DERROTA;
+    if(t->config->registrar)    registrarPartida(t,c);
+}
+
+/**
+ * @brief Poe uma conexao da thread dona em uma sala e avisa os membros.
+ * @param t A thread de trabalho (a dona da sala).
+ * @param c A conexao.
+ * @param s A sala.
+ */
+static void entrarNaSala (Trabalhador *t, Conexao *c, SalaServidor *s){
+    if(c->fila==NULL)   c->fila=calloc(1,sizeof(FilaQuadros));
+    if(c->fila==NULL||(s->sala.numeroRodada==0&&iniciarRodada(t,s,c)<0)||(c->membro=entrarSala(&s->sala,c,c->nome))<0){
+        responder(c,"FALHA sem memoria\n");
+        liberarSalaVazia(s);
+        return;
+    }
+    // A partida individual e abandonada (conta como derrota): a conexao passa a jogar a rodada da sala.
+    if(c->sessao!=0){
+        abandonarPartida(t,c);
+        liberarArena(&t->sessoes,c->sessao);
+        c->sessao=0;
+    }
+    c->sala=s;
+    responderEstadoSala(c,"OK");
+    difundir(s,codificarEventos(&s->sala,c->membro,0,EVENTO_ENTROU));
+}
+
+/**
+ * @brief Tira uma conexao da sua sala e avisa os membros que ficam.
+ * @param c A conexao.
+ */
+static void deixarSala (Conexao *c){
+    SalaServidor *s = c->sala;
+    Conexao *movida;
+    Quadro *q;
+    int eventos;
+    // O quadro e montado antes da saida, enquanto o nome ainda esta entre os membros.
+    q=codificarEventos(&s->sala,c->membro,0,EVENTO_SAIU);
+    movida=sairSala(&s->sala,c->membro,&eventos);
+    if(movida!=NULL)    movida->membro=c->membro;
+    c->sala=NULL;
+    difundir(s,q);
+    difundir(s,codificarEventos(&s->sala,-1,0,eventos));
+    liberarSalaVazia(s);
+}
+
+static void pausarConexao (Trabalhador *t, Conexao *c, int atrasoMs);
+
+// Nomes dos resultados dos palpites no protocolo.
+static const char *nomesResultado[]={"ACERTO","ERRO","REPETIDA","INVALIDA","ENCERRADA"};
+
+/**
+ * @brief Executa um comando de jogo de uma conexao que esta em uma sala.
+ * @param t A thread de trabalho (a dona da sala).
+ * @param c A conexao.
+ * @param linha O comando.
+ * @param argumento O argumento do comando.
+ * @return 1 se o comando foi tratado, 0 se nao e um comando da sala.
+ */
+static int executarComandoSala (Trabalhador *t, Conexao *c, const char *linha, const char *argumento){
+    SalaServidor *s = c->sala;
+    ResultadoJogada r;
+    int eventos=0;
+    if(strcasecmp(linha,"NOVO")==0){
+        if(s->sala.rodada.estado==SESSAO_EM_JOGO){
+            responder(c,"FALHA rodada em andamento\n");
+            return 1;
+        }
+        if(iniciarRodada(t,s,c)<0){
+            responder(c,"FALHA sem palavras\n");
+            return 1;
+        }
+        responderEstadoSala(c,"OK");
+        difundir(s,codificarEventos(&s->sala,-1,0,EVENTO_RODADA));
+    }
+    else if(strcasecmp(linha,"L")==0||strcasecmp(linha,"P")==0){
+        if(toupper((unsigned char)linha[0])=='L')
+            r=strlen(argumento)==1?chutarLetraSala(&s->sala,c->membro,argumento[0],&eventos):JOGADA_INVALIDA;
+        else    r=chutarPalavraSala(&s->sala,c->membro,argumento,&eventos);
+        responderEstadoSala(c,nomesResultado[r]);
+        // Uma unica copia do evento, compartilhada por todos os membros.
+        difundir(s,codificarEventos(&s->sala,c->membro,toupper((unsigned char)linha[0])=='L'?argumento[0]:0,eventos));
+    }
+    else if(strcasecmp(linha,"ESTADO")==0)  responderEstadoSala(c,"OK");
+    else    return 0;
+    return 1;
+}
+
+/**
+ * @brief Procura uma palavra no dicionario.
+ * @param d O dicionario.
+ * @param palavra A palavra (nao precisa terminar em '\0').
+ * @param n Bytes da palavra.
+ * @param palpite O indice mais provavel (o da gravacao), testado primeiro.
+ * @return O indice da palavra, ou -1 se ela nao estiver no dicionario.
+ */
+static int procurarPalavra (const Dicionario *d, const char *palavra, int n, uint32_t palpite){
+    const char *p;
+    int i,tam;
+    if(palpite<(uint32_t)d->quantidade){
+        p=obterPalavra(d,(int)palpite,&tam);
+        if(tam==n&&memcmp(p,palavra,n)==0)  return (int)palpite;
+    }
+    // O arquivo de palavras mudou desde a gravacao: a palavra pode estar em outra linha.
+    for(i=0;i<d->quantidade;i++){
+        p=obterPalavra(d,i,&tam);
+        if(tam==n&&memcmp(p,palavra,n)==0)  return i;
+    }
+    return -1;
+}
+
+/**
+ * @brief Retoma na conexao uma partida do instantaneo lido na inicializacao.
+ * @param t A thread de trabalho.
+ * @param c A conexao (fora de sala).
+ * @param argumento A chave da partida, em hexadecimal.
+ */
+static void retomarPartida (Trabalhador *t, Conexao *c, const char *argumento){
+    const RegistroInstantaneo *r;
+    const Dicionario *d;
+    const char *nome,*palavra;
+    VersaoDicionario *v=NULL;
+    SessaoCompacta *s;
+    char *fim;
+    uint64_t chave;
+    int64_t i;
+    int j;
+    chave=strtoull(argumento,&fim,16);
+    if(argumento[0]=='\0'||*fim!='\0'||(i=buscarInstantaneo(&anterior,chave))<0){
+        responder(c,"FALHA partida nao encontrada\n");
+        return;
+    }
+    // Duas conexoes podem pedir a mesma chave ao mesmo tempo: so uma leva a partida.
+    if(atomic_exchange(&retomadas[i],1)){
+        responder(c,"FALHA partida ja retomada\n");
+        return;
+    }
+    r=lerPartida(&anterior,(uint64_t)i,&nome,&palavra);
+    if(r==NULL||r->tamPalavra==0||r->tamPalavra>TAM_MAX_MASCARA||r->sessao.estado>SESSAO_DERROTA){
+        responder(c,"FALHA partida invalida\n");
+        return;
+    }
+    // A versao atual so passa para a conexao se a retomada der certo: ate
+    // la, a partida que a conexao ja tem continua lendo a sua versao.
+    if(t->recarga!=NULL&&c->versao!=consultarVersao(t->recarga))    v=adquirirVersao(t->recarga);
+    d=v!=NULL?&v->dicionario:dicionarioDe(t,c);
+    j=procurarPalavra(d,palavra,r->tamPalavra,r->sessao.palavra);
+    if(j<0||(c->sessao==0&&(c->sessao=alocarArena(&t->sessoes))==0)){
+        // A partida continua disponivel para o proximo instantaneo.
+        atomic_store(&retomadas[i],0);
+        if(v!=NULL) liberarVersao(v);
+        responder(c,j<0?"FALHA palavra indisponivel\n":"FALHA sem memoria\n");
+        return;
+    }
+    if(v!=NULL){
+        if(c->versao!=NULL) liberarVersao(c->versao);
+        c->versao=v;
+    }
+    s=sessaoDe(t,c);
+    *s=r->sessao;
+    s->palavra=(uint32_t)j;
+    s->jogador=c->numero;
+    memset(c->nome,0,sizeof(c->nome));
+    memcpy(c->nome,nome,r->tamNome<TAM_MAX_PALAVRA?r->tamNome:TAM_MAX_PALAVRA-1);
+    c->chave=chave;
+    responderEstado(t,c,"OK");
+}
+
+/**
+ * @brief Executa um comando recebido de um cliente.
+ * @param t A thread de trabalho.
+ * @param c A conexao.
+ * @param linha A linha recebida, ja sem '\n'.
+ */
+static void executarComando (Trabalhador *t, Conexao *c, char *linha){
+    char *argumento;
+    SalaServidor *s;
+    ResultadoJogada r;
+    apararString(linha);
+    if(linha[0]=='\0')  return;
+    // Separa o comando do argumento.
+    argumento=strchr(linha,' ');
+    if(argumento!=NULL){
+        *argumento++='\0';
+        apararString(argumento);
+    }
+    else    argumento="";
+    // Dentro de uma sala, NOVO, L, P e ESTADO valem para a rodada da sala.
+    if(c->sala!=NULL&&executarComandoSala(t,c,linha,argumento))    return;
+    if(strcasecmp(linha,"SALA")==0){
+        if(argumento[0]=='\0'||strlen(argumento)>=TAM_NOME_SALA||strchr(argumento,' ')!=NULL){
+            responder(c,"FALHA nome de sala invalido\n");
+            return;
+        }
+        if(c->sala!=NULL&&strcmp(c->sala->sala.nome,argumento)==0){
+            responder(c,"FALHA ja esta na sala\n");
+            return;
+        }
+        if(c->sala!=NULL)   deixarSala(c);
+        s=reservarSala(t,argumento);
+        if(s==NULL) responder(c,"FALHA sem memoria\n");
+        // Sala de outra thread: a conexao muda de thread ao fim da leitura (ver migrarConexao).
+        else if(s->dono!=t) c->destino=s;
+        else    entrarNaSala(t,c,s);
+    }
+    else if(strcasecmp(linha,"DEIXAR")==0){
+        if(c->sala==NULL)   responder(c,"FALHA nenhuma sala\n");
+        else{
+            deixarSala(c);
+            responder(c,"OK\n");
+        }
+    }
+    else if(strcasecmp(linha,"NOME")==0){
+        if(argumento[0]=='\0'){
+            responder(c,"FALHA nome vazio\n");
+            return;
+        }
+        strncpy(c->nome,argumento,TAM_MAX_PALAVRA-1);
+        responder(c,"OK\n");
+    }
+    else if(strcasecmp(linha,"CHAVE")==0)  responder(c,"OK %016llx\n",(unsigned long long)c->chave);
+    else if(strcasecmp(linha,"RETOMAR")==0){
+        if(c->sala!=NULL)   responder(c,"FALHA dentro de uma sala\n");
+        // A partida em andamento nao e trocada sem resultado: ela precisa terminar antes.
+        else if(c->sessao!=0&&sessaoDe(t,c)->estado==SESSAO_EM_JOGO)  responder(c,"FALHA partida em andamento\n");
+        else    retomarPartida(t,c,argumento);
+    }
+    else if(strcasecmp(linha,"NOVO")==0){
+        uint32_t indice;
+        MEDICAO(inicio);
+        // Trocar de partida no meio nao apaga a derrota que se aproximava.
+        abandonarPartida(t,c);
+        // A partida fica na arena da thread; a conexao guarda so o seu numero.
+        if(c->sessao==0&&(c->sessao=alocarArena(&t->sessoes))==0){
+            responder(c,"FALHA sem memoria\n");
+            return;
+        }
+        INICIAR_MEDICAO(inicio);
+        // Com recarga, a nova partida usa a versao atual; a anterior e devolvida.
+        if(t->recarga!=NULL&&c->versao!=consultarVersao(t->recarga)){
+            if(c->versao!=NULL) liberarVersao(c->versao);
+            c->versao=adquirirVersao(t->recarga);
+        }
+        indice=sortearIntervalo(&c->aleatorio,(uint32_t)dicionarioDe(t,c)->quantidade);
+        if(iniciarSessaoCompacta(sessaoDe(t,c),dicionarioDe(t,c),indice,c->numero)<0){
+            liberarArena(&t->sessoes,c->sessao);
+            c->sessao=0;
+            responder(c,"FALHA palavra invalida\n");
+            return;
+        }
+        ENCERRAR_MEDICAO(FASE_SORTEIO,inicio);
+        responderEstado(t,c,"OK");
+        if(t->config->ritmo)    pausarConexao(t,c,PAUSA_NOVO);
+    }
+    else if(strcasecmp(linha,"L")==0||strcasecmp(linha,"P")==0){
+        if(c->sessao==0){
+            responder(c,"FALHA nenhuma partida, use NOVO\n");
+            return;
+        }
+        if(toupper((unsigned char)linha[0])=='L')
+            r=strlen(argumento)==1?chutarLetraCompacta(sessaoDe(t,c),dicionarioDe(t,c),argumento[0]):JOGADA_INVALIDA;
+        else    r=chutarPalavraCompacta(sessaoDe(t,c),dicionarioDe(t,c),argumento);
+        responderEstado(t,c,nomesResultado[r]);
+        if(t->config->ritmo&&r!=JOGADA_INVALIDA&&r!=JOGADA_ENCERRADA)   pausarConexao(t,c,PAUSA_PALPITE);
+        // Grava o resultado uma unica vez, no palpite que encerrou a partida.
+        if(t->config->registrar&&r!=JOGADA_ENCERRADA&&r!=JOGADA_INVALIDA&&sessaoDe(t,c)->estado!=SESSAO_EM_JOGO)
+            registrarPartida(t,c);
+    }
+    else if(strcasecmp(linha,"ESTADO")==0){
+        if(c->sessao==0)    responder(c,"FALHA nenhuma partida, use NOVO\n");
+        else    responderEstado(t,c,"OK");
+    }
+    else if(strcasecmp(linha,"SAIR")==0){
+        responder(c,"TCHAU\n");
+        c->encerrar=1;
+    }
+    else    responder(c,"FALHA comando desconhecido\n");
+}
+
+/**
+ * @brief Inclui uma conexao na lista de conexoes abertas da thread.
+ * @param t A thread de trabalho.
+ * @param c A conexao.
+ */
+static void incluirAberta (Trabalhador *t, Conexao *c){
+    c->anteriorAberta=NULL;
+    c->proximaAberta=t->abertas;
+    if(t->abertas!=NULL)    t->abertas->anteriorAberta=c;
+    t->abertas=c;
+}
+
+/**
+ * @brief Retira uma conexao da lista de conexoes abertas da thread.
+ * @param t A thread de trabalho.
+ * @param c A conexao.
+ */
+static void retirarAberta (Trabalhador *t, Conexao *c){
+    if(c->anteriorAberta!=NULL) c->anteriorAberta->proximaAberta=c->proximaAberta;
+    else    t->abertas=c->proximaAberta;
+    if(c->proximaAberta!=NULL)  c->proximaAberta->anteriorAberta=c->anteriorAberta;
+    c->anteriorAberta=c->proximaAberta=NULL;
+}
+
+/**
+ * @brief Fecha uma conexao e libera sua memoria.
+ * @param c A conexao.
+ */
+static void fecharConexao (Conexao *c){
+    if(c->sala!=NULL)   deixarSala(c);
+    retirarAberta(c->trabalhador,c);
+    desmarcarEnvio(c->trabalhador,c);
+    cancelarEvento(&c->trabalhador->agenda,&c->pausa);
+    liberarArena(&c->trabalhador->sessoes,c->sessao);
+    if(c->versao!=NULL) liberarVersao(c->versao);
+    if(c->fila!=NULL){
+        esvaziarFila(c->fila);
+        free(c->fila);
+    }
+    free(c->pendente);
+    close(c->fd);
+    free(c);
+}
+
+/**
+ * @brief Envia o que for possivel do buffer de saida.
+ *
+ * Se o socket nao aceitar tudo, habilita EPOLLOUT para continuar depois.
+ *
+ * @param t A thread de trabalho.
+ * @param c A conexao.
+ * @return 0 se a conexao continua aberta, -1 se foi fechada.
+ */
+static int enviarSaida (Trabalhador *t, Conexao *c){
+    struct epoll_event ev;
+    int pendente;
+    if(escreverSaida(c)<0){
+        fecharConexao(c);
+        return -1;
+    }
+    pendente=c->tamSaida>0||(c->fila!=NULL&&c->fila->quantidade>0);
+    if(!pendente&&c->encerrar){
+        fecharConexao(c);
+        return -1;
+    }
+    // So altera o registro no epoll quando o interesse muda.
+    if(pendente!=c->esperandoEscrita){
+        c->esperandoEscrita=pendente;
+        ev.events=EPOLLIN|(c->esperandoEscrita?EPOLLOUT:0);
+        ev.data.ptr=c;
+        epoll_ctl(t->epoll,EPOLL_CTL_MOD,c->fd,&ev);
+    }
+    return 0;
+}
+
+/**
+ * @brief Encerra a pausa de uma conexao e envia as respostas retidas.
+ * @param dados A conexao.
+ */
+static void encerrarPausa (void *dados){
+    Conexao *c = dados;
+    c->pausada=0;
+    enviarSaida(c->trabalhador,c);
+}
+
+/**
+ * @brief Retem as respostas de uma conexao por um tempo, sem bloquear a thread.
+ *
+ * Os comandos seguintes continuam sendo executados; suas respostas saem
+ * junto com as retidas, no fim da pausa.
+ *
+ * @param t A thread de trabalho.
+ * @param c A conexao.
+ * @param atrasoMs A duracao da pausa, em milissegundos.
+ */
+static void pausarConexao (Trabalhador *t, Conexao *c, int atrasoMs){
+    struct epoll_event ev;
+    if(c->pausada)  return;
+    c->pausada=1;
+    // Sem isso, EPOLLOUT continuaria sinalizando durante toda a pausa.
+    if(c->esperandoEscrita){
+        c->esperandoEscrita=0;
+        ev.events=EPOLLIN;
+        ev.data.ptr=c;
+        epoll_ctl(t->epoll,EPOLL_CTL_MOD,c->fd,&ev);
+    }
+    agendarEvento(&t->agenda,&c->pausa,atrasoMs,encerrarPausa,c);
+}
+
+/**
+ * @brief Executa as linhas completas de um trecho recebido, guardando o inicio da ultima.
+ * @param t A thread de trabalho.
+ * @param c A conexao.
+ * @param buffer Os bytes recebidos.
+ * @param n O numero de bytes.
+ * @return Os bytes consumidos (menos que n se a conexao for encerrada ou mudar de thread).
+ */
+static int executarLinhas (Trabalhador *t, Conexao *c, const char *buffer, int n){
+    const char *quebra;
+    char *linha;
+    int i,resto;
+    for(i=0;i<n&&!c->encerrar&&c->destino==NULL;){
+        // Procura o fim da linha dentro do que acabou de chegar.
+        quebra=memchr(buffer+i,'\n',n-i);
+        resto=quebra!=NULL?(int)(quebra-(buffer+i)):n-i;
+        if(c->tamEntrada+resto>=TAM_MAX_LINHA){
+            responder(c,"FALHA linha longa demais\n");
+            c->encerrar=1;
+            break;
+        }
+        memcpy(c->entrada+c->tamEntrada,buffer+i,resto);
+        c->tamEntrada+=resto;
+        i+=resto;
+        if(quebra==NULL)    break;
+        i++;
+        c->entrada[c->tamEntrada]='\0';
+        linha=c->entrada;
+        c->tamEntrada=0;
+        executarComando(t,c,linha);
+    }
+    return i;
+}
+
+/**
+ * @brief Passa uma conexao para a thread dona da sala em que ela vai entrar.
+ *
+ * A conexao sai do epoll desta thread e entra na fila de chegada da
+ * outra, levando os bytes recebidos que ainda nao foram executados.
+ *
+ * @param t A thread de trabalho atual.
+ * @param c A conexao (com c->destino preenchido).
+ * @param resto Os bytes recebidos depois do comando SALA.
+ * @param n O numero de bytes.
+ * @return Sempre -1: a conexao nao pertence mais a esta thread.
+ */
+static int migrarConexao (Trabalhador *t, Conexao *c, const char *resto, int n){
+    Trabalhador *dono = c->destino->dono;
+    desmarcarEnvio(t,c);
+    retirarAberta(t,c);
+    epoll_ctl(t->epoll,EPOLL_CTL_DEL,c->fd,NULL);
+    cancelarEvento(&t->agenda,&c->pausa);
+    c->pausada=0;
+    c->esperandoEscrita=0;
+    // Como em entrarNaSala, a partida individual abandonada conta como derrota.
+    if(c->sessao!=0){
+        abandonarPartida(t,c);
+        liberarArena(&t->sessoes,c->sessao);
+        c->sessao=0;
+    }
+    c->tamPendente=0;
+    if(n>0&&(c->pendente=malloc(n))!=NULL){
+        memcpy(c->pendente,resto,n);
+        c->tamPendente=n;
+    }
+    pthread_mutex_lock(&dono->travaChegadas);
+    c->proximaChegada=dono->chegadas;
+    dono->chegadas=c;
+    pthread_mutex_unlock(&dono->travaChegadas);
+    // Daqui em diante a conexao pertence a outra thread e nao pode mais ser tocada.
+    eventfd_write(dono->aviso,1);
+    return -1;
+}
+
+/**
+ * @brief Recebe as conexoes que outras threads passaram para esta.
+ * @param t A thread de trabalho.
+ */
+static void receberChegadas (Trabalhador *t){
+    struct epoll_event ev;
+    Conexao *c,*proxima;
+    SalaServidor *s;
+    eventfd_t avisos;
+    char *pendente;
+    int i;
+    eventfd_read(t->aviso,&avisos);
+    pthread_mutex_lock(&t->travaChegadas);
+    c=t->chegadas;
+    t->chegadas=NULL;
+    pthread_mutex_unlock(&t->travaChegadas);
+    for(;c!=NULL;c=proxima){
+        proxima=c->proximaChegada;
+        s=c->destino;
+        c->destino=NULL;
+        c->trabalhador=t;
+        incluirAberta(t,c);
+        pthread_mutex_lock(&travaSalas);
+        s->reservas--;
+        pthread_mutex_unlock(&travaSalas);
+        ev.events=EPOLLIN;
+        ev.data.ptr=c;
+        if(epoll_ctl(t->epoll,EPOLL_CTL_ADD,c->fd,&ev)<0){
+            fecharConexao(c);
+            liberarSalaVazia(s);
+            continue;
+        }
+        entrarNaSala(t,c,s);
+        // Os comandos que chegaram junto com SALA sao executados aqui, na thread da sala.
+        pendente=c->pendente;
+        c->pendente=NULL;
+        i=pendente!=NULL?executarLinhas(t,c,pendente,c->tamPendente):0;
+        if(c->destino!=NULL)    migrarConexao(t,c,pendente+i,c->tamPendente-i);
+        else if(!c->pausada)    enviarSaida(t,c);
+        free(pendente);
+    }
+}
+
+/**
+ * @brief Envia os quadros entregues desde a ultima volta do laco de eventos.
+ * @param t A thread de trabalho.
+ */
+static void enviarPendentes (Trabalhador *t){
+    Conexao *c;
+    // Fechar uma conexao pode entregar novos quadros (SALA SAIU); a lista e refeita a cada passo.
+    while((c=t->paraEnviar)!=NULL){
+        desmarcarEnvio(t,c);
+        if(!c->pausada) enviarSaida(t,c);
+    }
+}
+
+/**
+ * @brief Le os dados disponiveis de uma conexao e executa as linhas completas.
+ * @param t A thread de trabalho.
+ * @param c A conexao.
+ * @return 0 se a conexao continua aberta, -1 se foi fechada ou passou para outra thread.
+ */
+static int lerConexao (Trabalhador *t, Conexao *c){
+    char buffer[4096];
+    ssize_t n;
+    int i;
+    for(;;){
+        n=recv(c->fd,buffer,sizeof(buffer),0);
+        if(n<0){
+            if(errno==EINTR)    continue;
+            if(errno==EAGAIN||errno==EWOULDBLOCK)   break;
+            fecharConexao(c);
+            return -1;
+        }
+        if(n==0){
+            fecharConexao(c);
+            return -1;
+        }
+        i=executarLinhas(t,c,buffer,(int)n);
+        // Sala de outra thread: o resto do que chegou vai junto com a conexao.
+        if(c->destino!=NULL)    return migrarConexao(t,c,buffer+i,(int)n-i);
+        if(c->encerrar) break;
+    }
+    // Durante uma pausa, as respostas so saem quando ela terminar.
+    if(c->pausada)  return 0;
+    return enviarSaida(t,c);
+}
+
+/**
+ * @brief Aceita todas as conexoes pendentes no socket de escuta.
+ * @param t A thread de trabalho.
+ */
+static void aceitarConexoes (Trabalhador *t){
+    struct epoll_event ev;
+    Conexao *c;
+    int fd,um=1;
+    for(;;){
+        fd=accept4(t->escuta,NULL,NULL,SOCK_NONBLOCK);
+        if(fd<0)    return;
+        if(t->config->caminhoUnix==NULL)
+            setsockopt(fd,IPPROTO_TCP,TCP_NODELAY,&um,sizeof(um));
+        c=calloc(1,sizeof(Conexao));
+        if(c==NULL){
+            close(fd);
+            continue;
+        }
+        c->fd=fd;
+        c->trabalhador=t;
+        c->numero=(uint32_t)t->conexoes;
+        semearFluxo(&c->aleatorio,t->semente,t->conexoes++);
+        c->chave=proximoAleatorio(&t->chaves)|1;
+        incluirAberta(t,c);
+        ev.events=EPOLLIN;
+        ev.data.ptr=c;
+        if(epoll_ctl(t->epoll,EPOLL_CTL_ADD,fd,&ev)<0)  fecharConexao(c);
+    }
+}
+
+/**
+ * @brief Laco de eventos de uma thread de trabalho.
+ * @param arg O Trabalhador da thread.
+ * @return Sempre NULL.
+ */
+static void *executarTrabalhador (void *arg){
+    Trabalhador *t = arg;
+    struct epoll_event eventos[MAX_EVENTOS];
+    int i,n,espera;
+    while(!atomic_load(&pararTrabalhadores)){
+        // Durante o fork do instantaneo, nenhuma thread altera as partidas.
+        if(atomic_load(&pausarTrabalhadores)){
+            pthread_barrier_wait(&barreiraInstantaneo);
+            pthread_barrier_wait(&barreiraInstantaneo);
+        }
+        // Entre duas voltas a thread nao guarda ponteiros de versoes sem referencia.
+        if(t->recarga!=NULL)    marcarQuiescencia(t->recarga,t->indice);
+        // O tempo limite permite verificar periodicamente o pedido de parada
+        // e acordar no vencimento da proxima pausa.
+        espera=tempoAteProximo(&t->agenda,relogioNs());
+        if(espera<0||espera>200)    espera=200;
+        n=epoll_wait(t->epoll,eventos,MAX_EVENTOS,espera);
+        for(i=0;i<n;i++){
+            Conexao *c = eventos[i].data.ptr;
+            if(c==NULL){
+                aceitarConexoes(t);
+                continue;
+            }
+            if(eventos[i].data.ptr==&t->aviso){
+                receberChegadas(t);
+                continue;
+            }
+            if(eventos[i].events&(EPOLLERR|EPOLLHUP)){
+                fecharConexao(c);
+                continue;
+            }
+            if(eventos[i].events&EPOLLIN){
+                if(lerConexao(t,c)<0)   continue;
+            }
+            else if(eventos[i].events&EPOLLOUT&&!c->pausada)
+                enviarSaida(t,c);
+        }
+        processarAgenda(&t->agenda,relogioNs());
+        enviarPendentes(t);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Grava as partidas em andamento de todas as threads em um instantaneo.
+ *
+ * Roda com as threads paradas: no processo filho do fork ou no
+ * encerramento. As partidas do instantaneo anterior que nao foram
+ * retomadas tambem sao gravadas, para nao se perderem.
+ *
+ * @param ts As threads de trabalho.
+ * @param n O numero de threads.
+ * @param nome O arquivo do instantaneo.
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+static int gravarInstantaneo (Trabalhador *ts, int n, const char *nome){
+    GravacaoInstantaneo g;
+    const RegistroInstantaneo *r;
+    const char *palavra,*nomeAnterior;
+    char jogador[TAM_MAX_PALAVRA];
+    long long inicio=relogioNs();
+    Conexao *c;
+    uint64_t k;
+    int i,tam;
+    if(iniciarGravacao(&g,nome)<0){
+        printf("Erro ao abrir o arquivo: %s\n",nome);
+        return -1;
+    }
+    for(i=0;i<n;i++)
+        for(c=ts[i].abertas;c!=NULL;c=c->proximaAberta){
+            // Partidas ja encerradas nao tem o que retomar.
+            if(c->sessao==0||sessaoDe(&ts[i],c)->estado!=SESSAO_EM_JOGO)    continue;
+            palavra=obterPalavra(dicionarioDe(&ts[i],c),(int)sessaoDe(&ts[i],c)->palavra,&tam);
+            gravarPartida(&g,c->chave,sessaoDe(&ts[i],c),c->nome,palavra,tam);
+        }
+    for(k=0;k<anterior.quantidade;k++){
+        if(atomic_load(&retomadas[k])||(r=lerPartida(&anterior,k,&nomeAnterior,&palavra))==NULL)   continue;
+        // O nome no arquivo nao termina em '\0'.
+        tam=r->tamNome<TAM_MAX_PALAVRA?r->tamNome:TAM_MAX_PALAVRA-1;
+        memcpy(jogador,nomeAnterior,tam);
+        jogador[tam]='\0';
+        gravarPartida(&g,r->chave,&r->sessao,jogador,palavra,r->tamPalavra);
+    }
+    k=g.quantidade;
+    if(concluirGravacao(&g)<0){
+        printf("Erro ao gravar o arquivo: %s\n",nome);
+        return -1;
+    }
+    printf("Instantaneo gravado: %llu partida(s) em %.1f ms.\n",(unsigned long long)k,(relogioNs()-inicio)/1e6);
+    return 0;
+}
+
+/**
+ * @brief Tira um instantaneo sem parar o servidor.
+ *
+ * As threads de trabalho sao paradas entre duas voltas do laco de eventos
+ * apenas durante o fork; o processo filho grava as partidas como estavam
+ * naquele instante (a memoria do pai e compartilhada com copia na escrita)
+ * enquanto o pai volta a atender os clientes. As threads do registro e da
+ * recarga tambem sao pausadas durante o fork: o filho usa malloc e stdio,
+ * e uma trava que uma delas segurasse no fork nunca seria solta nele.
+ *
+ * @param ts As threads de trabalho.
+ * @param n O numero de threads.
+ * @param nome O arquivo do instantaneo.
+ * @return O processo filho, ou -1 se o fork falhou.
+ */
+static pid_t tirarInstantaneo (Trabalhador *ts, int n, const char *nome){
+    long long inicio=relogioNs();
+    pid_t filho;
+    int i;
+    atomic_store(&pausarTrabalhadores,1);
+    for(i=0;i<n;i++)    eventfd_write(ts[i].aviso,1);
+    pthread_barrier_wait(&barreiraInstantaneo);
+    // So depois da barreira: uma thread de jogo esperando espaco no anel do registro impediria a pausa.
+    pausarRegistro(obterRegistroPadrao(ARQUIVO_RESULTADOS));
+    pausarRecarga(ts[0].recarga);
+    fflush(stdout);
+    filho=fork();
+    if(filho==0){
+        i=gravarInstantaneo(ts,n,nome);
+        fflush(stdout);
+        _exit(i<0);
+    }
+    retomarRecarga(ts[0].recarga);
+    retomarRegistro(obterRegistroPadrao(ARQUIVO_RESULTADOS));
+    atomic_store(&pausarTrabalhadores,0);
+    pthread_barrier_wait(&barreiraInstantaneo);
+    if(filho<0) printf("Erro ao criar o processo do instantaneo.\n");
+    else    printf("Instantaneo pedido: threads paradas por %.2f ms.\n",(relogioNs()-inicio)/1e6);
+    fflush(stdout);
+    return filho;
+}
+
+/**
+ * @brief Executa o servidor ate receber SIGINT ou SIGTERM.
+ * @param config Os parametros de execucao.
+ * @return 0 em caso de encerramento normal, 1 em caso de erro.
+ */
+int executarServidor (const ConfigServidor *config){
+    Trabalhador *trabalhadores;
+    struct epoll_event ev;
+    struct sigaction sa;
+    struct rlimit limite;
+    Registro *registro=NULL;
+    EstatisticasRegistro estatisticas;
+    Recarga *recarga=NULL;
+    EstatisticasRecarga estatisticasRecarga;
+    int i,n=config->threads,escutaUnix=-1,status;
+    pid_t filho=-1;
+#ifdef FORCA_METRICAS
+    long long proximasMetricas=relogioNs();
+#endif
+    uint64_t semente=config->semente!=0?config->semente:gerarSemente();
+    Dicionario *d = obterDicionarioPadrao(ARQUIVO_PALAVRAS);
+    if(d==NULL||d->quantidade==0){
+        printf("Erro ao abrir o arquivo: %s\n",ARQUIVO_PALAVRAS);
+        return 1;
+    }
+    if(n<=0)    n=(int)sysconf(_SC_NPROCESSORS_ONLN);
+    if(n<=0)    n=1;
+    // Com recarga, cada thread de trabalho e uma leitora das versoes (ver recarga.h).
+    if(config->recarregar&&(recarga=iniciarRecarga(ARQUIVO_PALAVRAS,n))==NULL){
+        printf("Erro ao abrir o arquivo: %s\n",ARQUIVO_PALAVRAS);
+        return 1;
+    }
+    memset(&sa,0,sizeof(sa));
+    sa.sa_handler=tratarSinal;
+    sigaction(SIGINT,&sa,NULL);
+    sigaction(SIGTERM,&sa,NULL);
+    signal(SIGPIPE,SIG_IGN);
+    // As partidas do servidor anterior ficam mapeadas ate serem retomadas (ver RETOMAR).
+    if(config->arquivoInstantaneo!=NULL){
+        sa.sa_handler=pedirInstantaneo;
+        sigaction(SIGUSR1,&sa,NULL);
+        if(access(config->arquivoInstantaneo,F_OK)==0){
+            if(abrirInstantaneo(&anterior,config->arquivoInstantaneo)<0){
+                printf("Erro ao abrir o arquivo: %s\n",config->arquivoInstantaneo);
+                return 1;
+            }
+            retomadas=calloc(anterior.quantidade+1,1);
+            if(retomadas==NULL) return 1;
+            printf("Partidas a retomar: %llu\n",(unsigned long long)anterior.quantidade);
+        }
+    }
+    // Milhares de conexoes exigem um limite de descritores maior que o padrao.
+    if(getrlimit(RLIMIT_NOFILE,&limite)==0){
+        limite.rlim_cur=limite.rlim_max;
+        setrlimit(RLIMIT_NOFILE,&limite);
+    }
+    // O socket Unix e unico; as threads o compartilham com EPOLLEXCLUSIVE.
+    if(config->caminhoUnix!=NULL){
+        escutaUnix=criarEscutaUnix(config->caminhoUnix);
+        if(escutaUnix<0){
+            printf("Erro ao abrir o socket: %s\n",config->caminhoUnix);
+            return 1;
+        }
+    }
+    // Os resultados sao gravados em lotes por uma thread de escrita (ver registro.h).
+    if(config->registrar){
+        // A thread de escrita do registro tambem atualiza os perfis dos jogadores:
+        // o cadastro e definido antes de ela existir, pois ela o le sem trava.
+        definirPerfisPadrao(abrirPerfis(ARQUIVO_PERFIS,0));
+        registro=iniciarRegistro(ARQUIVO_RESULTADOS,CAPACIDADE_REGISTRO,config->sincronia,1000);
+        // Sem a thread de escrita, as threads de jogo cairiam no registro sincrono,
+        // que nao foi feito para ser chamado de varias threads ao mesmo tempo.
+        if(registro==NULL){
+            printf("Erro ao abrir o arquivo: %s\n",ARQUIVO_RESULTADOS);
+            fecharPerfis(obterPerfisPadrao());
+            definirPerfisPadrao(NULL);
+            return 1;
+        }
+        definirRegistroPadrao(registro,ARQUIVO_RESULTADOS);
+    }
+    trabalhadores=calloc(n,sizeof(Trabalhador));
+    if(trabalhadores==NULL) return 1;
+    for(i=0;i<n;i++){
+        Trabalhador *t = &trabalhadores[i];
+        t->config=config;
+        t->dicionario=d;
+        t->recarga=recarga;
+        t->indice=i;
+        t->semente=semente^(0x9e3779b97f4a7c15ULL*(i+1));
+        // As chaves de retomada nao dependem da semente: dois servidores com a mesma semente nao as repetem.
+        semearAleatorio(&t->chaves,gerarSemente()^(uint64_t)i);
+        iniciarAgenda(&t->agenda,RESOLUCAO_AGENDA);
+        iniciarArena(&t->sessoes,sizeof(SessaoCompacta));
+        t->escuta=escutaUnix>=0?escutaUnix:criarEscutaTCP(config->porta);
+        t->epoll=epoll_create1(0);
+        t->aviso=eventfd(0,EFD_NONBLOCK|EFD_CLOEXEC);
+        pthread_mutex_init(&t->travaChegadas,NULL);
+        if(t->escuta<0||t->epoll<0||t->aviso<0){
+            printf("Erro ao abrir a porta: %d\n",config->porta);
+            return 1;
+        }
+        ev.events=EPOLLIN|(escutaUnix>=0?EPOLLEXCLUSIVE:0);
+        ev.data.ptr=NULL;
+        epoll_ctl(t->epoll,EPOLL_CTL_ADD,t->escuta,&ev);
+        // O aviso acorda a thread quando outra lhe passa uma conexao (salas).
+        ev.events=EPOLLIN;
+        ev.data.ptr=&t->aviso;
+        epoll_ctl(t->epoll,EPOLL_CTL_ADD,t->aviso,&ev);
+    }
+    if(config->caminhoUnix!=NULL)   printf("Servidor ouvindo em %s com %d thread(s).\n",config->caminhoUnix,n);
+    else    printf("Servidor ouvindo na porta %d com %d thread(s).\n",config->porta,n);
+    printf("Semente: %llu\n",(unsigned long long)semente);
+    fflush(stdout);
+    pthread_barrier_init(&barreiraInstantaneo,NULL,n+1);
+    for(i=0;i<n;i++)
+        pthread_create(&trabalhadores[i].thread,NULL,executarTrabalhador,&trabalhadores[i]);
+    // A thread principal atende os pedidos de instantaneo e grava o relatorio de metricas.
+    while(!pararServidor){
+#ifdef FORCA_METRICAS
+        if(config->arquivoMetricas!=NULL&&relogioNs()>=proximasMetricas){
+            gravarMetricas(config->arquivoMetricas);
+            proximasMetricas+=INTERVALO_METRICAS*1000000000LL;
+        }
+#endif
+        // Um instantaneo por vez; o pedido feito durante a gravacao espera o fim dela.
+        if(pedidoInstantaneo&&filho<0){
+            pedidoInstantaneo=0;
+            filho=tirarInstantaneo(trabalhadores,n,config->arquivoInstantaneo);
+        }
+        if(filho>0&&waitpid(filho,&status,WNOHANG)==filho)  filho=-1;
+        usleep(200000);
+    }
+    // So a thread principal para as de trabalho, para que nenhuma fique fora da barreira de um instantaneo.
+    atomic_store(&pararTrabalhadores,1);
+    for(i=0;i<n;i++)    eventfd_write(trabalhadores[i].aviso,1);
+    for(i=0;i<n;i++)    pthread_join(trabalhadores[i].thread,NULL);
+    if(filho>0) waitpid(filho,&status,0);
+    // Com as threads encerradas, as partidas ainda estao nas arenas: o ultimo instantaneo e gravado aqui.
+    if(config->arquivoInstantaneo!=NULL)    gravarInstantaneo(trabalhadores,n,config->arquivoInstantaneo);
+    pthread_barrier_destroy(&barreiraInstantaneo);
+    for(i=0;i<n;i++){
+        if(escutaUnix<0)    close(trabalhadores[i].escuta);
+        close(trabalhadores[i].epoll);
+        close(trabalhadores[i].aviso);
+        pthread_mutex_destroy(&trabalhadores[i].travaChegadas);
+        destruirArena(&trabalhadores[i].sessoes);
+    }
+    // As salas que ainda tem membros seguram versoes das palavras: sao liberadas antes da recarga.
+    for(i=0;i<TAM_TABELA_SALAS;i++){
+        SalaServidor *s;
+        while((s=salas[i])!=NULL){
+            salas[i]=s->proxima;
+            if(s->versao!=NULL) liberarVersao(s->versao);
+            destruirSala(&s->sala);
+            free(s);
+        }
+    }
+    if(escutaUnix>=0){
+        close(escutaUnix);
+        unlink(config->caminhoUnix);
+    }
+    free(trabalhadores);
+    fecharInstantaneo(&anterior);
+    free(retomadas);
+    if(recarga!=NULL){
+        consultarRecarga(recarga,&estatisticasRecarga);
+        encerrarRecarga(recarga);
+        printf("Recargas das palavras: %llu (falhas: %llu, maior leitura: %.1f ms).\n",
+               estatisticasRecarga.recargas,estatisticasRecarga.falhas,estatisticasRecarga.maiorLeitura/1e6);
+    }
+    if(registro!=NULL){
+        definirRegistroPadrao(NULL,ARQUIVO_RESULTADOS);
+        consultarRegistro(registro,&estatisticas);
+        encerrarRegistro(registro);
+        fecharPerfis(obterPerfisPadrao());
+        definirPerfisPadrao(NULL);
+        printf("Resultados gravados: %llu em %llu lotes (maior lote: %llu, esperas por anel cheio: %llu).\n",
+               estatisticas.enfileiradas,estatisticas.lotes,estatisticas.maiorLote,estatisticas.esperas);
+    }
+#ifdef FORCA_METRICAS
+    if(config->arquivoMetricas!=NULL)   gravarMetricas(config->arquivoMetricas);
+    imprimirMetricas(stdout);
+#endif
+    printf("Servidor encerrado.\n");
+    return 0;
+}
+
+#else
+
+/**
+ * @brief Executa o servidor (indisponivel fora do Linux).
+ * @param config Os parametros de execucao.
+ * @return Sempre 1.
+ */
+int executarServidor (const ConfigServidor *config){
+    (void)config;
+    printf("O modo servidor requer Linux (epoll).\n");
+    return 1;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,89 @@
+/**
+ * @file servidor.h
+ * @brief Arquivo de cabecalho do modo servidor (multiplas partidas via rede).
+ *
+ * O servidor aceita conexoes TCP ou por socket Unix e conduz uma sessao
+ * (sessao.h) por conexao. Cada thread de trabalho tem seu proprio epoll e,
+ * no caso de TCP, seu proprio socket de escuta com SO_REUSEPORT, de modo
+ * que o kernel distribui as conexoes entre os nucleos.
+ *
+ * Protocolo (uma linha de texto por comando, terminada em '\n'):
+ *
+ *   NOME <nome>     Define o nome do jogador.          -> OK
+ *   NOVO            Sorteia uma palavra e inicia.      -> OK <estado>
+ *   L <letra>       Chuta uma letra.                   -> <resultado> <estado>
+ *   P <palavra>     Chuta a palavra inteira.           -> <resultado> <estado>
+ *   ESTADO          Consulta a partida atual.          -> OK <estado>
+ *   SALA <nome>     Entra em uma sala (ver sala.h).    -> OK <estado>
+ *   DEIXAR          Sai da sala.                       -> OK
+ *   CHAVE           Chave de retomada da conexao.      -> OK <chave>
+ *   RETOMAR <chave> Retoma uma partida do instantaneo. -> OK <estado>
+ *   SAIR            Encerra a conexao.                 -> TCHAU
+ *
+ * <resultado> e ACERTO, ERRO, REPETIDA, INVALIDA ou ENCERRADA, e <estado>
+ * e "EM_JOGO|VITORIA|DERROTA <vidas> <forca> <letras usadas ou ->", seguido
+ * da palavra secreta quando a partida termina. Comandos invalidos recebem
+ * "FALHA <motivo>".
+ *
+ * Com a opcao de ritmo, as respostas a NOVO e aos palpites sao retidas
+ * pelo mesmo tempo das pausas do jogo no terminal. As pausas sao eventos
+ * da agenda de cada thread (agenda.h), e nao chamadas a delayMS, de modo
+ * que uma thread cadencia todas as suas conexoes ao mesmo tempo.
+ *
+ * Com a opcao de recarga, uma edicao de ARQUIVO_PALAVRAS passa a valer a
+ * partir do proximo NOVO de cada conexao; a partida em andamento continua
+ * com a versao em que comecou (ver recarga.h).
+ *
+ * Dentro de uma sala, NOVO, L, P e ESTADO valem para a rodada da sala (NOVO
+ * so depois do fim da rodada), e as mudancas da rodada chegam a todos os
+ * membros como linhas "SALA ..." (ver codificarEventos), intercaladas com
+ * as respostas. Cada sala pertence a uma thread de trabalho; uma conexao
+ * que entra em uma sala de outra thread passa para ela. As rodadas das
+ * salas nao sao gravadas em ARQUIVO_RESULTADOS.
+ *
+ * Com um arquivo de instantaneo, as partidas em andamento sao gravadas nele
+ * quando o processo recebe SIGUSR1 e no encerramento, e o servidor seguinte
+ * le o arquivo na inicializacao. Como a conexao TCP nao sobrevive a troca
+ * de processo, o cliente guarda a chave (CHAVE) e, reconectado, pede a sua
+ * partida com RETOMAR (recusado enquanto a conexao tem uma partida em
+ * andamento). Cada partida pode ser retomada uma vez; as que nao forem
+ * retomadas passam para o instantaneo seguinte. As rodadas das salas
+ * nao entram no instantaneo.
+ */
+
+#ifndef SERVIDOR_H
+#define SERVIDOR_H
+
+#include <stdint.h>
+#include "registro.h"
+
+// Porta TCP padrao do modo servidor.
+#define PORTA_PADRAO 7777
+// Tamanho maximo de uma linha de comando recebida.
+#define TAM_MAX_LINHA 256
+
+/**
+ * @struct ConfigServidor
+ * @brief Parametros de execucao do servidor.
+ */
+typedef struct{
+    int porta;                  // Porta TCP (ignorada se caminhoUnix for usado).
+    const char *caminhoUnix;    // Caminho do socket Unix, ou NULL para TCP.
+    int threads;                // Threads de trabalho (0 = uma por nucleo).
+    int registrar;              // 1 para gravar os resultados em ARQUIVO_RESULTADOS.
+    PoliticaSincronia sincronia;    // Quando sincronizar os resultados com o disco.
+    int ritmo;                  // 1 para aplicar as pausas do jogo no terminal.
+    uint64_t semente;           // Semente do sorteio das palavras (0 = gerada na inicializacao).
+    const char *arquivoMetricas;    // Relatorio de metricas (metricas.h), ou NULL.
+    int recarregar;             // 1 para reler ARQUIVO_PALAVRAS quando ele mudar (recarga.h).
+    const char *arquivoInstantaneo; // Instantaneo das partidas (instantaneo.h), ou NULL.
+} ConfigServidor;
+
+/**
+ * @brief Executa o servidor ate receber SIGINT ou SIGTERM.
+ * @param config Os parametros de execucao.
+ * @return 0 em caso de encerramento normal, 1 em caso de erro.
+ */
+int executarServidor (const ConfigServidor *config);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,365 @@
+/**
+ * @file sessao.c
+ * @brief Implementacao do motor de partidas sem entrada/saida.
+ *
+ * As regras sao as mesmas do laco interativo de main.c, montadas sobre
+ * verificarLetra e testarLetra (a sessao compacta consulta a palavra
+ * direto no dicionario). Nenhuma funcao deste arquivo le do teclado,
+ * escreve na tela, acessa arquivos ou pausa a execucao.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include "forca.h"
+#include "sessao.h"
+#include "metricas.h"
+
+/**
+ * @brief Inicia uma partida em uma sessao ja alocada.
+ *
+ * Equivale a preparacao de uma rodada em main.c: zera as letras
+ * utilizadas, reinicia a forca e as vidas do jogador. A tabela de
+ * posicoes da palavra e montada aqui, uma unica vez por partida.
+ *
+ * @param s A sessao a ser preenchida.
+ * @param nome O nome do jogador.
+ * @param palavra A palavra secreta.
+ * @return 0 em caso de sucesso, -1 se a palavra for vazia ou tiver mais de TAM_MAX_MASCARA caracteres.
+ */
+int iniciarSessao (Sessao *s, const char *nome, const char *palavra){
+    size_t tamanho=strlen(palavra),i;
+    if(tamanho==0||prepararMascara(palavra,&s->mascara)<0)  return -1;
+    // Copia o nome, truncando-o se necessario.
+    strncpy(s->jogador.nome,nome,TAM_MAX_PALAVRA-1);
+    s->jogador.nome[TAM_MAX_PALAVRA-1]='\0';
+    s->jogador.vidas=VIDAS;
+    memcpy(s->palavra,palavra,tamanho+1);
+    reiniciarForca(s->palavraNaForca,tamanho);
+    // Caracteres que nao sao letras ja aparecem revelados.
+    for(i=0;i<tamanho;i++)
+        if(!(s->mascara.completa&(1ULL<<i)))    s->palavraNaForca[i]=palavra[i];
+    s->reveladas=0;
+    s->letras=0;
+    s->estado=SESSAO_EM_JOGO;
+    CONTAR(CONTADOR_PARTIDAS);
+    return 0;
+}
+
+/**
+ * @brief Aloca e inicia uma nova sessao.
+ * @param nome O nome do jogador.
+ * @param palavra A palavra secreta.
+ * @return A nova sessao, ou NULL em caso de erro.
+ */
+Sessao *criarSessao (const char *nome, const char *palavra){
+    Sessao *s = malloc(sizeof(Sessao));
+    if(s==NULL) return NULL;
+    if(iniciarSessao(s,nome,palavra)<0){
+        free(s);
+        return NULL;
+    }
+    return s;
+}
+
+/**
+ * @brief Atualiza o estado da partida depois de um palpite.
+ * @param s A sessao.
+ */
+static void atualizarEstado (Sessao *s){
+    if(s->jogador.vidas<=0){
+        s->estado=SESSAO_DERROTA;
+        CONTAR(CONTADOR_DERROTAS);
+    }
+    // A palavra esta completa quando todas as posicoes foram reveladas.
+    else if(s->reveladas==s->mascara.completa){
+        s->estado=SESSAO_VITORIA;
+        CONTAR(CONTADOR_VITORIAS);
+    }
+}
+
+/**
+ * @brief Aplica um palpite de letra a partida.
+ *
+ * Uma letra repetida custa PENALIDADE_REPETIDA vidas e uma letra que
+ * nao existe na palavra custa uma vida.
+ *
+ * @param s A sessao.
+ * @param letra A letra chutada.
+ * @return O efeito do palpite.
+ */
+ResultadoJogada chutarLetra (Sessao *s, char letra){
+    ResultadoJogada r;
+    MEDICAO(inicio);
+    if(s->estado!=SESSAO_EM_JOGO)   return JOGADA_ENCERRADA;
+    // Apenas letras de A a Z tem um bit na mascara de letras.
+    if(!isascii((unsigned char)letra)||!isalpha((unsigned char)letra))  return JOGADA_INVALIDA;
+    INICIAR_MEDICAO(inicio);
+    if(verificarLetra(letra,&s->letras)){
+        s->jogador.vidas-=PENALIDADE_REPETIDA;
+        r=JOGADA_REPETIDA;
+        CONTAR(CONTADOR_LETRA_REPETIDA);
+    }
+    else if(testarLetra(letra,&s->mascara,&s->reveladas,s->palavraNaForca)==0){
+        s->jogador.vidas--;
+        r=JOGADA_ERRO;
+        CONTAR(CONTADOR_LETRA_ERRADA);
+    }
+    else    r=JOGADA_ACERTO;
+    atualizarEstado(s);
+    ENCERRAR_MEDICAO(FASE_PALPITE,inicio);
+    return r;
+}
+
+/**
+ * @brief Aplica um palpite da palavra inteira a partida.
+ *
+ * Acertar a palavra encerra a partida com vitoria; errar custa
+ * PENALIDADE_PALAVRA vidas.
+ *
+ * @param s A sessao.
+ * @param palavra A palavra chutada.
+ * @return O efeito do palpite.
+ */
+ResultadoJogada chutarPalavra (Sessao *s, const char *palavra){
+    MEDICAO(inicio);
+    if(s->estado!=SESSAO_EM_JOGO)   return JOGADA_ENCERRADA;
+    if(palavra==NULL||palavra[0]=='\0') return JOGADA_INVALIDA;
+    INICIAR_MEDICAO(inicio);
+    if(strcasecmp(s->palavra,palavra)==0){
+        s->estado=SESSAO_VITORIA;
+        CONTAR(CONTADOR_VITORIAS);
+        ENCERRAR_MEDICAO(FASE_PALPITE,inicio);
+        return JOGADA_ACERTO;
+    }
+    s->jogador.vidas-=PENALIDADE_PALAVRA;
+    CONTAR(CONTADOR_PALAVRA_ERRADA);
+    atualizarEstado(s);
+    ENCERRAR_MEDICAO(FASE_PALPITE,inicio);
+    return JOGADA_ERRO;
+}
+
+/**
+ * @brief Troca a palavra secreta de uma partida em andamento.
+ *
+ * Apenas a palavra e a sua tabela de posicoes mudam; como a nova palavra
+ * revela o mesmo que a antiga, reveladas e palavraNaForca continuam
+ * valendo.
+ *
+ * @param s A sessao.
+ * @param palavra A nova palavra secreta.
+ * @return 0 em caso de sucesso, -1 se o comprimento for diferente.
+ */
+int trocarPalavraSessao (Sessao *s, const char *palavra){
+    size_t tamanho=strlen(palavra);
+    if(tamanho!=strlen(s->palavra)) return -1;
+    prepararMascara(palavra,&s->mascara);
+    memcpy(s->palavra,palavra,tamanho+1);
+    return 0;
+}
+
+/**
+ * @brief Consulta a situacao atual da partida.
+ * @param s A sessao.
+ * @return O estado da partida.
+ */
+EstadoSessao consultarSessao (const Sessao *s){
+    return s->estado;
+}
+
+/**
+ * @brief Libera uma sessao criada com criarSessao.
+ * @param s A sessao a ser liberada.
+ */
+void destruirSessao (Sessao *s){
+    free(s);
+}
+_Static_assert(sizeof(SessaoCompacta)==24,"SessaoCompacta deve ocupar 24 bytes");
+
+/**
+ * @brief Indica se um caractere da palavra e uma letra a ser adivinhada.
+ * @param c O caractere.
+ * @return 1 para A-Z ou a-z, 0 caso contrario.
+ */
+static int ehLetra (char c){
+    return isascii((unsigned char)c)&&isalpha((unsigned char)c);
+}
+
+/**
+ * @brief Calcula as posicoes de uma letra numa palavra do dicionario.
+ *
+ * Faz o papel da tabela de posicoes (MascaraPalavra), que a sessao
+ * compacta nao guarda: a palavra tem no maximo TAM_MAX_MASCARA
+ * caracteres e ja esta no cache quando a sessao e consultada.
+ *
+ * @param palavra A palavra (nao terminada em '\0').
+ * @param n O comprimento da palavra.
+ * @param letra A letra, maiuscula.
+ * @return A mascara das posicoes da letra.
+ */
+static uint64_t posicoesDaLetra (const char *palavra, int n, char letra){
+    uint64_t posicoes=0;
+    int i;
+    for(i=0;i<n;i++)
+        if((palavra[i]&~0x20)==letra)   posicoes|=1ULL<<i;
+    return posicoes;
+}
+
+/**
+ * @brief Atualiza o estado de uma partida compacta depois de um palpite.
+ * @param s A sessao.
+ */
+static void atualizarEstadoCompacta (SessaoCompacta *s){
+    if(s->vidas<=0){
+        s->estado=SESSAO_DERROTA;
+        CONTAR(CONTADOR_DERROTAS);
+    }
+    else if(s->faltam==0){
+        s->estado=SESSAO_VITORIA;
+        CONTAR(CONTADOR_VITORIAS);
+    }
+}
+
+/**
+ * @brief Inicia uma partida compacta sobre uma palavra do dicionario.
+ *
+ * Caracteres que nao sao letras (hifen, por exemplo) nao precisam ser
+ * adivinhados, como em iniciarSessao.
+ *
+ * @param s A sessao a ser preenchida.
+ * @param d O dicionario (deve continuar aberto enquanto a sessao existir).
+ * @param palavra O indice da palavra secreta.
+ * @param jogador O identificador do jogador.
+ * @return 0 em caso de sucesso, -1 se o indice for invalido ou a palavra vazia.
+ */
+int iniciarSessaoCompacta (SessaoCompacta *s, const Dicionario *d, uint32_t palavra, uint32_t jogador){
+    const char *p;
+    int n,i;
+    if(palavra>=(uint32_t)d->quantidade)    return -1;
+    p=obterPalavra(d,(int)palavra,&n);
+    if(n==0)    return -1;
+    memset(s,0,sizeof(*s));
+    s->palavra=palavra;
+    s->jogador=jogador;
+    s->vidas=VIDAS;
+    s->estado=SESSAO_EM_JOGO;
+    for(i=0;i<n;i++)
+        if(ehLetra(p[i]))   s->faltam++;
+    CONTAR(CONTADOR_PARTIDAS);
+    return 0;
+}
+
+/**
+ * @brief Calcula as posicoes de uma letra na palavra de uma partida compacta.
+ * @param s A sessao.
+ * @param d O dicionario da sessao.
+ * @param letra A letra (maiuscula ou minuscula).
+ * @return A mascara das posicoes da letra (0 se ela nao aparece).
+ */
+uint64_t posicoesCompacta (const SessaoCompacta *s, const Dicionario *d, char letra){
+    const char *p;
+    int n;
+    // Com as letras de cada palavra ja calculadas (banco embutido ou binario), um erro nem le a palavra.
+    if(d->letras!=NULL&&(d->letras[s->palavra]&(1u<<((letra&~0x20)-'A')))==0)  return 0;
+    p=obterPalavra(d,(int)s->palavra,&n);
+    return posicoesDaLetra(p,n,letra&~0x20);
+}
+
+/**
+ * @brief Aplica um palpite de letra a uma partida compacta.
+ *
+ * Mesmas regras de chutarLetra.
+ *
+ * @param s A sessao.
+ * @param d O dicionario da sessao.
+ * @param letra A letra chutada.
+ * @return O efeito do palpite.
+ */
+ResultadoJogada chutarLetraCompacta (SessaoCompacta *s, const Dicionario *d, char letra){
+    ResultadoJogada r;
+    uint64_t achadas;
+    MEDICAO(inicio);
+    if(s->estado!=SESSAO_EM_JOGO)   return JOGADA_ENCERRADA;
+    if(!ehLetra(letra)) return JOGADA_INVALIDA;
+    INICIAR_MEDICAO(inicio);
+    if(verificarLetra(letra,&s->letras)){
+        s->vidas-=PENALIDADE_REPETIDA;
+        r=JOGADA_REPETIDA;
+        CONTAR(CONTADOR_LETRA_REPETIDA);
+    }
+    else{
+        achadas=posicoesCompacta(s,d,letra);
+        if(achadas==0){
+            s->vidas--;
+            r=JOGADA_ERRO;
+            CONTAR(CONTADOR_LETRA_ERRADA);
+        }
+        else{
+            s->reveladas|=achadas;
+            s->faltam-=__builtin_popcountll(achadas);
+            r=JOGADA_ACERTO;
+        }
+    }
+    atualizarEstadoCompacta(s);
+    ENCERRAR_MEDICAO(FASE_PALPITE,inicio);
+    return r;
+}
+
+/**
+ * @brief Aplica um palpite da palavra inteira a uma partida compacta.
+ *
+ * Mesmas regras de chutarPalavra.
+ *
+ * @param s A sessao.
+ * @param d O dicionario da sessao.
+ * @param palavra A palavra chutada.
+ * @return O efeito do palpite.
+ */
+ResultadoJogada chutarPalavraCompacta (SessaoCompacta *s, const Dicionario *d, const char *palavra){
+    const char *p;
+    int n;
+    MEDICAO(inicio);
+    if(s->estado!=SESSAO_EM_JOGO)   return JOGADA_ENCERRADA;
+    if(palavra==NULL||palavra[0]=='\0') return JOGADA_INVALIDA;
+    INICIAR_MEDICAO(inicio);
+    p=obterPalavra(d,(int)s->palavra,&n);
+    if(strlen(palavra)==(size_t)n&&strncasecmp(p,palavra,n)==0){
+        s->estado=SESSAO_VITORIA;
+        CONTAR(CONTADOR_VITORIAS);
+        ENCERRAR_MEDICAO(FASE_PALPITE,inicio);
+        return JOGADA_ACERTO;
+    }
+    s->vidas-=PENALIDADE_PALAVRA;
+    CONTAR(CONTADOR_PALAVRA_ERRADA);
+    atualizarEstadoCompacta(s);
+    ENCERRAR_MEDICAO(FASE_PALPITE,inicio);
+    return JOGADA_ERRO;
+}
+
+/**
+ * @brief Monta a forca (acertos e underscores) e a palavra secreta de uma partida compacta.
+ *
+ * A forca sai igual a palavraNaForca da Sessao: letras reveladas em
+ * maiusculas, as demais como '_' e os outros caracteres como estao.
+ *
+ * @param s A sessao.
+ * @param d O dicionario da sessao.
+ * @param palavraNaForca Recebe a forca (pelo menos TAM_MAX_MASCARA+1 bytes).
+ * @param palavra Recebe a palavra secreta (pode ser NULL; pelo menos TAM_MAX_MASCARA+1 bytes).
+ */
+void montarForcaCompacta (const SessaoCompacta *s, const Dicionario *d, char *palavraNaForca, char *palavra){
+    const char *p;
+    int n,i;
+    p=obterPalavra(d,(int)s->palavra,&n);
+    for(i=0;i<n;i++){
+        if(!ehLetra(p[i]))  palavraNaForca[i]=p[i];
+        else if(s->reveladas&(1ULL<<i)) palavraNaForca[i]=p[i]&~0x20;
+        else    palavraNaForca[i]='_';
+    }
+    palavraNaForca[n]='\0';
+    if(palavra!=NULL){
+        memcpy(palavra,p,n);
+        palavra[n]='\0';
+    }
+}
\ No newline at end of file
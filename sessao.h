@@ -0,0 +1,179 @@
+/**
+ * @file sessao.h
+ * @brief Arquivo de cabecalho do motor de partidas sem entrada/saida.
+ *
+ * Uma Sessao guarda todo o estado de uma partida e aplica as regras do
+ * jogo (vidas, penalidades, vitoria/derrota) sem ler do teclado, escrever
+ * na tela ou pausar. Cada sessao e independente, de modo que um mesmo
+ * processo pode conduzir qualquer numero de partidas ao mesmo tempo.
+ *
+ * A SessaoCompacta aplica as mesmas regras guardando apenas o indice da
+ * palavra no dicionario compartilhado e as mascaras da partida (24 bytes,
+ * contra mais de 500 da Sessao). A palavra e a forca sao remontadas a
+ * partir do dicionario quando precisam ser exibidas. E a representacao
+ * usada pelo servidor, que pode manter milhoes de partidas abertas.
+ */
+
+#ifndef SESSAO_H
+#define SESSAO_H
+
+#include "forca.h"
+#include "dicionario.h"
+
+/**
+ * @enum EstadoSessao
+ * @brief Situacao atual de uma partida.
+ */
+typedef enum{
+    SESSAO_EM_JOGO,     // A partida ainda aceita palpites.
+    SESSAO_VITORIA,     // O jogador descobriu a palavra.
+    SESSAO_DERROTA      // O jogador ficou sem vidas.
+} EstadoSessao;
+
+/**
+ * @enum ResultadoJogada
+ * @brief Efeito de um palpite sobre a partida.
+ */
+typedef enum{
+    JOGADA_ACERTO,      // A letra existe na palavra, ou a palavra foi acertada.
+    JOGADA_ERRO,        // A letra nao existe na palavra, ou a palavra esta errada.
+    JOGADA_REPETIDA,    // A letra ja havia sido utilizada.
+    JOGADA_INVALIDA,    // O palpite nao e uma letra ou palavra valida.
+    JOGADA_ENCERRADA    // A partida ja terminou; nada foi alterado.
+} ResultadoJogada;
+
+/**
+ * @struct Sessao
+ * @brief Estado completo de uma partida.
+ */
+typedef struct{
+    Jogador jogador;                        // Nome e vidas do jogador.
+    char palavra[TAM_MAX_PALAVRA];          // A palavra secreta.
+    char palavraNaForca[TAM_MAX_PALAVRA];   // Acertos e underscores.
+    MascaraPalavra mascara;                 // Posicoes de cada letra na palavra.
+    uint64_t reveladas;                     // Posicoes ja descobertas.
+    uint32_t letras;                        // Letras ja utilizadas (bit 0 = A).
+    EstadoSessao estado;                    // Situacao atual da partida.
+} Sessao;
+
+/**
+ * @struct SessaoCompacta
+ * @brief Estado minimo de uma partida sobre uma palavra do dicionario.
+ */
+typedef struct{
+    uint64_t reveladas;     // Posicoes ja descobertas.
+    uint32_t palavra;       // Indice da palavra secreta no dicionario.
+    uint32_t jogador;       // Identificador do jogador (definido por quem cria a sessao).
+    uint32_t letras;        // Letras ja utilizadas (bit 0 = A).
+    int8_t vidas;           // Vidas restantes.
+    uint8_t estado;         // Situacao atual da partida (EstadoSessao).
+    uint8_t faltam;         // Posicoes de letras ainda ocultas.
+    uint8_t reservado;
+} SessaoCompacta;
+
+/**
+ * @brief Inicia uma partida em uma sessao ja alocada.
+ * @param s A sessao a ser preenchida.
+ * @param nome O nome do jogador.
+ * @param palavra A palavra secreta.
+ * @return 0 em caso de sucesso, -1 se a palavra for vazia ou tiver mais de TAM_MAX_MASCARA caracteres.
+ */
+int iniciarSessao (Sessao *s, const char *nome, const char *palavra);
+
+/**
+ * @brief Aloca e inicia uma nova sessao.
+ * @param nome O nome do jogador.
+ * @param palavra A palavra secreta.
+ * @return A nova sessao, ou NULL em caso de erro.
+ */
+Sessao *criarSessao (const char *nome, const char *palavra);
+
+/**
+ * @brief Aplica um palpite de letra a partida.
+ * @param s A sessao.
+ * @param letra A letra chutada.
+ * @return O efeito do palpite.
+ */
+ResultadoJogada chutarLetra (Sessao *s, char letra);
+
+/**
+ * @brief Aplica um palpite da palavra inteira a partida.
+ * @param s A sessao.
+ * @param palavra A palavra chutada.
+ * @return O efeito do palpite.
+ */
+ResultadoJogada chutarPalavra (Sessao *s, const char *palavra);
+
+/**
+ * @brief Troca a palavra secreta de uma partida em andamento.
+ *
+ * A nova palavra deve ter o mesmo comprimento e ser compativel com tudo
+ * o que ja foi revelado (ver maligno.h): a forca, as letras utilizadas e
+ * as vidas continuam como estao.
+ *
+ * @param s A sessao.
+ * @param palavra A nova palavra secreta.
+ * @return 0 em caso de sucesso, -1 se o comprimento for diferente.
+ */
+int trocarPalavraSessao (Sessao *s, const char *palavra);
+
+/**
+ * @brief Consulta a situacao atual da partida.
+ * @param s A sessao.
+ * @return O estado da partida.
+ */
+EstadoSessao consultarSessao (const Sessao *s);
+
+/**
+ * @brief Libera uma sessao criada com criarSessao.
+ * @param s A sessao a ser liberada.
+ */
+void destruirSessao (Sessao *s);
+
+/**
+ * @brief Inicia uma partida compacta sobre uma palavra do dicionario.
+ * @param s A sessao a ser preenchida.
+ * @param d O dicionario (deve continuar aberto enquanto a sessao existir).
+ * @param palavra O indice da palavra secreta.
+ * @param jogador O identificador do jogador.
+ * @return 0 em caso de sucesso, -1 se o indice for invalido ou a palavra vazia.
+ */
+int iniciarSessaoCompacta (SessaoCompacta *s, const Dicionario *d, uint32_t palavra, uint32_t jogador);
+
+/**
+ * @brief Aplica um palpite de letra a uma partida compacta.
+ * @param s A sessao.
+ * @param d O dicionario da sessao.
+ * @param letra A letra chutada.
+ * @return O efeito do palpite.
+ */
+ResultadoJogada chutarLetraCompacta (SessaoCompacta *s, const Dicionario *d, char letra);
+
+/**
+ * @brief Calcula as posicoes de uma letra na palavra de uma partida compacta.
+ * @param s A sessao.
+ * @param d O dicionario da sessao.
+ * @param letra A letra (maiuscula ou minuscula).
+ * @return A mascara das posicoes da letra (0 se ela nao aparece).
+ */
+uint64_t posicoesCompacta (const SessaoCompacta *s, const Dicionario *d, char letra);
+
+/**
+ * @brief Aplica um palpite da palavra inteira a uma partida compacta.
+ * @param s A sessao.
+ * @param d O dicionario da sessao.
+ * @param palavra A palavra chutada.
+ * @return O efeito do palpite.
+ */
+ResultadoJogada chutarPalavraCompacta (SessaoCompacta *s, const Dicionario *d, const char *palavra);
+
+/**
+ * @brief Monta a forca (acertos e underscores) e a palavra secreta de uma partida compacta.
+ * @param s A sessao.
+ * @param d O dicionario da sessao.
+ * @param palavraNaForca Recebe a forca (pelo menos TAM_MAX_MASCARA+1 bytes).
+ * @param palavra Recebe a palavra secreta (pode ser NULL; pelo menos TAM_MAX_MASCARA+1 bytes).
+ */
+void montarForcaCompacta (const SessaoCompacta *s, const Dicionario *d, char *palavraNaForca, char *palavra);
+
+#endif
\ No newline at end of file
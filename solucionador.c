@@ -0,0 +1,298 @@
+/**
+ * @file solucionador.c
+ * @brief Implementacao do jogador automatico.
+ *
+ * Para cada comprimento de palavra, guarda um conjunto de bits por letra
+ * (palavras que contem a letra) e um por letra e posicao (palavras com a
+ * letra naquela posicao). Um palpite vira uma sequencia de ANDs sobre o
+ * conjunto de candidatos.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "forca.h"
+#include "solucionador.h"
+
+// Ordem de chutes usada quando nao ha candidatos no dicionario.
+#define ORDEM_FREQUENCIA "AEOSRINDMUTCLPVGHQBFZJXKWY"
+
+/**
+ * @brief Monta as tabelas do solucionador a partir de um dicionario.
+ *
+ * Duas passadas pelo dicionario: a primeira conta as palavras de cada
+ * comprimento, a segunda preenche os conjuntos de bits. Por fim, o
+ * primeiro palpite de cada comprimento, o mais caro de escolher (todos
+ * os candidatos) e o mesmo em toda partida, e calculado uma vez.
+ *
+ * @param s O solucionador.
+ * @param d O dicionario (deve permanecer aberto enquanto o solucionador for usado).
+ * @return 0 em caso de sucesso, -1 em caso de falta de memoria.
+ */
+int criarSolucionador (Solucionador *s, const Dicionario *d){
+    int i,j,n,c,t,preenchidas[TAM_MAX_MASCARA+1]={0};
+    const char *palavra;
+    EstadoSolucao e;
+    memset(s,0,sizeof(*s));
+    s->dicionario=d;
+    for(i=0;i<d->quantidade;i++)    s->grupos[d->tamanho[i]].quantidade++;
+    for(t=1;t<=TAM_MAX_MASCARA;t++){
+        GrupoTamanho *g = &s->grupos[t];
+        if(g->quantidade==0)    continue;
+        g->blocos=(g->quantidade+63)/64;
+        g->indices=malloc(g->quantidade*sizeof(int));
+        g->contem=calloc((size_t)TAM_ALFABETO*g->blocos,sizeof(uint64_t));
+        g->naPosicao=calloc((size_t)t*TAM_ALFABETO*g->blocos,sizeof(uint64_t));
+        if(g->indices==NULL||g->contem==NULL||g->naPosicao==NULL){
+            destruirSolucionador(s);
+            return -1;
+        }
+    }
+    for(i=0;i<d->quantidade;i++){
+        palavra=obterPalavra(d,i,&n);
+        GrupoTamanho *g = &s->grupos[n];
+        int k=preenchidas[n]++;
+        uint64_t bit=1ULL<<(k%64);
+        g->indices[k]=i;
+        for(j=0;j<n;j++){
+            c=toupper((unsigned char)palavra[j])-'A';
+            if(c<0||c>=TAM_ALFABETO)    continue;
+            g->contem[(size_t)c*g->blocos+k/64]|=bit;
+            g->naPosicao[((size_t)j*TAM_ALFABETO+c)*g->blocos+k/64]|=bit;
+        }
+    }
+    for(t=1;t<=TAM_MAX_MASCARA;t++){
+        if(s->grupos[t].quantidade==0)  continue;
+        if(iniciarSolucao(s,&e,t)<0){
+            destruirSolucionador(s);
+            return -1;
+        }
+        s->grupos[t].primeiraLetra=escolherLetra(&e,0);
+        encerrarSolucao(&e);
+    }
+    return 0;
+}
+
+/**
+ * @brief Libera as tabelas do solucionador.
+ * @param s O solucionador.
+ */
+void destruirSolucionador (Solucionador *s){
+    int t;
+    for(t=0;t<=TAM_MAX_MASCARA;t++){
+        free(s->grupos[t].indices);
+        free(s->grupos[t].contem);
+        free(s->grupos[t].naPosicao);
+    }
+    memset(s,0,sizeof(*s));
+}
+
+/**
+ * @brief Inicia o conjunto de candidatos para uma palavra de comprimento conhecido.
+ * @param s O solucionador.
+ * @param e O estado a ser preenchido.
+ * @param tamanho O comprimento da palavra secreta.
+ * @return 0 em caso de sucesso, -1 em caso de falta de memoria.
+ */
+int iniciarSolucao (const Solucionador *s, EstadoSolucao *e, int tamanho){
+    const GrupoTamanho *g = &s->grupos[tamanho>=0&&tamanho<=TAM_MAX_MASCARA?tamanho:0];
+    int resto;
+    uint32_t capacidade=16;
+    e->grupo=g;
+    e->tamanho=tamanho;
+    while(capacidade<2*(uint32_t)g->quantidade)   capacidade*=2;
+    e->candidatos=malloc((g->blocos>0?g->blocos:1)*sizeof(uint64_t));
+    e->classes=calloc(capacidade,sizeof(ClassePadrao));
+    e->mascaraClasses=capacidade-1;
+    e->geracao=0;
+    if(e->candidatos==NULL||e->classes==NULL){
+        encerrarSolucao(e);
+        return -1;
+    }
+    // Todas as palavras do comprimento comecam como candidatas.
+    if(g->blocos>0){
+        memset(e->candidatos,0xff,g->blocos*sizeof(uint64_t));
+        resto=g->quantidade%64;
+        if(resto!=0)    e->candidatos[g->blocos-1]=(1ULL<<resto)-1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Remove os candidatos incompativeis com o resultado de um palpite.
+ *
+ * Um erro elimina toda palavra que contem a letra. Um acerto exige a
+ * letra exatamente nas posicoes reveladas, e em nenhuma outra.
+ *
+ * @param e O estado da solucao.
+ * @param letra A letra chutada (A-Z).
+ * @param posicoes As posicoes reveladas pela letra (0 se a letra nao existe na palavra).
+ */
+void filtrarCandidatos (EstadoSolucao *e, char letra, uint64_t posicoes){
+    const GrupoTamanho *g = e->grupo;
+    const uint64_t *conjunto;
+    int c=(letra&~0x20)-'A',b,p;
+    if(posicoes==0){
+        conjunto=&g->contem[(size_t)c*g->blocos];
+        for(b=0;b<g->blocos;b++)    e->candidatos[b]&=~conjunto[b];
+        return;
+    }
+    for(p=0;p<e->tamanho;p++){
+        conjunto=&g->naPosicao[((size_t)p*TAM_ALFABETO+c)*g->blocos];
+        if(posicoes&(1ULL<<p))
+            for(b=0;b<g->blocos;b++)    e->candidatos[b]&=conjunto[b];
+        else
+            for(b=0;b<g->blocos;b++)    e->candidatos[b]&=~conjunto[b];
+    }
+}
+
+/**
+ * @brief Conta os candidatos restantes.
+ * @param e O estado da solucao.
+ * @return O numero de candidatos.
+ */
+int contarCandidatos (const EstadoSolucao *e){
+    int b,n=0;
+    for(b=0;b<e->grupo->blocos;b++) n+=__builtin_popcountll(e->candidatos[b]);
+    return n;
+}
+
+/**
+ * @brief Divide os candidatos que contem uma letra pelos padroes de posicoes.
+ *
+ * Para cada bloco de 64 candidatos, o padrao de cada um e montado a
+ * partir dos bits de naPosicao (so os bits ligados sao percorridos), e os
+ * padroes sao contados em uma tabela hash de enderecamento aberto, que e
+ * invalidada de uma letra para outra so trocando a geracao.
+ *
+ * @param e O estado da solucao.
+ * @param c A letra (0 = A).
+ * @param acertos Recebe o numero de candidatos que contem a letra.
+ * @return A soma dos quadrados dos tamanhos das classes de acerto.
+ */
+static uint64_t dividirCandidatos (EstadoSolucao *e, int c, int *acertos){
+    const GrupoTamanho *g = e->grupo;
+    const uint64_t *conjunto=&g->contem[(size_t)c*g->blocos];
+    uint64_t h,m,padrao,soma=0,padroes[64];
+    int b,p,k,n=0;
+    ClassePadrao *classe;
+    uint32_t i;
+    // Geracao 0 nunca e valida: ao dar a volta, a tabela e limpa.
+    if(++e->geracao==0){
+        memset(e->classes,0,((size_t)e->mascaraClasses+1)*sizeof(ClassePadrao));
+        e->geracao=1;
+    }
+    for(b=0;b<g->blocos;b++){
+        h=e->candidatos[b]&conjunto[b];
+        if(h==0)    continue;
+        n+=__builtin_popcountll(h);
+        for(m=h;m!=0;m&=m-1)    padroes[__builtin_ctzll(m)]=0;
+        for(p=0;p<e->tamanho;p++)
+            for(m=h&g->naPosicao[((size_t)p*TAM_ALFABETO+c)*g->blocos+b];m!=0;m&=m-1)
+                padroes[__builtin_ctzll(m)]|=1ULL<<p;
+        for(;h!=0;h&=h-1){
+            k=__builtin_ctzll(h);
+            padrao=padroes[k];
+            i=(uint32_t)((padrao*0x9e3779b97f4a7c15ULL)>>32)&e->mascaraClasses;
+            while(e->classes[i].geracao==e->geracao&&e->classes[i].padrao!=padrao)
+                i=(i+1)&e->mascaraClasses;
+            classe=&e->classes[i];
+            if(classe->geracao!=e->geracao){
+                classe->geracao=e->geracao;
+                classe->padrao=padrao;
+                classe->contagem=0;
+            }
+            // (k+1)^2 = k^2 + 2k + 1: a soma acompanha cada insercao.
+            soma+=2*(uint64_t)classe->contagem+1;
+            classe->contagem++;
+        }
+    }
+    *acertos=n;
+    return soma;
+}
+
+/**
+ * @brief Escolhe a proxima letra a chutar.
+ * @param e O estado da solucao (a tabela de padroes e reaproveitada).
+ * @param usadas A mascara das letras ja utilizadas (bit 0 = A).
+ * @return A letra escolhida, ou '\0' se todas ja foram usadas.
+ */
+char escolherLetra (EstadoSolucao *e, uint32_t usadas){
+    const char *ordem=ORDEM_FREQUENCIA;
+    uint64_t nota,melhorNota=UINT64_MAX;
+    int i,c,n,total=contarCandidatos(e),melhor=-1,melhorAcertos=-1;
+    if(usadas==0&&e->grupo->primeiraLetra!='\0'&&total==e->grupo->quantidade)   return e->grupo->primeiraLetra;
+    // Percorre as letras em ordem de frequencia para desempatar pelas mais comuns.
+    for(i=0;ordem[i]!='\0';i++){
+        c=ordem[i]-'A';
+        if(usadas&(1u<<c))  continue;
+        // A classe do erro sao os candidatos sem a letra.
+        nota=dividirCandidatos(e,c,&n);
+        nota+=(uint64_t)(total-n)*(uint64_t)(total-n);
+        if(nota<melhorNota||(nota==melhorNota&&n>melhorAcertos)){
+            melhor=c;
+            melhorNota=nota;
+            melhorAcertos=n;
+        }
+    }
+    return melhor<0?'\0':'A'+melhor;
+}
+
+/**
+ * @brief Libera o estado de uma solucao.
+ * @param e O estado da solucao.
+ */
+void encerrarSolucao (EstadoSolucao *e){
+    free(e->candidatos);
+    free(e->classes);
+    e->candidatos=NULL;
+    e->classes=NULL;
+}
+
+/**
+ * @brief Retorna o unico candidato restante, copiado para palavra.
+ * @param s O solucionador.
+ * @param e O estado da solucao.
+ * @param palavra Recebe a palavra.
+ */
+static void copiarUnicoCandidato (const Solucionador *s, const EstadoSolucao *e, char *palavra){
+    const char *origem;
+    int b,n;
+    for(b=0;e->candidatos[b]==0;b++);
+    origem=obterPalavra(s->dicionario,e->grupo->indices[b*64+__builtin_ctzll(e->candidatos[b])],&n);
+    memcpy(palavra,origem,n);
+    palavra[n]='\0';
+}
+
+/**
+ * @brief Joga uma sessao ate o fim usando o solucionador.
+ * @param s O solucionador.
+ * @param sessao A sessao, ja iniciada.
+ * @return O numero de palpites feitos, ou -1 em caso de falta de memoria.
+ */
+int jogarSessao (const Solucionador *s, Sessao *sessao){
+    EstadoSolucao e;
+    char letra,palavra[TAM_MAX_PALAVRA];
+    uint64_t antes;
+    int palpites=0;
+    if(iniciarSolucao(s,&e,(int)strlen(sessao->palavra))<0) return -1;
+    while(consultarSessao(sessao)==SESSAO_EM_JOGO){
+        // Com um unico candidato, arrisca a palavra inteira.
+        if(contarCandidatos(&e)==1){
+            copiarUnicoCandidato(s,&e,palavra);
+            palpites++;
+            if(chutarPalavra(sessao,palavra)==JOGADA_ACERTO)    break;
+            // Palavra fora do dicionario: descarta o candidato.
+            memset(e.candidatos,0,e.grupo->blocos*sizeof(uint64_t));
+            continue;
+        }
+        letra=escolherLetra(&e,sessao->letras);
+        if(letra=='\0') break;
+        antes=sessao->reveladas;
+        chutarLetra(sessao,letra);
+        palpites++;
+        filtrarCandidatos(&e,letra,sessao->reveladas&~antes);
+    }
+    encerrarSolucao(&e);
+    return palpites;
+}
\ No newline at end of file
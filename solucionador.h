@@ -0,0 +1,143 @@
+/**
+ * @file solucionador.h
+ * @brief Arquivo de cabecalho do jogador automatico.
+ *
+ * O solucionador mantem o conjunto de palavras do dicionario que ainda
+ * sao consistentes com o padrao revelado e com as letras erradas. Os
+ * candidatos sao representados por conjuntos de bits, separados por
+ * comprimento de palavra, de modo que cada palpite filtra o conjunto
+ * com poucas operacoes AND por bloco de 64 palavras.
+ */
+
+#ifndef SOLUCIONADOR_H
+#define SOLUCIONADOR_H
+
+#include <stdint.h>
+#include "forca.h"
+#include "dicionario.h"
+#include "sessao.h"
+
+/**
+ * @struct GrupoTamanho
+ * @brief Palavras do dicionario de um mesmo comprimento e seus conjuntos de bits.
+ */
+typedef struct{
+    int quantidade;         // Numero de palavras do grupo.
+    int blocos;             // Numero de uint64_t de cada conjunto de bits.
+    int *indices;           // Indice de cada palavra no dicionario.
+    uint64_t *contem;       // [letra][bloco]: palavras que contem a letra.
+    uint64_t *naPosicao;    // [posicao][letra][bloco]: palavras com a letra na posicao.
+    char primeiraLetra;     // Escolha de escolherLetra com todos os candidatos (calculada uma vez).
+} GrupoTamanho;
+
+/**
+ * @struct Solucionador
+ * @brief Tabelas do solucionador, montadas uma vez e somente lidas depois.
+ *
+ * Pode ser compartilhado entre threads; o estado de cada partida fica
+ * em um EstadoSolucao.
+ */
+typedef struct{
+    const Dicionario *dicionario;
+    GrupoTamanho grupos[TAM_MAX_MASCARA+1];
+} Solucionador;
+
+/**
+ * @struct ClassePadrao
+ * @brief Posicao da tabela hash em que escolherLetra conta os candidatos de cada padrao.
+ */
+typedef struct{
+    uint64_t padrao;            // Posicoes em que a letra aparece.
+    uint32_t geracao;           // A posicao so vale se for igual a EstadoSolucao.geracao.
+    uint32_t contagem;          // Candidatos com esse padrao.
+} ClassePadrao;
+
+/**
+ * @struct EstadoSolucao
+ * @brief Candidatos restantes em uma partida.
+ */
+typedef struct{
+    const GrupoTamanho *grupo;  // Grupo do comprimento da palavra secreta.
+    int tamanho;                // Comprimento da palavra secreta.
+    uint64_t *candidatos;       // Conjunto de bits dos candidatos restantes.
+    ClassePadrao *classes;      // Tabela de padroes (potencia de 2, pelo menos o dobro do grupo).
+    uint32_t mascaraClasses;    // Tamanho da tabela menos 1.
+    uint32_t geracao;           // Avaliacao atual; trocar de letra so incrementa (sem limpar a tabela).
+} EstadoSolucao;
+
+/**
+ * @brief Monta as tabelas do solucionador a partir de um dicionario.
+ * @param s O solucionador.
+ * @param d O dicionario (deve permanecer aberto enquanto o solucionador for usado).
+ * @return 0 em caso de sucesso, -1 em caso de falta de memoria.
+ */
+int criarSolucionador (Solucionador *s, const Dicionario *d);
+
+/**
+ * @brief Libera as tabelas do solucionador.
+ * @param s O solucionador.
+ */
+void destruirSolucionador (Solucionador *s);
+
+/**
+ * @brief Inicia o conjunto de candidatos para uma palavra de comprimento conhecido.
+ * @param s O solucionador.
+ * @param e O estado a ser preenchido.
+ * @param tamanho O comprimento da palavra secreta.
+ * @return 0 em caso de sucesso, -1 em caso de falta de memoria.
+ */
+int iniciarSolucao (const Solucionador *s, EstadoSolucao *e, int tamanho);
+
+/**
+ * @brief Remove os candidatos incompativeis com o resultado de um palpite.
+ * @param e O estado da solucao.
+ * @param letra A letra chutada (A-Z).
+ * @param posicoes As posicoes reveladas pela letra (0 se a letra nao existe na palavra).
+ */
+void filtrarCandidatos (EstadoSolucao *e, char letra, uint64_t posicoes);
+
+/**
+ * @brief Conta os candidatos restantes.
+ * @param e O estado da solucao.
+ * @return O numero de candidatos.
+ */
+int contarCandidatos (const EstadoSolucao *e);
+
+/**
+ * @brief Escolhe a proxima letra a chutar.
+ *
+ * Escolhe a letra ainda nao utilizada que melhor divide os candidatos.
+ * Cada letra separa os candidatos em classes: os que nao a contem (o
+ * erro) e, entre os que a contem, um grupo por padrao de posicoes
+ * reveladas. A letra escolhida e a de menor tamanho esperado da classe
+ * que sobra (soma dos quadrados dos tamanhos); empates ficam com a de
+ * mais acertos e, depois, com a mais frequente na lingua. Uma letra que
+ * todos os candidatos contem nas mesmas posicoes nao informa nada e tem
+ * a pior nota, igual a de uma letra que nenhum contem.
+ *
+ * @param e O estado da solucao (a tabela de padroes e reaproveitada).
+ * @param usadas A mascara das letras ja utilizadas (bit 0 = A).
+ * @return A letra escolhida, ou '\0' se todas ja foram usadas.
+ */
+char escolherLetra (EstadoSolucao *e, uint32_t usadas);
+
+/**
+ * @brief Libera o estado de uma solucao.
+ * @param e O estado da solucao.
+ */
+void encerrarSolucao (EstadoSolucao *e);
+
+/**
+ * @brief Joga uma sessao ate o fim usando o solucionador.
+ *
+ * Chuta a palavra inteira quando resta um unico candidato; se nenhum
+ * candidato restar (palavra fora do dicionario), segue chutando letras
+ * em ordem de frequencia.
+ *
+ * @param s O solucionador.
+ * @param sessao A sessao, ja iniciada.
+ * @return O numero de palpites feitos, ou -1 em caso de falta de memoria.
+ */
+int jogarSessao (const Solucionador *s, Sessao *sessao);
+
+#endif
\ No newline at end of file
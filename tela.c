@@ -0,0 +1,187 @@
+/**
+ * @file tela.c
+ * @brief Implementacao do desenho da partida com sequencias ANSI.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include "tela.h"
+#include "metricas.h"
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <unistd.h>
+    #include <sys/ioctl.h>
+#endif
+
+// Sequencias ANSI: cursor no topo e limpeza da tela inteira.
+#define ANSI_LIMPAR "\x1b[H\x1b[2J"
+// Linhas usadas abaixo do quadro pelas perguntas e mensagens de uma jogada.
+#define LINHAS_PERGUNTAS 6
+
+/**
+ * @brief Acrescenta bytes ao quadro em montagem.
+ * @param t A tela.
+ * @param s Os bytes.
+ * @param n O numero de bytes.
+ */
+static void anexar (Tela *t, const char *s, int n){
+    if(t->tamQuadro+n>TAM_QUADRO)   n=TAM_QUADRO-t->tamQuadro;
+    memcpy(t->quadro+t->tamQuadro,s,n);
+    t->tamQuadro+=n;
+}
+
+/**
+ * @brief Acrescenta ao quadro a sequencia que move o cursor para o inicio de uma linha.
+ * @param t A tela.
+ * @param linha A linha, a partir de 1.
+ */
+static void moverCursor (Tela *t, int linha){
+    char seq[16];
+    anexar(t,seq,snprintf(seq,sizeof(seq),"\x1b[%d;1H",linha));
+}
+
+/**
+ * @brief Consulta o numero de linhas do terminal.
+ * @return O numero de linhas, ou 0 se a saida nao for um terminal.
+ */
+static int alturaTerminal (void){
+    #ifdef _WIN32
+        CONSOLE_SCREEN_BUFFER_INFO info;
+        if(!GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE),&info))  return 0;
+        return info.srWindow.Bottom-info.srWindow.Top+1;
+    #else
+        struct winsize ws;
+        if(ioctl(STDOUT_FILENO,TIOCGWINSZ,&ws)<0)   return 0;
+        return ws.ws_row;
+    #endif
+}
+
+/**
+ * @brief Envia o quadro ao terminal com uma unica escrita.
+ *
+ * O que estiver pendente no buffer do stdout (perguntas feitas com
+ * printf) sai antes, para manter a ordem da saida.
+ *
+ * @param t A tela.
+ */
+static void enviarQuadro (Tela *t){
+    fflush(stdout);
+    #ifdef _WIN32
+        fwrite(t->quadro,1,t->tamQuadro,stdout);
+        fflush(stdout);
+    #else
+        int escritos=0,n;
+        while(escritos<t->tamQuadro){
+            n=write(STDOUT_FILENO,t->quadro+escritos,t->tamQuadro-escritos);
+            if(n<=0)    break;
+            escritos+=n;
+        }
+    #endif
+    t->tamQuadro=0;
+}
+
+/**
+ * @brief Prepara a tela (no Windows, ativa as sequencias ANSI no console).
+ * @param t A tela.
+ */
+void iniciarTela (Tela *t){
+    #ifdef _WIN32
+        HANDLE console=GetStdHandle(STD_OUTPUT_HANDLE);
+        DWORD modo;
+        // ENABLE_VIRTUAL_TERMINAL_PROCESSING (Windows 10 ou superior).
+        if(GetConsoleMode(console,&modo))   SetConsoleMode(console,modo|0x0004);
+    #endif
+    t->tamQuadro=0;
+    t->numLinhas=0;
+    t->numAnteriores=0;
+}
+
+/**
+ * @brief Limpa o terminal e descarta o ultimo quadro.
+ * @param t A tela.
+ */
+void limparTela (Tela *t){
+    anexar(t,ANSI_LIMPAR,sizeof(ANSI_LIMPAR)-1);
+    enviarQuadro(t);
+    t->numAnteriores=0;
+}
+
+/**
+ * @brief Monta as linhas do quadro, no mesmo formato de desenharForca().
+ * @param t A tela.
+ * @param p O jogador.
+ * @param palavra A string que mostra os acertos e os underscores.
+ * @param letras A mascara das letras ja utilizadas.
+ */
+static void montarLinhas (Tela *t, const Jogador *p, const char *palavra, uint32_t letras){
+    const char *desenho=obterDesenho(p->vidas),*fim;
+    char *linha;
+    int i,n=0,k;
+    t->linhas[n++][0]='\0';
+    t->linhas[n++][0]='\0';
+    // Letras utilizadas.
+    linha=t->linhas[n++];
+    k=sprintf(linha,"\tLetras utilizadas: ");
+    for(i=0;i<TAM_ALFABETO;i++){
+        if(letras&(1u<<i)){
+            linha[k++]='A'+i;
+            linha[k++]=' ';
+        }
+    }
+    linha[k]='\0';
+    t->linhas[n++][0]='\0';
+    // Desenho da forca, quebrado nas linhas.
+    while(*desenho!='\0'&&n<MAX_LINHAS_TELA-2){
+        fim=strchr(desenho,'\n');
+        k=fim!=NULL?(int)(fim-desenho):(int)strlen(desenho);
+        if(k>TAM_LINHA_TELA-1)  k=TAM_LINHA_TELA-1;
+        memcpy(t->linhas[n],desenho,k);
+        t->linhas[n++][k]='\0';
+        desenho=fim!=NULL?fim+1:desenho+k;
+    }
+    // Palavra na forca.
+    linha=t->linhas[n++];
+    k=sprintf(linha,"|\tPalavra: ");
+    for(i=0;palavra[i]!='\0'&&k<TAM_LINHA_TELA-2;i++){
+        linha[k++]=toupper((unsigned char)palavra[i]);
+        linha[k++]=' ';
+    }
+    linha[k]='\0';
+    t->linhas[n++][0]='\0';
+    t->numLinhas=n;
+}
+
+/**
+ * @brief Desenha o estado atual do jogo, reescrevendo so as linhas alteradas.
+ * @param t A tela.
+ * @param p O jogador (para saber as vidas).
+ * @param palavra A string que mostra os acertos e os underscores.
+ * @param letras A mascara das letras ja utilizadas (bit 0 = A).
+ */
+void desenharQuadro (Tela *t, const Jogador *p, const char *palavra, uint32_t letras){
+    int i,completo=t->numAnteriores==0,altura=alturaTerminal();
+    MEDICAO(inicio);
+    INICIAR_MEDICAO(inicio);
+    montarLinhas(t,p,palavra,letras);
+    // Em um terminal baixo, as perguntas rolam a tela e as linhas antigas
+    // mudam de lugar; nesse caso o quadro e sempre redesenhado por inteiro.
+    if(altura>0&&altura<t->numLinhas+LINHAS_PERGUNTAS)  completo=1;
+    if(completo)    anexar(t,ANSI_LIMPAR,sizeof(ANSI_LIMPAR)-1);
+    for(i=0;i<t->numLinhas;i++){
+        if(!completo&&i<t->numAnteriores&&strcmp(t->linhas[i],t->anteriores[i])==0)
+            continue;
+        // Reescreve a linha e apaga o que sobrar da versao anterior ("\x1b[K").
+        moverCursor(t,i+1);
+        anexar(t,t->linhas[i],(int)strlen(t->linhas[i]));
+        anexar(t,"\x1b[K",3);
+        strcpy(t->anteriores[i],t->linhas[i]);
+    }
+    // Cursor abaixo do quadro; apaga as perguntas e mensagens da jogada anterior.
+    moverCursor(t,t->numLinhas+1);
+    anexar(t,"\x1b[J",3);
+    t->numAnteriores=t->numLinhas;
+    enviarQuadro(t);
+    ENCERRAR_MEDICAO(FASE_DESENHO,inicio);
+}
\ No newline at end of file
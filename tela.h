@@ -0,0 +1,64 @@
+/**
+ * @file tela.h
+ * @brief Arquivo de cabecalho do desenho da partida com sequencias ANSI.
+ *
+ * Cada quadro (letras utilizadas, forca e palavra) e montado linha a
+ * linha em um buffer preparado de antemao e comparado com o quadro
+ * anterior; apenas as linhas que mudaram sao reescritas, posicionando
+ * o cursor com sequencias ANSI, e o resultado vai para o terminal em
+ * uma unica chamada write(). Nenhum processo e criado para limpar a tela.
+ */
+
+#ifndef TELA_H
+#define TELA_H
+
+#include <stdint.h>
+#include "forca.h"
+
+#define MAX_LINHAS_TELA 32      // Linhas de um quadro (o desenho da forca tem 23).
+#define TAM_LINHA_TELA 256      // Cabe a palavra mais longa, com um espaco por letra.
+#define TAM_QUADRO (MAX_LINHAS_TELA*(TAM_LINHA_TELA+16)+32)
+
+/**
+ * @struct Tela
+ * @brief Buffer de saida e copia do ultimo quadro enviado ao terminal.
+ */
+typedef struct{
+    char quadro[TAM_QUADRO];                            // Bytes a serem escritos.
+    int tamQuadro;
+    char linhas[MAX_LINHAS_TELA][TAM_LINHA_TELA];       // Linhas do quadro em montagem.
+    char anteriores[MAX_LINHAS_TELA][TAM_LINHA_TELA];   // Linhas do ultimo quadro escrito.
+    int numLinhas;
+    int numAnteriores;      // 0 quando o terminal nao reflete mais o ultimo quadro.
+} Tela;
+
+/**
+ * @brief Prepara a tela (no Windows, ativa as sequencias ANSI no console).
+ * @param t A tela.
+ */
+void iniciarTela (Tela *t);
+
+/**
+ * @brief Limpa o terminal e descarta o ultimo quadro.
+ *
+ * O proximo quadro sera desenhado por inteiro.
+ *
+ * @param t A tela.
+ */
+void limparTela (Tela *t);
+
+/**
+ * @brief Desenha o estado atual do jogo, reescrevendo so as linhas alteradas.
+ *
+ * O quadro e o mesmo de desenharForca(). Ao final, o cursor fica na
+ * linha seguinte ao quadro e o restante da tela (perguntas e mensagens
+ * da jogada anterior) e apagado.
+ *
+ * @param t A tela.
+ * @param p O jogador (para saber as vidas).
+ * @param palavra A string que mostra os acertos e os underscores.
+ * @param letras A mascara das letras ja utilizadas (bit 0 = A).
+ */
+void desenharQuadro (Tela *t, const Jogador *p, const char *palavra, uint32_t letras);
+
+#endif
\ No newline at end of file